@@ -47,9 +47,60 @@
 */
 #define TARGET_MIRROR_EDITION false
 
+/*!
+    @brief Configuration macro of servo refresh period [msec] at startup
+
+    Each servo gets a PWM pulse once in the period, and motions are updated at the same rate.
+    32 is the original timing. 24 or 20 gives motions higher control rate, if your servos accept it.
+    (The period can also be changed at runtime. See JointController::REFRESH_MODE.)
+*/
+#define SERVO_REFRESH_MS 32
+
+/*!
+    @brief Configuration macro of window to blend motions played in succession [msec] at startup
+
+    If it is not 0, the tail of a motion and the head of the next motion given by the interpreter overlap
+    in the window, so walking steps are chained without stopping between them.
+    0 is the original behavior. (The window can also be changed at runtime. See MotionController::setBlendWindow().)
+*/
+#define MOTION_BLEND_MS 0
+
+/*!
+    @brief Configuration macros of the motion cache in RAM
+
+    Headers and frames read from external EEPROM are kept for the MOTION_CACHE_SLOTS slots used most recently,
+    so a motion played repeatedly (e.g. walking steps) doesn't read I2C again. Frames of an index from
+    MOTION_CACHE_FRAMES are not cached. The cache takes about MOTION_CACHE_SLOTS * (38 + 52 * MOTION_CACHE_FRAMES) bytes
+    (about 560 bytes for a slot of 10 frames), which the firmware doesn't have on ATmega32u4, so it is disabled by 0.
+    Please enable it only if the test "firmware.size" of the host build still passes. (See README.md.)
+*/
+#define MOTION_CACHE_SLOTS  0
+#define MOTION_CACHE_FRAMES 10
+
+/*!
+    @brief Configuration macro of buffer length of the BLE serial session [bytes]
+
+    Commands whose arguments are longer than it are rejected on BLE serial (">MF" and ">SA" with 64),
+    so please send them from USB serial, or send ">MB" instead of ">MF". The other commands, including binary frames
+    of ">MB" and "$SF", fit in 64 bytes. 112 (the same as USB serial) accepts all commands, and takes 48 bytes more of SRAM.
+*/
+#define BLE_BUFFER_LENGTH 64
+
 
 #if TARGET_PLEN14 == TARGET_PLEN20
     #error "TARGET_PLEN14" and "TARGET_PLEN20" macros are incompatible! (You need to enable only one configuration.)
 #endif
 
+#if (SERVO_REFRESH_MS != 32) && (SERVO_REFRESH_MS != 24) && (SERVO_REFRESH_MS != 20)
+    #error "SERVO_REFRESH_MS" macro must be 32, 24 or 20!
+#endif
+
+#if (MOTION_CACHE_FRAMES < 1) || (MOTION_CACHE_FRAMES > 20)
+    #error "MOTION_CACHE_FRAMES" macro must be 1 to 20!
+#endif
+
+#if (BLE_BUFFER_LENGTH < 32) || (BLE_BUFFER_LENGTH > 112)
+    #error "BLE_BUFFER_LENGTH" macro must be 32 to 112!
+#endif
+
 #endif // PLEN2_BUILD_CONFIG_H
@@ -9,8 +9,9 @@
 
 #define DEBUG false
 
+#include <string.h>
+
 #include <Arduino.h>
-#include <Wire.h>
 
 #include "ExternalEEPROM.h"
 
@@ -20,20 +21,329 @@
 #endif
 
 
+namespace
+{
+    using namespace PLEN2;
+
+
+    enum OPERATION
+    {
+        OPERATION_READ,
+        OPERATION_WRITE
+    };
+
+    /*!
+        @brief Status codes of TWSR in master transmitter and receiver mode
+    */
+    enum
+    {
+        TW_START        = 0x08,
+        TW_REP_START    = 0x10,
+        TW_MT_SLA_ACK   = 0x18,
+        TW_MT_SLA_NACK  = 0x20,
+        TW_MT_DATA_ACK  = 0x28,
+        TW_MR_SLA_ACK   = 0x40,
+        TW_MR_DATA_ACK  = 0x50,
+        TW_MR_DATA_NACK = 0x58,
+        TW_STATUS_MASK  = 0xF8
+    };
+
+    /*!
+        @brief Steps of the transaction on the bus
+
+        Each value is the step the interface is carrying out, whose end is checked at the next poll().
+    */
+    enum PHASE
+    {
+        PHASE_IDLE,         //!< STOP condition has been sent, or nothing has been started.
+        PHASE_START,
+        PHASE_SLA_W,
+        PHASE_ADDRESS_HIGH,
+        PHASE_ADDRESS_LOW,  //!< (Only for reading. Writing goes on to PHASE_WRITING.)
+        PHASE_WRITING,
+        PHASE_REP_START,
+        PHASE_SLA_R,
+        PHASE_READING
+    };
+
+    //! @brief Result of a transaction that the device didn't acknowledge (in its write cycle)
+    enum { RESULT_BUSY = -3 };
+
+    struct Transaction
+    {
+        uint8_t  operation;
+        uint32_t address;
+        uint8_t  size;
+        uint8_t* read_data;
+        int8_t*  result;
+    };
+
+    namespace Shared
+    {
+        Transaction queue[ExternalEEPROM::QUEUE_LENGTH];
+        uint8_t     head   = 0;
+        uint8_t     length = 0;
+
+        /*!
+            Data of the write queued. Only a write is queued at a time (reads can be queued with it),
+            so the queue doesn't keep a block for each transaction.
+        */
+        uint8_t write_data[ExternalEEPROM::BLOCK_SIZE];
+        bool    writing = false;
+
+        bool     head_started = false;
+        uint32_t head_started_us;
+
+        uint8_t  phase = PHASE_IDLE;
+        uint8_t  index; //!< Count of data bytes sent or received.
+        uint8_t  slave_address;
+        uint16_t data_address;
+    }
+
+
+    Transaction* reserve(uint8_t operation, uint32_t address, uint8_t size, uint8_t* read_data, int8_t* result)
+    {
+        if (   (Shared::length >= ExternalEEPROM::QUEUE_LENGTH)
+            || ((operation == OPERATION_WRITE) && Shared::writing) )
+        {
+            return NULL;
+        }
+
+        Transaction& transaction = Shared::queue[
+            (Shared::head + Shared::length) % ExternalEEPROM::QUEUE_LENGTH
+        ];
+
+        transaction.operation = operation;
+        transaction.address   = address;
+        transaction.size      = size;
+        transaction.read_data = read_data;
+        transaction.result    = result;
+
+        if (result != NULL)
+        {
+            *result = ExternalEEPROM::RESULT_PENDING;
+        }
+
+        if (operation == OPERATION_WRITE)
+        {
+            Shared::writing = true;
+        }
+
+        Shared::length++;
+
+        return &transaction;
+    }
+
+    /*!
+        @brief Start an operation of TWI
+
+        The method doesn't wait for its end. (TWINT is set by the interface then.)
+    */
+    void twiCommand(uint8_t bits)
+    {
+        TWCR = _BV(TWINT) | _BV(TWEN) | bits;
+    }
+
+    void twiSend(uint8_t value)
+    {
+        TWDR = value;
+        twiCommand(0);
+    }
+
+    void twiStop()
+    {
+        twiCommand(_BV(TWSTO));
+
+        Shared::phase = PHASE_IDLE;
+    }
+
+    /*!
+        @brief Carry out a step of the transaction at the head of the queue
+
+        It is called after the step before has ended, so it only reads TWSR and starts the next one.
+
+        @return RESULT_PENDING until the transaction is finished, RESULT_BUSY if the device didn't acknowledge,
+                and the result of the transaction.
+    */
+    int8_t twiStep(Transaction& transaction)
+    {
+        const uint8_t status  = (TWSR & TW_STATUS_MASK);
+        const bool    reading = (transaction.operation == OPERATION_READ);
+
+        switch (Shared::phase)
+        {
+            case PHASE_START:
+            {
+                if (status != TW_START) break;
+
+                twiSend(Shared::slave_address << 1);
+                Shared::phase = PHASE_SLA_W;
+
+                return ExternalEEPROM::RESULT_PENDING;
+            }
+
+            case PHASE_SLA_W:
+            {
+                if (status == TW_MT_SLA_NACK)
+                {
+                    twiStop();
+
+                    return RESULT_BUSY;
+                }
+
+                if (status != TW_MT_SLA_ACK) break;
+
+                twiSend(static_cast<uint8_t>(Shared::data_address >> 8));
+                Shared::phase = PHASE_ADDRESS_HIGH;
+
+                return ExternalEEPROM::RESULT_PENDING;
+            }
+
+            case PHASE_ADDRESS_HIGH:
+            {
+                if (status != TW_MT_DATA_ACK) break;
+
+                twiSend(static_cast<uint8_t>(Shared::data_address & 0x00ff));
+                Shared::phase = (reading)? PHASE_ADDRESS_LOW : PHASE_WRITING;
+
+                return ExternalEEPROM::RESULT_PENDING;
+            }
+
+            case PHASE_ADDRESS_LOW:
+            {
+                if (status != TW_MT_DATA_ACK) break;
+
+                if (transaction.size == 0)
+                {
+                    twiStop();
+
+                    return 0;
+                }
+
+                twiCommand(_BV(TWSTA));
+                Shared::phase = PHASE_REP_START;
+
+                return ExternalEEPROM::RESULT_PENDING;
+            }
+
+            case PHASE_WRITING:
+            {
+                if (status != TW_MT_DATA_ACK) break;
+
+                if (Shared::index == transaction.size)
+                {
+                    // The device starts its write cycle at the STOP condition.
+                    twiStop();
+
+                    return 0;
+                }
+
+                twiSend(Shared::write_data[Shared::index++]);
+
+                return ExternalEEPROM::RESULT_PENDING;
+            }
+
+            case PHASE_REP_START:
+            {
+                if (status != TW_REP_START) break;
+
+                twiSend((Shared::slave_address << 1) | 0x01);
+                Shared::phase = PHASE_SLA_R;
+
+                return ExternalEEPROM::RESULT_PENDING;
+            }
+
+            case PHASE_SLA_R:
+            case PHASE_READING:
+            {
+                if (Shared::phase == PHASE_SLA_R)
+                {
+                    if (status != TW_MR_SLA_ACK) break;
+
+                    Shared::phase = PHASE_READING;
+                }
+                else
+                {
+                    if (   (status != TW_MR_DATA_ACK)
+                        && (status != TW_MR_DATA_NACK) )
+                    {
+                        break;
+                    }
+
+                    transaction.read_data[Shared::index++] = TWDR;
+
+                    if (Shared::index == transaction.size)
+                    {
+                        twiStop();
+
+                        return transaction.size;
+                    }
+                }
+
+                // The last byte is answered by NACK, so the device releases the bus before STOP condition.
+                twiCommand((Shared::index < (transaction.size - 1))? _BV(TWEA) : 0);
+
+                return ExternalEEPROM::RESULT_PENDING;
+            }
+        }
+
+        const bool addressing = (Shared::phase == PHASE_START);
+
+        twiStop();
+
+        return (reading)? -1 : ((addressing)? 4 : 3);
+    }
+}
+
+
 void PLEN2::ExternalEEPROM::begin()
 {
-    Wire.begin();
-    Wire.setClock(CLOCK);
+    // Enable internal pull-ups of SCL (PD0) and SDA (PD1), the same as Arduino's I2C library.
+    PORTD |= _BV(0) | _BV(1);
+
+    TWSR &= ~(_BV(TWPS1) | _BV(TWPS0));
+    TWBR  = ((F_CPU / CLOCK) - 16) / 2;
+    TWCR  = _BV(TWEN);
 }
 
 
-int8_t PLEN2::ExternalEEPROM::readSlot(uint16_t slot, uint8_t data[], uint8_t read_size)
+uint8_t PLEN2::ExternalEEPROM::m_deviceAddress(uint32_t address, uint16_t& data_address)
 {
+    uint8_t slave_address = ADDRESS;
+
+    if (address >= (SIZE / 2))
+    {
+        slave_address |= _BV(SELECT_BIT); // Select the memory block B0 = 1.
+        address       -= (SIZE / 2);
+    }
+
+    data_address = static_cast<uint16_t>(address);
+
     #if DEBUG
-        PROFILING("ExternalEEPROM::readSlot()");
+        System::debugSerial().print(F(">>> slave_address : "));
+        System::debugSerial().println(slave_address, HEX);
+
+        System::debugSerial().print(F(">>> data_address : "));
+        System::debugSerial().println(data_address, HEX);
     #endif
 
+    return slave_address;
+}
+
+
+int8_t PLEN2::ExternalEEPROM::m_wait(int8_t& result)
+{
+    while (result == RESULT_PENDING)
+    {
+        poll();
+    }
+
+    return result;
+}
+
 
+int8_t PLEN2::ExternalEEPROM::submitRead(uint16_t slot, uint8_t data[], uint8_t read_size, int8_t* result)
+{
     if (   (slot >= SLOT_END)
         || (read_size > SLOT_SIZE)
     )
@@ -48,96 +358,273 @@ int8_t PLEN2::ExternalEEPROM::readSlot(uint16_t slot, uint8_t data[], uint8_t re
         return -1;
     }
 
+    if (reserve(OPERATION_READ, static_cast<uint32_t>(slot) * CHUNK_SIZE, read_size, data, result) == NULL)
+    {
+        return 1;
+    }
+
+    return 0;
+}
 
-    uint16_t slave_address = ADDRESS;
-    uint32_t data_address = static_cast<uint32_t>(slot) * CHUNK_SIZE;
 
-    if (data_address >= (SIZE / 2))
+int8_t PLEN2::ExternalEEPROM::submitWrite(uint16_t slot, const uint8_t data[], uint8_t write_size, int8_t* result)
+{
+    if (   (slot >= SLOT_END)
+        || (write_size > SLOT_SIZE)
+    )
     {
-        slave_address |= _BV(SELECT_BIT); // Select the memory block B0 = 1.
-        data_address  -= (SIZE / 2);
+        #if DEBUG
+            System::debugSerial().print(F(">>> bad argument! : slot = "));
+            System::debugSerial().print(slot);
+            System::debugSerial().print(F(", or write_size = "));
+            System::debugSerial().println(write_size);
+        #endif
+
+        return -1;
     }
 
-    #if DEBUG
-        System::debugSerial().print(F(">>> slave_address = "));
-        System::debugSerial().println(slave_address, HEX);
+    Transaction* transaction_ptr = reserve(
+        OPERATION_WRITE, static_cast<uint32_t>(slot) * CHUNK_SIZE, write_size, NULL, result
+    );
 
-        System::debugSerial().print(F(">>> data_address = "));
-        System::debugSerial().println(data_address, HEX);
+    if (transaction_ptr == NULL)
+    {
+        return 1;
+    }
+
+    memcpy(Shared::write_data, data, write_size);
+
+    return 0;
+}
+
+
+int8_t PLEN2::ExternalEEPROM::submitWriteBlock(uint16_t block, const uint8_t data[], uint8_t write_size, uint8_t offset, int8_t* result)
+{
+    if (   (block >= BLOCK_END)
+        || ((static_cast<uint16_t>(offset) + write_size) > BLOCK_SIZE)
+    )
+    {
+        #if DEBUG
+            System::debugSerial().print(F(">>> bad argument! : block = "));
+            System::debugSerial().print(block);
+            System::debugSerial().print(F(", or write_size = "));
+            System::debugSerial().println(write_size);
+        #endif
+
+        return -1;
+    }
+
+    Transaction* transaction_ptr = reserve(
+        OPERATION_WRITE, static_cast<uint32_t>(block) * BLOCK_SIZE + offset, write_size, NULL, result
+    );
+
+    if (transaction_ptr == NULL)
+    {
+        return 1;
+    }
+
+    memcpy(Shared::write_data, data, write_size);
+
+    return 0;
+}
+
+
+bool PLEN2::ExternalEEPROM::poll()
+{
+    #if DEBUG
+        PROFILING("ExternalEEPROM::poll()");
     #endif
 
-    Wire.beginTransmission(static_cast<int>(slave_address));
-    Wire.write(static_cast<uint8_t>(data_address >> 8));     // Sending targeted address's high byte.
-    Wire.write(static_cast<uint8_t>(data_address & 0x00FF)); // Sending targeted address's low byte.
 
-    if (Wire.endTransmission() == 0)
+    if (idle())
+    {
+        return true;
+    }
+
+    Transaction& transaction = Shared::queue[Shared::head];
+
+    if (Shared::phase == PHASE_IDLE)
     {
-        if (Wire.requestFrom(slave_address, read_size) == read_size)
+        // START condition can not be sent until the STOP condition before has been sent.
+        if (TWCR & _BV(TWSTO))
         {
-            for (uint8_t index = 0; index < read_size; index++)
-            {
-                data[index] = Wire.read();
-            }
+            return false;
+        }
 
-            return read_size;
+        if (!Shared::head_started)
+        {
+            Shared::head_started    = true;
+            Shared::head_started_us = micros();
         }
+
+        Shared::slave_address = m_deviceAddress(transaction.address, Shared::data_address);
+        Shared::index         = 0;
+        Shared::phase         = PHASE_START;
+
+        twiCommand(_BV(TWSTA));
+
+        return false;
+    }
+
+    // The interface is still carrying out the step before.
+    if (!(TWCR & _BV(TWINT)))
+    {
+        return false;
+    }
+
+    int8_t ret = twiStep(transaction);
+
+    if (ret == RESULT_PENDING)
+    {
+        return false;
+    }
+
+    if (ret == RESULT_BUSY)
+    {
+        /*!
+            @note
+            The device keeps NACK only while its write cycle is running,
+            so NACK after the maximum write cycle time is regarded as an error.
+        */
+        if ((micros() - Shared::head_started_us) < WRITE_CYCLE_MAX_US)
+        {
+            return false;
+        }
+
+        ret = (transaction.operation == OPERATION_READ)? -1 : 2;
+    }
+
+    #if DEBUG
+        System::debugSerial().print(F(">>> result : "));
+        System::debugSerial().println(static_cast<int>(ret));
+    #endif
+
+    if (transaction.result != NULL)
+    {
+        *transaction.result = ret;
+    }
+
+    if (transaction.operation == OPERATION_WRITE)
+    {
+        Shared::writing = false;
+    }
+
+    Shared::head = (Shared::head + 1) % QUEUE_LENGTH;
+    Shared::length--;
+    Shared::head_started = false;
+
+    return idle();
+}
+
+
+bool PLEN2::ExternalEEPROM::idle()
+{
+    return (Shared::length == 0);
+}
+
+
+int8_t PLEN2::ExternalEEPROM::readSlot(uint16_t slot, uint8_t data[], uint8_t read_size)
+{
+    #if DEBUG
+        PROFILING("ExternalEEPROM::readSlot()");
+    #endif
+
+
+    int8_t result;
+    int8_t queued;
+
+    while ((queued = submitRead(slot, data, read_size, &result)) == 1)
+    {
+        poll();
+    }
+
+    if (queued != 0)
+    {
+        return queued;
     }
 
-    return -1;
+    return m_wait(result);
 }
 
 
-int8_t PLEN2::ExternalEEPROM::writeSlot(uint16_t  slot, const uint8_t data[], uint8_t write_size)
+int8_t PLEN2::ExternalEEPROM::writeSlot(uint16_t slot, const uint8_t data[], uint8_t write_size)
 {
     #if DEBUG
         PROFILING("ExternalEEPROM::writeSlot()");
     #endif
 
 
-    if (   (slot >= SLOT_END)
-        || (write_size > SLOT_SIZE)
+    int8_t result;
+    int8_t queued;
+
+    while ((queued = submitWrite(slot, data, write_size, &result)) == 1)
+    {
+        poll();
+    }
+
+    if (queued != 0)
+    {
+        return queued;
+    }
+
+    return m_wait(result);
+}
+
+
+int8_t PLEN2::ExternalEEPROM::readBlock(uint16_t block, uint8_t data[], uint8_t read_size, uint8_t offset)
+{
+    #if DEBUG
+        PROFILING("ExternalEEPROM::readBlock()");
+    #endif
+
+
+    if (   (block >= BLOCK_END)
+        || ((static_cast<uint16_t>(offset) + read_size) > BLOCK_SIZE)
     )
     {
         #if DEBUG
-            System::debugSerial().print(F(">>> bad argument! : slot = "));
-            System::debugSerial().print(slot);
-            System::debugSerial().print(F(", or write_size = "));
-            System::debugSerial().println(write_size);
+            System::debugSerial().print(F(">>> bad argument! : block = "));
+            System::debugSerial().print(block);
+            System::debugSerial().print(F(", or read_size = "));
+            System::debugSerial().println(read_size);
         #endif
 
         return -1;
     }
 
 
-    uint16_t slave_address = ADDRESS;
-    uint32_t data_address = static_cast<uint32_t>(slot) * CHUNK_SIZE;
+    int8_t result;
 
-    if (data_address >= (SIZE / 2))
+    while (reserve(
+        OPERATION_READ, static_cast<uint32_t>(block) * BLOCK_SIZE + offset, read_size, data, &result
+    ) == NULL)
     {
-        slave_address |= _BV(SELECT_BIT); // Select the memory block B0 = 1.
-        data_address  -= (SIZE / 2);
+        poll();
     }
 
-    #if DEBUG
-        System::debugSerial().print(F(">>> slave_address : "));
-        System::debugSerial().println(slave_address, HEX);
+    return m_wait(result);
+}
 
-        System::debugSerial().print(F(">>> data_address : "));
-        System::debugSerial().println(data_address, HEX);
+
+int8_t PLEN2::ExternalEEPROM::writeBlock(uint16_t block, const uint8_t data[], uint8_t write_size, uint8_t offset)
+{
+    #if DEBUG
+        PROFILING("ExternalEEPROM::writeBlock()");
     #endif
 
-    Wire.beginTransmission(static_cast<int>(slave_address));
-    Wire.write(static_cast<uint8_t>(data_address >> 8));     // Sending targeted address's high byte.
-    Wire.write(static_cast<uint8_t>(data_address & 0x00ff)); // Sending targeted address's low byte.
 
-    for (uint8_t index = 0; index < write_size; index++)
+    int8_t result;
+    int8_t queued;
+
+    while ((queued = submitWriteBlock(block, data, write_size, offset, &result)) == 1)
     {
-        Wire.write(data[index]);
+        poll();
     }
 
-    int8_t ret = Wire.endTransmission();
-
-    delay(5); // @attention Wait for writing EEPROM.
+    if (queued != 0)
+    {
+        return queued;
+    }
 
-    return ret;
+    return m_wait(result);
 }
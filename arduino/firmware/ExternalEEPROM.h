@@ -11,6 +11,7 @@
 #define PLEN2_EXTERNAL_EEPROM_H
 
 
+#include <stddef.h>
 #include <stdint.h>
 
 namespace PLEN2
@@ -25,9 +26,23 @@ namespace PLEN2
     24FC1025 supports the access to 128 bytes at once, but Arduino's I2C library doesn't support it
     because the library's buffer size is 32 bytes.
     <br><br>
-    Please pay attention to the fact that it is including bytes of targeted area address (= 2 bytes).
-    The accurate data size that you can write is 30 bytes.
+    Slots keep the layout of the firmware that used the library, which was including bytes of
+    targeted area address (= 2 bytes) in the buffer. The accurate data size of a slot is 30 bytes.
     (This is why there are differences between CHUNK_SIZE and SLOT_SIZE.)
+    <br><br>
+    The firmware drives TWI registers directly instead of the library,
+    so a block (BLOCK_SIZE bytes, aligned to the page) is written by one page program, and read by one sequential read.
+
+    @note
+    Transactions can be queued with submitRead() / submitWrite(), and poll() carries them out
+    one step at a time: a START condition, a byte or a STOP condition. It never waits for the interface,
+    so a call takes a few microseconds, and a transaction of a block is spread over about 70 calls
+    (about 1.6msec on the bus at 400kHz). While the device runs its internal write cycle,
+    it does not acknowledge its address, so poll() simply retries at the next call (ACK polling)
+    instead of waiting for a fixed time.
+    <br><br>
+    readSlot() / writeSlot() / readBlock() / writeBlock() are blocking wrappers of them,
+    so they wait for the whole transaction, and for the transactions queued before it.
 */
 class PLEN2::ExternalEEPROM
 {
@@ -47,6 +62,12 @@ private:
     //! @brief Selection bit of memory chip
     enum { SELECT_BIT = 2 };
 
+    //! @brief Page size of external EEPROM (bytes)
+    enum { PAGE_SIZE = 128 };
+
+    //! @brief Maximum time of an internal write cycle (usec)
+    enum { WRITE_CYCLE_MAX_US = 5000UL };
+
 public:
     //! @brief Chunk size of external EEPROM (bytes)
     enum { CHUNK_SIZE = 32 };
@@ -60,6 +81,21 @@ public:
     //! @brief End value of slots
     enum { SLOT_END = SIZE / CHUNK_SIZE };
 
+    //! @brief Block size of external EEPROM (bytes)
+    enum { BLOCK_SIZE = 64 };
+
+    //! @brief Beginning value of blocks
+    enum { BLOCK_BEGIN = 0 };
+
+    //! @brief End value of blocks
+    enum { BLOCK_END = SIZE / BLOCK_SIZE };
+
+    //! @brief Count of transactions that can be queued
+    enum { QUEUE_LENGTH = 2 };
+
+    //! @brief Result of a transaction that has not been finished yet
+    enum { RESULT_PENDING = -2 };
+
     /*!
         @brief Constructor
     */
@@ -93,16 +129,125 @@ public:
         @return Result
         @retval 0  Succeeded.
         @retval -1 Argument error. (**write_size** is bigger than slot size.)
-        @retval 1  Sending-buffer overflow.
         @retval 2  Received NACK after sending slave address.
         @retval 3  Received NACK after sending data bytes.
         @retval 4  Other errors were raised.
 
         @attention
         Writing external EEPROM requires time. (Typically using 3[msec].)
-        In the implementation, 5[msec] delay is inserted at the end of the method.
+        The method returns as soon as the device accepts the data,
+        and the next transaction waits for the end of the write cycle by ACK polling.
     */
     static int8_t writeSlot(uint16_t slot, const uint8_t data[], uint8_t write_size);
+
+    /*!
+        @brief Read a block of external EEPROM
+
+        @param [in]  block     Please set block number you want to read.
+        @param [out] data[]    Please set buffer to store reading data.
+        @param [in]  read_size Please set buffer size.
+        @param [in]  offset    Please set position in the block to begin reading.
+
+        @return Result
+        @retval !0 Succeeded. (Generally, the value equals **read-size**.)
+        @retval -1 Failed.
+    */
+    static int8_t readBlock(uint16_t block, uint8_t data[], uint8_t read_size, uint8_t offset = 0);
+
+    /*!
+        @brief Write a block of external EEPROM by one page program
+
+        @param [in] block      Please set block number you want to write.
+        @param [in] data[]     Please set buffer that stored writing data.
+        @param [in] write_size Please set buffer size.
+        @param [in] offset     Please set position in the block to begin writing.
+
+        @return Result
+        @retval 0  Succeeded.
+        @retval -1 Argument error. (**write_size** is bigger than the rest of the block.)
+        @retval 2  Received NACK after sending slave address.
+        @retval 3  Received NACK after sending data bytes.
+        @retval 4  Other errors were raised.
+    */
+    static int8_t writeBlock(uint16_t block, const uint8_t data[], uint8_t write_size, uint8_t offset = 0);
+
+    /*!
+        @brief Queue reading a slot of external EEPROM
+
+        @param [in]  slot      Please set slot number you want to read.
+        @param [out] data[]    Please set buffer to store reading data. (It must be alive until finished.)
+        @param [in]  read_size Please set buffer size.
+        @param [out] result    Please set a variable to store the result, or NULL.
+                               It is RESULT_PENDING until finished, and then the same value as readSlot().
+
+        @return Result
+        @retval 0  Queued.
+        @retval -1 Argument error.
+        @retval 1  The queue is full. (Please call poll() and retry.)
+    */
+    static int8_t submitRead(uint16_t slot, uint8_t data[], uint8_t read_size, int8_t* result = NULL);
+
+    /*!
+        @brief Queue writing a slot of external EEPROM
+
+        The data is copied, so the buffer can be reused at once.
+        Only a write is queued at a time (it has a buffer shared), but reads can be queued with it.
+
+        @param [in]  slot       Please set slot number you want to write.
+        @param [in]  data[]     Please set buffer that stored writing data.
+        @param [in]  write_size Please set buffer size.
+        @param [out] result     Please set a variable to store the result, or NULL.
+                                It is RESULT_PENDING until finished, and then the same value as writeSlot().
+
+        @return Result
+        @retval 0  Queued.
+        @retval -1 Argument error.
+        @retval 1  The queue is full, or a write is queued. (Please call poll() and retry.)
+    */
+    static int8_t submitWrite(uint16_t slot, const uint8_t data[], uint8_t write_size, int8_t* result = NULL);
+
+    /*!
+        @brief Queue writing a block of external EEPROM
+
+        The data is copied, so the buffer can be reused at once.
+        Only a write is queued at a time (it has a buffer shared), but reads can be queued with it.
+
+        @param [in]  block      Please set block number you want to write.
+        @param [in]  data[]     Please set buffer that stored writing data.
+        @param [in]  write_size Please set buffer size.
+        @param [in]  offset     Please set position in the block to begin writing.
+        @param [out] result     Please set a variable to store the result, or NULL.
+                                It is RESULT_PENDING until finished, and then the same value as writeBlock().
+
+        @return Result
+        @retval 0  Queued.
+        @retval -1 Argument error.
+        @retval 1  The queue is full, or a write is queued. (Please call poll() and retry.)
+    */
+    static int8_t submitWriteBlock(uint16_t block, const uint8_t data[], uint8_t write_size, uint8_t offset = 0, int8_t* result = NULL);
+
+    /*!
+        @brief Carry out the queued transactions
+
+        The method starts at most one step of a bus transaction per call, and doesn't wait for its end.
+        If the device is busy with its write cycle, the method returns at once and retries at the next call.
+
+        @return Result
+        @retval true  The queue is empty.
+        @retval false Some transactions are remaining.
+    */
+    static bool poll();
+
+    /*!
+        @brief Decide if the queue is empty
+
+        @return Result
+    */
+    static bool idle();
+
+private:
+    static uint8_t m_deviceAddress(uint32_t address, uint16_t& data_address);
+    static int8_t  m_wait(int8_t& result);
 };
 
 #endif // PLEN2_EXTERNAL_EEPROM_H
@@ -10,6 +10,22 @@
 #define DEBUG      false
 #define DEBUG_HARD false
 
+/*!
+    @note
+    If you want to convert angles to PWM width with Arduino's map() as before, set the macro to "false".
+    (The precomputed transform gives the same result without any division.)
+*/
+#define PRECOMPUTED_TRANSFORM true
+
+/*!
+    @note
+    If you want to switch the multiplexer with digitalWrite() as before, set the macro to "false".
+    (Comparing "<DI" of both builds shows the cost of the timer 1 overflow vector.)
+*/
+#define DIRECT_PORT_ACCESS true
+
+#include <string.h>
+
 #include <avr/pgmspace.h>
 #include <avr/eeprom.h>
 
@@ -41,6 +57,9 @@
 
 volatile bool PLEN2::JointController::m_1cycle_finished = false;
 uint16_t PLEN2::JointController::m_pwms[PLEN2::JointController::JOINTS_SUM];
+uint16_t PLEN2::JointController::m_frames[2][PLEN2::JointController::JOINTS_SUM];
+volatile uint8_t PLEN2::JointController::m_frame_front = 0;
+volatile bool PLEN2::JointController::m_frame_committed = false;
 
 
 namespace
@@ -78,6 +97,154 @@ namespace
         };
 
         const int16_t ERROR_LVALUE = -32768;
+
+        //! @brief Max PWM width that timer 1 can output, on the scale of 10bit mode.
+        const uint16_t PWM_TOP = 1023;
+
+        /*!
+            @brief Resolve uncalibrated points of a calibration curve
+
+            Uncalibrated endpoints get PWM_MIN or PWM_MAX,
+            and uncalibrated points between them are interpolated linearly from their calibrated neighbors.
+        */
+        void interpolateCalibration(uint16_t pwms[])
+        {
+            const uint8_t END = JointController::CALIBRATION_POINTS - 1;
+
+            #if CLOCK_WISE
+                const uint16_t PWM_BEGIN = JointController::PWM_MIN;
+                const uint16_t PWM_END   = JointController::PWM_MAX;
+            #else
+                const uint16_t PWM_BEGIN = JointController::PWM_MAX;
+                const uint16_t PWM_END   = JointController::PWM_MIN;
+            #endif
+
+            if (pwms[0] == JointController::PWM_UNCALIBRATED)
+            {
+                pwms[0] = PWM_BEGIN;
+            }
+
+            if (pwms[END] == JointController::PWM_UNCALIBRATED)
+            {
+                pwms[END] = PWM_END;
+            }
+
+            uint8_t begin = 0;
+
+            for (uint8_t point = 1; point <= END; point++)
+            {
+                if (pwms[point] == JointController::PWM_UNCALIBRATED)
+                {
+                    continue;
+                }
+
+                for (uint8_t middle = begin + 1; middle < point; middle++)
+                {
+                    pwms[middle] = pwms[begin] + (
+                        static_cast<int32_t>(pwms[point] - pwms[begin]) * (middle - begin)
+                    ) / (point - begin);
+                }
+
+                begin = point;
+            }
+        }
+
+        /*!
+            @brief TOP of timer 1 and update interval [msec] of each refresh mode
+
+            A period of timer 1 is (TOP + 1) * 4[usec], and a servo gets a pulse once in 8 periods.
+        */
+        enum { TIMER_TICK_US = 4 };
+
+        PROGMEM const uint16_t REFRESH_TOP[]         = { 1023, 749, 624 };
+        PROGMEM const uint8_t  REFRESH_INTERVAL_MS[] = {   32,  24,  20 };
+
+        /*!
+            @brief Difference between PWM width in 10bit mode and the value of OCR1x in the refresh mode
+
+            PWM width is kept on the scale of 10bit mode (TOP = 1023) whatever the refresh mode is,
+            and a pulse is HIGH from compare match until TOP, so subtracting the difference keeps the pulse length.
+        */
+        volatile uint16_t pwm_offset = 0;
+
+        volatile uint16_t isr_cycles     = 0; //!< CPU cycles taken by the last timer 1 overflow vector.
+        volatile uint16_t isr_cycles_max = 0; //!< CPU cycles taken by the slowest timer 1 overflow vector.
+    }
+
+
+    /*!
+        @brief Port register of a port ID given
+    */
+    template<int PORT>
+    class PortRegister;
+
+    template<> class PortRegister<PLEN2::Pin::PORT_B> { public: static volatile uint8_t& get() { return PORTB; } };
+    template<> class PortRegister<PLEN2::Pin::PORT_C> { public: static volatile uint8_t& get() { return PORTC; } };
+    template<> class PortRegister<PLEN2::Pin::PORT_D> { public: static volatile uint8_t& get() { return PORTD; } };
+    template<> class PortRegister<PLEN2::Pin::PORT_E> { public: static volatile uint8_t& get() { return PORTE; } };
+    template<> class PortRegister<PLEN2::Pin::PORT_F> { public: static volatile uint8_t& get() { return PORTF; } };
+
+    /*!
+        @brief Writer of the multiplexer's selection bits that are on a port
+
+        Each selection bit is mapped to its port bit at compile time,
+        so writing costs one read-modify-write of the port, and nothing if the port has no selection bits.
+
+        @tparam PORT    Port ID to write.
+        @tparam SELECT0 Pin of selection bit 0.
+        @tparam SELECT1 Pin of selection bit 1.
+        @tparam SELECT2 Pin of selection bit 2.
+    */
+    template<int PORT, int SELECT0, int SELECT1, int SELECT2>
+    class MultiplexerPort
+    {
+    private:
+        typedef PLEN2::Pin::PortBit<SELECT0> BIT0;
+        typedef PLEN2::Pin::PortBit<SELECT1> BIT1;
+        typedef PLEN2::Pin::PortBit<SELECT2> BIT2;
+
+        enum
+        {
+            MASK0 = (BIT0::PORT == PORT)? _BV(BIT0::BIT) : 0,
+            MASK1 = (BIT1::PORT == PORT)? _BV(BIT1::BIT) : 0,
+            MASK2 = (BIT2::PORT == PORT)? _BV(BIT2::BIT) : 0,
+            MASK  = MASK0 | MASK1 | MASK2
+        };
+
+    public:
+        static inline void write(uint8_t output_select)
+        {
+            if (MASK == 0)
+            {
+                return;
+            }
+
+            const uint8_t bits =
+                ((output_select & 0x01)? MASK0 : 0) |
+                ((output_select & 0x02)? MASK1 : 0) |
+                ((output_select & 0x04)? MASK2 : 0);
+
+            volatile uint8_t& port = PortRegister<PORT>::get();
+
+            port = (port & ~MASK) | bits;
+        }
+    };
+
+    /*!
+        @brief Select an output line of the multiplexers by direct port access
+
+        @note
+        On Arduino Micro the selection bits are PC6, PD7 and PD6,
+        so they are written by two port writes. (The bits on PORTD are changed at a time.)
+    */
+    template<int SELECT0, int SELECT1, int SELECT2>
+    inline void selectMultiplexer(uint8_t output_select)
+    {
+        MultiplexerPort<PLEN2::Pin::PORT_B, SELECT0, SELECT1, SELECT2>::write(output_select);
+        MultiplexerPort<PLEN2::Pin::PORT_C, SELECT0, SELECT1, SELECT2>::write(output_select);
+        MultiplexerPort<PLEN2::Pin::PORT_D, SELECT0, SELECT1, SELECT2>::write(output_select);
+        MultiplexerPort<PLEN2::Pin::PORT_E, SELECT0, SELECT1, SELECT2>::write(output_select);
+        MultiplexerPort<PLEN2::Pin::PORT_F, SELECT0, SELECT1, SELECT2>::write(output_select);
     }
 }
 
@@ -91,17 +258,115 @@ PLEN2::JointController::JointController()
     pinMode(Pin::PWM_OUT_08_15,       OUTPUT);
     pinMode(Pin::PWM_OUT_16_23,       OUTPUT);
 
+    m_calibration_loaded = false;
+
+    m_journal_epoch   = 0;
+    m_journal_start   = 0;
+    m_journal_length  = 0;
+    m_journal_written = JOURNAL_RECORD_SIZE;
+    m_folded          = FOLD_IDLE;
+
+    memset(m_dirty, 0, sizeof(m_dirty));
+
+    #if SERVO_REFRESH_MS == 20
+        m_refresh_mode = REFRESH_20MS;
+    #elif SERVO_REFRESH_MS == 24
+        m_refresh_mode = REFRESH_24MS;
+    #else
+        m_refresh_mode = REFRESH_32MS;
+    #endif
+
     for (uint8_t joint_id = 0; joint_id < JOINTS_SUM; joint_id++)
     {
         m_SETTINGS[joint_id].MIN  = pgm_read_word(Shared::m_SETTINGS_INITIAL + joint_id * 3 + 0);
         m_SETTINGS[joint_id].MAX  = pgm_read_word(Shared::m_SETTINGS_INITIAL + joint_id * 3 + 1);
         m_SETTINGS[joint_id].HOME = pgm_read_word(Shared::m_SETTINGS_INITIAL + joint_id * 3 + 2);
 
+        m_updateTransform(joint_id);
         setAngle(joint_id, m_SETTINGS[joint_id].HOME);
     }
 }
 
 
+void PLEN2::JointController::m_loadCalibration(uint8_t joint_id, uint16_t pwms[])
+{
+    for (uint8_t point = 0; point < CALIBRATION_POINTS; point++)
+    {
+        pwms[point] = PWM_UNCALIBRATED;
+
+        if (m_calibration_loaded)
+        {
+            const uint16_t address = CALIBRATION_HEAD_ADDRESS
+                + (joint_id * CALIBRATION_POINTS + point) * sizeof(uint16_t);
+
+            pwms[point] = EEPROM[address] | (static_cast<uint16_t>(EEPROM[address + 1]) << 8);
+        }
+    }
+}
+
+
+void PLEN2::JointController::m_updateTransform(uint8_t joint_id)
+{
+    uint16_t pwms[CALIBRATION_POINTS];
+
+    m_loadCalibration(joint_id, pwms);
+    Shared::interpolateCalibration(pwms);
+
+    /*!
+        @note
+        SCALE is rounded up, so (n * SCALE) >> TRANSFORM_PRECISION never falls below
+        the truncated quotient of map(). TRANSFORM_PRECISION = 16 is enough to make them
+        bit-exact for n in [0, CALIBRATION_SPAN] with the default calibration on both PLEN 1.4 and PLEN 2.0,
+        and a calibrated point is always reached exactly.
+    */
+    m_transforms[joint_id].PWM_BEGIN = pwms[0];
+
+    for (uint8_t segment = 0; segment < (CALIBRATION_POINTS - 1); segment++)
+    {
+        #if CLOCK_WISE
+            const uint32_t pwm_range = pwms[segment + 1] - pwms[segment];
+        #else
+            const uint32_t pwm_range = pwms[segment] - pwms[segment + 1];
+        #endif
+
+        m_transforms[joint_id].SCALE[segment] =
+            ((pwm_range << TRANSFORM_PRECISION) + CALIBRATION_SPAN - 1) / CALIBRATION_SPAN;
+    }
+}
+
+
+inline uint16_t PLEN2::JointController::m_angle2PWM(uint8_t joint_id, int16_t angle)
+{
+    const Transform& transform = m_transforms[joint_id];
+
+    uint16_t n       = angle - ANGLE_MIN;
+    uint16_t begin   = 0; //!< PWM width from the curve's begin to the segment's begin.
+    uint8_t  segment = 0;
+
+    while (   (segment < (CALIBRATION_POINTS - 2))
+           && (n >= CALIBRATION_SPAN) )
+    {
+        begin += (static_cast<uint32_t>(CALIBRATION_SPAN) * transform.SCALE[segment]) >> TRANSFORM_PRECISION;
+        n     -= CALIBRATION_SPAN;
+        segment++;
+    }
+
+    #if PRECOMPUTED_TRANSFORM
+        const uint16_t width = begin + ((static_cast<uint32_t>(n) * transform.SCALE[segment]) >> TRANSFORM_PRECISION);
+    #else
+        const uint16_t width = begin + map(n, 0, CALIBRATION_SPAN,
+            0, (static_cast<uint32_t>(CALIBRATION_SPAN) * transform.SCALE[segment]) >> TRANSFORM_PRECISION
+        );
+    #endif
+
+    #if CLOCK_WISE
+        return transform.PWM_BEGIN + width;
+    #else
+        return transform.PWM_BEGIN - width;
+    #endif
+}
+
+
 void PLEN2::JointController::loadSettings()
 {
     #if DEBUG
@@ -109,32 +374,311 @@ void PLEN2::JointController::loadSettings()
     #endif
 
 
-    uint8_t* filler = reinterpret_cast<uint8_t*>(m_SETTINGS);
-    
-    if (EEPROM[INIT_FLAG_ADDRESS] != INIT_FLAG_VALUE)
+    if (m_calibration_loaded)
     {
-        EEPROM[INIT_FLAG_ADDRESS] = INIT_FLAG_VALUE;
-        eeprom_busy_wait();
+        m_flushJournal();
+    }
+
+    const uint8_t init_flag = EEPROM[INIT_FLAG_ADDRESS];
+
+    if (init_flag == INIT_FLAG_VALUE)
+    {
+        uint8_t* filler = reinterpret_cast<uint8_t*>(m_SETTINGS);
 
         for (uint8_t index = 0; index < sizeof(m_SETTINGS); index++)
         {
-            EEPROM[SETTINGS_HEAD_ADDRESS + index] = filler[index];
-            eeprom_busy_wait();
+            filler[index] = EEPROM[SETTINGS_HEAD_ADDRESS + index];
         }
     }
     else
     {
-        for (uint8_t index = 0; index < sizeof(m_SETTINGS); index++)
+        /*!
+            @note
+            The default settings are not written until the first compaction,
+            so the first boot doesn't wait for write cycles of all settings.
+        */
+        if (init_flag != INIT_FLAG_DEFAULTS)
         {
-            filler[index] = EEPROM[SETTINGS_HEAD_ADDRESS + index];
+            EEPROM[INIT_FLAG_ADDRESS] = INIT_FLAG_DEFAULTS;
+            eeprom_busy_wait();
+        }
+
+        for (uint8_t joint_id = 0; joint_id < JOINTS_SUM; joint_id++)
+        {
+            m_SETTINGS[joint_id].MIN  = pgm_read_word(Shared::m_SETTINGS_INITIAL + joint_id * 3 + 0);
+            m_SETTINGS[joint_id].MAX  = pgm_read_word(Shared::m_SETTINGS_INITIAL + joint_id * 3 + 1);
+            m_SETTINGS[joint_id].HOME = pgm_read_word(Shared::m_SETTINGS_INITIAL + joint_id * 3 + 2);
         }
     }
 
+    m_readJournal();
+
+    m_calibration_loaded = true;
+
     for (uint8_t joint_id = 0; joint_id < JOINTS_SUM; joint_id++)
     {
+        /*!
+            @note
+            A fold cut by power down can leave a setting torn, and the journal doesn't always have its value
+            (e.g. after setSettings()), so a joint whose settings the setters couldn't have given gets the default settings.
+            (HOME is not compared with MIN and MAX, because setMinAngle() and setMaxAngle() can move them over HOME.)
+        */
+        const JointSetting& setting = m_SETTINGS[joint_id];
+
+        if (   (setting.MIN  <  ANGLE_MIN)
+            || (setting.MAX  >  ANGLE_MAX)
+            || (setting.MIN  >= setting.MAX)
+            || (setting.HOME <  ANGLE_MIN)
+            || (setting.HOME >  ANGLE_MAX) )
+        {
+            m_SETTINGS[joint_id].MIN  = pgm_read_word(Shared::m_SETTINGS_INITIAL + joint_id * 3 + 0);
+            m_SETTINGS[joint_id].MAX  = pgm_read_word(Shared::m_SETTINGS_INITIAL + joint_id * 3 + 1);
+            m_SETTINGS[joint_id].HOME = pgm_read_word(Shared::m_SETTINGS_INITIAL + joint_id * 3 + 2);
+        }
+
+        m_updateTransform(joint_id);
         setAngle(joint_id, m_SETTINGS[joint_id].HOME);
     }
 
+    m_fillFrames();
+    m_configureTimer();
+}
+
+
+uint16_t PLEN2::JointController::m_recordAddress(uint8_t index)
+{
+    return JOURNAL_HEAD_ADDRESS
+        + static_cast<uint16_t>((m_journal_start + index) % JOURNAL_RECORDS) * JOURNAL_RECORD_SIZE;
+}
+
+
+void PLEN2::JointController::m_readJournal()
+{
+    m_journal_epoch = EEPROM[JOURNAL_EPOCH_ADDRESS];
+    m_journal_start = EEPROM[JOURNAL_START_ADDRESS];
+
+    if (   (m_journal_epoch >= JOURNAL_EPOCH_SUM)
+        || (m_journal_start >= JOURNAL_RECORDS) )
+    {
+        /*!
+            @note
+            The journal is read until the first record not valid,
+            so the first epoch has only to differ from the epoch of the first record.
+        */
+        m_journal_start = 0;
+        m_journal_epoch = (EEPROM[JOURNAL_HEAD_ADDRESS + JOURNAL_RECORD_SIZE - 1] == 0)? 1 : 0;
+
+        EEPROM[JOURNAL_START_ADDRESS] = m_journal_start;
+        eeprom_busy_wait();
+
+        EEPROM[JOURNAL_EPOCH_ADDRESS] = m_journal_epoch;
+        eeprom_busy_wait();
+    }
+
+    int16_t* fields = reinterpret_cast<int16_t*>(m_SETTINGS);
+
+    for (m_journal_length = 0; m_journal_length < JOURNAL_RECORDS; m_journal_length++)
+    {
+        const uint16_t address = m_recordAddress(m_journal_length);
+        const uint8_t  field   = EEPROM[address + 2];
+
+        if (   (EEPROM[address + 3] != m_journal_epoch)
+            || (field >= SETTINGS_SUM) )
+        {
+            break;
+        }
+
+        fields[field] = EEPROM[address] | (static_cast<uint16_t>(EEPROM[address + 1]) << 8);
+    }
+
+    m_journal_written = JOURNAL_RECORD_SIZE;
+
+    memset(m_dirty, 0, sizeof(m_dirty));
+}
+
+
+void PLEN2::JointController::m_markDirty(const int16_t& field)
+{
+    const uint8_t index = &field - &(m_SETTINGS[0].MIN);
+
+    m_dirty[index / 8] |= (1 << (index % 8));
+}
+
+
+bool PLEN2::JointController::m_appendRecord()
+{
+    if (m_journal_written == JOURNAL_RECORD_SIZE)
+    {
+        uint8_t byte = 0;
+
+        while (   (byte < sizeof(m_dirty))
+               && (m_dirty[byte] == 0) )
+        {
+            byte++;
+        }
+
+        if (byte == sizeof(m_dirty))
+        {
+            return false;
+        }
+
+        uint8_t field = byte * 8;
+
+        while (!(m_dirty[byte] & (1 << (field % 8))))
+        {
+            field++;
+        }
+
+        // The journal is full, so fold it into the joint settings before appending.
+        if (m_journal_length == JOURNAL_RECORDS)
+        {
+            m_beginFold();
+
+            return true;
+        }
+
+        m_dirty[field / 8] &= ~(1 << (field % 8));
+
+        const uint16_t value = reinterpret_cast<const int16_t*>(m_SETTINGS)[field];
+
+        m_journal_record[0] = value & 0xFF;
+        m_journal_record[1] = value >> 8;
+        m_journal_record[2] = field;
+        m_journal_record[3] = m_journal_epoch;
+        m_journal_written   = 0;
+    }
+
+    // The epoch is written last, so a record cut by power down is not valid.
+    EEPROM[m_recordAddress(m_journal_length) + m_journal_written].update(m_journal_record[m_journal_written]);
+    m_journal_written++;
+
+    if (m_journal_written == JOURNAL_RECORD_SIZE)
+    {
+        m_journal_length++;
+    }
+
+    return true;
+}
+
+
+void PLEN2::JointController::m_beginFold()
+{
+    /*!
+        @note
+        A record being appended is abandoned, because its value is folded too.
+        Its epoch is not written yet, so it is not valid.
+    */
+    m_folded          = 0;
+    m_journal_written = JOURNAL_RECORD_SIZE;
+
+    memset(m_dirty, 0, sizeof(m_dirty));
+}
+
+
+void PLEN2::JointController::m_flushJournal()
+{
+    for (;;)
+    {
+        eeprom_busy_wait();
+
+        if (m_folded != FOLD_IDLE)
+        {
+            m_foldSettings();
+        }
+        else if (!m_appendRecord())
+        {
+            break;
+        }
+    }
+}
+
+
+void PLEN2::JointController::m_startEpoch()
+{
+    if (m_journal_length == 0)
+    {
+        return;
+    }
+
+    m_journal_start = (m_journal_start + m_journal_length) % JOURNAL_RECORDS;
+    m_journal_epoch = (m_journal_epoch + 1) % JOURNAL_EPOCH_SUM;
+    m_journal_length = 0;
+
+    // The epoch is written last, so the records of the last epoch stay valid until then.
+    EEPROM[JOURNAL_START_ADDRESS] = m_journal_start;
+    eeprom_busy_wait();
+
+    EEPROM[JOURNAL_EPOCH_ADDRESS] = m_journal_epoch;
+    eeprom_busy_wait();
+}
+
+
+void PLEN2::JointController::m_foldSettings()
+{
+    const uint8_t* filler = reinterpret_cast<const uint8_t*>(m_SETTINGS);
+
+    // Bytes not changed are skipped, and a byte changed is written per call.
+    while (m_folded < sizeof(m_SETTINGS))
+    {
+        const uint16_t address = SETTINGS_HEAD_ADDRESS + m_folded;
+        const uint8_t  value   = filler[m_folded++];
+
+        if (EEPROM[address] != value)
+        {
+            EEPROM[address] = value;
+
+            return;
+        }
+    }
+
+    EEPROM[INIT_FLAG_ADDRESS].update(INIT_FLAG_VALUE);
+    eeprom_busy_wait();
+
+    m_folded = FOLD_IDLE;
+
+    m_startEpoch();
+}
+
+
+void PLEN2::JointController::m_compactJournal()
+{
+    #if DEBUG
+        PROFILING("JointController::m_compactJournal()");
+    #endif
+
+
+    m_beginFold();
+
+    while (m_folded != FOLD_IDLE)
+    {
+        eeprom_busy_wait();
+        m_foldSettings();
+    }
+}
+
+
+void PLEN2::JointController::m_fillFrames()
+{
+    /*!
+        @note
+        Both of the frames are filled, so the vector outputs the angles set at once
+        even if it has not started yet, or a frame committed is waiting for swapping.
+    */
+    cli();
+
+    for (uint8_t joint_id = 0; joint_id < JOINTS_SUM; joint_id++)
+    {
+        m_frames[0][joint_id] = m_frames[1][joint_id] = m_pwms[joint_id];
+    }
+
+    m_frame_committed = false;
+
+    sei();
+}
+
+
+void PLEN2::JointController::m_configureTimer()
+{
     /*
         @brief Configure timer 1
 
@@ -146,17 +690,31 @@ void PLEN2::JointController::loadSettings()
     cli();
 
     TCCR1A =
-        _BV(WGM11)  | _BV(WGM10)  | // Set mode to "10bit fast PWM".
+        _BV(WGM11)  |               // Set mode to "fast PWM, TOP = ICR1".
         _BV(COM1A1) | _BV(COM1A0) | // Set OC1A to HIGH when compare matched.
         _BV(COM1B1) | _BV(COM1B0) | // Set OC1B to HIGH when compare matched.
         _BV(COM1C1) | _BV(COM1C0);  // Set OC1C to HIGH when compare matched.
 
-    TCCR1B = 
-        _BV(WGM12) |                // Set mode to "10bit fast PWM".
+    TCCR1B =
+        _BV(WGM13) | _BV(WGM12) |   // Set mode to "fast PWM, TOP = ICR1".
         _BV(CS11)  | _BV(CS10);     // Set prescaler to 64.
 
+    const uint16_t top = pgm_read_word(Shared::REFRESH_TOP + m_refresh_mode);
+
+    ICR1  = top;
+    TCNT1 = 0;
+    Shared::pwm_offset = Shared::PWM_TOP - top;
+
     TIFR1 = _BV(OCF1A) | _BV(OCF1B) | _BV(OCF1C) | _BV(TOV1); // Clearing interruption flag.
 
+    /*
+        @brief Configure timer 3
+
+        Timer 3 runs without prescaler, to count CPU cycles taken by timer 1 overflow vector.
+    */
+    TCCR3A = 0;                     // Set mode to "normal".
+    TCCR3B = _BV(CS30);             // Set prescaler to 1.
+
     sei();
 
     TIMSK1 = _BV(TOIE1); // Begin timer 1.
@@ -170,25 +728,84 @@ void PLEN2::JointController::resetSettings()
     #endif
 
 
-    EEPROM[INIT_FLAG_ADDRESS] = INIT_FLAG_VALUE;
+    if (!m_calibration_loaded)
+    {
+        m_readJournal();
+    }
+
+    /*!
+        @note
+        The default settings are not written, and the journal is dropped by starting the next epoch,
+        so resetting writes a few cells instead of all settings.
+        (A record being appended is abandoned, and its epoch is not written yet.)
+    */
+    EEPROM[INIT_FLAG_ADDRESS].update(INIT_FLAG_DEFAULTS);
     eeprom_busy_wait();
 
-    for (uint8_t index = 0; index < sizeof(Shared::m_SETTINGS_INITIAL); index++)
+    m_folded          = FOLD_IDLE;
+    m_journal_written = JOURNAL_RECORD_SIZE;
+    memset(m_dirty, 0, sizeof(m_dirty));
+
+    m_startEpoch();
+
+    /*!
+        @note
+        Only cells calibrated are erased, so resetting doesn't wear the others.
+    */
+    for (uint16_t index = 0; index < JOINTS_SUM * CALIBRATION_POINTS * sizeof(uint16_t); index++)
     {
-        EEPROM[SETTINGS_HEAD_ADDRESS + index] = pgm_read_byte(
-            reinterpret_cast<const uint8_t*>(Shared::m_SETTINGS_INITIAL) + index
-        );
+        EEPROM[CALIBRATION_HEAD_ADDRESS + index].update(0xFF);
         eeprom_busy_wait();
     }
 
+    m_calibration_loaded = true;
+
     for (uint8_t joint_id = 0; joint_id < JOINTS_SUM; joint_id++)
     {
         m_SETTINGS[joint_id].MIN  = pgm_read_word(Shared::m_SETTINGS_INITIAL + joint_id * 3 + 0);
         m_SETTINGS[joint_id].MAX  = pgm_read_word(Shared::m_SETTINGS_INITIAL + joint_id * 3 + 1);
         m_SETTINGS[joint_id].HOME = pgm_read_word(Shared::m_SETTINGS_INITIAL + joint_id * 3 + 2);
 
+        m_updateTransform(joint_id);
         setAngle(joint_id, m_SETTINGS[joint_id].HOME);
     }
+
+    m_fillFrames();
+}
+
+
+void PLEN2::JointController::persistSettings()
+{
+    if (   !m_calibration_loaded
+        || !eeprom_is_ready() )
+    {
+        return;
+    }
+
+    if (m_folded != FOLD_IDLE)
+    {
+        m_foldSettings();
+    }
+    else
+    {
+        m_appendRecord();
+    }
+}
+
+
+void PLEN2::JointController::commitSettings()
+{
+    #if DEBUG
+        PROFILING("JointController::commitSettings()");
+    #endif
+
+
+    if (!m_calibration_loaded)
+    {
+        return;
+    }
+
+    m_compactJournal();
 }
 
 
@@ -285,20 +902,7 @@ bool PLEN2::JointController::setMinAngle(uint8_t joint_id, int16_t angle)
 
 
     m_SETTINGS[joint_id].MIN = angle;
-
-    uint8_t* filler = reinterpret_cast<uint8_t*>(&(m_SETTINGS[joint_id].MIN));
-    uint16_t address_offset = reinterpret_cast<uint16_t>(filler) - reinterpret_cast<uint16_t>(m_SETTINGS);
-
-    #if DEBUG
-        System::debugSerial().print(F(">>> address_offset : "));
-        System::debugSerial().println(address_offset);
-    #endif
-
-    for (uint8_t index = 0; index < sizeof(m_SETTINGS[joint_id].MIN); index++)
-    {
-        EEPROM[SETTINGS_HEAD_ADDRESS + address_offset + index] = filler[index];
-        eeprom_busy_wait();
-    }
+    m_markDirty(m_SETTINGS[joint_id].MIN);
 
     return true;
 }
@@ -334,20 +938,7 @@ bool PLEN2::JointController::setMaxAngle(uint8_t joint_id, int16_t angle)
 
 
     m_SETTINGS[joint_id].MAX = angle;
-
-    uint8_t* filler = reinterpret_cast<uint8_t*>(&(m_SETTINGS[joint_id].MAX));
-    uint16_t address_offset = reinterpret_cast<uint16_t>(filler) - reinterpret_cast<uint16_t>(m_SETTINGS);
-
-    #if DEBUG
-        System::debugSerial().print(F(">>> address_offset : "));
-        System::debugSerial().println(address_offset);
-    #endif
-
-    for (uint8_t index = 0; index < sizeof(m_SETTINGS[joint_id].MAX); index++)
-    {
-        EEPROM[SETTINGS_HEAD_ADDRESS + address_offset + index] = filler[index];
-        eeprom_busy_wait();
-    }
+    m_markDirty(m_SETTINGS[joint_id].MAX);
 
     return true;
 }
@@ -383,21 +974,158 @@ bool PLEN2::JointController::setHomeAngle(uint8_t joint_id, int16_t angle)
 
 
     m_SETTINGS[joint_id].HOME = angle;
+    m_markDirty(m_SETTINGS[joint_id].HOME);
+
+    return true;
+}
 
-    uint8_t* filler = reinterpret_cast<uint8_t*>(&(m_SETTINGS[joint_id].HOME));
-    uint16_t address_offset = reinterpret_cast<uint16_t>(filler) - reinterpret_cast<uint16_t>(m_SETTINGS);
 
+bool PLEN2::JointController::setSettings(const int16_t settings[])
+{
     #if DEBUG
-        System::debugSerial().print(F(">>> address_offset : "));
-        System::debugSerial().println(address_offset);
+        PROFILING("JointController::setSettings()");
     #endif
 
-    for (uint8_t index = 0; index < sizeof(m_SETTINGS[joint_id].HOME); index++)
+
+    for (uint8_t joint_id = 0; joint_id < JOINTS_SUM; joint_id++)
     {
-        EEPROM[SETTINGS_HEAD_ADDRESS + address_offset + index] = filler[index];
-        eeprom_busy_wait();
+        const int16_t min  = settings[joint_id * 3 + 0];
+        const int16_t max  = settings[joint_id * 3 + 1];
+        const int16_t home = settings[joint_id * 3 + 2];
+
+        if (   (min <  ANGLE_MIN)
+            || (max >  ANGLE_MAX)
+            || (min >= max)
+            || (home < min)
+            || (home > max) )
+        {
+            #if DEBUG
+                System::debugSerial().print(F(">>> bad argment! : joint_id = "));
+                System::debugSerial().println(static_cast<int>(joint_id));
+            #endif
+
+            return false;
+        }
+    }
+
+    for (uint8_t joint_id = 0; joint_id < JOINTS_SUM; joint_id++)
+    {
+        m_SETTINGS[joint_id].MIN  = settings[joint_id * 3 + 0];
+        m_SETTINGS[joint_id].MAX  = settings[joint_id * 3 + 1];
+        m_SETTINGS[joint_id].HOME = settings[joint_id * 3 + 2];
+    }
+
+    if (m_calibration_loaded)
+    {
+        m_beginFold();
+    }
+
+    return true;
+}
+
+
+int16_t PLEN2::JointController::getCalibration(uint8_t joint_id, uint8_t point)
+{
+    #if DEBUG
+        PROFILING("JointController::getCalibration()");
+    #endif
+
+
+    if (   (joint_id >= JOINTS_SUM)
+        || (point >= CALIBRATION_POINTS) )
+    {
+        #if DEBUG
+            System::debugSerial().print(F(">>> bad argment! : joint_id = "));
+            System::debugSerial().print(static_cast<int>(joint_id));
+            System::debugSerial().print(F(", point = "));
+            System::debugSerial().println(static_cast<int>(point));
+        #endif
+
+        return Shared::ERROR_LVALUE;
+    }
+
+    uint16_t pwms[CALIBRATION_POINTS];
+
+    m_loadCalibration(joint_id, pwms);
+    Shared::interpolateCalibration(pwms);
+
+    return pwms[point];
+}
+
+
+bool PLEN2::JointController::setCalibration(uint8_t joint_id, uint8_t point, uint16_t pwm)
+{
+    #if DEBUG
+        PROFILING("JointController::setCalibration()");
+    #endif
+
+
+    if (   (joint_id >= JOINTS_SUM)
+        || (point >= CALIBRATION_POINTS)
+        || ((pwm > Shared::PWM_TOP) && (pwm != PWM_UNCALIBRATED)) )
+    {
+        #if DEBUG
+            System::debugSerial().print(F(">>> bad argment! : joint_id = "));
+            System::debugSerial().print(static_cast<int>(joint_id));
+            System::debugSerial().print(F(", point = "));
+            System::debugSerial().print(static_cast<int>(point));
+            System::debugSerial().print(F(", pwm = "));
+            System::debugSerial().println(pwm);
+        #endif
+
+        return false;
+    }
+
+    if (!m_calibration_loaded)
+    {
+        #if DEBUG
+            System::debugSerial().println(F(">>> error : Calibration is not loaded yet."));
+        #endif
+
+        return false;
+    }
+
+    uint16_t pwms[CALIBRATION_POINTS];
+
+    m_loadCalibration(joint_id, pwms);
+    pwms[point] = pwm;
+    Shared::interpolateCalibration(pwms);
+
+    for (uint8_t segment = 0; segment < (CALIBRATION_POINTS - 1); segment++)
+    {
+        #if CLOCK_WISE
+            const int16_t pwm_range = pwms[segment + 1] - pwms[segment];
+        #else
+            const int16_t pwm_range = pwms[segment] - pwms[segment + 1];
+        #endif
+
+        // A pulse must fit in the period of a line. (See setRefreshMode().)
+        if (   (pwm_range < 0)
+            || (pwm_range >= CALIBRATION_SPAN)
+            || (pwms[segment] < Shared::pwm_offset)
+            || (pwms[segment + 1] < Shared::pwm_offset) )
+        {
+            #if DEBUG
+                System::debugSerial().print(F(">>> bad argment! : pwm_range = "));
+                System::debugSerial().println(pwm_range);
+            #endif
+
+            return false;
+        }
     }
 
+
+    const uint16_t address = CALIBRATION_HEAD_ADDRESS
+        + (joint_id * CALIBRATION_POINTS + point) * sizeof(uint16_t);
+
+    EEPROM[address + 0] = pwm & 0xFF;
+    eeprom_busy_wait();
+
+    EEPROM[address + 1] = pwm >> 8;
+    eeprom_busy_wait();
+
+    m_updateTransform(joint_id);
+
     return true;
 }
 
@@ -422,13 +1150,7 @@ bool PLEN2::JointController::setAngle(uint8_t joint_id, int16_t angle)
 
     angle = constrain(angle, m_SETTINGS[joint_id].MIN, m_SETTINGS[joint_id].MAX);
 
-    m_pwms[joint_id] = map(angle, ANGLE_MIN, ANGLE_MAX,
-        #if CLOCK_WISE
-            PWM_MIN, PWM_MAX
-        #else
-            PWM_MAX, PWM_MIN
-        #endif
-    );
+    m_pwms[joint_id] = m_angle2PWM(joint_id, angle);
 
     return true;
 }
@@ -457,18 +1179,40 @@ bool PLEN2::JointController::setAngleDiff(uint8_t joint_id, int16_t angle_diff)
         m_SETTINGS[joint_id].MIN, m_SETTINGS[joint_id].MAX
     );
 
-    m_pwms[joint_id] = map(angle, ANGLE_MIN, ANGLE_MAX,
-        #if CLOCK_WISE
-            PWM_MIN, PWM_MAX
-        #else
-            PWM_MAX, PWM_MIN
-        #endif
-    );
+    m_pwms[joint_id] = m_angle2PWM(joint_id, angle);
 
     return true;
 }
 
 
+void PLEN2::JointController::commitFrame()
+{
+    #if DEBUG_HARD
+        PROFILING("JointController::commitFrame()");
+    #endif
+
+
+    /*!
+        @note
+        The committed flag is cleared before writing the back frame,
+        so the vector never swaps the frames while the back frame is half-written.
+    */
+    cli();
+
+    m_frame_committed = false;
+    uint16_t* back = m_frames[m_frame_front ^ 1];
+
+    sei();
+
+    for (uint8_t joint_id = 0; joint_id < JOINTS_SUM; joint_id++)
+    {
+        back[joint_id] = m_pwms[joint_id];
+    }
+
+    m_frame_committed = true;
+}
+
+
 void PLEN2::JointController::dump()
 {
     #if DEBUG
@@ -495,7 +1239,22 @@ void PLEN2::JointController::dump()
         System::outputSerial().println(F(","));
 
         System::outputSerial().print(F("\t\t\"home\": "));
-        System::outputSerial().println(m_SETTINGS[joint_id].HOME);
+        System::outputSerial().print(m_SETTINGS[joint_id].HOME);
+        System::outputSerial().println(F(","));
+
+        System::outputSerial().print(F("\t\t\"calibration\": ["));
+
+        for (uint8_t point = 0; point < CALIBRATION_POINTS; point++)
+        {
+            System::outputSerial().print(getCalibration(joint_id, point));
+
+            if (point != (CALIBRATION_POINTS - 1))
+            {
+                System::outputSerial().print(F(", "));
+            }
+        }
+
+        System::outputSerial().println(F("]"));
 
         System::outputSerial().print(F("\t}"));
 
@@ -513,12 +1272,119 @@ void PLEN2::JointController::dump()
 }
 
 
+bool PLEN2::JointController::setRefreshMode(uint8_t mode)
+{
+    #if DEBUG
+        PROFILING("JointController::setRefreshMode()");
+    #endif
+
+
+    if (mode >= REFRESH_MODE_SUM)
+    {
+        #if DEBUG
+            System::debugSerial().print(F(">>> bad argment! : mode = "));
+            System::debugSerial().println(static_cast<int>(mode));
+        #endif
+
+        return false;
+    }
+
+    const uint16_t pwm_offset = Shared::PWM_TOP - pgm_read_word(Shared::REFRESH_TOP + mode);
+
+    /*!
+        @note
+        A curve is monotonic, so its smallest PWM width is at either endpoint.
+    */
+    for (uint8_t joint_id = 0; joint_id < JOINTS_SUM; joint_id++)
+    {
+        if (   (static_cast<uint16_t>(getCalibration(joint_id, 0)) < pwm_offset)
+            || (static_cast<uint16_t>(getCalibration(joint_id, CALIBRATION_POINTS - 1)) < pwm_offset) )
+        {
+            #if DEBUG
+                System::debugSerial().print(F(">>> error : A pulse is too long for the mode. joint_id = "));
+                System::debugSerial().println(static_cast<int>(joint_id));
+            #endif
+
+            return false;
+        }
+    }
+
+    m_refresh_mode = mode;
+    m_configureTimer();
+
+    return true;
+}
+
+
+uint8_t PLEN2::JointController::getRefreshMode()
+{
+    return m_refresh_mode;
+}
+
+
+uint8_t PLEN2::JointController::getUpdateInterval()
+{
+    return pgm_read_byte(Shared::REFRESH_INTERVAL_MS + m_refresh_mode);
+}
+
+
+uint16_t PLEN2::JointController::getUpdatePeriod()
+{
+    const uint16_t top = pgm_read_word(Shared::REFRESH_TOP + m_refresh_mode);
+
+    return (top + 1) * Shared::TIMER_TICK_US * Multiplexer::SELECTABLE_LINES;
+}
+
+
+void PLEN2::JointController::dumpDiagnostics()
+{
+    #if DEBUG
+        PROFILING("JointController::dumpDiagnostics()");
+    #endif
+
+
+    cli();
+
+    const uint16_t isr_cycles     = Shared::isr_cycles;
+    const uint16_t isr_cycles_max = Shared::isr_cycles_max;
+
+    sei();
+
+    System::outputSerial().println(F("{"));
+
+    System::outputSerial().print(F("\t\"isr_cycles\": "));
+    System::outputSerial().print(isr_cycles);
+    System::outputSerial().println(F(","));
+
+    System::outputSerial().print(F("\t\"isr_cycles_max\": "));
+    System::outputSerial().print(isr_cycles_max);
+    System::outputSerial().println(F(","));
+
+    System::outputSerial().print(F("\t\"port_access\": \""));
+    #if DIRECT_PORT_ACCESS
+        System::outputSerial().print(F("direct"));
+    #else
+        System::outputSerial().print(F("digitalWrite"));
+    #endif
+    System::outputSerial().println(F("\","));
+
+    System::outputSerial().print(F("\t\"update_interval_ms\": "));
+    System::outputSerial().print(getUpdateInterval());
+    System::outputSerial().println(F(","));
+
+    System::outputSerial().print(F("\t\"update_period_us\": "));
+    System::outputSerial().println(getUpdatePeriod());
+
+    System::outputSerial().println(F("}"));
+}
+
+
 /*
     @brief Timer 1 overflow interruption vector
 
     The interruption vector runs at the moment TCNT1 overflowed.
-    In the firmware, 16[MHz] clock source is prescaled by 64, and using 10bit mode,
-    so interruption interval is (16,000,000 / (64 * 1,024))^-1 * 1,000 = 4.096[msec].
+    In the firmware, 16[MHz] clock source is prescaled by 64, and TOP is given by the refresh mode,
+    so interruption interval is (16,000,000 / (64 * (TOP + 1)))^-1 * 1,000 = 4.096[msec] if TOP is 1,023.
 
     The value is too smaller than servo's PWM acceptable interval,
     so the firmware can control 24 servos by outputting PWM once in 8 times
@@ -535,6 +1401,8 @@ ISR(TIMER1_OVF_vect)
 {
     using namespace PLEN2;
 
+    const uint16_t cycles_begin = TCNT3;
+
     /*
         @attention
         **joint_select** looks ahead next joint considering double-buffering.
@@ -550,24 +1418,52 @@ ISR(TIMER1_OVF_vect)
         @sa
         PLEN2::JointController::loadSettings()
     */
-    digitalWrite(Pin::MULTIPLEXER_SELECT0, bitRead(output_select, 0));
-    digitalWrite(Pin::MULTIPLEXER_SELECT1, bitRead(output_select, 1));
-    digitalWrite(Pin::MULTIPLEXER_SELECT2, bitRead(output_select, 2));
+    #if DIRECT_PORT_ACCESS
+        selectMultiplexer<
+            Pin::MULTIPLEXER_SELECT0, Pin::MULTIPLEXER_SELECT1, Pin::MULTIPLEXER_SELECT2
+        >(output_select);
+    #else
+        digitalWrite(Pin::MULTIPLEXER_SELECT0, bitRead(output_select, 0));
+        digitalWrite(Pin::MULTIPLEXER_SELECT1, bitRead(output_select, 1));
+        digitalWrite(Pin::MULTIPLEXER_SELECT2, bitRead(output_select, 2));
+    #endif
+
+    const uint16_t  pwm_offset = Shared::pwm_offset;
+    const uint16_t* pwms       = JointController::m_frames[JointController::m_frame_front];
 
-    PLEN2_JOINTCONTROLLER_PWM_OUT_00_07_REGISTER = JointController::m_pwms[
+    PLEN2_JOINTCONTROLLER_PWM_OUT_00_07_REGISTER = pwms[
         joint_select + 0 * JointController::Multiplexer::SELECTABLE_LINES
-    ];
+    ] - pwm_offset;
 
-    PLEN2_JOINTCONTROLLER_PWM_OUT_08_15_REGISTER = JointController::m_pwms[
+    PLEN2_JOINTCONTROLLER_PWM_OUT_08_15_REGISTER = pwms[
         joint_select + 1 * JointController::Multiplexer::SELECTABLE_LINES
-    ];
+    ] - pwm_offset;
 
-    PLEN2_JOINTCONTROLLER_PWM_OUT_16_23_REGISTER = JointController::m_pwms[
+    PLEN2_JOINTCONTROLLER_PWM_OUT_16_23_REGISTER = pwms[
         joint_select + 2 * JointController::Multiplexer::SELECTABLE_LINES
-    ];
+    ] - pwm_offset;
 
     (++output_select) &= (JointController::Multiplexer::SELECTABLE_LINES - 1);
     (++joint_select)  &= (JointController::Multiplexer::SELECTABLE_LINES - 1);
 
-    (joint_select == 0)? (JointController::m_1cycle_finished = true) : false;
+    /*
+        @attention
+        Frames are swapped only between cycles (after the last line is written),
+        so every joint in a cycle outputs the same frame.
+    */
+    if (joint_select == 0)
+    {
+        if (JointController::m_frame_committed)
+        {
+            JointController::m_frame_front   ^= 1;
+            JointController::m_frame_committed = false;
+        }
+
+        JointController::m_1cycle_finished = true;
+    }
+
+    const uint16_t cycles = TCNT3 - cycles_begin;
+
+    Shared::isr_cycles = cycles;
+    (cycles > Shared::isr_cycles_max)? (Shared::isr_cycles_max = cycles) : 0;
 }
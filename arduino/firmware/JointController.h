@@ -68,6 +68,40 @@ public:
         #endif
     };
 
+    //! @brief Summation of the joint settings (MIN, MAX and HOME of each joint, in the order)
+    enum { SETTINGS_SUM = JOINTS_SUM * 3 };
+
+    /*!
+        @brief Settings of PWM calibration
+
+        Each joint has a calibration curve, which is piecewise-linear through PWM widths
+        at CALIBRATION_POINTS angles spaced at CALIBRATION_SPAN from ANGLE_MIN to ANGLE_MAX.
+        A point can be left "uncalibrated" (PWM_UNCALIBRATED, that is also the value of erased EEPROM).
+        An uncalibrated endpoint has PWM_MIN or PWM_MAX as before,
+        and an uncalibrated point between them lies on the line between its calibrated neighbors.
+    */
+    enum CALIBRATION_SETTINGS
+    {
+        CALIBRATION_POINTS = 5, //!< Summation of the points of a calibration curve.
+        CALIBRATION_SPAN   = (ANGLE_MAX - ANGLE_MIN) / (CALIBRATION_POINTS - 1), //!< Angle between the points.
+        PWM_UNCALIBRATED   = 0xFFFF //!< PWM width that means the point is uncalibrated.
+    };
+
+    /*!
+        @brief Refresh modes of servos
+
+        Timer 1 outputs PWM of a line of the multiplexers in each period (TOP + 1) of it,
+        so a servo gets a pulse once in 8 periods. A pulse is up to (1,024 - PWM_MIN) * 4[usec] long,
+        so the period of a line can't be shorter than it. (16[msec] per servo is out of reach.)
+    */
+    enum REFRESH_MODE
+    {
+        REFRESH_32MS,    //!< 4.096[msec] per line, and 32.768[msec] per servo. (The original timing.)
+        REFRESH_24MS,    //!< 3.000[msec] per line, and 24[msec] per servo.
+        REFRESH_20MS,    //!< 2.500[msec] per line, and 20[msec] per servo.
+        REFRESH_MODE_SUM //!< Summation of the modes.
+    };
+
 private:
     //! @brief Initialized flag's address on internal EEPROM
     enum { INIT_FLAG_ADDRESS = 0 };
@@ -75,6 +109,9 @@ private:
     //! @brief Initialized flag's value
     enum { INIT_FLAG_VALUE = 2 };
 
+    //! @brief Initialized flag's value, that means the joint settings on internal EEPROM are not written yet (the defaults)
+    enum { INIT_FLAG_DEFAULTS = 3 };
+
     //! @brief Head-address of joint settings on internal EEPROM
     enum { SETTINGS_HEAD_ADDRESS = 1 };
 
@@ -102,6 +139,91 @@ private:
 
     JointSetting m_SETTINGS[JOINTS_SUM];
 
+    //! @brief Head-address of PWM calibration on internal EEPROM (next to the joint settings)
+    enum { CALIBRATION_HEAD_ADDRESS = SETTINGS_HEAD_ADDRESS + sizeof(JointSetting) * JOINTS_SUM };
+
+    /*!
+        @brief Settings of the journal of joint settings on internal EEPROM
+
+        A change of a setting is appended to the journal as a record | value (2) | field | epoch |
+        instead of rewriting the same cells, and the records are folded into the joint settings
+        (only bytes changed) when the journal is full. (Compaction)
+        The fields are SETTINGS_SUM settings in the order of m_SETTINGS.
+        The journal is a ring, and each compaction starts the next epoch after the last record,
+        so appending wears all cells of the ring evenly.
+        A record is valid only if its epoch is the current one, and the epoch is written last,
+        so the records are read from the start until the first record not valid.
+    */
+    enum JOURNAL_SETTINGS
+    {
+        JOURNAL_EPOCH_ADDRESS = CALIBRATION_HEAD_ADDRESS + JOINTS_SUM * CALIBRATION_POINTS * sizeof(uint16_t), //!< Address of the current epoch.
+        JOURNAL_START_ADDRESS = JOURNAL_EPOCH_ADDRESS + 1, //!< Address of the first record of the epoch.
+        JOURNAL_HEAD_ADDRESS  = JOURNAL_START_ADDRESS + 1, //!< Head-address of the records.
+        JOURNAL_RECORD_SIZE   = 4,
+        JOURNAL_RECORDS       = (1024 - JOURNAL_HEAD_ADDRESS) / JOURNAL_RECORD_SIZE, //!< Summation of the records of the ring.
+        JOURNAL_EPOCH_SUM     = 0xFF //!< Summation of epochs. (0xFF is erased EEPROM, so it is never used.)
+    };
+
+    /*!
+        @note
+        The next epoch begins after the last record, and each epoch has one record at least,
+        so a record after the last one was written in one of the last JOURNAL_RECORDS epochs,
+        that differ from the current one. (See m_startEpoch().)
+    */
+    typedef char JOURNAL_RECORDS_needs_to_be_under_JOURNAL_EPOCH_SUM[(JOURNAL_RECORDS < JOURNAL_EPOCH_SUM)? 1 : -1];
+
+    //! @brief Fractional bits of Transform::SCALE
+    enum { TRANSFORM_PRECISION = 16 };
+
+    /*!
+        @brief Precomputed transform from an angle to PWM width, on the calibration curve of a joint
+
+        PWM width on a segment is given by (PWM width at the segment's begin)
+        +/- (((angle - angle at the segment's begin) * SCALE[segment]) >> TRANSFORM_PRECISION),
+        so converting an angle costs one 16x16 multiply and a shift instead of map()'s 32bit division.
+        With the default calibration, the result is bit-exact with map() in the range of angles.
+
+        Only the width at the curve's begin is stored, and the width at a segment's begin is
+        accumulated from the segments before it, that is exact since (CALIBRATION_SPAN * SCALE) >> TRANSFORM_PRECISION
+        equals the segment's range. It takes 10 bytes of RAM per joint instead of 16.
+    */
+    class Transform
+    {
+    public:
+        uint16_t PWM_BEGIN;                         //!< PWM width at the curve's begin.
+        uint16_t SCALE[CALIBRATION_POINTS - 1];     //!< Width of PWM per angle on each segment, that has TRANSFORM_PRECISION fractional bits.
+    };
+
+    Transform m_transforms[JOINTS_SUM];
+    bool      m_calibration_loaded;
+    uint8_t   m_refresh_mode;
+
+    uint8_t m_journal_epoch;
+    uint8_t m_journal_start;
+    uint8_t m_journal_length;                      //!< Count of the records of the epoch.
+    uint8_t m_journal_record[JOURNAL_RECORD_SIZE]; //!< Record being appended.
+    uint8_t m_journal_written;                     //!< Bytes of the record written, or JOURNAL_RECORD_SIZE if no record is being appended.
+    uint8_t m_dirty[(SETTINGS_SUM + 7) / 8];         //!< Bitmap of the fields changed but not appended yet.
+    uint8_t m_folded;                              //!< Bytes of the joint settings folded by the compaction, or FOLD_IDLE.
+
+    //! @brief Value of m_folded while no compaction runs
+    enum { FOLD_IDLE = 0xFF };
+
+    uint16_t m_recordAddress(uint8_t index);
+    void     m_markDirty(const int16_t& field);
+    bool     m_appendRecord();
+    void     m_beginFold();
+    void     m_flushJournal();
+    void     m_startEpoch();
+    void     m_foldSettings();
+    void     m_compactJournal();
+    void     m_readJournal();
+    void     m_configureTimer();
+    void     m_fillFrames();
+    void     m_updateTransform(uint8_t joint_id);
+    void     m_loadCalibration(uint8_t joint_id, uint16_t pwms[]);
+    uint16_t m_angle2PWM(uint8_t joint_id, int16_t angle);
+
 public:
     /*!
         @brief Management class (as namespace) of multiplexer
@@ -155,12 +277,33 @@ public:
     /*!
         @brief PWM buffer
 
+        Values are on the scale of 10bit mode (TOP = 1,023) whatever the refresh mode is.
+        The buffer is only written by the methods, and the vector outputs it after commitFrame().
+
+        @attention
+        You must not access it from other functions basically.
+    */
+    static uint16_t m_pwms[JOINTS_SUM];
+
+    /*!
+        @brief PWM frames output by the vector (double-buffering)
+
+        The vector reads only the front frame, m_frames[m_frame_front].
+        commitFrame() copies m_pwms into the back frame and sets m_frame_committed,
+        then the vector swaps the frames at the end of a cycle, so all joints output the same frame in a cycle.
+
         @attention
         The instance should be a private member normally.
         It is a public member because it is the only way to access it from Timer 1 overflow interruption vector,
         so you must not access it from other functions basically.
     */
-    static uint16_t m_pwms[JOINTS_SUM];
+    static uint16_t m_frames[2][JOINTS_SUM];
+
+    //! @brief Index of the front frame (see m_frames)
+    volatile static uint8_t m_frame_front;
+
+    //! @brief Committed flag of the back frame (see m_frames)
+    volatile static bool m_frame_committed;
 
     /*!
         @brief Constructor
@@ -170,8 +313,9 @@ public:
     /*!
         @brief Load the joint settings
 
-        The method reads joint settings from internal EEPROM.
-        If the EEPROM has no settings, the method also writes the default values.
+        The method reads joint settings from internal EEPROM, and replays the journal over them.
+        If the EEPROM has no settings, the default values are used. (They are written at the first compaction.)
+        Settings changed but not persisted yet are appended to the journal before reading.
 
         @sa
         JointController.cpp::Shared::m_SETTINGS_INITIAL
@@ -186,10 +330,32 @@ public:
     /*!
         @brief Reset the joint settings
 
-        Write default settings to internal EEPROM.
+        Write default settings to internal EEPROM. (The calibration is also reset.)
     */
     void resetSettings();
 
+    /*!
+        @brief Persist a part of the joint settings changed
+
+        setMinAngle(), setMaxAngle() and setHomeAngle() change the settings in RAM, and the method appends them
+        to the journal on internal EEPROM, a byte per call while the EEPROM is ready, so it never waits for a write cycle.
+        A setting changed again before it is appended is appended only once with the last value.
+        When the journal is full, it is compacted a byte changed per call in the same way.
+
+        @attention
+        Please call the method in the main loop. Settings not appended yet are lost at power down,
+        so call commitSettings() to make sure that all of them are persisted.
+    */
+    void persistSettings();
+
+    /*!
+        @brief Commit all joint settings changed
+
+        The method appends all changed settings and folds the journal into the joint settings on internal EEPROM,
+        writing only bytes changed. (It waits for the write cycles.)
+    */
+    void commitSettings();
+
     /*!
         @brief Get min angle of the joint given
 
@@ -227,6 +393,9 @@ public:
         @param [in] angle    Please set angle that has steps of degree 1/10.
 
         @return Result
+
+        @note
+        The setting is persisted by persistSettings() later.
     */
     bool setMinAngle(uint8_t joint_id, int16_t angle);
 
@@ -237,6 +406,9 @@ public:
         @param [in] angle    Please set angle that has steps of degree 1/10.
 
         @return Result
+
+        @note
+        The setting is persisted by persistSettings() later.
     */
     bool setMaxAngle(uint8_t joint_id, int16_t angle);
 
@@ -247,9 +419,57 @@ public:
         @param [in] angle    Please set angle that has steps of degree 1/10.
 
         @return Result
+
+        @note
+        The setting is persisted by persistSettings() later.
     */
     bool setHomeAngle(uint8_t joint_id, int16_t angle);
 
+    /*!
+        @brief Set min, max and home angles of all joints at once
+
+        @param [in] settings Please set SETTINGS_SUM angles, that are min, max and home angle of each joint in the order.
+
+        @return Result
+
+        @attention
+        All settings are validated before any of them is changed, so if a joint violates
+        ANGLE_MIN <= min < max <= ANGLE_MAX or min <= home <= max, the method fails and nothing is changed.
+
+        @note
+        The settings changed are folded into internal EEPROM directly by persistSettings(),
+        writing only bytes changed in one pass.
+    */
+    bool setSettings(const int16_t settings[]);
+
+    /*!
+        @brief Get PWM width at a point of the calibration curve of the joint given
+
+        @param [in] joint_id Please set the joint id from which you want to get the calibration.
+        @param [in] point    Please set index of the point. (0 is ANGLE_MIN, and CALIBRATION_POINTS - 1 is ANGLE_MAX.)
+
+        @return PWM width at the point. (An uncalibrated point gives the width interpolated.)
+        @retval -32768 Argument error. (**joint_id** or **point** is invalid.)
+    */
+    int16_t getCalibration(uint8_t joint_id, uint8_t point);
+
+    /*!
+        @brief Set PWM width at a point of the calibration curve of the joint given
+
+        @param [in] joint_id Please set the joint id from which you want to define the calibration.
+        @param [in] point    Please set index of the point. (0 is ANGLE_MIN, and CALIBRATION_POINTS - 1 is ANGLE_MAX.)
+        @param [in] pwm      Please set PWM width that makes the angle of the point,
+                             or PWM_UNCALIBRATED to make the point uncalibrated.
+
+        @return Result
+
+        @attention
+        The curve must be monotonic in the direction of the servos,
+        and PWM width between neighboring points must differ by less than CALIBRATION_SPAN.
+        If the curve given violates them, the method fails and nothing is changed.
+    */
+    bool setCalibration(uint8_t joint_id, uint8_t point, uint16_t pwm);
+
     /*!
         @brief Set angle of the joint given
 
@@ -280,6 +500,54 @@ public:
     */
     bool setAngleDiff(uint8_t joint_id, int16_t angle_diff);
 
+    /*!
+        @brief Commit angles set to the servos
+
+        Angles set by setAngle() or setAngleDiff() are output from the next cycle after the method called,
+        so angles set between two calls are output together.
+    */
+    void commitFrame();
+
+    /*!
+        @brief Set refresh mode of the servos
+
+        Timer 1 is restarted with the period of the mode,
+        so a pulse being output at the time might be cut.
+
+        @param [in] mode Please set a value of REFRESH_MODE.
+
+        @return Result
+
+        @attention
+        The mode is rejected if a calibrated PWM width of any joint doesn't fit in the period of a line.
+    */
+    bool setRefreshMode(uint8_t mode);
+
+    /*!
+        @brief Get refresh mode of the servos
+
+        @return A value of REFRESH_MODE.
+    */
+    uint8_t getRefreshMode();
+
+    /*!
+        @brief Get update interval of motions, that follows the refresh mode
+
+        @return Interval [msec]
+    */
+    uint8_t getUpdateInterval();
+
+    /*!
+        @brief Get exact period of updates, that follows the refresh mode
+
+        @return Period [usec]
+
+        @note
+        The interval of 32[msec] is 32.768[msec] on the clock, so timing that must not drift
+        against real time should be counted by the period instead of the interval.
+    */
+    uint16_t getUpdatePeriod();
+
     /*!
         @brief Dump the joint settings
 
@@ -290,13 +558,31 @@ public:
                 "@device": <integer>,
                 "max": <integer>,
                 "min": <integer>,
-                "home": <integer>
+                "home": <integer>,
+                "calibration": [<integer>, ...]
             },
             ...
         ]
         @endcode
     */
     void dump();
+
+    /*!
+        @brief Dump diagnostics of PWM output
+
+        Output result in JSON format as below.
+        (Cycles are measured by timer 3 without prescaler, so they are CPU cycles.)
+        @code
+        {
+            "isr_cycles": <integer>,
+            "isr_cycles_max": <integer>,
+            "port_access": <string>,
+            "update_interval_ms": <integer>,
+            "update_period_us": <integer>
+        }
+        @endcode
+    */
+    void dumpDiagnostics();
 };
 
 #endif // PLEN2_JOINT_CONTROLLER_H
@@ -11,12 +11,14 @@
 
 #include <Arduino.h>
 
+#include "BuildConfig.h"
 #include "ExternalEEPROM.h"
 #include "Motion.h"
 #include "JointController.h"
+#include "Parser.h"
+#include "System.h"
 
 #if DEBUG
-    #include "System.h"
     #include "Profiler.h"
 #endif
 
@@ -39,60 +41,1685 @@ namespace
         enum { VALUE = 0 };
     };
 
-    template<typename T>
-    struct SIZE_SUP
+    template<typename T, const int UNIT>
+    struct COUNT_SUP
     {
-        enum { VALUE = sizeof(T) % ExternalEEPROM::SLOT_SIZE };
+        enum { VALUE = sizeof(T) / UNIT + IF<sizeof(T) % UNIT>::VALUE };
     };
 
+    /*!
+        @brief Compile-time check that a type fits in a block
+
+        The array size becomes negative (so compiling fails) if the type is larger than a block.
+    */
     template<typename T>
-    struct SLOT_COUNT
+    struct FITS_IN_BLOCK
     {
-        enum
-        {
-            VALUE = sizeof(T) / ExternalEEPROM::SLOT_SIZE + IF<SIZE_SUP<T>::VALUE>::VALUE
-        };
+        typedef char CHECK[(sizeof(T) <= ExternalEEPROM::BLOCK_SIZE)? 1 : -1];
     };
 
+    typedef FITS_IN_BLOCK<Header>::CHECK HEADER_FITS_IN_BLOCK;
+    typedef FITS_IN_BLOCK<Frame>::CHECK  FRAME_FITS_IN_BLOCK;
+
+
+    typedef char EXTENTS_FILL_BLOCK[(ExternalEEPROM::BLOCK_SIZE % sizeof(Extent) == 0)? 1 : -1];
+
+
+    /*!
+        @brief Storage layout of motions
+
+        Each motion is given an extent, a run of blocks from its header to its last frame,
+        so a header and each frame are written by one page program.
+        Extents are allocated from the first block, and the allocation table follows them.
+        The last block keeps the version of the layout.
+    */
     enum
     {
-        SLOT_COUNT_HEADER = SLOT_COUNT<Header>::VALUE,
-        SLOT_COUNT_FRAME  = SLOT_COUNT<Frame>::VALUE,
-        SLOT_COUNT_MOTION = SLOT_COUNT_HEADER + SLOT_COUNT_FRAME * Header::FRAMELENGTH_MAX
+        BLOCK_LAYOUT      = ExternalEEPROM::BLOCK_END - 1,
+        EXTENTS_PER_BLOCK = ExternalEEPROM::BLOCK_SIZE / sizeof(Extent),
+        BLOCK_COUNT_TABLE = (SLOT_END + EXTENTS_PER_BLOCK - 1) / EXTENTS_PER_BLOCK,
+        BLOCK_TABLE       = BLOCK_LAYOUT - BLOCK_COUNT_TABLE,
+        BLOCK_DATA_END    = BLOCK_TABLE, //!< Ending value of the blocks allocated to motions.
+
+        //! Count of chunks a frame is read by. (A chunk bounds the time of a step of prefetching.)
+        CHUNK_COUNT_FRAME = COUNT_SUP<Frame, ExternalEEPROM::CHUNK_SIZE>::VALUE
     };
-}
 
+    /*!
+        @brief Integrity records in blocks
 
-namespace PLEN2
-{
-namespace Motion
-{
+        A header block is | header | CRC (2) |, and a frame block is | frame | CRC (2) |.
+        The last block of an extent ends with the seal (2) (see Motion::validate()),
+        and the length (2) of delta-compressed frames is before it.
+    */
+    enum
+    {
+        CRC_SIZE      = sizeof(uint16_t),
+        SEAL_OFFSET   = ExternalEEPROM::BLOCK_SIZE - CRC_SIZE,
+        LENGTH_OFFSET = SEAL_OFFSET - sizeof(uint16_t),
+        TAIL_SIZE     = ExternalEEPROM::BLOCK_SIZE - LENGTH_OFFSET,
+        SEAL_SEED     = 0xFFFF
+    };
+
+    typedef char FRAME_FITS_BEFORE_TAIL[(sizeof(Frame) + CRC_SIZE <= LENGTH_OFFSET)? 1 : -1];
+    typedef char FRAME_TAIL_FITS_IN_CHUNK[
+        (sizeof(Frame) - ExternalEEPROM::CHUNK_SIZE * (CHUNK_COUNT_FRAME - 1) + CRC_SIZE <= ExternalEEPROM::CHUNK_SIZE)? 1 : -1
+    ];
+
+    /*!
+        @brief Legacy storage layout of motions
+
+        Firmware 1.4.1 and earlier divided a header and frames into slots, and wrote them slot by slot.
+        Motions are migrated to fixed blocks for a header and 20 frames of each slot, that are given to them as extents.
+    */
+    enum
+    {
+        LEGACY_FRAMELENGTH_MAX    = 20,
+        LEGACY_SLOT_COUNT_HEADER  = COUNT_SUP<Header, ExternalEEPROM::SLOT_SIZE>::VALUE,
+        LEGACY_SLOT_COUNT_FRAME   = COUNT_SUP<Frame, ExternalEEPROM::SLOT_SIZE>::VALUE,
+        LEGACY_SLOT_COUNT_MOTION  = LEGACY_SLOT_COUNT_HEADER + LEGACY_SLOT_COUNT_FRAME * LEGACY_FRAMELENGTH_MAX,
+        LEGACY_BLOCK_COUNT_MOTION = 1 + LEGACY_FRAMELENGTH_MAX
+    };
+
+    enum LAYOUT_VERSION
+    {
+        LAYOUT_VERSION_SLOT = 1,   //!< Legacy layout of slots, being migrated.
+        LAYOUT_VERSION_CRC  = 4,   //!< Current layout.
+        LAYOUT_VERSION_NONE = 0xFF //!< Erased block. (Regarded as the legacy layout of slots.)
+    };
+
+    enum { MOVING_NONE = 0xFF };
+
+    struct LayoutRecord
+    {
+        uint8_t  version;     //!< Version of the layout.
+        uint8_t  progress;    //!< Motions from the slot to the end have been migrated.
+        uint8_t  moving;      //!< Slot whose motion is being moved by defragment(), or MOVING_NONE.
+        uint16_t moving_to;   //!< First block the motion is moved to.
+        uint16_t moving_done; //!< Count of blocks of the motion that have been moved.
+    };
+
+
+    /*!
+        @brief LRU cache of motions read from external EEPROM
+
+        An entry keeps the header of a slot and the frames of the slot read so far.
+        A slot gets an entry when its header is read (e.g. by MotionController::play()),
+        and the entry used least recently is given to it. Writing a header or a frame drops the entry of the slot.
+    */
+    namespace Cache
+    {
+        struct Entry
+        {
+            bool     valid;
+            uint8_t  slot;
+            uint32_t stamp;                      //!< Time the entry was used last, counted by reads.
+            uint32_t frames;                     //!< Bitmask of the frames cached.
+            Header   header;
+            Extent   extent;
+            Frame    frame[MOTION_CACHE_FRAMES];
+        };
+
+        #if MOTION_CACHE_SLOTS > 0
+            Entry    entries[MOTION_CACHE_SLOTS];
+            uint32_t clock = 0;
+            uint32_t hits  = 0;
+
+            //! The frame being read by chunks, that is cached when its last chunk is read.
+            bool    filling = false;
+            uint8_t filling_slot;
+            uint8_t filling_index;
+        #endif
+
+        uint32_t misses = 0; //!< It counts reads of external EEPROM even if the cache is disabled.
+
+        Entry* find(uint8_t slot)
+        {
+            #if MOTION_CACHE_SLOTS > 0
+                for (uint8_t entry_id = 0; entry_id < MOTION_CACHE_SLOTS; entry_id++)
+                {
+                    if (   (entries[entry_id].valid)
+                        && (entries[entry_id].slot == slot) )
+                    {
+                        return &entries[entry_id];
+                    }
+                }
+            #else
+                (void)slot;
+            #endif
+
+            return NULL;
+        }
+
+        Entry* allocate(uint8_t slot)
+        {
+            #if MOTION_CACHE_SLOTS > 0
+                Entry* victim = &entries[0];
+
+                for (uint8_t entry_id = 0; entry_id < MOTION_CACHE_SLOTS; entry_id++)
+                {
+                    if (!entries[entry_id].valid)
+                    {
+                        victim = &entries[entry_id];
+
+                        break;
+                    }
+
+                    if (entries[entry_id].stamp < victim->stamp)
+                    {
+                        victim = &entries[entry_id];
+                    }
+                }
+
+                victim->valid  = true;
+                victim->slot   = slot;
+                victim->frames = 0;
+
+                return victim;
+            #else
+                (void)slot;
+
+                return NULL;
+            #endif
+        }
+
+        inline void touch(Entry& entry)
+        {
+            #if MOTION_CACHE_SLOTS > 0
+                entry.stamp = ++clock;
+            #else
+                (void)entry;
+            #endif
+        }
+
+        inline void hit(Entry& entry)
+        {
+            touch(entry);
+
+            #if MOTION_CACHE_SLOTS > 0
+                hits++;
+            #endif
+        }
+
+        inline bool hasFrame(const Entry* entry, uint8_t index)
+        {
+            return (entry != NULL)
+                && (index < MOTION_CACHE_FRAMES)
+                && (entry->frames & (1UL << index));
+        }
+
+        void invalidate(uint8_t slot)
+        {
+            Entry* entry = find(slot);
+
+            if (entry != NULL)
+            {
+                entry->valid = false;
+            }
+
+            #if MOTION_CACHE_SLOTS > 0
+                if (filling_slot == slot)
+                {
+                    filling = false;
+                }
+            #endif
+        }
+
+        void clear()
+        {
+            #if MOTION_CACHE_SLOTS > 0
+                for (uint8_t entry_id = 0; entry_id < MOTION_CACHE_SLOTS; entry_id++)
+                {
+                    entries[entry_id].valid = false;
+                }
+
+                filling = false;
+            #endif
+        }
+    }
+
+
+    inline uint16_t frameBlock(const Extent& extent, uint8_t index)
+    {
+        return extent.first + 1 + index;
+    }
+
+    inline uint16_t legacyHeaderBlock(uint8_t slot)
+    {
+        return static_cast<uint16_t>(slot) * LEGACY_BLOCK_COUNT_MOTION;
+    }
+
+    inline uint16_t crcOf(const void* data, uint8_t size, uint16_t crc = SEAL_SEED)
+    {
+        return Utility::crc16(reinterpret_cast<const uint8_t*>(data), size, crc);
+    }
+
+    inline uint16_t loadWord(const uint8_t* bytes)
+    {
+        return bytes[0] | (static_cast<uint16_t>(bytes[1]) << 8);
+    }
+
+    inline void storeWord(uint8_t* bytes, uint16_t value)
+    {
+        bytes[0] = value & 0xFF;
+        bytes[1] = value >> 8;
+    }
+
+    //! Chain a CRC of a header or a frame to a seal.
+    inline uint16_t chain(uint16_t crc, uint16_t seal)
+    {
+        uint8_t bytes[CRC_SIZE];
+        storeWord(bytes, crc);
+
+        return crcOf(bytes, CRC_SIZE, seal);
+    }
+
+    /*!
+        @brief Queue writing a block, and wait only while the queue is full
+
+        The write is carried out by ExternalEEPROM::poll() in loop(),
+        so installing a motion does not stall for each write cycle.
+    */
+    int8_t queueBlock(uint16_t block, const void* data, uint8_t write_size, uint8_t offset = 0)
+    {
+        int8_t result;
+
+        while ((result = ExternalEEPROM::submitWriteBlock(
+            block, reinterpret_cast<const uint8_t*>(data), write_size, offset
+        )) == 1)
+        {
+            ExternalEEPROM::poll();
+        }
+
+        return result;
+    }
+
+    /*!
+        @brief Read an instance stored with the legacy layout
+
+        @param [in]  first_slot First slot number of the instance.
+        @param [out] data       Pointer of the instance.
+        @param [in]  size       Size of the instance.
+    */
+    bool getLegacy(uint16_t first_slot, void* data, uint8_t size)
+    {
+        uint8_t* filler = reinterpret_cast<uint8_t*>(data);
+
+        for (uint8_t done = 0; done < size; done += ExternalEEPROM::SLOT_SIZE)
+        {
+            const uint8_t read_size = ((size - done) > ExternalEEPROM::SLOT_SIZE)?
+                ExternalEEPROM::SLOT_SIZE : (size - done);
+
+            if (ExternalEEPROM::readSlot(first_slot++, filler + done, read_size) == -1)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+    /*!
+        @brief Allocation table of extents
+
+        The table is an array of Extent indexed by slot, in BLOCK_COUNT_TABLE blocks from BLOCK_TABLE.
+        An entry is rewritten after the blocks it points to, so a reset never leaves it pointing to blocks not written.
+        An entry is read and written in place, so the table keeps no block in RAM.
+    */
+    namespace Table
+    {
+        uint16_t high_water;               //!< Block after the extent at the highest address.
+        bool     high_water_valid = false;
+
+        inline uint16_t blockOf(uint8_t slot)
+        {
+            return BLOCK_TABLE + slot / EXTENTS_PER_BLOCK;
+        }
+
+        inline uint8_t offsetOf(uint8_t slot)
+        {
+            return (slot % EXTENTS_PER_BLOCK) * sizeof(Extent);
+        }
+
+        inline bool isAllocated(const Extent& extent)
+        {
+            return (extent.first  != Extent::FIRST_NONE)
+                && (extent.blocks != 0)
+                && (static_cast<uint32_t>(extent.first) + extent.blocks <= BLOCK_DATA_END);
+        }
+
+        bool read(uint8_t slot, Extent& extent)
+        {
+            if (ExternalEEPROM::readBlock(
+                    blockOf(slot), reinterpret_cast<uint8_t*>(&extent), sizeof(Extent), offsetOf(slot)
+                ) == -1)
+            {
+                return false;
+            }
+
+            if (!isAllocated(extent))
+            {
+                extent.first  = Extent::FIRST_NONE;
+                extent.blocks = 0;
+            }
+
+            return true;
+        }
+
+        //! Keep the high-water mark when the blocks after an extent are released.
+        inline void shrink(const Extent& extent, uint16_t blocks)
+        {
+            if (   (high_water_valid)
+                && (extent.first + extent.blocks == high_water) )
+            {
+                high_water = extent.first + blocks;
+            }
+        }
+
+        bool write(uint8_t slot, const Extent& extent)
+        {
+            if (   (high_water_valid)
+                && (isAllocated(extent))
+                && (extent.first + extent.blocks > high_water) )
+            {
+                high_water = extent.first + extent.blocks;
+            }
+
+            return (queueBlock(blockOf(slot), &extent, sizeof(Extent), offsetOf(slot)) == 0);
+        }
+
+        /*!
+            @brief Call visitor.visit(slot, extent) for each slot that has an extent
+
+            The table is read block by block.
+        */
+        template<typename VISITOR>
+        bool scan(VISITOR& visitor)
+        {
+            Extent entries[EXTENTS_PER_BLOCK];
+
+            for (uint8_t table_block = 0; table_block < BLOCK_COUNT_TABLE; table_block++)
+            {
+                if (ExternalEEPROM::readBlock(
+                        BLOCK_TABLE + table_block, reinterpret_cast<uint8_t*>(entries), ExternalEEPROM::BLOCK_SIZE
+                    ) == -1)
+                {
+                    return false;
+                }
+
+                for (uint8_t entry_id = 0; entry_id < EXTENTS_PER_BLOCK; entry_id++)
+                {
+                    const uint8_t slot = table_block * EXTENTS_PER_BLOCK + entry_id;
+
+                    if (   (slot < SLOT_END)
+                        && (isAllocated(entries[entry_id])) )
+                    {
+                        visitor.visit(slot, entries[entry_id]);
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        struct End
+        {
+            uint16_t end;
+
+            void visit(uint8_t, const Extent& extent)
+            {
+                (extent.first + extent.blocks > end)? (end = extent.first + extent.blocks) : 0;
+            }
+        };
+
+        struct Usage
+        {
+            uint16_t blocks;
+
+            void visit(uint8_t, const Extent& extent)
+            {
+                blocks += extent.blocks;
+            }
+        };
+
+        //! Find the extent at the lowest address from a block.
+        struct Lowest
+        {
+            uint16_t from;
+            bool     found;
+            uint8_t  slot;
+            Extent   extent;
+
+            void visit(uint8_t slot_, const Extent& extent_)
+            {
+                if (   (extent_.first >= from)
+                    && (!found || (extent_.first < extent.first)) )
+                {
+                    found  = true;
+                    slot   = slot_;
+                    extent = extent_;
+                }
+            }
+        };
+
+        bool highWater(uint16_t& block)
+        {
+            if (!high_water_valid)
+            {
+                End visitor = { 0 };
+
+                if (!scan(visitor))
+                {
+                    return false;
+                }
+
+                high_water       = visitor.end;
+                high_water_valid = true;
+            }
+
+            block = high_water;
+
+            return true;
+        }
+
+        /*!
+            @brief Move the blocks of an extent to a lower address
+
+            Blocks are copied by runs no longer than the distance, so a run never overwrites the blocks
+            not copied yet. The progress is recorded after each run, and moving resumes from it after a reset.
+
+            @param [in] done Count of blocks that have been moved.
+        */
+        bool move(uint8_t slot, const Extent& extent, uint16_t to, uint16_t done)
+        {
+            const uint16_t distance = extent.first - to;
+
+            LayoutRecord record;
+            record.version     = LAYOUT_VERSION_CRC;
+            record.progress    = SLOT_BEGIN;
+            record.moving      = slot;
+            record.moving_to   = to;
+            record.moving_done = done;
+
+            uint8_t buffer[ExternalEEPROM::BLOCK_SIZE];
+
+            while (done < extent.blocks)
+            {
+                const uint16_t run_end = ((extent.blocks - done) > distance)? (done + distance) : extent.blocks;
+
+                for (; done < run_end; done++)
+                {
+                    if (   (ExternalEEPROM::readBlock(extent.first + done, buffer, ExternalEEPROM::BLOCK_SIZE) == -1)
+                        || (queueBlock(to + done, buffer, ExternalEEPROM::BLOCK_SIZE) != 0) )
+                    {
+                        return false;
+                    }
+                }
+
+                record.moving_done = done;
+                queueBlock(BLOCK_LAYOUT, &record, sizeof(record));
+            }
+
+            const Extent moved = { to, extent.blocks };
+
+            if (!write(slot, moved))
+            {
+                return false;
+            }
+
+            record.moving = MOVING_NONE;
+
+            return (queueBlock(BLOCK_LAYOUT, &record, sizeof(record)) == 0);
+        }
+
+        /*!
+            @brief Allocate an extent to a slot
+
+            The extent of the slot is reused if it is large enough. Otherwise blocks after the highest extent are allocated,
+            and the blocks released before them are left until defragment() packs the motions.
+
+            @param [in] current Extent of the slot. (See read().)
+        */
+        bool allocate(const Extent& current, uint16_t blocks, Extent& extent)
+        {
+            if (   (isAllocated(current))
+                && (current.blocks >= blocks) )
+            {
+                extent.first  = current.first;
+                extent.blocks = blocks;
+
+                shrink(current, blocks);
+
+                return true;
+            }
+
+            uint16_t first;
+
+            if (   !highWater(first)
+                || (static_cast<uint32_t>(first) + blocks > BLOCK_DATA_END) )
+            {
+                return false;
+            }
+
+            extent.first  = first;
+            extent.blocks = blocks;
+
+            return true;
+        }
+    }
+
+
+    /*!
+        @brief Read the header and the extent of a slot, through the motion cache
+
+        @return Result (false if the slot has no motion, or the CRC of the header doesn't match)
+    */
+    bool load(uint8_t slot, Header& header, Extent& extent)
+    {
+        Cache::Entry* entry = Cache::find(slot);
+
+        if (entry != NULL)
+        {
+            header = entry->header;
+            extent = entry->extent;
+
+            Cache::hit(*entry);
+
+            return true;
+        }
+
+        if (   !Table::read(slot, extent)
+            || !Table::isAllocated(extent) )
+        {
+            return false;
+        }
+
+        uint8_t record[sizeof(Header) + CRC_SIZE];
+
+        if (   (ExternalEEPROM::readBlock(extent.first, record, sizeof(record)) == -1)
+            || (crcOf(record, sizeof(Header)) != loadWord(record + sizeof(Header))) )
+        {
+            return false;
+        }
+
+        memcpy(&header, record, sizeof(Header));
+
+        Cache::misses++;
+
+        entry = Cache::allocate(slot);
+
+        if (entry != NULL)
+        {
+            entry->header = header;
+            entry->extent = extent;
+
+            Cache::touch(*entry);
+        }
+
+        return true;
+    }
+
+
+    /*!
+        @brief Delta-compressed frames of a slot with Header::use_delta
+
+        The frame blocks of the slot make a byte stream, and frames are packed into it in order:
+        | transition_time_ms (2) | easing (1) | joint mask (3) | zigzag varint of each joint in the mask |
+        with little endian. A joint in the mask is given by its difference from the previous frame,
+        and the others keep their angles. The first frame and the first frame of the loop are key frames,
+        given by differences from 0, so a loop restarts without decoding the frames before it.
+
+        Frames are read and written through a cursor that keeps the position in the stream
+        and the angles of the previous frame, so reading frames in order decodes each of them once.
+        (The cursor also keeps the extent of the slot, so plain frames are read and written through it too.)
+        The reader and the writer share the cursor to save RAM. If the reader takes it while frames are appended
+        (e.g. a motion is played while another one is installed), the writer decodes the frames written again to resume.
+    */
+    namespace Delta
+    {
+        enum
+        {
+            KEY_UNKNOWN = 0xFFFF,
+            MASK_SIZE   = (JointController::JOINTS_SUM + 7) / 8,
+            HEAD_SIZE   = sizeof(uint16_t) + sizeof(uint8_t) + MASK_SIZE,
+            RECORD_MAX  = HEAD_SIZE + 3 * JointController::JOINTS_SUM        //!< A varint of int16_t takes 3 bytes at most.
+        };
+
+        struct Cursor
+        {
+            bool     valid;
+            bool     delta;        //!< The slot uses delta-compressed frames.
+            uint8_t  slot;
+            uint8_t  frame_length;
+            uint8_t  key_index;    //!< Index of the key frame that begins the loop. (0 without loop.)
+            uint16_t key_offset;   //!< Offset of the key frame, or KEY_UNKNOWN until it is passed.
+            uint8_t  index;        //!< Index of the frame at the offset.
+            uint16_t offset;
+            int16_t  angle[JointController::JOINTS_SUM]; //!< Angles of the frame before the offset.
+            Extent   extent;
+            uint16_t stream_size;  //!< Size of the frame blocks of the extent.
+            uint16_t header_crc;
+            uint16_t seal;         //!< Seal of the frames written in order so far. (Used by the writer.)
+            bool     sealing;      //!< The frames have been written in order from the first one.
+            bool     writing;      //!< The position is the writer's. (It is false after the reader moves the cursor.)
+        };
+
+        Cursor cursor;
+
+        uint8_t append_slot  = SLOT_END; //!< Slot that delta-compressed frames are appended to. (It is kept while the reader has the cursor.)
+        uint8_t append_index = 0;        //!< Index of the frame appended next.
+
+        inline bool usesDelta(const Header& header)
+        {
+            return (header.use_delta) && (header.NON_RESERVED == 0);
+        }
+
+        void prime(Cursor& cursor, uint8_t slot, const Header& header, const Extent& extent)
+        {
+            cursor.valid        = true;
+            cursor.delta        = usesDelta(header);
+            cursor.slot         = slot;
+            cursor.frame_length = header.frame_length;
+            cursor.key_index    = (header.use_loop)? header.loop_begin : 0;
+            cursor.key_offset   = (cursor.key_index == 0)? 0 : static_cast<uint16_t>(KEY_UNKNOWN);
+            cursor.index        = 0;
+            cursor.offset       = 0;
+            cursor.extent       = extent;
+            cursor.stream_size  = (extent.blocks - 1) * ExternalEEPROM::BLOCK_SIZE;
+            cursor.header_crc   = crcOf(&header, sizeof(Header));
+            cursor.seal         = chain(cursor.header_crc, SEAL_SEED);
+            cursor.sealing      = true;
+            cursor.writing      = false;
+        }
+
+        /*!
+            @brief Make the cursor point to the slot
+
+            @return Result (false if the slot has no motion, or the header of the slot can't be read)
+        */
+        bool open(uint8_t slot)
+        {
+            if (   (cursor.valid)
+                && (cursor.slot == slot) )
+            {
+                return true;
+            }
+
+            Header header;
+            Extent extent;
+
+            if (!load(slot, header, extent))
+            {
+                return false;
+            }
+
+            prime(cursor, slot, header, extent);
+
+            return true;
+        }
+
+        void invalidate(uint8_t slot)
+        {
+            if (cursor.slot == slot)
+            {
+                cursor.valid = false;
+            }
+
+            if (append_slot == slot)
+            {
+                append_slot = SLOT_END;
+            }
+        }
+
+        inline bool isKey(const Cursor& cursor, uint8_t index)
+        {
+            return (index == 0) || (index == cursor.key_index);
+        }
+
+        /*!
+            @brief Bytes read from the stream of a slot
+
+            Bytes are read by I2C transactions as few as the record needs, and never across a block.
+        */
+        struct Source
+        {
+            const Cursor* cursor;
+            uint16_t offset;   //!< Offset of the next byte.
+            uint8_t  buffer[ExternalEEPROM::CHUNK_SIZE];
+            uint8_t  position;
+            uint8_t  length;
+            bool     failed;
+
+            Source(const Cursor& cursor_, uint16_t offset_)
+                : cursor(&cursor_)
+                , offset(offset_)
+                , position(0)
+                , length(0)
+                , failed(false)
+            {
+                // noop.
+            }
+
+            /*!
+                @param [in] hint Count of bytes that are likely to be read from now.
+            */
+            uint8_t next(uint8_t hint)
+            {
+                if (position >= length)
+                {
+                    const uint8_t in_block = ExternalEEPROM::BLOCK_SIZE - (offset % ExternalEEPROM::BLOCK_SIZE);
+
+                    length   = (hint < in_block)? hint : in_block;
+                    length   = (length < ExternalEEPROM::CHUNK_SIZE)? length : static_cast<uint8_t>(ExternalEEPROM::CHUNK_SIZE);
+                    position = 0;
+
+                    if (   (offset >= cursor->stream_size)
+                        || (ExternalEEPROM::readBlock(
+                                frameBlock(cursor->extent, offset / ExternalEEPROM::BLOCK_SIZE),
+                                buffer, length, offset % ExternalEEPROM::BLOCK_SIZE
+                            ) == -1) )
+                    {
+                        failed = true;
+                        length = 0;
+
+                        return 0;
+                    }
+                }
+
+                offset++;
+
+                return buffer[position++];
+            }
+        };
+
+        inline uint16_t zigzag(int16_t value)
+        {
+            return (static_cast<uint16_t>(value) << 1) ^ static_cast<uint16_t>(value >> 15);
+        }
+
+        inline int16_t unzigzag(uint16_t value)
+        {
+            return static_cast<int16_t>((value >> 1) ^ (0 - (value & 1)));
+        }
+
+        /*!
+            @brief Decode the frame at the cursor, and advance it
+        */
+        bool decode(Cursor& cursor, Frame& frame)
+        {
+            if (cursor.index >= cursor.frame_length)
+            {
+                return false;
+            }
+
+            const bool key = isKey(cursor, cursor.index);
+
+            if (cursor.index == cursor.key_index)
+            {
+                cursor.key_offset = cursor.offset;
+            }
+
+            Source source(cursor, cursor.offset);
+
+            uint8_t head[HEAD_SIZE];
+
+            for (uint8_t done = 0; done < HEAD_SIZE; done++)
+            {
+                head[done] = source.next(HEAD_SIZE - done);
+            }
+
+            uint8_t masked = 0;
+
+            for (uint8_t byte = 0; byte < MASK_SIZE; byte++)
+            {
+                for (uint8_t bits = head[3 + byte]; bits != 0; bits &= bits - 1)
+                {
+                    masked++;
+                }
+            }
+
+            // Most of differences take 1 or 2 bytes.
+            uint8_t hint = masked * 2;
+
+            for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+            {
+                int16_t angle = (key)? 0 : cursor.angle[joint_id];
+
+                if (head[3 + joint_id / 8] & (1 << (joint_id % 8)))
+                {
+                    uint16_t value = 0;
+                    uint8_t  byte;
+
+                    for (uint8_t shift = 0; ; shift += 7)
+                    {
+                        byte   = source.next((hint > 0)? hint : 1);
+                        hint   = (hint > 0)? (hint - 1) : 0;
+                        value |= static_cast<uint16_t>(byte & 0x7F) << shift;
+
+                        if (   !(byte & 0x80)
+                            || (shift >= 14) )
+                        {
+                            break;
+                        }
+                    }
+
+                    angle += unzigzag(value);
+                }
+
+                frame.joint_angle[joint_id] = angle;
+                cursor.angle[joint_id]      = angle;
+            }
+
+            if (source.failed)
+            {
+                cursor.valid = false;
+
+                return false;
+            }
+
+            frame.index              = cursor.index;
+            frame.transition_time_ms = head[0] | (static_cast<uint16_t>(head[1]) << 8);
+            frame.easing             = head[2];
+
+            cursor.index++;
+            cursor.offset = source.offset;
+
+            return true;
+        }
+
+        /*!
+            @brief Move the cursor to a frame of the slot
+
+            The frames before it are decoded from the cursor, or from the nearest key frame before it,
+            so the frame given is overwritten by them.
+        */
+        bool seek(uint8_t index, Frame& frame)
+        {
+            if (index != cursor.index)
+            {
+                const bool key_passed = (cursor.key_offset != KEY_UNKNOWN) && (cursor.key_index <= index);
+
+                if (   (key_passed)
+                    && ((index < cursor.index) || (cursor.index < cursor.key_index)) )
+                {
+                    cursor.index  = cursor.key_index;
+                    cursor.offset = cursor.key_offset;
+                }
+                else if (index < cursor.index)
+                {
+                    cursor.index  = 0;
+                    cursor.offset = 0;
+                }
+            }
+
+            while (cursor.index < index)
+            {
+                if (!decode(cursor, frame))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /*!
+            @brief Read a frame of the slot that the cursor points to
+
+            Frames read in order (and the first frame of the loop) are decoded at once,
+            and the others are decoded from the nearest key frame before them.
+        */
+        bool read(uint8_t index, Frame& frame)
+        {
+            if (index >= cursor.frame_length)
+            {
+                return false;
+            }
+
+            cursor.writing = false;
+
+            return seek(index, frame) && decode(cursor, frame);
+        }
+
+        /*!
+            @brief Move the cursor back to the end of the frames appended, after the reader has moved it
+
+            The frames appended are decoded again, and the seal is chained over their bytes again.
+        */
+        bool resume(uint8_t index)
+        {
+            Frame frame;
+
+            if (!seek(index, frame))
+            {
+                return false;
+            }
+
+            Source   source(cursor, 0);
+            uint16_t seal = chain(cursor.header_crc, SEAL_SEED);
+
+            while (   (source.offset < cursor.offset)
+                   && !source.failed )
+            {
+                const uint16_t rest = cursor.offset - source.offset;
+                const uint8_t  byte = source.next(
+                    (rest < ExternalEEPROM::CHUNK_SIZE)? static_cast<uint8_t>(rest) : static_cast<uint8_t>(ExternalEEPROM::CHUNK_SIZE)
+                );
+
+                seal = crcOf(&byte, sizeof(byte), seal);
+            }
+
+            if (source.failed)
+            {
+                return false;
+            }
+
+            cursor.seal    = seal;
+            cursor.writing = true;
+
+            return true;
+        }
+
+        /*!
+            @brief Append a frame to the slot that the cursor points to
+
+            Frames must be written in order from the first one, after the header.
+            Each record is queued in place by a page program of the blocks it lies on (one per frame mostly, like plain frames),
+            so the writer keeps no block in RAM. The last frame queues the length of the stream and the seal,
+            that chains the bytes of the stream.
+        */
+        bool write(uint8_t index, const Frame& frame)
+        {
+            if (index == 0)
+            {
+                cursor.index   = 0;
+                cursor.offset  = 0;
+                cursor.seal    = chain(cursor.header_crc, SEAL_SEED);
+                cursor.writing = true;
+                append_slot    = cursor.slot;
+                append_index   = 0;
+            }
+
+            if (   (append_slot != cursor.slot)
+                || (index != append_index)
+                || (index >= cursor.frame_length) )
+            {
+                return false;
+            }
+
+            if (   !cursor.writing
+                && !resume(index) )
+            {
+                return false;
+            }
+
+            if (index == cursor.key_index)
+            {
+                cursor.key_offset = cursor.offset;
+            }
+
+            const bool key = isKey(cursor, index);
+
+            uint8_t record[RECORD_MAX];
+            uint8_t length = HEAD_SIZE;
+
+            record[0] = frame.transition_time_ms & 0xFF;
+            record[1] = frame.transition_time_ms >> 8;
+            record[2] = frame.easing;
+
+            for (uint8_t byte = 0; byte < MASK_SIZE; byte++)
+            {
+                record[3 + byte] = 0;
+            }
+
+            for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+            {
+                const int16_t base = (key)? 0 : cursor.angle[joint_id];
+
+                if (frame.joint_angle[joint_id] == base)
+                {
+                    continue;
+                }
+
+                record[3 + joint_id / 8] |= 1 << (joint_id % 8);
+
+                uint16_t value = zigzag(frame.joint_angle[joint_id] - base);
+
+                while (value >= 0x80)
+                {
+                    record[length++] = (value & 0x7F) | 0x80;
+                    value >>= 7;
+                }
+
+                record[length++] = value;
+            }
+
+            const bool last = (index + 1 == cursor.frame_length);
+
+            if (cursor.offset + length + ((last)? TAIL_SIZE : 0) > cursor.stream_size)
+            {
+                return false;
+            }
+
+            cursor.seal = crcOf(record, length, cursor.seal);
+
+            for (uint8_t done = 0; done < length; )
+            {
+                const uint8_t position = cursor.offset % ExternalEEPROM::BLOCK_SIZE;
+                const uint8_t in_block = ExternalEEPROM::BLOCK_SIZE - position;
+                const uint8_t size     = ((length - done) < in_block)? (length - done) : in_block;
+
+                if (queueBlock(frameBlock(cursor.extent, cursor.offset / ExternalEEPROM::BLOCK_SIZE), record + done, size, position) != 0)
+                {
+                    return false;
+                }
+
+                cursor.offset += size;
+                done          += size;
+            }
+
+            for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+            {
+                cursor.angle[joint_id] = frame.joint_angle[joint_id];
+            }
+
+            cursor.index++;
+            append_index++;
+
+            if (last)
+            {
+                uint16_t index_block = cursor.offset / ExternalEEPROM::BLOCK_SIZE;
+
+                // The tail goes to the next block if the last record overlaps it.
+                if ((cursor.offset % ExternalEEPROM::BLOCK_SIZE) > LENGTH_OFFSET)
+                {
+                    index_block++;
+                }
+
+                uint8_t tail[TAIL_SIZE];
+                storeWord(tail,                                 cursor.offset);
+                storeWord(tail + (SEAL_OFFSET - LENGTH_OFFSET), cursor.seal);
+
+                if (queueBlock(frameBlock(cursor.extent, index_block), tail, TAIL_SIZE, LENGTH_OFFSET) != 0)
+                {
+                    return false;
+                }
+
+                // Blocks allocated for the longest frames and not used are released.
+                const uint16_t blocks = 2 + index_block;
+
+                if (blocks < cursor.extent.blocks)
+                {
+                    Table::shrink(cursor.extent, blocks);
+
+                    cursor.extent.blocks = blocks;
+                    cursor.stream_size   = (blocks - 1) * ExternalEEPROM::BLOCK_SIZE;
+
+                    return Table::write(cursor.slot, cursor.extent);
+                }
+            }
+
+            return true;
+        }
+    }
+
+
+    /*!
+        @brief Get count of blocks to allocate to a motion
+
+        Delta-compressed frames are given blocks for the longest records, until the last frame is written.
+    */
+    inline uint16_t blocksOf(const Header& header)
+    {
+        if (Delta::usesDelta(header))
+        {
+            return 1 + (static_cast<uint16_t>(header.frame_length) * Delta::RECORD_MAX + TAIL_SIZE + ExternalEEPROM::BLOCK_SIZE - 1)
+                / ExternalEEPROM::BLOCK_SIZE;
+        }
+
+        return 1 + header.frame_length;
+    }
+
+
+    /*!
+        @brief Validity of slots, decided by the seals of motions (see Motion::validate())
+    */
+    namespace Seal
+    {
+        uint8_t bitmap[(SLOT_END + 7) / 8];
+
+        inline bool isValid(uint8_t slot)
+        {
+            return bitmap[slot / 8] & (1 << (slot % 8));
+        }
+
+        inline void mark(uint8_t slot, bool valid)
+        {
+            if (valid)
+            {
+                bitmap[slot / 8] |= (1 << (slot % 8));
+            }
+            else
+            {
+                bitmap[slot / 8] &= ~(1 << (slot % 8));
+            }
+        }
+
+        inline uint16_t lastBlock(const Extent& extent)
+        {
+            return extent.first + extent.blocks - 1;
+        }
+
+        /*!
+            @brief Chain the CRCs of frames stored
+
+            @param [in] count Count of frames from the first one.
+        */
+        bool ofFrames(const Extent& extent, uint8_t count, uint16_t header_crc, uint16_t& seal)
+        {
+            seal = chain(header_crc, SEAL_SEED);
+
+            for (uint8_t index = 0; index < count; index++)
+            {
+                uint8_t crc[CRC_SIZE];
+
+                if (ExternalEEPROM::readBlock(frameBlock(extent, index), crc, CRC_SIZE, sizeof(Frame)) == -1)
+                {
+                    return false;
+                }
+
+                seal = chain(loadWord(crc), seal);
+            }
+
+            return true;
+        }
+
+        //! Chain the bytes of delta-compressed frames stored.
+        bool ofStream(const Extent& extent, uint16_t length, uint16_t header_crc, uint16_t& seal)
+        {
+            seal = chain(header_crc, SEAL_SEED);
+
+            uint8_t buffer[ExternalEEPROM::CHUNK_SIZE];
+
+            for (uint16_t offset = 0; offset < length; )
+            {
+                const uint8_t in_block = ExternalEEPROM::BLOCK_SIZE - (offset % ExternalEEPROM::BLOCK_SIZE);
+
+                uint8_t size = (in_block < ExternalEEPROM::CHUNK_SIZE)? in_block : static_cast<uint8_t>(ExternalEEPROM::CHUNK_SIZE);
+                size = ((length - offset) < size)? (length - offset) : size;
+
+                if (ExternalEEPROM::readBlock(
+                        frameBlock(extent, offset / ExternalEEPROM::BLOCK_SIZE),
+                        buffer, size, offset % ExternalEEPROM::BLOCK_SIZE
+                    ) == -1)
+                {
+                    return false;
+                }
+
+                seal    = crcOf(buffer, size, seal);
+                offset += size;
+            }
+
+            return true;
+        }
+
+        /*!
+            @brief Decide if the motion of a slot is stored completely
+
+            The header and the tail of the last block are read, and then the CRCs of the frames
+            (or the bytes of delta-compressed frames) are chained to be compared with the seal.
+        */
+        bool check(uint8_t slot)
+        {
+            Extent extent;
+
+            if (   !Table::read(slot, extent)
+                || !Table::isAllocated(extent) )
+            {
+                return false;
+            }
+
+            uint8_t record[sizeof(Header) + CRC_SIZE];
+            uint8_t tail[TAIL_SIZE];
+
+            if (   (ExternalEEPROM::readBlock(extent.first, record, sizeof(record)) == -1)
+                || (ExternalEEPROM::readBlock(lastBlock(extent), tail, TAIL_SIZE, LENGTH_OFFSET) == -1) )
+            {
+                return false;
+            }
+
+            const uint16_t header_crc = loadWord(record + sizeof(Header));
+
+            if (crcOf(record, sizeof(Header)) != header_crc)
+            {
+                return false;
+            }
+
+            const Header& header = *reinterpret_cast<const Header*>(record);
+            uint16_t seal;
+
+            if (Delta::usesDelta(header))
+            {
+                const uint16_t length = loadWord(tail);
+
+                if (   (static_cast<uint32_t>(length) + TAIL_SIZE > static_cast<uint32_t>(extent.blocks - 1) * ExternalEEPROM::BLOCK_SIZE)
+                    || !ofStream(extent, length, header_crc, seal) )
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                if (   (header.frame_length < Header::FRAMELENGTH_MIN)
+                    || (1 + header.frame_length != extent.blocks)
+                    || !ofFrames(extent, header.frame_length, header_crc, seal) )
+                {
+                    return false;
+                }
+            }
+
+            return (seal == loadWord(tail + CRC_SIZE));
+        }
+
+        /*!
+            @brief Write the seal of plain frames again, after a frame before the last one is written
+
+            The CRCs are read after the frame queued, so the seal chains the new one.
+        */
+        bool renew(const Delta::Cursor& cursor)
+        {
+            uint8_t  block_last[ExternalEEPROM::BLOCK_SIZE];
+            uint16_t seal;
+
+            if (   !ofFrames(cursor.extent, cursor.frame_length, cursor.header_crc, seal)
+                || (ExternalEEPROM::readBlock(lastBlock(cursor.extent), block_last, ExternalEEPROM::BLOCK_SIZE) == -1) )
+            {
+                return false;
+            }
+
+            storeWord(block_last + SEAL_OFFSET, seal);
+
+            return (queueBlock(lastBlock(cursor.extent), block_last, ExternalEEPROM::BLOCK_SIZE) == 0);
+        }
+
+    }
+
+
+    /*!
+        @brief Move a motion stored with the legacy layout to its fixed blocks (see Motion::migrateLayout())
+
+        The header and the frames are written with their CRCs and the last frame with the seal,
+        and then the slot is given the blocks as its extent. Empty slots (e.g. erased ones) are skipped.
+    */
+    bool migrateLegacy(uint8_t slot)
+    {
+        const uint16_t first_slot = static_cast<uint16_t>(slot) * LEGACY_SLOT_COUNT_MOTION;
+
+        Header header;
+
+        if (!getLegacy(first_slot, &header, sizeof(Header)))
+        {
+            return false;
+        }
+
+        if (   (header.frame_length < Header::FRAMELENGTH_MIN)
+            || (header.frame_length > LEGACY_FRAMELENGTH_MAX) )
+        {
+            return true;
+        }
+
+        // Legacy motions have no delta-compressed frames.
+        header.use_delta = 0;
+
+        const Extent extent = { legacyHeaderBlock(slot), static_cast<uint16_t>(1 + header.frame_length) };
+
+        uint8_t record[sizeof(Frame) + CRC_SIZE];
+
+        /*!
+            @note
+            Every header and frame moves to a higher address than its legacy one,
+            so moving the frames from the last one and the header after them never overwrites the ones not moved yet.
+        */
+        for (uint8_t index = header.frame_length; index-- > 0; )
+        {
+            Frame& frame = *reinterpret_cast<Frame*>(record);
+
+            if (!getLegacy(
+                first_slot + LEGACY_SLOT_COUNT_HEADER + static_cast<uint16_t>(index) * LEGACY_SLOT_COUNT_FRAME,
+                &frame, sizeof(Frame)
+            ))
+            {
+                return false;
+            }
+
+            // Legacy frames have no easing, and the byte read is the rest of the slot.
+            frame.easing = Frame::EASING_LINEAR;
+
+            storeWord(record + sizeof(Frame), crcOf(&frame, sizeof(Frame)));
+
+            if (queueBlock(frameBlock(extent, index), record, sizeof(Frame) + CRC_SIZE) != 0)
+            {
+                return false;
+            }
+        }
+
+        const uint16_t header_crc = crcOf(&header, sizeof(Header));
+
+        memcpy(record, &header, sizeof(Header));
+        storeWord(record + sizeof(Header), header_crc);
+
+        uint16_t seal;
+
+        if (   (queueBlock(extent.first, record, sizeof(Header) + CRC_SIZE) != 0)
+            || !Seal::ofFrames(extent, header.frame_length, header_crc, seal) )
+        {
+            return false;
+        }
+
+        storeWord(record, seal);
+
+        return (queueBlock(Seal::lastBlock(extent), record, CRC_SIZE, SEAL_OFFSET) == 0)
+            && Table::write(slot, extent);
+    }
+}
+
+
+namespace PLEN2
+{
+namespace Motion
+{
+
+void Header::init(Header& header)
+{
+    #if DEBUG
+        PROFILING("Header::init()");
+    #endif
+
+
+    header.slot              = 0;
+    header.name[0]           = '\0';
+    header.name[NAME_LENGTH] = '\0';
+    header.frame_length      = FRAMELENGTH_MIN;
+    header.NON_RESERVED      = 0;
+    header.use_delta         = 0;
+    header.use_extra         = 0;
+    header.use_jump          = 0;
+    header.use_loop          = 0;
+    header.loop_begin        = 0;
+    header.loop_end          = 0;
+    header.loop_count        = 0;
+    header.jump_slot         = 0;
+}
+
+
+bool Header::set(uint8_t slot, const Header& header)
+{
+    #if DEBUG
+        PROFILING("Header::set()");
+    #endif
+
+
+    if (slot >= SLOT_END)
+    {
+        #if DEBUG
+            System::debugSerial().print(F(">>> bad argument : slot = "));
+            System::debugSerial().println(static_cast<int>(slot));
+        #endif
+
+        return false;
+    }
+
+    // frame_length never exceeds FRAMELENGTH_MAX, that is the maximum value of uint8_t.
+    if (header.frame_length < FRAMELENGTH_MIN)
+    {
+        #if DEBUG
+            System::debugSerial().print(F(">>> bad instance : header.frame_length = "));
+            System::debugSerial().println(static_cast<int>(header.frame_length));
+        #endif
+
+        return false;
+    }
+
+
+    Cache::invalidate(slot);
+    Delta::invalidate(slot);
+    Seal::mark(slot, false);
+
+    Extent current, extent;
+
+    if (   !Table::read(slot, current)
+        || !Table::allocate(current, blocksOf(header), extent) )
+    {
+        #if DEBUG
+            System::debugSerial().print(F(">>> failed : free blocks = "));
+            System::debugSerial().println(getFreeBlocks());
+        #endif
+
+        return false;
+    }
+
+    uint8_t record[sizeof(Header) + CRC_SIZE];
+    memcpy(record, &header, sizeof(Header));
+    storeWord(record + sizeof(Header), crcOf(record, sizeof(Header)));
+
+    // The header is written before the entry of the table, that switches the slot to it.
+    // (A motion installed again with the same length keeps its entry, and the table isn't written.)
+    int8_t result = queueBlock(extent.first, record, sizeof(record));
+
+    const bool moved = (extent.first != current.first) || (extent.blocks != current.blocks);
+
+    if (   (result != 0)
+        || (moved && !Table::write(slot, extent)) )
+    {
+        #if DEBUG
+            System::debugSerial().print(F(">>> failed : result = "));
+            System::debugSerial().println(static_cast<int>(result));
+        #endif
+
+        return false;
+    }
+
+    // Frames written next don't need to read the header back.
+    Delta::prime(Delta::cursor, slot, header, extent);
+
+    return true;
+}
+
+
+bool Header::get(uint8_t slot, Header& header)
+{
+    #if DEBUG
+        PROFILING("Header::get()");
+    #endif
+
+
+    if (slot >= SLOT_END)
+    {
+        #if DEBUG
+            System::debugSerial().print(F(">>> bad argument : slot = "));
+            System::debugSerial().println(static_cast<int>(slot));
+        #endif
+
+        return false;
+    }
+
+
+    Extent extent;
+
+    if (!load(slot, header, extent))
+    {
+        #if DEBUG
+            System::debugSerial().print(F(">>> no motion : slot = "));
+            System::debugSerial().println(static_cast<int>(slot));
+        #endif
+
+        init(header);
+        header.slot = slot;
+
+        return false;
+    }
+
+    return true;
+}
+
+
+bool Frame::set(uint8_t slot, uint8_t index, const Frame& frame)
+{
+    #if DEBUG
+        PROFILING("Frame::set()");
+    #endif
+
+
+    if (slot >= SLOT_END)
+    {
+        #if DEBUG
+            System::debugSerial().print(F(">>> bad argument : slot = "));
+            System::debugSerial().println(static_cast<int>(slot));
+        #endif
+
+        return false;
+    }
+
+    if (!Delta::open(slot))
+    {
+        return false;
+    }
+
+    Cache::invalidate(slot);
+
+    Delta::Cursor& writer = Delta::cursor;
+    const bool     last   = (index + 1 == writer.frame_length);
+
+    if (writer.delta)
+    {
+        if (!Delta::write(index, frame))
+        {
+            #if DEBUG
+                System::debugSerial().print(F(">>> bad argument : index = "));
+                System::debugSerial().println(static_cast<int>(index));
+            #endif
+
+            return false;
+        }
+
+        if (last)
+        {
+            Seal::mark(slot, true);
+        }
+
+        return true;
+    }
+
+    if (   (index >= writer.frame_length)
+        || (1 + index >= writer.extent.blocks) )
+    {
+        #if DEBUG
+            System::debugSerial().print(F(">>> bad argument : index = "));
+            System::debugSerial().println(static_cast<int>(index));
+        #endif
+
+        return false;
+    }
+
+
+    uint8_t record[ExternalEEPROM::BLOCK_SIZE];
+    uint8_t record_size = sizeof(Frame) + CRC_SIZE;
+
+    memcpy(record, &frame, sizeof(Frame));
+
+    const uint16_t crc = crcOf(record, sizeof(Frame));
+    storeWord(record + sizeof(Frame), crc);
+
+    if (   (writer.sealing)
+        && (writer.index == index) )
+    {
+        writer.seal = chain(crc, writer.seal);
+        writer.index++;
+    }
+    else
+    {
+        writer.sealing = false;
+    }
+
+    // The last frame is written with the seal. (The CRCs written are read back if the frames were not in order.)
+    if (last)
+    {
+        uint16_t seal = writer.seal;
+
+        if (!writer.sealing)
+        {
+            if (!Seal::ofFrames(writer.extent, index, writer.header_crc, seal))
+            {
+                return false;
+            }
+
+            seal = chain(crc, seal);
+        }
+
+        memset(record + record_size, 0xFF, SEAL_OFFSET - record_size);
+        storeWord(record + SEAL_OFFSET, seal);
+
+        record_size = ExternalEEPROM::BLOCK_SIZE;
+    }
+
+    int8_t result = queueBlock(frameBlock(writer.extent, index), record, record_size);
+
+    if (result != 0)
+    {
+        #if DEBUG
+            System::debugSerial().print(F(">>> failed : result = "));
+            System::debugSerial().println(static_cast<int>(result));
+        #endif
+
+        Seal::mark(slot, false);
+
+        return false;
+    }
+
+    if (last)
+    {
+        Seal::mark(slot, true);
+    }
+    else if (Seal::isValid(slot))
+    {
+        // A frame of a valid motion is edited.
+        Seal::mark(slot, Seal::renew(writer));
+    }
+
+    return true;
+}
 
-void Header::init(Header& header)
+
+bool Frame::get(uint8_t slot, uint8_t index, Frame& frame)
 {
     #if DEBUG
-        PROFILING("Header::init()");
+        PROFILING("Frame::get()");
     #endif
 
 
-    header.slot              = 0;
-    header.name[0]           = '\0';
-    header.name[NAME_LENGTH] = '\0';
-    header.frame_length      = FRAMELENGTH_MIN;
-    header.use_extra         = 0;
-    header.use_jump          = 0;
-    header.use_loop          = 0;
-    header.loop_begin        = 0;
-    header.loop_end          = 0;
-    header.loop_count        = 0;
-    header.jump_slot         = 0;
+    for (uint8_t chunk = 0; chunk < CHUNK_COUNT_FRAME; chunk++)
+    {
+        if (!getChunk(slot, index, chunk, frame))
+        {
+            return false;
+        }
+    }
+
+    return true;
 }
 
 
-bool Header::set(uint8_t slot, const Header& header)
+uint8_t Frame::chunks()
+{
+    return CHUNK_COUNT_FRAME;
+}
+
+
+bool Frame::getChunk(uint8_t slot, uint8_t index, uint8_t chunk, Frame& frame)
 {
     #if DEBUG
-        PROFILING("Header::set()");
+        PROFILING("Frame::getChunk()");
     #endif
 
 
@@ -106,265 +1733,540 @@ bool Header::set(uint8_t slot, const Header& header)
         return false;
     }
 
-    if (   (header.frame_length < FRAMELENGTH_MIN)
-        || (header.frame_length > FRAMELENGTH_MAX)
-    )
+    if (!Delta::open(slot))
+    {
+        return false;
+    }
+
+    const bool delta = Delta::cursor.delta;
+
+    if (   (index >= Delta::cursor.frame_length)
+        || (!delta && (1 + index >= Delta::cursor.extent.blocks)) )
+    {
+        #if DEBUG
+            System::debugSerial().print(F(">>> bad instance : frame.index = "));
+            System::debugSerial().println(static_cast<int>(index));
+        #endif
+
+        return false;
+    }
+
+    if (chunk >= CHUNK_COUNT_FRAME)
     {
         #if DEBUG
-            System::debugSerial().print(F(">>> bad instance : header.frame_length = "));
-            System::debugSerial().println(static_cast<int>(header.frame_length));
+            System::debugSerial().print(F(">>> bad argument : chunk = "));
+            System::debugSerial().println(static_cast<int>(chunk));
         #endif
 
         return false;
     }
 
 
-    const uint8_t* filler = reinterpret_cast<const uint8_t*>(&header);
+    const uint8_t offset    = ExternalEEPROM::CHUNK_SIZE * chunk;
+    const uint8_t read_size = (chunk == (CHUNK_COUNT_FRAME - 1))?
+        static_cast<uint8_t>(sizeof(Frame) - offset) : static_cast<uint8_t>(ExternalEEPROM::CHUNK_SIZE);
+
+    // Frames of a slot with delta-compressed frames are not cached, because the reader follows them in order.
+    Cache::Entry* entry = (delta)? NULL : Cache::find(slot);
+
+    if (Cache::hasFrame(entry, index))
+    {
+        memcpy(
+            reinterpret_cast<uint8_t*>(&frame) + offset,
+            reinterpret_cast<const uint8_t*>(&entry->frame[index]) + offset,
+            read_size
+        );
+
+        if (chunk == 0)
+        {
+            Cache::hit(*entry);
+        }
+
+        return true;
+    }
+
+
+    int8_t result;
 
-    for (uint16_t count = 0; count < SLOT_COUNT_HEADER; count++)
+    if (delta)
     {
-        int8_t result = ExternalEEPROM::writeSlot(
-            (
-                static_cast<uint16_t>(slot) * SLOT_COUNT_MOTION + count
-            ),
-            (
-                filler + count * ExternalEEPROM::SLOT_SIZE
-            ),
-            (
-                (count == (SLOT_COUNT_HEADER - 1))?
-                    (
-                        (SIZE_SUP<Header>::VALUE)?
-                            SIZE_SUP<Header>::VALUE : ExternalEEPROM::SLOT_SIZE
-                    )
-                    : ExternalEEPROM::SLOT_SIZE
-            )
+        // A frame is decoded at once by the first chunk, and it is shorter than a chunk of the plain frame mostly.
+        result = ((chunk != 0) || Delta::read(index, frame))? 1 : -1;
+    }
+    else if (chunk == (CHUNK_COUNT_FRAME - 1))
+    {
+        // The last chunk is read with the CRC, and the frame is checked by it.
+        uint8_t buffer[ExternalEEPROM::CHUNK_SIZE];
+
+        result = ExternalEEPROM::readBlock(
+            frameBlock(Delta::cursor.extent, index), buffer, read_size + CRC_SIZE, offset
         );
 
-        if (result != 0)
+        memcpy(reinterpret_cast<uint8_t*>(&frame) + offset, buffer, read_size);
+
+        if (   (result != -1)
+            && (crcOf(&frame, sizeof(Frame)) != loadWord(buffer + read_size)) )
         {
             #if DEBUG
-                System::debugSerial().print(F(">>> failed : result["));
-                System::debugSerial().print(static_cast<int>(count));
-                System::debugSerial().print(F("] = "));
-                System::debugSerial().println(static_cast<int>(result));
+                System::debugSerial().print(F(">>> bad CRC : frame.index = "));
+                System::debugSerial().println(static_cast<int>(index));
             #endif
 
-            return false;
+            result = -1;
         }
     }
+    else
+    {
+        result = ExternalEEPROM::readBlock(
+            frameBlock(Delta::cursor.extent, index),
+            reinterpret_cast<uint8_t*>(&frame) + offset,
+            read_size,
+            offset
+        );
+    }
+
+    if (result == -1)
+    {
+        #if DEBUG
+            System::debugSerial().print(F(">>> failed : result["));
+            System::debugSerial().print(static_cast<int>(chunk));
+            System::debugSerial().print(F("] = "));
+            System::debugSerial().println(static_cast<int>(result));
+        #endif
+
+        #if MOTION_CACHE_SLOTS > 0
+            Cache::filling = false;
+        #endif
+
+        return false;
+    }
+
+    /*!
+        @note
+        The chunks of a frame are read in order into the same instance (see MotionController::prefetchFrame()),
+        so the frame is cached when its last chunk follows its first chunk without any write to the slot.
+    */
+    if (chunk == 0)
+    {
+        Cache::misses++;
+    }
+
+    #if MOTION_CACHE_SLOTS > 0
+        if (chunk == 0)
+        {
+            Cache::filling       = true;
+            Cache::filling_slot  = slot;
+            Cache::filling_index = index;
+        }
+
+        if (   (chunk == (CHUNK_COUNT_FRAME - 1))
+            && (Cache::filling)
+            && (Cache::filling_slot  == slot)
+            && (Cache::filling_index == index) )
+        {
+            Cache::filling = false;
+
+            if (   (entry != NULL)
+                && (index < MOTION_CACHE_FRAMES) )
+            {
+                entry->frame[index] = frame;
+                entry->frames |= (1UL << index);
+            }
+        }
+    #endif
 
     return true;
 }
 
 
-bool Header::get(uint8_t slot, Header& header)
+bool migrateLayout()
 {
     #if DEBUG
-        PROFILING("Header::get()");
+        PROFILING("Motion::migrateLayout()");
     #endif
 
 
-    if (slot >= SLOT_END)
-    {
-        #if DEBUG
-            System::debugSerial().print(F(">>> bad argument : slot = "));
-            System::debugSerial().println(static_cast<int>(slot));
-        #endif
+    LayoutRecord record;
 
+    if (ExternalEEPROM::readBlock(BLOCK_LAYOUT, reinterpret_cast<uint8_t*>(&record), sizeof(record)) == -1)
+    {
         return false;
     }
 
+    if (record.version == LAYOUT_VERSION_CRC)
+    {
+        // A motion whose move was interrupted by a reset is moved to the end.
+        if (record.moving < SLOT_END)
+        {
+            Extent extent;
+
+            if (!Table::read(record.moving, extent))
+            {
+                return false;
+            }
+
+            if (   (Table::isAllocated(extent))
+                && (record.moving_to < extent.first)
+                && (record.moving_done <= extent.blocks) )
+            {
+                if (!Table::move(record.moving, extent, record.moving_to, record.moving_done))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                record.moving = MOVING_NONE;
+                queueBlock(BLOCK_LAYOUT, &record, sizeof(record));
+            }
+
+            while (!ExternalEEPROM::poll());
+        }
+
+        // The high-water mark is found at boot, not by the first motion installed.
+        uint16_t block;
 
-    uint8_t* filler = reinterpret_cast<uint8_t*>(&header);
+        return Table::highWater(block);
+    }
 
-    for (uint16_t count = 0; count < SLOT_COUNT_HEADER; count++)
+    // The table is cleared before the first motion of the legacy layout is given its extent.
+    if (record.version != LAYOUT_VERSION_SLOT)
     {
-        int8_t result = ExternalEEPROM::readSlot(
-            (
-                static_cast<uint16_t>(slot) * SLOT_COUNT_MOTION + count
-            ),
-            (
-                filler + count * ExternalEEPROM::SLOT_SIZE
-            ),
-            (
-                (count == (SLOT_COUNT_HEADER - 1))?
-                    (
-                        (SIZE_SUP<Header>::VALUE)?
-                            SIZE_SUP<Header>::VALUE : ExternalEEPROM::SLOT_SIZE
-                    )
-                    : ExternalEEPROM::SLOT_SIZE
-            )
-        );
+        Extent entries[EXTENTS_PER_BLOCK];
 
-        if (result == -1)
+        for (uint8_t entry_id = 0; entry_id < EXTENTS_PER_BLOCK; entry_id++)
         {
-            #if DEBUG
-                System::debugSerial().print(F(">>> failed : result["));
-                System::debugSerial().print(static_cast<int>(count));
-                System::debugSerial().print(F("] = "));
-                System::debugSerial().println(static_cast<int>(result));
-            #endif
+            entries[entry_id].first  = Extent::FIRST_NONE;
+            entries[entry_id].blocks = 0;
+        }
+
+        for (uint8_t table_block = 0; table_block < BLOCK_COUNT_TABLE; table_block++)
+        {
+            queueBlock(BLOCK_TABLE + table_block, entries, ExternalEEPROM::BLOCK_SIZE);
+        }
 
+        record.version  = LAYOUT_VERSION_SLOT;
+        record.progress = SLOT_END;
+        record.moving   = MOVING_NONE;
+        queueBlock(BLOCK_LAYOUT, &record, sizeof(record));
+    }
+
+    // The progress is recorded for each motion, and a reset redoes only the last one.
+    while (record.progress > SLOT_BEGIN)
+    {
+        const uint8_t slot = record.progress - 1;
+
+        if (!migrateLegacy(slot))
+        {
             return false;
         }
+
+        record.progress = slot;
+        queueBlock(BLOCK_LAYOUT, &record, sizeof(record));
+
+        #if DEBUG
+            System::debugSerial().print(F(">>> migrated : slot = "));
+            System::debugSerial().println(static_cast<int>(slot));
+        #endif
     }
 
-    return true;
+    record.version = LAYOUT_VERSION_CRC;
+    queueBlock(BLOCK_LAYOUT, &record, sizeof(record));
+
+    while (!ExternalEEPROM::poll());
+
+    // Motions moved are written without Header::set() and Frame::set().
+    Cache::clear();
+    Delta::cursor.valid     = false;
+    Delta::append_slot      = SLOT_END;
+    Table::high_water_valid = false;
+
+    uint16_t block;
+
+    return Table::highWater(block);
 }
 
 
-void Frame::init(Frame& frame)
+bool getExtent(uint8_t slot, Extent& extent)
 {
-    #if DEBUG
-        PROFILING("Frame::init()");
-    #endif
+    if (slot >= SLOT_END)
+    {
+        return false;
+    }
+
+    return Table::read(slot, extent);
+}
 
 
-    frame.index              = 0;
-    frame.transition_time_ms = 32;
+uint16_t getFreeBlocks()
+{
+    Table::Usage visitor = { 0 };
 
-    for (uint8_t index = 0; index < JointController::JOINTS_SUM; index++)
+    if (!Table::scan(visitor))
     {
-        frame.joint_angle[index] = 0;
+        return 0;
     }
+
+    return BLOCK_DATA_END - visitor.blocks;
 }
 
 
-bool Frame::set(uint8_t slot, uint8_t index, const Frame& frame)
+bool defragment()
 {
     #if DEBUG
-        PROFILING("Frame::set()");
+        PROFILING("Motion::defragment()");
     #endif
 
 
-    if (slot >= SLOT_END)
+    uint16_t next = 0;
+
+    for (;;)
     {
-        #if DEBUG
-            System::debugSerial().print(F(">>> bad argument : slot = "));
-            System::debugSerial().println(static_cast<int>(slot));
-        #endif
+        Table::Lowest visitor;
+        visitor.from  = next;
+        visitor.found = false;
 
-        return false;
-    }
+        if (!Table::scan(visitor))
+        {
+            return false;
+        }
+
+        if (!visitor.found)
+        {
+            break;
+        }
+
+        if (   (visitor.extent.first != next)
+            && !Table::move(visitor.slot, visitor.extent, next, 0) )
+        {
+            return false;
+        }
 
-    if (index >= FRAME_END)
-    {
         #if DEBUG
-            System::debugSerial().print(F(">>> bad argument : index = "));
-            System::debugSerial().println(static_cast<int>(index));
+            System::debugSerial().print(F(">>> packed : slot = "));
+            System::debugSerial().println(static_cast<int>(visitor.slot));
         #endif
 
-        return false;
+        next += visitor.extent.blocks;
     }
 
+    Table::high_water       = next;
+    Table::high_water_valid = true;
 
-    const uint8_t* filler = reinterpret_cast<const uint8_t*>(&frame);
-
-    for (uint16_t count = 0; count < SLOT_COUNT_FRAME; count++)
-    {
-        int8_t result = ExternalEEPROM::writeSlot(
-            (
-                  static_cast<uint16_t>(slot) * SLOT_COUNT_MOTION
-                + SLOT_COUNT_HEADER
-                + static_cast<uint16_t>(index) * SLOT_COUNT_FRAME
-                + count
-            ),
-            (
-                filler + ExternalEEPROM::SLOT_SIZE * count
-            ),
-            (
-                (count == (SLOT_COUNT_FRAME - 1))?
-                    (
-                        (SIZE_SUP<Frame>::VALUE)?
-                            SIZE_SUP<Frame>::VALUE : ExternalEEPROM::SLOT_SIZE
-                    )
-                    : ExternalEEPROM::SLOT_SIZE
-            )
-        );
+    // Cached extents point to the blocks before moving.
+    Cache::clear();
+    Delta::cursor.valid = false;
+    Delta::append_slot  = SLOT_END;
+
+    return true;
+}
+
+
+void dumpTable()
+{
+    #if DEBUG
+        PROFILING("Motion::dumpTable()");
+    #endif
+
+
+    System::outputSerial().println(F("{"));
+
+    System::outputSerial().print(F("\t\"blocks\": "));
+    System::outputSerial().print(static_cast<int>(BLOCK_DATA_END));
+    System::outputSerial().println(F(","));
+
+    System::outputSerial().print(F("\t\"free\": "));
+    System::outputSerial().print(static_cast<int>(getFreeBlocks()));
+    System::outputSerial().println(F(","));
+
+    System::outputSerial().println(F("\t\"extents\": ["));
+
+    bool first = true;
 
-        if (result != 0)
+    for (uint8_t slot = SLOT_BEGIN; slot < SLOT_END; slot++)
+    {
+        Extent extent;
+
+        if (   !Table::read(slot, extent)
+            || !Table::isAllocated(extent) )
         {
-            #if DEBUG
-                System::debugSerial().print(F(">>> failed : result["));
-                System::debugSerial().print(static_cast<int>(count));
-                System::debugSerial().print(F("] = "));
-                System::debugSerial().println(static_cast<int>(result));
-            #endif
+            continue;
+        }
 
-            return false;
+        if (!first)
+        {
+            System::outputSerial().println(F(","));
         }
+
+        System::outputSerial().println(F("\t\t{"));
+
+        System::outputSerial().print(F("\t\t\t\"slot\": "));
+        System::outputSerial().print(static_cast<int>(slot));
+        System::outputSerial().println(F(","));
+
+        System::outputSerial().print(F("\t\t\t\"first\": "));
+        System::outputSerial().print(static_cast<int>(extent.first));
+        System::outputSerial().println(F(","));
+
+        System::outputSerial().print(F("\t\t\t\"blocks\": "));
+        System::outputSerial().println(static_cast<int>(extent.blocks));
+
+        System::outputSerial().print(F("\t\t}"));
+
+        first = false;
     }
 
-    return true;
+    if (!first)
+    {
+        System::outputSerial().println();
+    }
+
+    System::outputSerial().println(F("\t]"));
+
+    System::outputSerial().println(F("}"));
 }
 
 
-bool Frame::get(uint8_t slot, uint8_t index, Frame& frame)
+uint8_t validate()
 {
     #if DEBUG
-        PROFILING("Frame::get()");
+        PROFILING("Motion::validate()");
     #endif
 
 
-    if (slot >= SLOT_END)
+    uint8_t count = 0;
+
+    for (uint8_t slot = SLOT_BEGIN; slot < SLOT_END; slot++)
     {
-        #if DEBUG
-            System::debugSerial().print(F(">>> bad argument : slot = "));
-            System::debugSerial().println(static_cast<int>(slot));
-        #endif
+        const bool valid = Seal::check(slot);
+
+        Seal::mark(slot, valid);
+        count += (valid)? 1 : 0;
+    }
 
+    return count;
+}
+
+
+bool isValid(uint8_t slot)
+{
+    if (slot >= SLOT_END)
+    {
         return false;
     }
 
-    if (index >= Frame::FRAME_END)
+    return Seal::isValid(slot);
+}
+
+
+void dumpValidity()
+{
+    #if DEBUG
+        PROFILING("Motion::dumpValidity()");
+    #endif
+
+
+    uint8_t count = 0;
+
+    for (uint8_t slot = SLOT_BEGIN; slot < SLOT_END; slot++)
     {
-        #if DEBUG
-            System::debugSerial().print(F(">>> bad instance : frame.index = "));
-            System::debugSerial().println(static_cast<int>(index));
-        #endif
+        count += (Seal::isValid(slot))? 1 : 0;
+    }
 
-        return false;
+    System::outputSerial().println(F("{"));
+
+    System::outputSerial().print(F("\t\"slots\": "));
+    System::outputSerial().print(static_cast<int>(SLOT_END));
+    System::outputSerial().println(F(","));
+
+    System::outputSerial().print(F("\t\"valid\": "));
+    System::outputSerial().print(static_cast<int>(count));
+    System::outputSerial().println(F(","));
+
+    System::outputSerial().print(F("\t\"bitmap\": \""));
+
+    for (uint8_t byte = 0; byte < sizeof(Seal::bitmap); byte++)
+    {
+        System::outputSerial().print(Seal::bitmap[byte] >> 4,  HEX);
+        System::outputSerial().print(Seal::bitmap[byte] & 0xF, HEX);
     }
 
+    System::outputSerial().println(F("\""));
 
-    uint8_t* filler = reinterpret_cast<uint8_t*>(&frame);
-
-    for (uint16_t count = 0; count < SLOT_COUNT_FRAME; count++)
-    {
-        int8_t result = ExternalEEPROM::readSlot(
-            (
-                  static_cast<uint16_t>(slot) * SLOT_COUNT_MOTION
-                + SLOT_COUNT_HEADER
-                + static_cast<uint16_t>(index) * SLOT_COUNT_FRAME
-                + count
-            ),
-            (
-                filler + ExternalEEPROM::SLOT_SIZE * count
-            ),
-            (
-                (count == (SLOT_COUNT_FRAME - 1))?
-                    (
-                        (SIZE_SUP<Frame>::VALUE)?
-                            SIZE_SUP<Frame>::VALUE : ExternalEEPROM::SLOT_SIZE
-                    )
-                    : ExternalEEPROM::SLOT_SIZE
-            )
-        );
+    System::outputSerial().println(F("}"));
+}
 
-        if (result == -1)
+
+uint32_t getCacheHits()
+{
+    #if MOTION_CACHE_SLOTS > 0
+        return Cache::hits;
+    #else
+        return 0;
+    #endif
+}
+
+
+uint32_t getCacheMisses()
+{
+    return Cache::misses;
+}
+
+
+void dumpCache()
+{
+    #if DEBUG
+        PROFILING("Motion::dumpCache()");
+    #endif
+
+
+    uint8_t frames = 0;
+
+    System::outputSerial().println(F("{"));
+
+    System::outputSerial().print(F("\t\"slots\": ["));
+
+    #if MOTION_CACHE_SLOTS > 0
+        bool first = true;
+
+        for (uint8_t entry_id = 0; entry_id < MOTION_CACHE_SLOTS; entry_id++)
         {
-            #if DEBUG
-                System::debugSerial().print(F(">>> failed : result["));
-                System::debugSerial().print(static_cast<int>(count));
-                System::debugSerial().print(F("] = "));
-                System::debugSerial().println(static_cast<int>(result));
-            #endif
+            const Cache::Entry& entry = Cache::entries[entry_id];
 
-            return false;
+            if (!entry.valid)
+            {
+                continue;
+            }
+
+            if (!first)
+            {
+                System::outputSerial().print(F(", "));
+            }
+
+            System::outputSerial().print(static_cast<int>(entry.slot));
+            first = false;
+
+            for (uint8_t index = 0; index < MOTION_CACHE_FRAMES; index++)
+            {
+                (entry.frames & (1UL << index))? frames++ : 0;
+            }
         }
-    }
+    #endif
 
-    return true;
+    System::outputSerial().println(F("],"));
+
+    System::outputSerial().print(F("\t\"frames\": "));
+    System::outputSerial().print(static_cast<int>(frames));
+    System::outputSerial().println(F(","));
+
+    System::outputSerial().print(F("\t\"hits\": "));
+    System::outputSerial().print(static_cast<unsigned long>(getCacheHits()));
+    System::outputSerial().println(F(","));
+
+    System::outputSerial().print(F("\t\"misses\": "));
+    System::outputSerial().println(static_cast<unsigned long>(Cache::misses));
+
+    System::outputSerial().println(F("}"));
 }
 
 } // end of namespace "Motion".
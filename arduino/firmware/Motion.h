@@ -27,6 +27,164 @@ namespace PLEN2
 
         class Header;
         class Frame;
+
+        /*!
+            @brief Blocks of external EEPROM allocated to a motion
+
+            The first block keeps the header, and the following blocks keep the frames.
+            Extents of all slots are listed by the allocation table at a fixed location of external EEPROM.
+        */
+        struct Extent
+        {
+            enum { FIRST_NONE = 0xFFFF }; //!< First block of a slot that has no motion. (e.g. An erased entry.)
+
+            uint16_t first;  //!< First block.
+            uint16_t blocks; //!< Count of blocks.
+        };
+
+        /*!
+            @brief Migrate motions stored with the layout of firmware 1.4.1 and earlier
+
+            Firmware 1.4.1 and earlier divided a frame into two slots of 30 bytes.
+            The current one allocates blocks to each motion by the allocation table,
+            and stores CRCs with headers and frames (see validate()).
+            The method moves the motions once to fixed 21 blocks of each slot with their CRCs,
+            gives the blocks to them as extents, and records the version of the layout.
+            It also completes moving a motion that was interrupted by a reset during defragment().
+
+            @return Result
+
+            @attention
+            Migration takes a few seconds per installed motions, so please call it once in setup().
+        */
+        bool migrateLayout();
+
+        /*!
+            @brief Get the blocks allocated to a slot
+
+            @param [in] slot Slot number of a motion.
+            @param [out] extent Blocks allocated. (first is Extent::FIRST_NONE if the slot has no motion.)
+
+            @return Result
+        */
+        bool getExtent(uint8_t slot, Extent& extent);
+
+        /*!
+            @brief Get count of blocks that are not allocated to any motion
+
+            @return Count of blocks
+        */
+        uint16_t getFreeBlocks();
+
+        /*!
+            @brief Pack all motions toward the beginning of external EEPROM
+
+            Motions are moved in order of their addresses, so the free blocks become a run at the end.
+            Progress is recorded while a motion is moved, and migrateLayout() completes it after a reset.
+
+            @return Result
+
+            @attention
+            It takes a page program per block moved, so please don't call it while playing a motion.
+            Header::set() fails when the blocks after the highest motion are not enough, so please call it then.
+        */
+        bool defragment();
+
+        /*!
+            @brief Dump the allocation table
+
+            Output result in JSON format as below.
+            @code
+            {
+                "blocks": <integer>,
+                "free": <integer>,
+                "extents": [
+                    {
+                        "slot": <integer>,
+                        "first": <integer>,
+                        "blocks": <integer>
+                    },
+                    ...
+                ]
+            }
+            @endcode
+            "blocks" is count of the blocks for motions, and "extents" lists the slots that have a motion.
+        */
+        void dumpTable();
+
+        /*!
+            @brief Scan all slots, and build the validity bitmap
+
+            A header and each frame are stored with their CRC-16, and the last block of a motion keeps a seal,
+            that chains the CRC of the header and the CRCs of the frames in order (or the bytes of delta-compressed frames).
+            A slot is valid if its header and its seal match, so a motion whose frames are not written completely
+            (or are written by another motion) is invalid. The scan reads only the header and the CRCs of each slot.
+            <br><br>
+            Frame::set() of the last frame seals the motion (and marks the slot valid), and Header::set() marks it invalid.
+            Frames written after the last frame seal the motion again.
+
+            @return Count of valid slots
+
+            @attention
+            Please call it once in setup(), after migrateLayout().
+        */
+        uint8_t validate();
+
+        /*!
+            @brief Decide if a slot has a valid motion (see validate())
+
+            @param [in] slot Slot number of a motion.
+
+            @return Result
+        */
+        bool isValid(uint8_t slot);
+
+        /*!
+            @brief Dump the validity bitmap
+
+            Output result in JSON format as below.
+            @code
+            {
+                "slots": <integer>,
+                "valid": <integer>,
+                "bitmap": <string>
+            }
+            @endcode
+            "bitmap" is hex digits of the bytes of the bitmap in order, and slot N is the bit (N % 8) of the byte (N / 8).
+        */
+        void dumpValidity();
+
+        /*!
+            @brief Get count of reads served by the motion cache
+
+            A header or a frame read by Header::get() or Frame::get() (Frame::getChunk() from chunk 0) counts as one read.
+
+            @return Count of reads
+        */
+        uint32_t getCacheHits();
+
+        /*!
+            @brief Get count of reads that went to external EEPROM
+
+            @return Count of reads
+        */
+        uint32_t getCacheMisses();
+
+        /*!
+            @brief Dump the motion cache
+
+            Output result in JSON format as below.
+            @code
+            {
+                "slots": [<integer>, ...],
+                "frames": <integer>,
+                "hits": <integer>,
+                "misses": <integer>
+            }
+            @endcode
+            "slots" are the cached slots, and "frames" is count of the frames cached for them.
+        */
+        void dumpCache();
     }
 }
 
@@ -52,8 +210,8 @@ public:
         */
         NAME_LENGTH     = 21,
 
-        FRAMELENGTH_MIN =  1, //!< Minimum value of frame length.
-        FRAMELENGTH_MAX = 20  //!< Maximum value of frame length.
+        FRAMELENGTH_MIN =   1, //!< Minimum value of frame length.
+        FRAMELENGTH_MAX = 255  //!< Maximum value of frame length. (While external EEPROM has free blocks for it.)
     };
 
     /*!
@@ -70,6 +228,13 @@ public:
         @param [in] header An instance of header.
 
         @return Result
+
+        @note
+        Writing is queued to ExternalEEPROM and carried out by ExternalEEPROM::poll(),
+        and reading the header afterward waits for the queue to be flushed.
+        <br><br>
+        Blocks for the header and frame_length frames are allocated to the slot,
+        and the ones allocated to the motion before are released.
     */
     static bool set(uint8_t slot, const Header& header);
 
@@ -79,7 +244,7 @@ public:
         @param [in] slot Number of a header.
         @param [in, out] header An instance of header.
 
-        @return Result
+        @return Result (false if the slot has no motion or its CRC doesn't match, and the header is initialized by init())
     */
     static bool get(uint8_t slot, Header& header);
 
@@ -88,7 +253,18 @@ public:
     char    name[NAME_LENGTH]; //!< Motion name.
     uint8_t frame_length;      //!< Frame length of a motion.
 
-    uint8_t NON_RESERVED : 5;  //!< Undefined area. (It is reserved for future changes.)
+    uint8_t NON_RESERVED : 4;  //!< Undefined area. (It is reserved for future changes, and must be 0.)
+
+    /*!
+        @brief Selector to enable delta-compressed frames
+
+        Frames of the motion are packed into the frame blocks of the slot, each with the joints changed
+        from the previous frame. Blocks for the longest frames are allocated by Header::set(),
+        and the ones left are released when the last frame is written.
+        Frames must be written in order from the first one, after the header.
+        (It is regarded as 0 while NON_RESERVED is not 0, e.g. in an erased block.)
+    */
+    uint8_t use_delta    : 1;
     uint8_t use_extra    : 1;  //!< Selector to enable "extra".
     uint8_t use_jump     : 1;  //!< Selector to enable "jump".
     uint8_t use_loop     : 1;  //!< Selector to enable "loop".
@@ -126,15 +302,31 @@ public:
     enum
     {
         /*!
-            @brief Update interval between frames
+            @brief Update interval between frames at startup
 
             @sa
-            Refer to ISR(TIMER1_OVF_vect), in JointController.cpp.
+            Refer to ISR(TIMER1_OVF_vect), in JointController.cpp,
+            and JointController::getUpdateInterval() that follows the refresh mode at runtime.
         */
-        UPDATE_INTERVAL_MS = 32,
+        UPDATE_INTERVAL_MS = SERVO_REFRESH_MS,
 
-        FRAME_BEGIN =  0, //!< Beginning value of frames.
-        FRAME_END   = 20  //!< Ending value of frames.
+        FRAME_BEGIN =   0, //!< Beginning value of frames.
+        FRAME_END   = 255  //!< Ending value of frames. (Frames of a motion end at its frame_length.)
+    };
+
+    /*!
+        @brief Easing curves of the transition to a frame
+
+        @note
+        Values out of the range (e.g. 0xFF of an erased block) are regarded as EASING_LINEAR,
+        so frames installed by older firmware keep their behavior.
+    */
+    enum EASING
+    {
+        EASING_LINEAR,       //!< Constant speed.
+        EASING_SMOOTHSTEP,   //!< Cubic Hermite curve with zero speed at both ends. (3u^2 - 2u^3)
+        EASING_MINIMUM_JERK, //!< Quintic curve with zero speed and acceleration at both ends. (10u^3 - 15u^4 + 6u^5)
+        EASING_SUM           //!< Summation of the curves.
     };
 
     /*!
@@ -152,6 +344,10 @@ public:
         @param [in] frame An instance of frame.
 
         @return Result
+
+        @note
+        Writing is queued to ExternalEEPROM and carried out by ExternalEEPROM::poll(),
+        and reading the frame afterward waits for the queue to be flushed.
     */
     static bool set(uint8_t slot, uint8_t index, const Frame& frame);
 
@@ -162,14 +358,37 @@ public:
         @param [in] index Index of the frame.
         @param [in, out] frame An instance of frame.
 
-        @return Result
+        @return Result (false if the CRC of the frame doesn't match)
     */
     static bool get(uint8_t slot, uint8_t index, Frame& frame);
 
+    /*!
+        @brief Get count of chunks that a frame is divided into on external EEPROM
+
+        @return Count of chunks
+    */
+    static uint8_t chunks();
+
+    /*!
+        @brief Read a chunk of the frame from external EEPROM
+
+        Reading all chunks (from 0 to chunks() - 1) is equivalent to get(),
+        so the caller can spread reading a frame across short idle windows.
+
+        @param [in] slot Slot number of a motion.
+        @param [in] index Index of the frame.
+        @param [in] chunk Index of the chunk.
+        @param [in, out] frame An instance of frame.
+
+        @return Result (false if the CRC of the frame doesn't match, by the last chunk)
+    */
+    static bool getChunk(uint8_t slot, uint8_t index, uint8_t chunk, Frame& frame);
+
 
     uint8_t  index;                                    //!< Index of a frame.
     uint16_t transition_time_ms;                       //!< Time of transit to the frame.
     int16_t  joint_angle[JointController::JOINTS_SUM]; //!< Angles.
+    uint8_t  easing;                                   //!< Easing curve of the transition. (See EASING.)
 
     /*
     uint8_t  device_value[8];                          //!< Output values.
@@ -12,6 +12,7 @@
 
 #include <Arduino.h>
 
+#include "BuildConfig.h"
 #include "System.h"
 #include "ExternalEEPROM.h"
 #include "JointController.h"
@@ -36,6 +37,65 @@ namespace
     {
         return static_cast<int16_t>(value >> PRECISION);
     }
+
+    //! @brief Bitmask of all joints (bit N is joint N)
+    const uint32_t JOINTS_ALL = (static_cast<uint32_t>(1) << PLEN2::JointController::JOINTS_SUM) - 1;
+
+
+    /*!
+        @brief Lookup tables of easing curves
+
+        Each curve is sampled at EASING_SPAN + 1 points of progress from 0 to 1,
+        and its values are also progress from 0 to 1 given as EASING_ONE.
+        Values between the points are linearly interpolated, so the cost per tick is integer-only.
+    */
+    enum
+    {
+        EASING_SPAN      = 32,
+        EASING_POSITION  = 8,                                //!< Fractional bits of a position in a table.
+        EASING_PRECISION = 15,
+        EASING_ONE       = static_cast<uint16_t>(1) << EASING_PRECISION
+    };
+
+    PROGMEM const uint16_t EASING_TABLE[PLEN2::Motion::Frame::EASING_SUM - 1][EASING_SPAN + 1] =
+    {
+        // EASING_SMOOTHSTEP
+        {
+                0,    94,   368,   810,  1408,  2150,  3024,  4018,
+             5120,  6318,  7600,  8954, 10368, 11830, 13328, 14850,
+            16384, 17918, 19440, 20938, 22400, 23814, 25168, 26450,
+            27648, 28750, 29744, 30618, 31360, 31958, 32400, 32674,
+            32768
+        },
+
+        // EASING_MINIMUM_JERK
+        {
+                0,    10,    73,   233,   526,   975,  1598,  2403,
+             3392,  4561,  5898,  7391,  9018, 10758, 12584, 14469,
+            16384, 18299, 20184, 22010, 23750, 25377, 26870, 28207,
+            29376, 30365, 31170, 31793, 32242, 32535, 32695, 32758,
+            32768
+        }
+    };
+
+    /*!
+        @brief Get progress of an easing curve
+
+        @param [in] easing   Easing curve except EASING_LINEAR.
+        @param [in] position Position in the table, that has EASING_POSITION fractional bits.
+
+        @return Progress (EASING_ONE means 1)
+    */
+    inline uint16_t easing_progress(uint8_t easing, uint16_t position)
+    {
+        const uint16_t* table    = EASING_TABLE[easing - 1] + (position >> EASING_POSITION);
+        const uint8_t   fraction = position & ((1 << EASING_POSITION) - 1);
+
+        const uint16_t begin = pgm_read_word(table);
+        const uint16_t end   = pgm_read_word(table + 1);
+
+        return begin + static_cast<uint16_t>((static_cast<uint32_t>(end - begin) * fraction) >> EASING_POSITION);
+    }
 }
 
 
@@ -47,6 +107,22 @@ PLEN2::MotionController::MotionController(JointController& joint_ctrl)
     m_frame_current_ptr = m_buffer;
     m_frame_next_ptr    = m_buffer + 1;
 
+    m_prefetch_state = PREFETCH_NONE;
+    m_easing         = Motion::Frame::EASING_LINEAR;
+    m_active_joints  = 0;
+    m_refresh_joints = true;
+
+    m_stream_head    = 0;
+    m_stream_count   = 0;
+    m_streaming      = false;
+    m_stream_closing = false;
+
+    m_blend_window_ms = MOTION_BLEND_MS;
+    m_blend_length    = 0;
+
+    m_speed          = SPEED_ONE;
+    m_time_remainder = 0;
+
     for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
     {
         m_frame_current_ptr->joint_angle[joint_id] = 0;
@@ -94,6 +170,11 @@ bool PLEN2::MotionController::nextFrameLoadable()
     #endif
 
 
+    if (m_streaming)
+    {
+        return ((m_stream_count != 0) || !m_stream_closing);
+    }
+
     if (   (m_header.use_loop)
         || (m_header.use_jump) )
     {
@@ -104,6 +185,84 @@ bool PLEN2::MotionController::nextFrameLoadable()
 }
 
 
+bool PLEN2::MotionController::blendable()
+{
+    #if DEBUG_HARD
+        PROFILING("MotionController::blendable()");
+    #endif
+
+
+    if (   (!playing())
+        || (m_streaming)
+        || (m_blend_length != 0)
+        || (m_easing != Motion::Frame::EASING_LINEAR)
+        || (m_transition_count == 0)
+        || (nextFrameLoadable()) )
+    {
+        return false;
+    }
+
+    return (m_transition_count <= m_blend_window_ms / m_joint_ctrl_ptr->getUpdateInterval());
+}
+
+
+void PLEN2::MotionController::setBlendWindow(uint16_t window_ms)
+{
+    #if DEBUG
+        PROFILING("MotionController::setBlendWindow()");
+    #endif
+
+
+    m_blend_window_ms = window_ms;
+}
+
+
+uint16_t PLEN2::MotionController::getBlendWindow()
+{
+    #if DEBUG_HARD
+        PROFILING("MotionController::getBlendWindow()");
+    #endif
+
+
+    return m_blend_window_ms;
+}
+
+
+bool PLEN2::MotionController::setSpeed(uint16_t speed)
+{
+    #if DEBUG
+        PROFILING("MotionController::setSpeed()");
+    #endif
+
+
+    if (   (speed < SPEED_MIN)
+        || (speed > SPEED_MAX) )
+    {
+        #if DEBUG
+            System::debugSerial().print(F(">>> bad argment : speed = "));
+            System::debugSerial().println(static_cast<int>(speed));
+        #endif
+
+        return false;
+    }
+
+    m_speed = speed;
+
+    return true;
+}
+
+
+uint16_t PLEN2::MotionController::getSpeed()
+{
+    #if DEBUG_HARD
+        PROFILING("MotionController::getSpeed()");
+    #endif
+
+
+    return m_speed;
+}
+
+
 void PLEN2::MotionController::play(uint8_t slot)
 {
     #if DEBUG
@@ -111,7 +270,9 @@ void PLEN2::MotionController::play(uint8_t slot)
     #endif
 
 
-    if (playing())
+    const bool blending = playing();
+
+    if (blending && !blendable())
     {
         #if DEBUG
             System::debugSerial().println(F(">>> error : A motion has been playing."));
@@ -131,9 +292,33 @@ void PLEN2::MotionController::play(uint8_t slot)
     }
 
 
-    Motion::Header::get(slot, m_header);
+    Motion::Header header;
 
-    m_setupFrame(0);
+    // A motion whose frames are not written completely is not played. (See Motion::validate().)
+    if (   !Motion::isValid(slot)
+        || !Motion::Header::get(slot, header) )
+    {
+        #if DEBUG
+            System::debugSerial().print(F(">>> invalid motion : slot = "));
+            System::debugSerial().println(static_cast<int>(slot));
+        #endif
+
+        return;
+    }
+
+    m_header.assign(header);
+
+    m_prefetch_state = PREFETCH_NONE;
+
+    if (blending)
+    {
+        m_setupBlend();
+    }
+    else
+    {
+        m_time_remainder = 0;
+        m_setupFrame(0);
+    }
 
     m_playing = true;
 }
@@ -163,19 +348,72 @@ void PLEN2::MotionController::playFrameDirectly(const Motion::Frame& frame)
     *m_frame_next_ptr = frame;
     m_frame_next_ptr->index = 0;
 
-    m_transition_count = m_frame_next_ptr->transition_time_ms / Motion::Frame::UPDATE_INTERVAL_MS;
+    m_time_remainder = 0;
+    m_setupTransition();
 
-    for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+    m_prefetch_state = PREFETCH_NONE;
+    m_playing = true;
+}
+
+
+bool PLEN2::MotionController::pushStreamFrame(const Motion::Frame& frame)
+{
+    #if DEBUG
+        PROFILING("MotionController::pushStreamFrame()");
+    #endif
+
+
+    if (   (playing() && !m_streaming)
+        || (m_stream_count >= STREAMBUFFER_LENGTH) )
     {
-        m_current_fixed_points[joint_id] = fixed_cast(m_frame_current_ptr->joint_angle[joint_id]);
+        #if DEBUG
+            System::debugSerial().println(F(">>> error : The stream can't accept a frame."));
+        #endif
 
-        m_diff_fixed_points[joint_id]  = fixed_cast(m_frame_next_ptr->joint_angle[joint_id])
-                                       - m_current_fixed_points[joint_id];
+        m_reportStream('R');
 
-        m_diff_fixed_points[joint_id] /= m_transition_count;
+        return false;
     }
 
-    m_playing = true;
+
+    uint8_t tail = m_stream_head + m_stream_count;
+
+    if (tail >= STREAMBUFFER_LENGTH)
+    {
+        tail -= STREAMBUFFER_LENGTH;
+    }
+
+    m_stream[tail] = frame;
+    m_stream[tail].index = 0;
+    m_stream_count++;
+
+    if (!playing())
+    {
+        m_header.frame_length = 1;
+        m_header.use_loop     = 0;
+        m_header.use_jump     = 0;
+
+        m_streaming      = true;
+        m_stream_closing = false;
+        m_time_remainder = 0;
+
+        m_setupStreamFrame();
+
+        m_playing = true;
+    }
+
+    return true;
+}
+
+
+bool PLEN2::MotionController::streaming()
+{
+    #if DEBUG_HARD
+        PROFILING("MotionController::streaming()");
+    #endif
+
+
+    return m_streaming;
 }
 
 
@@ -188,6 +426,8 @@ void PLEN2::MotionController::willStop()
 
     m_header.use_loop = 0;
     m_header.use_jump = 0;
+
+    m_stream_closing = true;
 }
 
 
@@ -200,6 +440,14 @@ void PLEN2::MotionController::stop()
 
     m_playing = false;
     m_bufferingFrame(); // @attension It is necessary for a valid sequence!
+
+    m_blend_length = 0;
+
+    m_prefetch_state = PREFETCH_NONE;
+
+    m_streaming      = false;
+    m_stream_closing = false;
+    m_stream_count   = 0;
 }
 
 
@@ -212,30 +460,371 @@ void PLEN2::MotionController::updateFrame()
 
     m_transition_count--;
 
-    for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+    /*!
+        @note
+        Only joints that move in the transition are updated at each tick,
+        and all joints are updated at the first tick to give them the beginning angles.
+        (e.g. a joint moved by "apply" commands before playing a motion.)
+    */
+    uint32_t joints = (m_refresh_joints)? JOINTS_ALL : m_active_joints;
+    m_refresh_joints = false;
+
+    /*!
+        @note
+        While blending motions, weights of the incoming motion follow smoothstep curve,
+        so the speed changes from the outgoing motion to the incoming one without any step.
+    */
+    if (m_blend_length != 0)
     {
-        m_current_fixed_points[joint_id] += m_diff_fixed_points[joint_id];
-        m_joint_ctrl_ptr->setAngleDiff(joint_id, unfixed_cast(m_current_fixed_points[joint_id]));
+        m_blend_count++;
+        m_blend_position += m_blend_step;
+
+        if (m_blend_count >= m_blend_length)
+        {
+            m_blend_length = 0;
+        }
+        else
+        {
+            m_blend_weight = easing_progress(Motion::Frame::EASING_SMOOTHSTEP, m_blend_position);
+        }
+    }
+
+    if (m_easing == Motion::Frame::EASING_LINEAR)
+    {
+        for (uint8_t joint_id = 0; joints != 0; joint_id++, joints >>= 1)
+        {
+            if (!(joints & 1))
+            {
+                continue;
+            }
+
+            // The differences per tick are truncated, so the last tick lands on the next frame exactly.
+            if (m_transition_count == 0)
+            {
+                m_current_fixed_points[joint_id] = fixed_cast(m_frame_next_ptr->joint_angle[joint_id]);
+            }
+            else
+            {
+                m_current_fixed_points[joint_id] += m_diff_fixed_points[joint_id];
+            }
+
+            const int16_t angle = unfixed_cast(m_current_fixed_points[joint_id]);
+            m_joint_ctrl_ptr->setAngleDiff(joint_id, (m_blend_length != 0)? m_blendAngle(joint_id, angle) : angle);
+        }
+    }
+    else
+    {
+        m_easing_position += m_easing_step;
+
+        const uint16_t progress = (m_transition_count == 0)?
+            static_cast<uint16_t>(EASING_ONE) : easing_progress(m_easing, m_easing_position);
+
+        for (uint8_t joint_id = 0; joints != 0; joint_id++, joints >>= 1)
+        {
+            if (!(joints & 1))
+            {
+                continue;
+            }
+
+            const int16_t diff  = static_cast<int16_t>(m_diff_fixed_points[joint_id]);
+            const int16_t angle = unfixed_cast(m_current_fixed_points[joint_id])
+                + static_cast<int16_t>((static_cast<int32_t>(diff) * progress) >> EASING_PRECISION);
+
+            m_joint_ctrl_ptr->setAngleDiff(joint_id, (m_blend_length != 0)? m_blendAngle(joint_id, angle) : angle);
+        }
     }
 
+    m_joint_ctrl_ptr->commitFrame();
     m_joint_ctrl_ptr->m_1cycle_finished = false;
 }
 
 
 void PLEN2::MotionController::m_setupFrame(uint8_t index)
 {
-    Motion::Frame::get(m_header.slot, index, *m_frame_next_ptr);
+    const bool prefetched = (
+           (m_prefetch_state == PREFETCH_LOADING || m_prefetch_state == PREFETCH_LOADED)
+        && (m_prefetch_slot  == m_header.slot)
+        && (m_prefetch_index == index)
+    );
+
+    /*!
+        @note
+        The frame was read ahead into the buffer of the current frame, that is the next frame's buffer
+        after m_bufferingFrame(), so the frame prefetched is already in place.
+    */
+    if (prefetched)
+    {
+        // Read remaining chunks if the transition was too short to finish reading ahead.
+        while (m_prefetch_state == PREFETCH_LOADING)
+        {
+            m_prefetchChunk(*m_frame_next_ptr);
+        }
+    }
+
+    if (   (!prefetched)
+        || (m_prefetch_state != PREFETCH_LOADED) )
+    {
+        Motion::Frame::get(m_header.slot, index, *m_frame_next_ptr);
+    }
+
+    m_prefetch_state = PREFETCH_IDLE;
+
+    m_setupTransition();
+}
+
+
+void PLEN2::MotionController::m_setupBlend()
+{
+    /*!
+        @note
+        The incoming motion starts from the current angles, and the outgoing motion is given back
+        from the same angles and its differences per tick, so the angles are continuous.
+        The last frame of the outgoing motion is overwritten with the current angles for them,
+        because it is not needed any more.
+    */
+    const uint32_t tail_joints = m_active_joints;
+
+    for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+    {
+        m_blend_fixed_points[joint_id] = m_diff_fixed_points[joint_id];
+        m_frame_next_ptr->joint_angle[joint_id] = unfixed_cast(m_current_fixed_points[joint_id]);
+    }
+
+    m_blend_length   = m_transition_count;
+    m_blend_count    = 0;
+    m_blend_position = 0;
+    m_blend_step     = (static_cast<uint16_t>(EASING_SPAN) << EASING_POSITION) / m_blend_length;
+
+    m_bufferingFrame();
+    m_setupFrame(0);
+
+    m_active_joints |= tail_joints;
+}
+
+
+int16_t PLEN2::MotionController::m_blendAngle(uint8_t joint_id, int16_t angle)
+{
+    const int16_t tail = unfixed_cast(
+        fixed_cast(m_frame_current_ptr->joint_angle[joint_id])
+        + m_blend_fixed_points[joint_id] * m_blend_count
+    );
+
+    return tail + static_cast<int16_t>((static_cast<int32_t>(angle - tail) * m_blend_weight) >> EASING_PRECISION);
+}
+
+
+void PLEN2::MotionController::m_setupTransition()
+{
+    /*!
+        @note
+        Ticks are scheduled like Bresenham's algorithm: transition time is counted on the scale of [usec * SPEED_ONE / 8]
+        against the exact period of updates, and a part shorter than the period is carried over to the next frame.
+        (The scale keeps the longest frame in int32_t, and the periods of every refresh mode are multiples of 8[usec].)
+        A frame shorter than one period is reached by one update, and the time overrun is taken from the next frame.
+        Streamed frames are not scaled by the playback speed.
+    */
+    const int32_t speed = (m_streaming)? static_cast<int32_t>(SPEED_ONE) : m_speed;
+    const int32_t time  = static_cast<int32_t>(m_frame_next_ptr->transition_time_ms) * (1000L * SPEED_ONE / 8) + m_time_remainder;
+    const int32_t tick  = speed * (m_joint_ctrl_ptr->getUpdatePeriod() / 8);
+
+    m_transition_count = (time > tick)? (time / tick) : 1;
+    m_time_remainder   = time - static_cast<int32_t>(m_transition_count) * tick;
 
-    m_transition_count = m_frame_next_ptr->transition_time_ms / Motion::Frame::UPDATE_INTERVAL_MS;
+    // Overruns by a run of frames shorter than one period are not piled up.
+    if (m_time_remainder < -tick)
+    {
+        m_time_remainder = -tick;
+    }
+
+    // The head of a motion blended is stretched to cover the tail of the outgoing motion.
+    if (m_transition_count < m_blend_length)
+    {
+        m_transition_count = m_blend_length;
+    }
+
+    m_easing = m_frame_next_ptr->easing;
+
+    if (m_easing >= Motion::Frame::EASING_SUM)
+    {
+        m_easing = Motion::Frame::EASING_LINEAR;
+    }
+
+    m_active_joints  = 0;
+    m_refresh_joints = true;
+
+    if (m_easing == Motion::Frame::EASING_LINEAR)
+    {
+        for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+        {
+            m_current_fixed_points[joint_id] = fixed_cast(m_frame_current_ptr->joint_angle[joint_id]);
+
+            m_diff_fixed_points[joint_id]  = fixed_cast(m_frame_next_ptr->joint_angle[joint_id])
+                                           - m_current_fixed_points[joint_id];
+
+            m_diff_fixed_points[joint_id] /= m_transition_count;
+
+            if (m_diff_fixed_points[joint_id] != 0)
+            {
+                m_active_joints |= static_cast<uint32_t>(1) << joint_id;
+            }
+        }
+
+        return;
+    }
+
+    /*!
+        @note
+        An eased transition keeps the beginning angles in m_current_fixed_points,
+        and the whole differences (not fixed points) in m_diff_fixed_points,
+        so it needs no extra RAM per joint.
+    */
+    m_easing_position = 0;
+    m_easing_step     = (static_cast<uint16_t>(EASING_SPAN) << EASING_POSITION) / m_transition_count;
 
     for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
     {
         m_current_fixed_points[joint_id] = fixed_cast(m_frame_current_ptr->joint_angle[joint_id]);
 
-        m_diff_fixed_points[joint_id]  = fixed_cast(m_frame_next_ptr->joint_angle[joint_id])
-                                       - m_current_fixed_points[joint_id];
+        m_diff_fixed_points[joint_id]  = m_frame_next_ptr->joint_angle[joint_id]
+                                       - m_frame_current_ptr->joint_angle[joint_id];
+
+        if (m_diff_fixed_points[joint_id] != 0)
+        {
+            m_active_joints |= static_cast<uint32_t>(1) << joint_id;
+        }
+    }
+}
+
+
+void PLEN2::MotionController::m_setupStreamFrame()
+{
+    *m_frame_next_ptr = m_stream[m_stream_head];
+
+    m_stream_head++;
+    if (m_stream_head >= STREAMBUFFER_LENGTH)
+    {
+        m_stream_head = 0;
+    }
+
+    m_stream_count--;
+
+    m_prefetch_state = PREFETCH_NONE;
+
+    m_setupTransition();
+    m_reportStream('C');
+}
+
+
+void PLEN2::MotionController::m_reportStream(char status)
+{
+    const uint8_t credit = STREAMBUFFER_LENGTH - m_stream_count;
+
+    System::outputSerial().print('S');
+    System::outputSerial().print(status);
+    System::outputSerial().print(credit >> 4,   HEX);
+    System::outputSerial().println(credit & 0xF, HEX);
+}
+
+
+bool PLEN2::MotionController::m_predictNextFrame(uint8_t& slot, uint8_t& index)
+{
+    const uint8_t index_next = m_frame_next_ptr->index;
+
+    /*!
+        @note
+        The prediction follows the same order of priority as loadNextFrame().
+    */
+    if (   (m_header.use_loop)
+        && (index_next >= m_header.loop_end) )
+    {
+        slot  = m_header.slot;
+        index = m_header.loop_begin;
+
+        return true;
+    }
+
+    if (   (!m_header.use_loop)
+        && (m_header.use_jump)
+        && (index_next >= (m_header.frame_length - 1)) )
+    {
+        slot  = m_header.jump_slot;
+        index = 0;
+
+        return Motion::isValid(slot);
+    }
+
+    if ((index_next + 1) < m_header.frame_length)
+    {
+        slot  = m_header.slot;
+        index = index_next + 1;
+
+        return true;
+    }
+
+    return false;
+}
+
+
+void PLEN2::MotionController::m_prefetchChunk(Motion::Frame& frame)
+{
+    if (!Motion::Frame::getChunk(m_prefetch_slot, m_prefetch_index, m_prefetch_chunk, frame))
+    {
+        m_prefetch_state = PREFETCH_NONE;
+
+        return;
+    }
+
+    m_prefetch_chunk++;
+
+    if (m_prefetch_chunk >= Motion::Frame::chunks())
+    {
+        m_prefetch_state = PREFETCH_LOADED;
+    }
+}
+
+
+void PLEN2::MotionController::prefetchFrame()
+{
+    #if DEBUG_HARD
+        PROFILING("MotionController::prefetchFrame()");
+    #endif
+
+
+    /*!
+        @note
+        Once a transition is set up, it runs from m_current_fixed_points to the next frame,
+        so the frame is read ahead into the buffer of the current frame without another buffer.
+        The current frame is still needed while blending motions (see m_blendAngle()), so it waits until then.
+    */
+    if (   !playing()
+        || (m_blend_length != 0) )
+    {
+        return;
+    }
+
+    if (m_prefetch_state == PREFETCH_IDLE)
+    {
+        if (!m_predictNextFrame(m_prefetch_slot, m_prefetch_index))
+        {
+            m_prefetch_state = PREFETCH_NONE;
+
+            return;
+        }
+
+        m_prefetch_chunk = 0;
+        m_prefetch_state = PREFETCH_LOADING;
 
-        m_diff_fixed_points[joint_id] /= m_transition_count;
+        #if DEBUG
+            System::debugSerial().print(F(">>> prefetch : slot = "));
+            System::debugSerial().print(static_cast<int>(m_prefetch_slot));
+            System::debugSerial().print(F(", index = "));
+            System::debugSerial().println(static_cast<int>(m_prefetch_index));
+        #endif
+    }
+
+    if (m_prefetch_state == PREFETCH_LOADING)
+    {
+        m_prefetchChunk(*m_frame_current_ptr);
     }
 }
 
@@ -261,6 +850,31 @@ void PLEN2::MotionController::loadNextFrame()
     #endif
 
 
+    if (m_streaming)
+    {
+        // Keep the last frame for an update interval, until a host pushes the next one.
+        if (m_stream_count == 0)
+        {
+            m_transition_count = 1;
+            m_easing           = Motion::Frame::EASING_LINEAR;
+            m_active_joints    = 0;
+            m_refresh_joints   = true;
+
+            for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+            {
+                m_current_fixed_points[joint_id] = fixed_cast(m_frame_next_ptr->joint_angle[joint_id]);
+                m_diff_fixed_points[joint_id]    = 0;
+            }
+
+            return;
+        }
+
+        m_bufferingFrame();
+        m_setupStreamFrame();
+
+        return;
+    }
+
     m_bufferingFrame();
     const uint8_t index_current = m_frame_current_ptr->index;
 
@@ -300,8 +914,22 @@ void PLEN2::MotionController::loadNextFrame()
         && (m_header.use_jump)
         && (index_current >= (m_header.frame_length - 1)) )
     {
-        Motion::Header::get(m_header.jump_slot, m_header);
+        Motion::Header header;
+
+        /*!
+            @note
+            If the motion jumped to is not valid, the jump is cancelled, so nextFrameLoadable() is false
+            and the motion stops through stop() at the next call of loop(), as it does at the end of a motion.
+        */
+        if (   !Motion::isValid(m_header.jump_slot)
+            || !Motion::Header::get(m_header.jump_slot, header) )
+        {
+            m_header.use_jump = 0;
+
+            return;
+        }
 
+        m_header.assign(header);
         m_setupFrame(0);
 
         return;
@@ -412,6 +1040,14 @@ void PLEN2::MotionController::dump(uint8_t slot)
         System::outputSerial().print(frame.transition_time_ms);
         System::outputSerial().println(F(","));
 
+        if (   (frame.easing != Motion::Frame::EASING_LINEAR)
+            && (frame.easing <  Motion::Frame::EASING_SUM) )
+        {
+            System::outputSerial().print(F("\t\t\t\"easing\": "));
+            System::outputSerial().print(static_cast<int>(frame.easing));
+            System::outputSerial().println(F(","));
+        }
+
         System::outputSerial().println(F("\t\t\t\"outputs\": ["));
 
         for (uint16_t device_index = 0; device_index < JointController::JOINTS_SUM; device_index++)
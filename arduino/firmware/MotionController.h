@@ -40,6 +40,24 @@ class PLEN2::MotionController
 #endif
 
 public:
+    enum
+    {
+        STREAMBUFFER_LENGTH = 2 //!< Count of frames that a host can push ahead while streaming. (See pushStreamFrame().)
+    };
+
+    /*!
+        @brief Playback speed settings
+
+        Playback speed is a fixed point number that has SPEED_PRECISION fractional bits.
+    */
+    enum SPEED_SETTINGS
+    {
+        SPEED_PRECISION = 8,
+        SPEED_ONE       = 1 << SPEED_PRECISION, //!< Original speed.
+        SPEED_MIN       = SPEED_ONE / 4,
+        SPEED_MAX       = SPEED_ONE * 4
+    };
+
     /*!
         @brief Constructor
 
@@ -78,10 +96,63 @@ public:
     /*!
         @brief Play a motion
 
+        If a motion is playing, the method fails unless blendable().
+
         @param [in] slot Number of a motion.
     */
     void play(uint8_t slot);
 
+    /*!
+        @brief Decide if the next motion can be blended into the motion playing
+
+        The tail of a motion is blendable, if blending is enabled and the remaining time of the last transition
+        is shorter than the blend window. (Transitions with easing curves are not blended,
+        because they already end with zero speed.)
+
+        @return Result
+    */
+    bool blendable();
+
+    /*!
+        @brief Set window to blend motions played in succession
+
+        play() given while blendable() starts the next motion at once from the current angles,
+        and both of the motions are blended in the rest of the last transition: the angles move
+        from the outgoing motion to the incoming one by weights that follow smoothstep curve.
+        If the first transition of the incoming motion is shorter than the rest, it is stretched to the same length.
+
+        @param [in] window_ms Blend window [msec]. (0 disables blending.)
+    */
+    void setBlendWindow(uint16_t window_ms);
+
+    /*!
+        @brief Get window to blend motions played in succession
+
+        @return Blend window [msec]
+    */
+    uint16_t getBlendWindow();
+
+    /*!
+        @brief Set playback speed of motions
+
+        Transition time of each frame is divided by the speed, when it is set up by play() or playFrameDirectly().
+        (Frames of a stream are played as they are given.)
+        A part of the time shorter than an update interval is carried over to the next frame,
+        so timing error doesn't accumulate in a long motion.
+
+        @param [in] speed Playback speed. (SPEED_ONE means the original speed.)
+
+        @return Result (false if the speed is out of SPEED_MIN to SPEED_MAX)
+    */
+    bool setSpeed(uint16_t speed);
+
+    /*!
+        @brief Get playback speed of motions
+
+        @return Playback speed
+    */
+    uint16_t getSpeed();
+
     /*!
         @brief Play a frame directly
 
@@ -89,11 +160,40 @@ public:
     */
     void playFrameDirectly(const Motion::Frame& frame);
 
+    /*!
+        @brief Push a frame of a stream given from a host
+
+        The first pushed frame starts streaming, and following frames are played in order
+        without any access to external EEPROM. If the buffer runs out while streaming,
+        the robot keeps the last frame until the next one is pushed.
+
+        Each time a frame is consumed, the count of free buffer is reported to the host
+        as a line "SC" + 2 hex digits via System::outputSerial(), and it gives back one credit.
+        A host starts with STREAMBUFFER_LENGTH credits, spends one per pushed frame,
+        and must not push frames beyond its credits. A rejected frame is reported as "SR" + 2 hex digits.
+
+        A credit is given back when a frame begins, so the host has a whole transition time
+        to push the next one, and the second buffer only covers jitter of the link.
+
+        @param [in] frame An instance of frame. (Its index is ignored.)
+
+        @return Result (false if the buffer is full, or a motion in a slot is playing)
+    */
+    bool pushStreamFrame(const Motion::Frame& frame);
+
+    /*!
+        @brief Decide if a stream from a host is playing
+
+        @return Result
+    */
+    bool streaming();
+
     /*!
         @brief Will stop playing a motion
 
         The method doesn't stop playing a motion just after running itself,
         but will stop it when a frame that has the stop flag is discovered.
+        While streaming, it will stop after the frames already pushed are played.
     */
     void willStop();
 
@@ -112,6 +212,19 @@ public:
     */
     void loadNextFrame();
 
+    /*!
+        @brief Read ahead the frame that will be loaded at the next time
+
+        The method reads at most one chunk of the frame from external EEPROM per call,
+        so calling it in idle time between frame updates spreads I2C transactions
+        over a transition, and loadNextFrame() only swaps buffers when the prediction hits.
+
+        @attention
+        A prefetched frame is discarded if loading order is changed (e.g. willStop() is called),
+        and loadNextFrame() reads the right frame synchronously instead.
+    */
+    void prefetchFrame();
+
     /*!
         @brief Dump a motion with JSON format
 
@@ -129,20 +242,105 @@ public:
 private:
     enum { FRAMEBUFFER_LENGTH = 2 };
 
+    /*!
+        @brief Fields of the header used while a motion is playing
+
+        The name and the stop flags are not used by the playback,
+        so it takes 7 bytes of RAM instead of the whole header.
+    */
+    class Playback
+    {
+    public:
+        uint8_t slot;
+        uint8_t frame_length;
+        uint8_t use_jump : 1;
+        uint8_t use_loop : 1;
+        uint8_t loop_begin;
+        uint8_t loop_end;
+        uint8_t loop_count;
+        uint8_t jump_slot;
+
+        /*!
+            @brief Take the fields from a header
+        */
+        void assign(const Motion::Header& header)
+        {
+            slot         = header.slot;
+            frame_length = header.frame_length;
+            use_jump     = header.use_jump;
+            use_loop     = header.use_loop;
+            loop_begin   = header.loop_begin;
+            loop_end     = header.loop_end;
+            loop_count   = header.loop_count;
+            jump_slot    = header.jump_slot;
+        }
+    };
+
+    enum PREFETCH_STATE
+    {
+        PREFETCH_IDLE,    //!< The frame to read ahead has not been decided yet.
+        PREFETCH_LOADING,
+        PREFETCH_LOADED,
+        PREFETCH_NONE     //!< There is no frame to read ahead, or reading it failed.
+    };
+
     void m_setupFrame(uint8_t index);
+    void m_setupBlend();
+    int16_t m_blendAngle(uint8_t joint_id, int16_t angle);
+    void m_setupTransition();
+    void m_setupStreamFrame();
+    void m_reportStream(char status);
     void m_bufferingFrame();
+    bool m_predictNextFrame(uint8_t& slot, uint8_t& index);
+    void m_prefetchChunk(Motion::Frame& frame);
 
 
     JointController* m_joint_ctrl_ptr;
 
-    uint8_t m_transition_count;
+    uint16_t m_transition_count;
+    uint16_t m_speed;
+    int32_t  m_time_remainder; //!< Transition time carried over to the next frame. [usec * SPEED_ONE / 8]
     bool    m_playing;
 
-    Motion::Header m_header;
+    Playback       m_header;
     Motion::Frame  m_buffer[FRAMEBUFFER_LENGTH];
     Motion::Frame* m_frame_current_ptr;
     Motion::Frame* m_frame_next_ptr;
 
+    uint8_t m_prefetch_state;
+    uint8_t m_prefetch_slot;
+    uint8_t m_prefetch_index;
+    uint8_t m_prefetch_chunk;
+
+    /*!
+        @note
+        Motions are blended only while a motion in a slot is playing, and a stream is pushed only while it is not
+        (see blendable() and pushStreamFrame()), so the differences of the outgoing motion share memory with the stream buffer.
+    */
+    union
+    {
+        Motion::Frame m_stream[STREAMBUFFER_LENGTH];
+        int32_t       m_blend_fixed_points[JointController::JOINTS_SUM]; //!< Differences per tick of the outgoing motion.
+    };
+    uint8_t m_stream_head;
+    uint8_t m_stream_count;
+    bool    m_streaming;
+    bool    m_stream_closing;
+
+    uint32_t m_active_joints;  //!< Bitmask of joints that move in the transition.
+    bool     m_refresh_joints; //!< Update all joints at the next tick.
+
+    uint8_t  m_easing;
+    uint16_t m_easing_position;
+    uint16_t m_easing_step;
+
+    uint16_t m_blend_window_ms;
+    uint16_t m_blend_length;   //!< Ticks to blend motions. (0 while not blending.)
+    uint16_t m_blend_count;
+    uint16_t m_blend_position; //!< Position in the easing table of the weights.
+    uint16_t m_blend_step;
+    uint16_t m_blend_weight;   //!< Weight of the incoming motion.
+
     int32_t m_current_fixed_points[JointController::JOINTS_SUM];
     int32_t m_diff_fixed_points[JointController::JOINTS_SUM];
 };
@@ -12,6 +12,8 @@
 #include <ctype.h>
 #include <string.h>
 
+#include <avr/pgmspace.h>
+
 #include "Parser.h"
 
 
@@ -52,6 +54,13 @@ NilParser::~NilParser()
 }
 
 bool NilParser::parse(const char* input)
+{
+    (void)input;
+
+    return true;
+}
+
+bool NilParser::parseByte(const char* /* input */, uint8_t /* length */)
 {
     return true;
 }
@@ -90,17 +99,20 @@ bool CharGroupParser::parse(const char* input)
     return false;
 }
 
+bool CharGroupParser::parseByte(const char* input, uint8_t length)
+{
+    if (length == 1)
+    {
+        return parse(input);
+    }
+
+    return (m_index != -1);
+}
+
 
 /*!
     @brief Parser class that accepts only strings given
 */
-StringGroupParser::StringGroupParser(const char* accept_strs[], const uint8_t size)
-    : m_accept_strs(accept_strs)
-    , m_size(size)
-{
-    // no operations.
-}
-
 StringGroupParser::~StringGroupParser()
 {
     // no operations.
@@ -114,13 +126,13 @@ bool StringGroupParser::parse(const char* input)
 
     while (begin <= end)
     {
-        if (strlen(input) != strlen(m_accept_strs[middle]))
+        if (strlen(input) != strlen_P(m_acceptStr(middle)))
         {
             m_index = -1;
             return false;
         }
 
-        int result = strcasecmp(input, m_accept_strs[middle]);
+        int result = strcasecmp_P(input, m_acceptStr(middle));
 
         if (result == 0)
         {
@@ -149,6 +161,35 @@ bool StringGroupParser::parse(const char* input)
     return false;
 }
 
+bool StringGroupParser::parseByte(const char* input, uint8_t length)
+{
+    int8_t begin = 0;
+    int8_t end   = m_size - 1;
+
+    m_index = -1;
+
+    // The condition strings are sorted, so are their prefixes.
+    while (begin <= end)
+    {
+        const int8_t middle = (begin + end) / 2;
+        const int    result = strncasecmp_P(input, m_acceptStr(middle), length);
+
+        if (result == 0)
+        {
+            if (pgm_read_byte(m_acceptStr(middle) + length) == '\0')
+            {
+                m_index = middle;
+            }
+
+            return true;
+        }
+
+        (result > 0)? (begin = middle + 1) : (end = middle - 1);
+    }
+
+    return false;
+}
+
 
 /*!
     @brief Parser class that accepts only hex string
@@ -178,6 +219,78 @@ bool HexStringParser::parse(const char* input)
     return true;
 }
 
+bool HexStringParser::parseByte(const char* input, uint8_t length)
+{
+    m_index = (isxdigit(input[length - 1]) == 0)? -1 : 0;
+
+    return (m_index == 0);
+}
+
+
+/*!
+    @brief Parser class that accepts only a length-prefixed and CRC-checked binary frame
+*/
+BinaryParser::BinaryParser()
+    : m_crc(0xFFFF)
+{
+    // no operations.
+}
+
+BinaryParser::~BinaryParser()
+{
+    // no operations.
+}
+
+bool BinaryParser::parse(const char* input)
+{
+    const uint8_t* bytes  = reinterpret_cast<const uint8_t*>(input);
+    const uint8_t  length = PREFIX_LENGTH + bytes[0];
+
+    const uint16_t crc = bytes[length] | (static_cast<uint16_t>(bytes[length + 1]) << 8);
+
+    if (crc16(bytes, length) != crc)
+    {
+        m_index = -1;
+        return false;
+    }
+
+    m_index = 0;
+    return true;
+}
+
+bool BinaryParser::parseByte(const char* input, uint8_t length)
+{
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(input);
+    const uint8_t  end   = PREFIX_LENGTH + bytes[0];
+
+    m_index = -1;
+
+    if (length == 1)
+    {
+        m_crc = 0xFFFF;
+    }
+
+    if (length <= end)
+    {
+        m_crc = crc16(bytes + length - 1, 1, m_crc);
+
+        return true;
+    }
+
+    if (length < end + CRC_LENGTH)
+    {
+        return true;
+    }
+
+    if (m_crc != (bytes[end] | (static_cast<uint16_t>(bytes[end + 1]) << 8)))
+    {
+        return false;
+    }
+
+    m_index = 0;
+    return true;
+}
+
 
 /*!
     @brief Convert hex string to an uint16_t
@@ -225,4 +338,22 @@ int16_t hexbytes2int16_impl(const char* bytes, uint8_t size)
     return result;
 }
 
+/*!
+    @brief Calculate CRC-16/CCITT-FALSE
+*/
+uint16_t crc16(const uint8_t* bytes, uint8_t size, uint16_t crc)
+{
+    while (size--)
+    {
+        crc ^= static_cast<uint16_t>(*bytes++) << 8;
+
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000)? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+    }
+
+    return crc;
+}
+
 } // end of namespace "Utility".
\ No newline at end of file
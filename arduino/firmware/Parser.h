@@ -20,6 +20,7 @@ namespace Utility
     class CharGroupParser;
     class StringGroupParser;
     class HexStringParser;
+    class BinaryParser;
 
 
     /*!
@@ -74,6 +75,17 @@ namespace Utility
 
         return hexbytes2int16_impl(bytes, SIZE);
     }
+
+    /*!
+        @brief Calculate CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF)
+
+        @param [in] bytes Pointer of bytes.
+        @param [in] size  Length of bytes.
+        @param [in] crc   CRC of the bytes before them, to continue the calculation.
+
+        @return CRC
+    */
+    uint16_t crc16(const uint8_t* bytes, uint8_t size, uint16_t crc = 0xFFFF);
 }
 
 
@@ -107,6 +119,20 @@ public:
     */
     virtual bool parse(const char* input) = 0;
 
+    /*!
+        @brief Incremental parser function interface
+
+        Parse the last byte of the input, regarding the bytes before it as parsed by the method already,
+        so a token is validated in O(1) per byte while it is incoming.
+        After the last byte of a token, the result and index() are the same as parse() of the token.
+
+        @param [in] input  Bytes you want to parse. (They don't need to be NUL-terminated.)
+        @param [in] length Length of the input, so input[length - 1] is the byte appended.
+
+        @return Result (false if the input can't be accepted whatever follows it)
+    */
+    virtual bool parseByte(const char* input, uint8_t length) = 0;
+
     /*!
         @brief Get matched index of after parsing
 
@@ -142,6 +168,16 @@ public:
         @return true
     */
     virtual bool parse(const char* input);
+
+    /*!
+        @brief Do nothing
+
+        @param [in] input  Bytes you want to parse.
+        @param [in] length Length of the input.
+
+        @return true
+    */
+    virtual bool parseByte(const char* input, uint8_t length);
 };
 
 
@@ -201,15 +237,28 @@ public:
         @return Result
     */
     virtual bool parse(const char* input);
+
+    /*!
+        @brief Parse the last byte of input
+
+        Only the heading is validated, so the bytes after it are not parsed.
+
+        @param [in] input  Bytes you want to parse.
+        @param [in] length Length of the input.
+
+        @return Result
+    */
+    virtual bool parseByte(const char* input, uint8_t length);
 };
 
 
 /*!
     @brief Parser class that accepts only strings given
 
+    The condition strings are a table of fixed width in program space, so they don't take SRAM.
     Refer to the usage below.
     @code
-    const char* ACCEPT_STRS[] = {
+    PROGMEM const char ACCEPT_STRS[][3] = {
         "AA",
         "BB",
         "CC"
@@ -234,21 +283,34 @@ public:
 class Utility::StringGroupParser : public Utility::AbstractParser
 {
 private:
-    const char** m_accept_strs;
+    const char*   m_accept_strs; //!< Condition table in program space.
+    const uint8_t m_stride;      //!< Width of a row of the table. (Including the terminator.)
     const uint8_t m_size;
 
+    const char* m_acceptStr(uint8_t index) const
+    {
+        return m_accept_strs + static_cast<uint16_t>(m_stride) * index;
+    }
+
 public:
     /*!
         @brief Constructor
 
-        @param [in] accept_strs Pointer of condition array sorted with dictionary order.
-        @param [in] size        Size of the condition array.
+        @param [in] accept_strs Pointer of condition table in program space, sorted with dictionary order.
+        @param [in] size        Count of rows of the condition table.
 
         @attention
-        Should give the class array sorted with dictionary order,
+        Should give the class table sorted with dictionary order,
         because it runs binary search internally.
     */
-    StringGroupParser(const char* accept_strs[], uint8_t size);
+    template <uint8_t STRIDE>
+    StringGroupParser(const char (*accept_strs)[STRIDE], uint8_t size)
+        : m_accept_strs(accept_strs[0])
+        , m_stride(STRIDE)
+        , m_size(size)
+    {
+        // no operations.
+    }
 
     /*!
         @brief Destructor
@@ -263,6 +325,19 @@ public:
         @return Result
     */
     virtual bool parse(const char* input);
+
+    /*!
+        @brief Parse the last byte of input
+
+        The input is accepted while it is a prefix of a condition string,
+        and index() is the condition matched only if it is the whole string. (-1 otherwise.)
+
+        @param [in] input  Bytes you want to parse.
+        @param [in] length Length of the input.
+
+        @return Result
+    */
+    virtual bool parseByte(const char* input, uint8_t length);
 };
 
 
@@ -290,6 +365,70 @@ public:
         @return Result
     */
     virtual bool parse(const char* input);
+
+    /*!
+        @brief Parse the last byte of input
+
+        @param [in] input  Bytes you want to parse.
+        @param [in] length Length of the input.
+
+        @return Result
+    */
+    virtual bool parseByte(const char* input, uint8_t length);
+};
+
+/*!
+    @brief Parser class that accepts only a length-prefixed and CRC-checked binary frame
+
+    The input is expected as below, and its length is given by the heading byte:
+
+    | length (1 byte) | payload (**length** bytes) | CRC-16 (2 bytes, little endian) |
+
+    The CRC is calculated over the length byte and the payload (see crc16()).
+*/
+class Utility::BinaryParser : public Utility::AbstractParser
+{
+private:
+    uint16_t m_crc; //!< CRC of the bytes parsed by parseByte().
+
+public:
+    enum
+    {
+        PREFIX_LENGTH = 1, //!< Length of the length prefix.
+        CRC_LENGTH    = 2  //!< Length of the CRC.
+    };
+
+    /*!
+        @brief Constructor
+    */
+    BinaryParser();
+
+    /*!
+        @brief Destructor
+    */
+    virtual ~BinaryParser();
+
+    /*!
+        @brief Parse input frame
+
+        @param [in] input Frame you want to parse.
+
+        @return Result
+    */
+    virtual bool parse(const char* input);
+
+    /*!
+        @brief Parse the last byte of input frame
+
+        The CRC is updated by each byte, and compared after the last byte given by the length prefix.
+        index() is -1 until then.
+
+        @param [in] input  Frame you want to parse.
+        @param [in] length Length of the input.
+
+        @return Result
+    */
+    virtual bool parseByte(const char* input, uint8_t length);
 };
 
 #endif // UTILITY_PARSER_H
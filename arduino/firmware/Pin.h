@@ -54,6 +54,49 @@ namespace PLEN2
 
         //! @brief Input of random-device (Get an open circuit voltage.)
         enum { RANDOM_DEVICE_IN = 6 };
+
+
+        //! @brief I/O ports of Atmega32u4
+        enum PORT_ID
+        {
+            PORT_B,
+            PORT_C,
+            PORT_D,
+            PORT_E,
+            PORT_F
+        };
+
+        /*!
+            @brief Port and bit of a digital pin, for direct port access
+
+            Only the pins that need direct port access are defined,
+            so using the other pins is a compile time error.
+
+            @tparam PIN Digital pin number of Arduino Micro.
+        */
+        template<int PIN>
+        class PortBit;
+
+        template<>
+        class PortBit<MULTIPLEXER_SELECT0>
+        {
+        public:
+            enum { PORT = PORT_C, BIT = 6 }; // D5  := PC6
+        };
+
+        template<>
+        class PortBit<MULTIPLEXER_SELECT1>
+        {
+        public:
+            enum { PORT = PORT_D, BIT = 7 }; // D6  := PD7
+        };
+
+        template<>
+        class PortBit<MULTIPLEXER_SELECT2>
+        {
+        public:
+            enum { PORT = PORT_D, BIT = 6 }; // D12 := PD6
+        };
     }
 }
 
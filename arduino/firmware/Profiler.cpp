@@ -38,7 +38,7 @@ Utility::Profiler::Profiler(const __FlashStringHelper* fsh_ptr)
 
     m_tabbing();
     Serial.print(F("+++ stack ptr : "));
-    Serial.println(reinterpret_cast<uint16_t>(this), HEX);
+    Serial.println(reinterpret_cast<uintptr_t>(this), HEX);
 
     Shared::m_nest++;
     m_begin = micros();
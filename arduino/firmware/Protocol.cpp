@@ -24,35 +24,43 @@ namespace
 {
     namespace Shared
     {
-        const char* CONTROLLER_SYMBOL[] = {
+        PROGMEM const char CONTROLLER_SYMBOL[][3] = {
             "AD", // APPLY DIFF
             "AN", // APPLY NATIVE
+            "BD", // BULK APPLY DIFF
+            "BN", // BULK APPLY NATIVE
             "HP", // HOME POSITION
             "MP", // Alias of PLAY MOTION, @attention It will obsolescent in firmware version 2.x.
             "MS", // Alias of STOP MOTION, @attention It will obsolescent in firmware version 2.x.
             "PM", // PLAY MOTION
-            "SM"  // STOP MOTION
+            "SF", // STREAM FRAME
+            "SM", // STOP MOTION
+            "SP"  // SPEED
         };
-        const uint8_t CONTROLLER_ARGS_STORE_LENGTH[] = {
+        PROGMEM const uint8_t CONTROLLER_ARGS_STORE_LENGTH[] = {
             5,    // APPLY DIFF
             5,    // APPLY NATIVE
+            1,    // BULK APPLY DIFF, @attention It is the length prefix of a binary frame.
+            1,    // BULK APPLY NATIVE, @attention It is the length prefix of a binary frame.
             0,    // HOME POSITION
             2,    // PLAY MOTION, @attention It will obsolescent in firmware version 2.x.
             0,    // STOP MOTION, @attention It will obsolescent in firmware version 2.x.
             2,    // PLAY MOTION
-            0     // STOP MOTION
+            1,    // STREAM FRAME, @attention It is the length prefix of a binary frame.
+            0,    // STOP MOTION
+            4     // SPEED
         };
 
         enum { CONTROLLER_SYMBOL_LENGTH = sizeof(CONTROLLER_SYMBOL) / sizeof(CONTROLLER_SYMBOL[0]) };
         Utility::StringGroupParser controller_parser(CONTROLLER_SYMBOL, CONTROLLER_SYMBOL_LENGTH);
 
 
-        const char* INTERPRETER_SYMBOL[] = {
+        PROGMEM const char INTERPRETER_SYMBOL[][3] = {
             "PO", // POP CODE
             "PU", // PUSH CODE
             "RI"  // RESET INTERPRETER
         };
-        const uint8_t INTERPRETER_ARGS_STORE_LENGTH[] = {
+        PROGMEM const uint8_t INTERPRETER_ARGS_STORE_LENGTH[] = {
             0,    // POP CODE
             4,    // PUSH CODE
             0     // RESET INTERPRETER
@@ -62,35 +70,57 @@ namespace
         Utility::StringGroupParser interpreter_parser(INTERPRETER_SYMBOL, INTERPRETER_SYMBOL_LENGTH);
 
 
-        const char* SETTER_SYMBOL[] = {
+        PROGMEM const char SETTER_SYMBOL[][3] = {
             "HO", // HOME
             "JS", // JOINT SETTINGS
             "MA", // MAX
+            "MB", // MOTION FRAME (BINARY)
+            "MD", // MOTION DEFRAGMENT
             "MF", // MOTION FRAME
             "MH", // MOTION HEADER
-            "MI"  // MIN
+            "MI", // MIN
+            "PC", // PWM CALIBRATION
+            "RM", // REFRESH MODE
+            "SA", // SETTINGS (ALL JOINTS)
+            "SS", // SAVE SETTINGS
+            "TB"  // TRANSITION BLEND
         };
-        const uint8_t SETTER_ARGS_STORE_LENGTH[] = {
+        PROGMEM const uint8_t SETTER_ARGS_STORE_LENGTH[] = {
             5,    // HOME
             0,    // RESET JOINT SETTINGS
             5,    // MAX
+            1,    // MOTION FRAME (BINARY), @attention It is the length prefix, and the rest is decided by it.
+            0,    // MOTION DEFRAGMENT
             104,  // MOTION FRAME
             35,   // MOTION HEADER
-            5     // MIN
+            5,    // MIN
+            7,    // PWM CALIBRATION
+            2,    // REFRESH MODE
+            1,    // SETTINGS (ALL JOINTS), @attention It is the length prefix of a binary frame.
+            0,    // SAVE SETTINGS
+            4     // TRANSITION BLEND
         };
 
         enum { SETTER_SYMBOL_LENGTH = sizeof(SETTER_SYMBOL) / sizeof(SETTER_SYMBOL[0]) };
         Utility::StringGroupParser setter_parser(SETTER_SYMBOL, SETTER_SYMBOL_LENGTH);
 
 
-        const char* GETTER_SYMBOL[] = {
+        PROGMEM const char GETTER_SYMBOL[][3] = {
+            "DI", // DIAGNOSTICS
             "JS", // JOINT SETTINGS
+            "MC", // MOTION CACHE
             "MO", // MOTION
+            "MT", // MOTION TABLE
+            "MV", // MOTION VALIDITY
             "VI"  // VERSION INFORMATION
         };
-        const uint8_t GETTER_ARGS_STORE_LENGTH[] = {
+        PROGMEM const uint8_t GETTER_ARGS_STORE_LENGTH[] = {
+            0,    // DIAGNOSTICS
             0,    // JOINT SETTINGS
+            0,    // MOTION CACHE
             2,    // MOTION
+            0,    // MOTION TABLE
+            0,    // MOTION VALIDITY
             0     // VERSION INFORMATION
         };
 
@@ -114,7 +144,7 @@ namespace
             &getter_parser
         };
 
-        const unsigned char* ARGS_STORE_LENGTH[] = {
+        PROGMEM const uint8_t* const ARGS_STORE_LENGTH[] = {
             CONTROLLER_ARGS_STORE_LENGTH,
             INTERPRETER_ARGS_STORE_LENGTH,
             SETTER_ARGS_STORE_LENGTH,
@@ -148,18 +178,26 @@ void PLEN2::Protocol::m_abort()
     m_store_length    = 1;
     m_state           = READY;
     m_installing      = false;
+    m_rejected        = false;
+    m_discard_length  = 0;
     m_buffer.position = 0;
 }
 
 
-PLEN2::Protocol::Protocol()
-    : m_store_length(1)
+PLEN2::Protocol::Protocol(char buffer[], uint8_t length)
+    : m_buffer(buffer, length)
     , m_state(READY)
+    , m_store_length(1)
     , m_installing(false)
+    , m_rejected(false)
+    , m_header_id(-1)
+    , m_command_id(-1)
+    , m_discard_length(0)
 {
     m_parser[HEADER_INCOMING]    = &Shared::header_parser;
     m_parser[COMMAND_INCOMING]   = Shared::command_parser[0];
     m_parser[ARGUMENTS_INCOMING] = &Shared::args_parser;
+    m_parser[BINARY_INCOMING]    = &m_binary_parser;
 }
 
 
@@ -170,10 +208,55 @@ void PLEN2::Protocol::readByte(char byte)
     #endif
 
 
+    // The rest of a binary frame rejected is discarded.
+    if (m_discard_length != 0)
+    {
+        m_discard_length--;
+
+        return;
+    }
+
+    // The token is longer than expected.
+    if (m_buffer.position >= m_store_length)
+    {
+        m_rejected = true;
+    }
+
     m_buffer.data[m_buffer.position] = byte;
-    (++m_buffer.position) &= (Buffer::LENGTH - 1);
 
-    m_buffer.data[m_buffer.position] = '\0';
+    if (++m_buffer.position >= m_buffer.length)
+    {
+        m_buffer.position = 0;
+    }
+
+    if (m_rejected)
+    {
+        return;
+    }
+
+    if (m_parser[m_state]->parseByte(m_buffer.data, m_buffer.position) == false)
+    {
+        m_rejected = true;
+
+        return;
+    }
+
+    // The length prefix of a binary frame has been received, so wait for the rest.
+    if (   (m_state == BINARY_INCOMING)
+        && (m_buffer.position == Utility::BinaryParser::PREFIX_LENGTH) )
+    {
+        const uint8_t length = static_cast<uint8_t>(m_buffer.data[0]);
+
+        if (length > (m_buffer.length - 1 - Utility::BinaryParser::PREFIX_LENGTH - Utility::BinaryParser::CRC_LENGTH))
+        {
+            m_rejected       = true;
+            m_discard_length = length + Utility::BinaryParser::CRC_LENGTH;
+
+            return;
+        }
+
+        m_store_length = Utility::BinaryParser::PREFIX_LENGTH + length + Utility::BinaryParser::CRC_LENGTH;
+    }
 }
 
 
@@ -184,19 +267,17 @@ bool PLEN2::Protocol::accept()
     #endif
 
 
-    if (m_buffer.position < m_store_length)
+    if (m_rejected)
     {
-        return false;
-    }
-
-    if (m_parser[m_state]->parse(m_buffer.data) == false)
-    {
-        m_abort();
+        if (m_discard_length == 0)
+        {
+            m_abort();
+        }
 
         return false;
     }
 
-    return true;
+    return (m_buffer.position >= m_store_length);
 }
 
 
@@ -214,7 +295,8 @@ void PLEN2::Protocol::transitState()
         case HEADER_INCOMING:
         {
             m_state = COMMAND_INCOMING;
-            m_parser[COMMAND_INCOMING] = Shared::command_parser[m_parser[HEADER_INCOMING]->index()];
+            m_header_id = m_parser[HEADER_INCOMING]->index();
+            m_parser[COMMAND_INCOMING] = Shared::command_parser[m_header_id];
             m_store_length = 2;
 
             break;
@@ -223,21 +305,49 @@ void PLEN2::Protocol::transitState()
         case COMMAND_INCOMING:
         {
             m_state = ARGUMENTS_INCOMING;
+            m_command_id = m_parser[COMMAND_INCOMING]->index();
 
             // Partial specialization for a command
-            if (m_parser[HEADER_INCOMING]->index() == 2 /* := Setter */)
+            if (m_header_id == 0 /* := Controller */)
+            {
+                // If accepted BULK APPLY DIFF or BULK APPLY NATIVE command, receive a binary frame.
+                if (   (m_command_id == 2 /* := BULK APPLY DIFF */)
+                    || (m_command_id == 3 /* := BULK APPLY NATIVE */) )
+                {
+                    m_state = BINARY_INCOMING;
+                }
+
+                // If accepted STREAM FRAME command, receive a binary frame.
+                if (m_command_id == 8 /* := STREAM FRAME */)
+                {
+                    m_state = BINARY_INCOMING;
+                }
+            }
+
+            if (m_header_id == 2 /* := Setter */)
             {
                 // If accepted SET MOTION HEADER command, change to no-validation mode.
-                if (m_parser[COMMAND_INCOMING]->index() == 4 /* := MOTION HEADER */)
+                if (m_command_id == 6 /* := MOTION HEADER */)
                 {
                     m_parser[ARGUMENTS_INCOMING] = &Shared::nil_parser;
                 }
-            }
 
-            uint8_t header_id = m_parser[HEADER_INCOMING ]->index();
-            uint8_t cmd_id    = m_parser[COMMAND_INCOMING]->index();
+                // If accepted SET MOTION FRAME (BINARY) command, receive a binary frame.
+                if (m_command_id == 3 /* := MOTION FRAME (BINARY) */)
+                {
+                    m_state = BINARY_INCOMING;
+                }
+
+                // If accepted SET SETTINGS (ALL JOINTS) command, receive a binary frame.
+                if (m_command_id == 10 /* := SETTINGS (ALL JOINTS) */)
+                {
+                    m_state = BINARY_INCOMING;
+                }
+            }
 
-            m_store_length = Shared::ARGS_STORE_LENGTH[header_id][cmd_id];
+            m_store_length = pgm_read_byte(
+                reinterpret_cast<const uint8_t*>(pgm_read_ptr(Shared::ARGS_STORE_LENGTH + m_header_id)) + m_command_id
+            );
 
             // If satisfy the following condition, transit READY state because the command has no arguments.
             if (m_store_length == 0)
@@ -246,10 +356,17 @@ void PLEN2::Protocol::transitState()
                 m_store_length = 1;
             }
 
+            // The arguments don't fit in the buffer of the session, so they are rejected.
+            if (m_store_length >= m_buffer.length)
+            {
+                m_rejected = true;
+            }
+
             break;
         }
 
         case ARGUMENTS_INCOMING:
+        case BINARY_INCOMING:
         {
             m_state = READY;
             m_parser[ARGUMENTS_INCOMING] = &Shared::args_parser;
@@ -13,22 +13,22 @@
 
 #include <stdint.h>
 
+#include "Parser.h"
+
 namespace PLEN2
 {
     class Protocol;
 }
 
-namespace Utility
-{
-    class AbstractParser;
-}
-
 /*!
     @brief Analysis class of the PLEN2's protocol
 
     The class only analyses the command line given,
     so you should override the event handler(s) by inheriting the class yourself.
 
+    An instance is a session of a transport (e.g. USB serial or BLE serial), so bytes of the transports
+    can be interleaved by giving them to each instance. The parsers that have no state between bytes are shared by the instances.
+
     Please see the virtual methods to get more details.
 */
 class PLEN2::Protocol
@@ -43,34 +43,34 @@ protected:
         HEADER_INCOMING = 0, //!< Will receive string that might be HEADER. (Alias of state READY.)
         COMMAND_INCOMING,    //!< Will receive string that might be COMMAND.
         ARGUMENTS_INCOMING,  //!< Will receive string that might be ARGUMENTS.
+        BINARY_INCOMING,     //!< Will receive a length-prefixed binary frame as ARGUMENTS.
         STATE_EOE            //!< Summation of the states.
     } State;
 
     /*!
         @brief Buffer struct
+
+        A token (HEADER, COMMAND or ARGUMENTS) is stored from the head of the buffer, and validated byte by byte
+        while it is incoming, so the event handlers read its arguments in place without copying them.
+        The storage is given by the owner of the session, so a transport that doesn't take long commands
+        can have a shorter buffer.
     */
     class Buffer
     {
     public:
-        /*!
-            @brief Buffer length
-
-            @attention
-            The value is required to be at least more than BLE payload length (= 20 bytes),
-            and it should be defined 2^N length for processing the class with high speed.
-        */
-        enum { LENGTH = 128 };
-
-        char    data[LENGTH]; //!< Actual buffer instance.
-        uint8_t position;     //!< Current iterator's position.
+        char* const   data;     //!< Actual buffer instance.
+        const uint8_t length;   //!< Buffer length.
+        uint8_t       position; //!< Current iterator's position.
 
         /*!
             @brief Constructor
         */
-        Buffer()
-            : position(0)
+        Buffer(char data_[], uint8_t length_)
+            : data(data_)
+            , length(length_)
+            , position(0)
         {
-            for (uint8_t index = 0; index < LENGTH; index++)
+            for (uint8_t index = 0; index < length; index++)
             {
                 data[index] = '\0';
             }
@@ -81,6 +81,11 @@ protected:
     State   m_state;
     uint8_t m_store_length;
     bool    m_installing;
+    bool    m_rejected; //!< A byte of the token was rejected, so accept() aborts analysis.
+    int8_t  m_header_id;  //!< Index of HEADER accepted.
+    int8_t  m_command_id; //!< Index of COMMAND accepted.
+    uint16_t m_discard_length; //!< Bytes of a binary frame rejected that are still incoming.
+    Utility::BinaryParser    m_binary_parser; //!< It keeps CRC of the frame incoming, so it is not shared.
     Utility::AbstractParser* m_parser[STATE_EOE];
 
     /*!
@@ -89,10 +94,25 @@ protected:
     void m_abort();
 
 public:
+    /*!
+        @brief Buffer length of a session that accepts all commands
+
+        @attention
+        The value is required to be at least more than BLE payload length (= 20 bytes),
+        and more than the longest token, that is a binary frame of ">SA" (= 111 bytes).
+    */
+    enum { SESSION_BUFFER_LENGTH = 112 };
+
     /*!
         @brief Constructor
+
+        @param [in] buffer Please set storage of the buffer, that must be alive while the session is.
+        @param [in] length Please set length of the storage. (SESSION_BUFFER_LENGTH accepts all commands.)
+
+        @attention
+        A command whose ARGUMENTS are longer than the buffer is rejected.
     */
-    Protocol();
+    Protocol(char buffer[], uint8_t length);
 
     /*!
         @brief Destructor
@@ -100,7 +120,10 @@ public:
     virtual ~Protocol() {}
 
     /*!
-        @brief Read a character, and store it in the ring buffer
+        @brief Read a character, store it in the buffer, and validate it
+
+        The byte is parsed incrementally (see Utility::AbstractParser::parseByte()),
+        so the cost of the method doesn't depend on the length of the token.
 
         @param [in] byte A character.
     */
@@ -109,7 +132,11 @@ public:
     /*!
         @brief Accept buffered string considering internal state
 
-        @return Result
+        The method aborts analysis if a byte has been rejected by readByte().
+        If the byte is in a binary frame, analysis is aborted after the rest of the frame given by its length prefix,
+        so the bytes of the payload are not analysed as a new command.
+
+        @return Result (true if the token is completed)
     */
     bool accept();
 
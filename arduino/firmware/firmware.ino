@@ -20,8 +20,8 @@
 #include <string.h>
 
 #include <EEPROM.h>
-#include <Wire.h>
 
+#include "BuildConfig.h"
 #include "ExternalEEPROM.h"
 #include "JointController.h"
 #include "Motion.h"
@@ -60,20 +60,155 @@ namespace
 
     /*!
         The application instance
+
+        An instance is made for each transport (see Protocol), and they share the event handlers.
     */
     class Application : public Protocol
     {
     private:
-        static void (Application::*CONTROLLER_EVENT_HANDLER[])();
-        static void (Application::*INTERPRETER_EVENT_HANDLER[])();
-        static void (Application::*SETTER_EVENT_HANDLER[])();
-        static void (Application::*GETTER_EVENT_HANDLER[])();
+        typedef void (Application::*EventHandler)();
+
+        // The tables are in program space, so they don't take SRAM. (See afterHook().)
+        static const EventHandler CONTROLLER_EVENT_HANDLER[];
+        static const EventHandler INTERPRETER_EVENT_HANDLER[];
+        static const EventHandler SETTER_EVENT_HANDLER[];
+        static const EventHandler GETTER_EVENT_HANDLER[];
+
+        static const EventHandler* const EVENT_HANDLER[];
+
+        enum { JOINT_MASK_LENGTH = (JointController::JOINTS_SUM + 7) / 8 }; //!< Bytes of a joint mask of "$BD" and "$BN".
+
+        /*!
+            @note
+            An event handler runs to the end at once, and uses only one of the temporaries,
+            so the instances and the handlers share their memory.
+        */
+        union Temporary
+        {
+            Motion::Header    header;
+            Motion::Frame     frame;
+            Interpreter::Code code;
+        };
+
+        static Temporary m_tmp;
+
+        /*!
+            @brief Decode a binary frame validated by Utility::BinaryParser
+
+            The payload is | (prefix_length bytes) | transition_time_ms (2) | output (2 * JOINTS_SUM) | easing (1) |
+            with little endian, the same as the memory image of Motion::Frame on AVR.
+            The easing is optional, and EASING_LINEAR is used if it is omitted.
+
+            @param [in]  prefix_length Length of arguments before transition_time_ms.
+            @param [out] frame         An instance of frame. (Its index is not touched.)
+
+            @return Result (false if the payload length is invalid)
+        */
+        bool decodeFrameBinary(uint8_t prefix_length, Motion::Frame& frame)
+        {
+            const uint8_t  length  = static_cast<uint8_t>(m_buffer.data[0]);
+            const uint8_t* payload = reinterpret_cast<const uint8_t*>(m_buffer.data)
+                                   + Utility::BinaryParser::PREFIX_LENGTH + prefix_length;
+
+            const uint8_t length_min = prefix_length + sizeof(uint16_t) + sizeof(frame.joint_angle);
+
+            if (   (length != length_min)
+                && (length != length_min + sizeof(frame.easing)) )
+            {
+                #if DEBUG
+                    System::debugSerial().println(F(">>> error : Invalid payload length."));
+                #endif
+
+                return false;
+            }
+
+            frame.transition_time_ms = payload[0] | (static_cast<uint16_t>(payload[1]) << 8);
+
+            memcpy(frame.joint_angle, payload + 2, sizeof(frame.joint_angle));
+
+            frame.easing = (length > length_min)?
+                payload[2 + sizeof(frame.joint_angle)] : static_cast<uint8_t>(Motion::Frame::EASING_LINEAR);
+
+            return true;
+        }
+
+        /*!
+            @brief Get an angle from angles packed as 12bit two's complement
+
+            Each pair of angles a, b takes 3 bytes:
+            | a & 0xFF | ((a >> 8) & 0x0F) + ((b & 0x0F) << 4) | (b >> 4) & 0xFF |
+
+            @param [in] packed Packed angles.
+            @param [in] index  Index of the angle.
+
+            @return Angle
+        */
+        static int16_t unpackAngle(const uint8_t packed[], uint8_t index)
+        {
+            const uint8_t* it = packed + index / 2 * 3;
+
+            const uint16_t angle = (index & 0x1)?
+                  ((it[1] >> 4) | (static_cast<uint16_t>(it[2]) << 4))
+                : (it[0] | (static_cast<uint16_t>(it[1] & 0x0F) << 8));
 
-        static void (Application::**EVENT_HANDLER[])();
+            // Sign extension of 12bit
+            return static_cast<int16_t>(angle << 4) >> 4;
+        }
+
+        /*!
+            @brief Apply angles of joints given as binary, and commit them at once
+
+            The payload is | joint mask (3) | angles (3 per 2 joints) |.
+            The bit N of the mask (little endian) is joint N, and the angles of the joints in the mask
+            follow in ascending order, packed by 12bit two's complement (see unpackAngle()).
+            The last angle of an odd count takes 2 bytes.
+
+            @param [in] diff Apply the angles as angle-diffs from the home angles.
+        */
+        void applyBulk(bool diff)
+        {
+            const uint8_t  length  = static_cast<uint8_t>(m_buffer.data[0]);
+            const uint8_t* payload = reinterpret_cast<const uint8_t*>(m_buffer.data)
+                                   + Utility::BinaryParser::PREFIX_LENGTH;
 
-        Motion::Header    m_header_tmp;
-        Motion::Frame     m_frame_tmp;
-        Interpreter::Code m_code_tmp;
+            uint8_t count = 0;
+
+            for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+            {
+                count += (payload[joint_id / 8] >> (joint_id % 8)) & 0x1;
+            }
+
+            if (length != JOINT_MASK_LENGTH + (count * 3 + 1) / 2)
+            {
+                #if DEBUG
+                    System::debugSerial().println(F(">>> error : Invalid payload length."));
+                #endif
+
+                return;
+            }
+
+            const uint8_t* angles = payload + JOINT_MASK_LENGTH;
+            uint8_t index = 0;
+
+            for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+            {
+                if (!((payload[joint_id / 8] >> (joint_id % 8)) & 0x1))
+                {
+                    continue;
+                }
+
+                if (diff)
+                {
+                    joint_ctrl.setAngleDiff(joint_id, unpackAngle(angles, index++));
+                }
+                else
+                {
+                    joint_ctrl.setAngle(joint_id, unpackAngle(angles, index++));
+                }
+            }
+
+            joint_ctrl.commitFrame();
+        }
 
         void applyDiff()
         {
@@ -103,6 +238,7 @@ namespace
             joint_ctrl.setAngleDiff(
                 args::joint_id(m_buffer.data), args::angle_diff(m_buffer.data)
             );
+            joint_ctrl.commitFrame();
         }
 
         void apply()
@@ -133,6 +269,25 @@ namespace
             joint_ctrl.setAngle(
                 args::joint_id(m_buffer.data), args::angle(m_buffer.data)
             );
+            joint_ctrl.commitFrame();
+        }
+
+        void applyBulkDiff()
+        {
+            #if DEBUG
+                PROFILING("Application::applyBulkDiff()");
+            #endif
+
+            applyBulk(true);
+        }
+
+        void applyBulkNative()
+        {
+            #if DEBUG
+                PROFILING("Application::applyBulkNative()");
+            #endif
+
+            applyBulk(false);
         }
 
         void homePosition()
@@ -164,6 +319,25 @@ namespace
             motion_ctrl.play(args::slot(m_buffer.data));
         }
 
+        /*!
+            @brief Push a frame given as binary to the stream
+
+            The payload is | transition_time_ms (2) | output (2 * JOINTS_SUM) | (see decodeFrameBinary()).
+        */
+        void streamFrame()
+        {
+            #if DEBUG
+                PROFILING("Application::streamFrame()");
+            #endif
+
+            if (!decodeFrameBinary(0, m_tmp.frame))
+            {
+                return;
+            }
+
+            motion_ctrl.pushStreamFrame(m_tmp.frame);
+        }
+
         void stopMotion()
         {
             #if DEBUG
@@ -173,6 +347,26 @@ namespace
             motion_ctrl.willStop();
         }
 
+        void setSpeed()
+        {
+            struct args
+            {
+                static uint16_t speed(char data[])
+                {
+                    return Utility::hexbytes2uint16<4>(data);
+                }
+            };
+
+            #if DEBUG
+                PROFILING("Application::setSpeed()");
+
+                System::debugSerial().print(F(">>> speed : "));
+                System::debugSerial().println(args::speed(m_buffer.data));
+            #endif
+
+            motion_ctrl.setSpeed(args::speed(m_buffer.data));
+        }
+
         void popCode()
         {
             #if DEBUG
@@ -212,10 +406,10 @@ namespace
                 Currently, official controller applications send loop_count that is 'expected value + 1',
                 thus the firmware must adjust recieved loop_count subtracting 1.
             */
-            m_code_tmp.slot       = args::slot(m_buffer.data);
-            m_code_tmp.loop_count = args::loop_count(m_buffer.data) - 1; // (*)
+            m_tmp.code.slot       = args::slot(m_buffer.data);
+            m_tmp.code.loop_count = args::loop_count(m_buffer.data) - 1; // (*)
 
-            interpreter.pushCode(m_code_tmp);
+            interpreter.pushCode(m_tmp.code);
         }
 
         void resetInterpreter()
@@ -297,6 +491,56 @@ namespace
             );
         }
 
+        /*!
+            @brief Install a frame given as binary
+
+            The payload is | slot (1) | frame_id (1) | transition_time_ms (2) | output (2 * JOINTS_SUM) |
+            (see decodeFrameBinary()).
+        */
+        void setMotionFrameBinary()
+        {
+            struct args
+            {
+                static uint8_t slot(char data[])
+                {
+                    return static_cast<uint8_t>(data[Utility::BinaryParser::PREFIX_LENGTH]);
+                }
+
+                static uint8_t frame_id(char data[])
+                {
+                    return static_cast<uint8_t>(data[Utility::BinaryParser::PREFIX_LENGTH + 1]);
+                }
+            };
+
+            #if DEBUG
+                PROFILING("Application::setMotionFrameBinary()");
+
+                System::debugSerial().print(F(">>> slot : "));
+                System::debugSerial().println(args::slot(m_buffer.data));
+
+                System::debugSerial().print(F(">>> frame_id : "));
+                System::debugSerial().println(args::frame_id(m_buffer.data));
+            #endif
+
+            if (!decodeFrameBinary(2, m_tmp.frame))
+            {
+                return;
+            }
+
+            m_tmp.frame.index = args::frame_id(m_buffer.data);
+
+            Motion::Frame::set(args::slot(m_buffer.data), m_tmp.frame.index, m_tmp.frame);
+        }
+
+        void defragmentMotions()
+        {
+            #if DEBUG
+                PROFILING("Application::defragmentMotions()");
+            #endif
+
+            Motion::defragment();
+        }
+
         void setMotionFrame()
         {
             struct args
@@ -343,16 +587,18 @@ namespace
                 }
             #endif
 
-            m_frame_tmp.index              = args::frame_id(m_buffer.data);
-            m_frame_tmp.transition_time_ms = args::transition_time_ms(m_buffer.data);
+            m_tmp.frame.index              = args::frame_id(m_buffer.data);
+            m_tmp.frame.transition_time_ms = args::transition_time_ms(m_buffer.data);
 
             for (uint8_t device_id = 0; device_id < JointController::JOINTS_SUM; device_id++)
             {
-                m_frame_tmp.joint_angle[device_id] = args::output(m_buffer.data, device_id);
+                m_tmp.frame.joint_angle[device_id] = args::output(m_buffer.data, device_id);
             }
 
+            m_tmp.frame.easing = Motion::Frame::EASING_LINEAR;
+
             Motion::Frame::set(
-                args::slot(m_buffer.data), args::frame_id(m_buffer.data), m_frame_tmp
+                args::slot(m_buffer.data), args::frame_id(m_buffer.data), m_tmp.frame
             );
         }
 
@@ -408,6 +654,12 @@ namespace
                     return ((data[32] != '0')? 1 : 0);
                 }
 
+                //! The digit of use_extra also carries flags of storage. (0x2 : delta-compressed frames)
+                static uint8_t use_delta(char data[])
+                {
+                    return ((Utility::hexbytes2uint16<1>(data + 32) & 0x2)? 1 : 0);
+                }
+
                 static uint8_t frame_length(char data[])
                 {
                     return Utility::hexbytes2uint16<2>(data + 33);
@@ -421,7 +673,7 @@ namespace
                 System::debugSerial().println(args::slot(m_buffer.data));
 
                 System::debugSerial().print(F(">>> name : "));
-                System::debugSerial().println(args::name(m_header_tmp, m_buffer.data));
+                System::debugSerial().println(args::name(m_tmp.header, m_buffer.data));
 
                 System::debugSerial().print(F(">>> use_loop : "));
                 System::debugSerial().println(args::use_loop(m_buffer.data));
@@ -445,17 +697,19 @@ namespace
                 System::debugSerial().println(args::frame_length(m_buffer.data));
             #endif
 
-            m_header_tmp.slot         = args::slot(m_buffer.data);
-            /* m_header_tmp.name */     args::name(m_header_tmp, m_buffer.data);
-            m_header_tmp.frame_length = args::frame_length(m_buffer.data);
-            m_header_tmp.use_loop     = args::use_loop(m_buffer.data);
-            m_header_tmp.loop_begin   = args::loop_begin(m_buffer.data);
-            m_header_tmp.loop_end     = args::loop_end(m_buffer.data);
-            m_header_tmp.loop_count   = args::loop_count(m_buffer.data);
-            m_header_tmp.use_jump     = args::use_jump(m_buffer.data);
-            m_header_tmp.jump_slot    = args::jump_slot(m_buffer.data);
-
-            Motion::Header::set(args::slot(m_buffer.data), m_header_tmp);
+            m_tmp.header.slot         = args::slot(m_buffer.data);
+            /* m_tmp.header.name */     args::name(m_tmp.header, m_buffer.data);
+            m_tmp.header.frame_length = args::frame_length(m_buffer.data);
+            m_tmp.header.use_loop     = args::use_loop(m_buffer.data);
+            m_tmp.header.loop_begin   = args::loop_begin(m_buffer.data);
+            m_tmp.header.loop_end     = args::loop_end(m_buffer.data);
+            m_tmp.header.loop_count   = args::loop_count(m_buffer.data);
+            m_tmp.header.use_jump     = args::use_jump(m_buffer.data);
+            m_tmp.header.jump_slot    = args::jump_slot(m_buffer.data);
+            m_tmp.header.NON_RESERVED = 0;
+            m_tmp.header.use_delta    = args::use_delta(m_buffer.data);
+
+            Motion::Header::set(args::slot(m_buffer.data), m_tmp.header);
         }
 
         void setMin()
@@ -488,6 +742,137 @@ namespace
             );
         }
 
+        void setPWMCalibration()
+        {
+            struct args
+            {
+                static uint16_t joint_id(char data[])
+                {
+                    return Utility::hexbytes2uint16<2>(data);
+                }
+
+                static uint16_t point(char data[])
+                {
+                    return Utility::hexbytes2uint16<1>(data + 2);
+                }
+
+                static uint16_t pwm(char data[])
+                {
+                    return Utility::hexbytes2uint16<4>(data + 3);
+                }
+            };
+
+            #if DEBUG
+                PROFILING("Application::setPWMCalibration()");
+
+                System::debugSerial().print(F(">>> joint_id : "));
+                System::debugSerial().println(args::joint_id(m_buffer.data));
+
+                System::debugSerial().print(F(">>> point : "));
+                System::debugSerial().println(args::point(m_buffer.data));
+
+                System::debugSerial().print(F(">>> pwm : "));
+                System::debugSerial().println(args::pwm(m_buffer.data));
+            #endif
+
+            joint_ctrl.setCalibration(
+                args::joint_id(m_buffer.data), args::point(m_buffer.data), args::pwm(m_buffer.data)
+            );
+        }
+
+        void setRefreshMode()
+        {
+            struct args
+            {
+                static uint16_t mode(char data[])
+                {
+                    return Utility::hexbytes2uint16<2>(data);
+                }
+            };
+
+            #if DEBUG
+                PROFILING("Application::setRefreshMode()");
+
+                System::debugSerial().print(F(">>> mode : "));
+                System::debugSerial().println(args::mode(m_buffer.data));
+            #endif
+
+            joint_ctrl.setRefreshMode(args::mode(m_buffer.data));
+        }
+
+        /*!
+            @brief Set all joint settings given as binary
+
+            The payload is JointController::SETTINGS_SUM angles (min, max and home of each joint)
+            packed as 12bit two's complement. (See unpackAngle().)
+        */
+        void setSettings()
+        {
+            #if DEBUG
+                PROFILING("Application::setSettings()");
+            #endif
+
+            const uint8_t  length  = static_cast<uint8_t>(m_buffer.data[0]);
+            const uint8_t* payload = reinterpret_cast<const uint8_t*>(m_buffer.data)
+                                   + Utility::BinaryParser::PREFIX_LENGTH;
+
+            if (length != JointController::SETTINGS_SUM / 2 * 3)
+            {
+                #if DEBUG
+                    System::debugSerial().println(F(">>> error : Invalid payload length."));
+                #endif
+
+                return;
+            }
+
+            int16_t settings[JointController::SETTINGS_SUM];
+
+            for (uint8_t index = 0; index < JointController::SETTINGS_SUM; index++)
+            {
+                settings[index] = unpackAngle(payload, index);
+            }
+
+            joint_ctrl.setSettings(settings);
+        }
+
+        void saveSettings()
+        {
+            #if DEBUG
+                PROFILING("Application::saveSettings()");
+            #endif
+
+            joint_ctrl.commitSettings();
+        }
+
+        void setTransitionBlend()
+        {
+            struct args
+            {
+                static uint16_t window_ms(char data[])
+                {
+                    return Utility::hexbytes2uint16<4>(data);
+                }
+            };
+
+            #if DEBUG
+                PROFILING("Application::setTransitionBlend()");
+
+                System::debugSerial().print(F(">>> window_ms : "));
+                System::debugSerial().println(args::window_ms(m_buffer.data));
+            #endif
+
+            motion_ctrl.setBlendWindow(args::window_ms(m_buffer.data));
+        }
+
+        void getDiagnostics()
+        {
+            #if DEBUG
+                PROFILING("Application::getDiagnostics()");
+            #endif
+
+            joint_ctrl.dumpDiagnostics();
+        }
+
         void getJointSettings()
         {
             #if DEBUG
@@ -497,6 +882,15 @@ namespace
             joint_ctrl.dump();
         }
 
+        void getMotionCache()
+        {
+            #if DEBUG
+                PROFILING("Application::getMotionCache()");
+            #endif
+
+            Motion::dumpCache();
+        }
+
         void getMotion()
         {
             struct args
@@ -517,6 +911,24 @@ namespace
             motion_ctrl.dump(args::slot(m_buffer.data));
         }
 
+        void getMotionTable()
+        {
+            #if DEBUG
+                PROFILING("Application::getMotionTable()");
+            #endif
+
+            Motion::dumpTable();
+        }
+
+        void getMotionValidity()
+        {
+            #if DEBUG
+                PROFILING("Application::getMotionValidity()");
+            #endif
+
+            Motion::dumpValidity();
+        }
+
         void getVersionInformation()
         {
             #if DEBUG
@@ -527,6 +939,18 @@ namespace
         }
 
     public:
+        /*!
+            @brief Constructor
+
+            @param [in] buffer Storage of the buffer of the session.
+            @param [in] length Length of the storage.
+        */
+        Application(char buffer[], uint8_t length)
+            : Protocol(buffer, length)
+        {
+            // noop.
+        }
+
         virtual void afterHook()
         {
             #if DEBUG
@@ -535,10 +959,14 @@ namespace
 
             if (m_state == HEADER_INCOMING)
             {
-                uint8_t header_id = m_parser[HEADER_INCOMING ]->index();
-                uint8_t cmd_id    = m_parser[COMMAND_INCOMING]->index();
+                const EventHandler* handlers = reinterpret_cast<const EventHandler*>(
+                    pgm_read_ptr(EVENT_HANDLER + m_header_id)
+                );
+                EventHandler handler;
 
-                (this->*EVENT_HANDLER[header_id][cmd_id])();
+                memcpy_P(&handler, handlers + m_command_id, sizeof(handler));
+
+                (this->*handler)();
 
                 #if ENSOUL_PLEN2
                     soul.userActionInputed();
@@ -547,45 +975,70 @@ namespace
         }
     };
 
-    void (Application::*Application::CONTROLLER_EVENT_HANDLER[])() = {
+    PROGMEM const Application::EventHandler Application::CONTROLLER_EVENT_HANDLER[] = {
         &Application::applyDiff,
         &Application::apply,
+        &Application::applyBulkDiff,
+        &Application::applyBulkNative,
         &Application::homePosition,
         &Application::playMotion,
         &Application::stopMotion,
         &Application::playMotion,
-        &Application::stopMotion
+        &Application::streamFrame,
+        &Application::stopMotion,
+        &Application::setSpeed
     };
 
-    void (Application::*Application::INTERPRETER_EVENT_HANDLER[])() = {
+    PROGMEM const Application::EventHandler Application::INTERPRETER_EVENT_HANDLER[] = {
         &Application::popCode,
         &Application::pushCode,
         &Application::resetInterpreter
     };
 
-    void (Application::*Application::SETTER_EVENT_HANDLER[])() = {
+    PROGMEM const Application::EventHandler Application::SETTER_EVENT_HANDLER[] = {
         &Application::setHome,
         &Application::setJointSettings,
         &Application::setMax,
+        &Application::setMotionFrameBinary,
+        &Application::defragmentMotions,
         &Application::setMotionFrame,
         &Application::setMotionHeader,
-        &Application::setMin
+        &Application::setMin,
+        &Application::setPWMCalibration,
+        &Application::setRefreshMode,
+        &Application::setSettings,
+        &Application::saveSettings,
+        &Application::setTransitionBlend
     };
 
-    void (Application::*Application::GETTER_EVENT_HANDLER[])() = {
+    PROGMEM const Application::EventHandler Application::GETTER_EVENT_HANDLER[] = {
+        &Application::getDiagnostics,
         &Application::getJointSettings,
+        &Application::getMotionCache,
         &Application::getMotion,
+        &Application::getMotionTable,
+        &Application::getMotionValidity,
         &Application::getVersionInformation
     };
 
-    void (Application::**Application::EVENT_HANDLER[])() = {
+    PROGMEM const Application::EventHandler* const Application::EVENT_HANDLER[] = {
         Application::CONTROLLER_EVENT_HANDLER,
         Application::INTERPRETER_EVENT_HANDLER,
         Application::SETTER_EVENT_HANDLER,
         Application::GETTER_EVENT_HANDLER
     };
 
-    Application app;
+    Application::Temporary Application::m_tmp;
+
+    /*!
+        The BLE serial session has a shorter buffer, so commands longer than it are accepted only on USB serial.
+        (See BLE_BUFFER_LENGTH.)
+    */
+    char usb_buffer[Protocol::SESSION_BUFFER_LENGTH];
+    char ble_buffer[BLE_BUFFER_LENGTH];
+
+    Application usb_app(usb_buffer, sizeof(usb_buffer));
+    Application ble_app(ble_buffer, sizeof(ble_buffer));
 }
 
 
@@ -606,6 +1059,8 @@ void setup()
 {
     PLEN2::System::begin();
     PLEN2::ExternalEEPROM::begin();
+    PLEN2::Motion::migrateLayout();
+    PLEN2::Motion::validate();
 
     joint_ctrl.loadSettings();
 
@@ -634,6 +1089,12 @@ void setup()
 */
 void loop()
 {
+    // Carry out a queued transaction of external EEPROM (e.g. writing a motion being installed).
+    PLEN2::ExternalEEPROM::poll();
+
+    // Append a part of the joint settings changed to the journal on internal EEPROM.
+    joint_ctrl.persistSettings();
+
     if (motion_ctrl.playing())
     {
         if (motion_ctrl.frameUpdatable())
@@ -657,26 +1118,37 @@ void loop()
                 }
             }
         }
+        else
+        {
+            // Start the next motion in the tail of the motion playing, to blend them.
+            if (   motion_ctrl.blendable()
+                && interpreter.ready() )
+            {
+                interpreter.popCode();
+            }
+
+            // Read ahead the next frame while waiting for the next update.
+            motion_ctrl.prefetchFrame();
+        }
     }
 
     if (PLEN2::System::USBSerial().available())
     {
-        app.readByte(PLEN2::System::USBSerial().read());
+        usb_app.readByte(PLEN2::System::USBSerial().read());
 
-        if (app.accept())
+        if (usb_app.accept())
         {
-            app.transitState();
-
+            usb_app.transitState();
         }
     }
 
     if (PLEN2::System::BLESerial().available())
     {
-        app.readByte(PLEN2::System::BLESerial().read());
+        ble_app.readByte(PLEN2::System::BLESerial().read());
 
-        if (app.accept())
+        if (ble_app.accept())
         {
-            app.transitState();
+            ble_app.transitState();
         }
     }
 
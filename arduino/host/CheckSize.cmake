@@ -0,0 +1,58 @@
+#
+#   Copyright (c) 2015,
+#   - Kazuyuki TAKASE - https://github.com/Guvalif
+#   - PLEN Project Company Inc. - https://plen.jp
+#
+#   This software is released under the MIT License.
+#   (See also : http://opensource.org/licenses/mit-license.php)
+#
+#   Build the firmware for the robot, and check its size against the budget.
+#   (Run by the "firmware.size" test in CMakeLists.txt.)
+#
+#   -DARDUINO_CLI=<path> -DAVR_SIZE=<path> -DFQBN=<board>
+#   -DSKETCH_DIR=<path> -DBUILD_DIR=<path>
+#   -DFLASH_BYTES=<bytes> -DSRAM_BYTES=<bytes> -DSTACK_BYTES=<bytes>
+#
+
+execute_process(
+    COMMAND ${ARDUINO_CLI} compile --fqbn ${FQBN} --build-path ${BUILD_DIR} ${SKETCH_DIR}
+    RESULT_VARIABLE COMPILED
+)
+
+if(NOT COMPILED EQUAL 0)
+    message(FATAL_ERROR "error: the firmware can not be built for ${FQBN}.")
+endif()
+
+execute_process(
+    COMMAND ${AVR_SIZE} -A ${BUILD_DIR}/firmware.ino.elf
+    OUTPUT_VARIABLE SECTIONS
+    RESULT_VARIABLE SIZED
+)
+
+if(NOT SIZED EQUAL 0)
+    message(FATAL_ERROR "error: the size of the firmware can not be read.")
+endif()
+
+foreach(SECTION text data bss)
+    if("${SECTIONS}" MATCHES "\n\\.${SECTION}[ \t]+([0-9]+)")
+        set(${SECTION}_BYTES ${CMAKE_MATCH_1})
+    else()
+        set(${SECTION}_BYTES 0)
+    endif()
+endforeach()
+
+# .data is stored in flash too, and copied to SRAM at startup.
+math(EXPR FLASH_USED "${text_BYTES} + ${data_BYTES}")
+math(EXPR SRAM_USED  "${data_BYTES} + ${bss_BYTES}")
+math(EXPR SRAM_LEFT  "${SRAM_BYTES} - ${SRAM_USED}")
+
+message("flash       ${FLASH_USED} / ${FLASH_BYTES} bytes")
+message("static RAM  ${SRAM_USED} / ${SRAM_BYTES} bytes (${SRAM_LEFT} bytes left for the stack)")
+
+if(FLASH_USED GREATER FLASH_BYTES)
+    message(FATAL_ERROR "error: the firmware is over the flash left by the bootloader.")
+endif()
+
+if(SRAM_LEFT LESS STACK_BYTES)
+    message(FATAL_ERROR "error: the static RAM leaves less than ${STACK_BYTES} bytes for the stack.")
+endif()
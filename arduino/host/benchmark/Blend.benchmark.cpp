@@ -0,0 +1,267 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Arduino.h>
+
+#include "Host.h"
+#include "JointController.h"
+#include "Motion.h"
+#include "MotionController.h"
+#include "Scenario.h"
+
+
+/*!
+    @brief Benchmark of motions chained by the interpreter, with and without blending
+
+    Three motions like walking steps (slot 0 - 2) are pushed to the interpreter with "#PU" commands
+    in the order of walking, and played with "#PO". Each of them begins and ends with the same pose,
+    like "00_LStep" to "02_RStep", so the robot stands still between them without blending.
+    The chain is played with each blend window given by ">TB", and the benchmark reports for each window:
+
+    - Stall ticks: ticks of MotionController::updateFrame() that move no joint.
+    - Total time of the chain on the virtual clock. (Ticks of MotionController::updateFrame().)
+    - The peak step and the peak change of the step per tick given to the joints.
+
+    Usage: Blend.benchmark [--quick]
+*/
+namespace
+{
+    using namespace PLEN2;
+
+    enum
+    {
+        STEPS_DEFAULT = 30,
+        STEPS_QUICK   = 6,
+        FRAME_LENGTH  = 8,
+        MOTIONS       = 3,
+        MARGIN_US     = 100000
+    };
+
+    //! Transition time of each frame [msec], the same as "00_LStep".
+    const uint16_t TRANSITION_TIME_MS[FRAME_LENGTH] = { 100, 140, 140, 140, 140, 140, 180, 200 };
+
+    //! Blend windows compared [msec]. (0 is the original behavior.)
+    const uint16_t WINDOW_MS[] = { 0, 64, 128 };
+
+    enum { WINDOWS = sizeof(WINDOW_MS) / sizeof(WINDOW_MS[0]) };
+
+    namespace Shared
+    {
+        int16_t  angle[JointController::JOINTS_SUM];
+        int16_t  speed[JointController::JOINTS_SUM];
+        uint32_t speed_max;
+        uint32_t acceleration_max;
+        uint32_t ticks;
+        uint32_t stalls;
+        bool     moved;
+    }
+
+    void record(uint8_t joint_id, int16_t angle)
+    {
+        const int16_t speed = angle - Shared::angle[joint_id];
+        const uint32_t acceleration = abs(speed - Shared::speed[joint_id]);
+
+        if (static_cast<uint32_t>(abs(speed)) > Shared::speed_max)
+        {
+            Shared::speed_max = abs(speed);
+        }
+
+        if (acceleration > Shared::acceleration_max)
+        {
+            Shared::acceleration_max = acceleration;
+        }
+
+        Shared::angle[joint_id] = angle;
+        Shared::speed[joint_id] = speed;
+
+        (speed != 0)? (Shared::moved = true) : false;
+    }
+
+    /*!
+        @brief Get joint angle of a step motion [deg * 10]
+
+        The first and the last frames are the standing pose, and the others swing the joints.
+    */
+    int16_t stepAngleOf(uint8_t slot, uint8_t frame_id, uint8_t joint_id)
+    {
+        if (   (frame_id == 0)
+            || (frame_id == FRAME_LENGTH - 1) )
+        {
+            return 0;
+        }
+
+        return ((frame_id + joint_id + slot) % 5 - 2) * 60;
+    }
+
+    /*!
+        @brief Install the motions, and wait for writing them to external EEPROM
+    */
+    void installMotions()
+    {
+        const Scenario::MotionOptions options = { 0, 0, 0, 0 };
+
+        for (uint8_t slot = 0; slot < MOTIONS; slot++)
+        {
+            Scenario::feedHeader(slot, FRAME_LENGTH, options);
+
+            for (uint8_t frame_id = 0; frame_id < FRAME_LENGTH; frame_id++)
+            {
+                char command[128] = ">MF";
+
+                Scenario::appendHex(command, slot, 2);
+                Scenario::appendHex(command, frame_id, 2);
+                Scenario::appendHex(command, TRANSITION_TIME_MS[frame_id], 4);
+
+                for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+                {
+                    Scenario::appendHex(command, static_cast<uint16_t>(stepAngleOf(slot, frame_id, joint_id)), 4);
+                }
+
+                Scenario::feedCommand(command);
+            }
+        }
+
+        Scenario::runFor(MARGIN_US);
+    }
+
+    /*!
+        @brief Play the chain of the motions with the interpreter
+    */
+    void playChain(uint32_t steps)
+    {
+        for (uint32_t step = 0; step < steps; step++)
+        {
+            char command[16] = "#PU";
+
+            Scenario::appendHex(command, step % MOTIONS, 2);
+            Scenario::appendHex(command, 1, 2); // Played once. (See Application::pushCode().)
+            Scenario::feedCommand(command);
+        }
+
+        Scenario::feedCommand("#PO");
+    }
+}
+
+
+/*
+    Linker-level probes (see "-Wl,--wrap" in CMakeLists.txt)
+*/
+extern "C"
+{
+    void __real__ZN5PLEN216MotionController11updateFrameEv(MotionController* self);
+    bool __real__ZN5PLEN215JointController12setAngleDiffEhs(JointController* self, uint8_t joint_id, int16_t angle_diff);
+
+    void __wrap__ZN5PLEN216MotionController11updateFrameEv(MotionController* self)
+    {
+        Shared::moved = false;
+
+        __real__ZN5PLEN216MotionController11updateFrameEv(self);
+
+        Shared::ticks++;
+        (!Shared::moved)? Shared::stalls++ : 0;
+    }
+
+    bool __wrap__ZN5PLEN215JointController12setAngleDiffEhs(JointController* self, uint8_t joint_id, int16_t angle_diff)
+    {
+        if (joint_id < JointController::JOINTS_SUM)
+        {
+            record(joint_id, angle_diff);
+        }
+
+        return __real__ZN5PLEN215JointController12setAngleDiffEhs(self, joint_id, angle_diff);
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    const bool quick = (argc > 1) && (strcmp(argv[1], "--quick") == 0);
+    const uint32_t steps = quick? STEPS_QUICK : STEPS_DEFAULT;
+
+    uint32_t ticks[WINDOWS];
+    uint32_t stalls[WINDOWS];
+
+    printf("%-16s %12s %12s %16s %20s\n", "blend window ms", "stall ticks", "chain ms", "max step / tick", "max step change");
+
+    for (uint8_t window = 0; window < WINDOWS; window++)
+    {
+        Host::reset();
+        setup();
+        installMotions();
+
+        char command[16] = ">TB";
+
+        Scenario::appendHex(command, WINDOW_MS[window], 4);
+        Scenario::feedCommand(command);
+        Scenario::runFor(0);
+
+        // The robot starts from rest.
+        memset(Shared::speed, 0, sizeof(Shared::speed));
+        Shared::speed_max        = 0;
+        Shared::acceleration_max = 0;
+        Shared::ticks            = 0;
+        Shared::stalls           = 0;
+
+        playChain(steps);
+
+        // Long enough for the chain without blending.
+        uint32_t chain_ms = 0;
+
+        for (uint8_t frame_id = 0; frame_id < FRAME_LENGTH; frame_id++)
+        {
+            chain_ms += TRANSITION_TIME_MS[frame_id] + Motion::Frame::UPDATE_INTERVAL_MS;
+        }
+
+        Scenario::runFor(steps * chain_ms * 1000 + MARGIN_US);
+
+        // The robot stops at the last frame of the last motion.
+        for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+        {
+            record(joint_id, Shared::angle[joint_id]);
+
+            if (Shared::angle[joint_id] != stepAngleOf((steps - 1) % MOTIONS, FRAME_LENGTH - 1, joint_id))
+            {
+                fprintf(stderr, "error: the last frame was not reached with blend window %u.\n",
+                    static_cast<unsigned>(WINDOW_MS[window]));
+
+                return 1;
+            }
+        }
+
+        ticks[window]  = Shared::ticks;
+        stalls[window] = Shared::stalls;
+
+        printf("%-16u %12lu %12lu %16lu %20lu\n",
+            static_cast<unsigned>(WINDOW_MS[window]),
+            static_cast<unsigned long>(Shared::stalls),
+            static_cast<unsigned long>(Shared::ticks * Motion::Frame::UPDATE_INTERVAL_MS),
+            static_cast<unsigned long>(Shared::speed_max),
+            static_cast<unsigned long>(Shared::acceleration_max)
+        );
+    }
+
+    // Sanity check: blending must shorten the chain, and must cut stalls between the motions.
+    for (uint8_t window = 1; window < WINDOWS; window++)
+    {
+        if (   (ticks[window] >= ticks[0])
+            || (stalls[window] >= stalls[0]) )
+        {
+            fprintf(stderr, "error: blend window %u did not smooth the chain.\n",
+                static_cast<unsigned>(WINDOW_MS[window]));
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,319 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "Host.h"
+#include "ExternalEEPROM.h"
+#include "JointController.h"
+#include "Motion.h"
+#include "MotionController.h"
+#include "Scenario.h"
+
+
+/*!
+    @brief Benchmark of delta-compressed frames, compared with plain frames
+
+    Every motion shipped in "motions/" (the ".json" files) is installed with its joint angles,
+    once with plain frames and once with delta-compressed frames (">MH" with the flag 0x2 of use_extra).
+    Every motion is played with "$PM", and the benchmark reports for each storage:
+
+    - Bytes stored in external EEPROM per frame.
+    - Frames read during playback, and frames fetched from external EEPROM out of them.
+      (Plain frames may be hit in the RAM cache, but delta-compressed frames are always decoded.)
+    - I2C transactions and time on the virtual clock to fetch a frame from external EEPROM.
+    - Ticks of MotionController::updateFrame(), and a hash of the angles given to the joints.
+
+    Usage: Delta.benchmark [--quick] [motions directory]
+*/
+namespace
+{
+    using namespace PLEN2;
+
+    enum
+    {
+        LOOP_COUNT_DEFAULT = 10,
+        LOOP_COUNT_QUICK   = 1,
+        MARGIN_US          = 100000
+    };
+
+    struct Result
+    {
+        uint32_t stored_bytes;
+        uint32_t frames_read;
+        uint32_t frames_fetched;
+        uint32_t transactions;
+        uint64_t read_us;
+        uint32_t ticks;
+        uint32_t hash;
+    };
+
+    namespace Shared
+    {
+        uint32_t frames_read;
+        uint32_t frames_fetched;
+        uint64_t read_us;
+        uint32_t ticks;
+        uint32_t hash;
+    }
+
+    /*!
+        @brief Install a motion with ">MH" and ">MF" commands
+    */
+    void install(const Scenario::MotionFile& motion, bool delta)
+    {
+        Scenario::feedHeader(motion.slot, motion.frame_length, motion.options, (delta)? 0x2 : 0x0);
+
+        for (uint8_t frame_id = 0; frame_id < motion.frame_length; frame_id++)
+        {
+            char command[128] = ">MF";
+
+            Scenario::appendHex(command, motion.slot, 2);
+            Scenario::appendHex(command, frame_id, 2);
+            Scenario::appendHex(command, motion.transition_time_ms[frame_id], 4);
+
+            for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+            {
+                Scenario::appendHex(command, static_cast<uint16_t>(motion.joint_angle[frame_id][joint_id]), 4);
+            }
+
+            Scenario::feedCommand(command);
+        }
+
+        Scenario::runFor(MARGIN_US);
+    }
+
+    /*!
+        @brief Count bytes written to the frame blocks of a slot
+
+        The device is erased to 0xFF by Host::reset(), so trailing 0xFF of a block is counted as unused.
+    */
+    uint32_t storedBytesOf(uint8_t slot)
+    {
+        const uint8_t* memory = Host::ExternalEEPROM::memory();
+        uint32_t bytes = 0;
+
+        Motion::Extent extent;
+
+        if (!Motion::getExtent(slot, extent) || (extent.first == Motion::Extent::FIRST_NONE))
+        {
+            return 0;
+        }
+
+        // The first block of an extent is the header.
+        for (uint16_t index = 1; index < extent.blocks; index++)
+        {
+            const uint32_t block = static_cast<uint32_t>(extent.first) + index;
+            const uint8_t* it    = memory + block * ExternalEEPROM::BLOCK_SIZE;
+
+            uint8_t used = ExternalEEPROM::BLOCK_SIZE;
+
+            while ((used > 0) && (it[used - 1] == 0xFF))
+            {
+                used--;
+            }
+
+            bytes += used;
+        }
+
+        return bytes;
+    }
+
+    /*!
+        @brief Install and play every motion on freshly reset hardware
+    */
+    Result run(const std::vector<Scenario::MotionFile>& motions, bool delta)
+    {
+        Host::reset();
+        setup();
+
+        JointController joint_ctrl;
+        const uint32_t period_us = joint_ctrl.getUpdatePeriod();
+
+        Result result = {};
+
+        for (size_t index = 0; index < motions.size(); index++)
+        {
+            install(motions[index], delta);
+            result.stored_bytes += storedBytesOf(motions[index].slot);
+        }
+
+        Shared::frames_read    = 0;
+        Shared::frames_fetched = 0;
+        Shared::read_us        = 0;
+        Shared::ticks          = 0;
+        Shared::hash           = 2166136261UL;
+
+        const uint32_t transactions = Host::ExternalEEPROM::transactions();
+
+        for (size_t index = 0; index < motions.size(); index++)
+        {
+            const Scenario::MotionFile& motion = motions[index];
+
+            uint32_t time = 0;
+
+            for (uint8_t frame_id = 0; frame_id < motion.frame_length; frame_id++)
+            {
+                const bool looped = (motion.options.use_loop)
+                    && (frame_id >= motion.options.loop_begin)
+                    && (frame_id <= motion.options.loop_end);
+
+                time += motion.transition_time_ms[frame_id] * ((looped)? (1 + motion.options.loop_count) : 1);
+            }
+
+            char command[16] = "$PM";
+
+            Scenario::appendHex(command, motion.slot, 2);
+            Scenario::feedCommand(command);
+            Scenario::runFor(static_cast<uint64_t>(time) * 1000 + period_us + MARGIN_US);
+        }
+
+        result.frames_read    = Shared::frames_read;
+        result.frames_fetched = Shared::frames_fetched;
+        result.transactions   = Host::ExternalEEPROM::transactions() - transactions;
+        result.read_us        = Shared::read_us;
+        result.ticks          = Shared::ticks;
+        result.hash           = Shared::hash;
+
+        return result;
+    }
+
+    void print(const char* name, const Result& result, uint32_t frames)
+    {
+        printf("[%s]\n", name);
+        printf("%-28s %12lu\n", "stored bytes / frame",
+            static_cast<unsigned long>(result.stored_bytes / frames));
+        printf("%-28s %12lu\n", "frames read", static_cast<unsigned long>(result.frames_read));
+        printf("%-28s %12lu\n", "frames fetched", static_cast<unsigned long>(result.frames_fetched));
+        printf("%-28s %8lu.%03lu\n", "I2C transactions / fetch",
+            static_cast<unsigned long>(result.transactions / result.frames_fetched),
+            static_cast<unsigned long>(result.transactions * 1000ULL / result.frames_fetched % 1000));
+        printf("%-28s %12lu\n", "sim us / fetch",
+            static_cast<unsigned long>(result.read_us / result.frames_fetched));
+        printf("%-28s %12lu\n", "ticks", static_cast<unsigned long>(result.ticks));
+        printf("%-28s     %08lX\n", "hash of joint angles", static_cast<unsigned long>(result.hash));
+    }
+}
+
+
+/*
+    Linker-level probes (see "-Wl,--wrap" in CMakeLists.txt)
+*/
+extern "C"
+{
+    void __real__ZN5PLEN216MotionController11updateFrameEv(MotionController* self);
+    bool __real__ZN5PLEN215JointController12setAngleDiffEhs(JointController* self, uint8_t joint_id, int16_t angle_diff);
+    bool __real__ZN5PLEN26Motion5Frame3getEhhRS1_(uint8_t slot, uint8_t index, Motion::Frame& frame);
+    bool __real__ZN5PLEN26Motion5Frame8getChunkEhhhRS1_(uint8_t slot, uint8_t index, uint8_t chunk, Motion::Frame& frame);
+
+    void __wrap__ZN5PLEN216MotionController11updateFrameEv(MotionController* self)
+    {
+        Shared::ticks++;
+
+        __real__ZN5PLEN216MotionController11updateFrameEv(self);
+    }
+
+    bool __wrap__ZN5PLEN215JointController12setAngleDiffEhs(JointController* self, uint8_t joint_id, int16_t angle_diff)
+    {
+        // FNV-1a of the joints and the angles in the order given.
+        Shared::hash = (Shared::hash ^ joint_id) * 16777619UL;
+        Shared::hash = (Shared::hash ^ static_cast<uint16_t>(angle_diff)) * 16777619UL;
+
+        return __real__ZN5PLEN215JointController12setAngleDiffEhs(self, joint_id, angle_diff);
+    }
+
+    bool __wrap__ZN5PLEN26Motion5Frame3getEhhRS1_(uint8_t slot, uint8_t index, Motion::Frame& frame)
+    {
+        const uint64_t begin = Host::now();
+        const bool result = __real__ZN5PLEN26Motion5Frame3getEhhRS1_(slot, index, frame);
+
+        Shared::frames_read++;
+        (Host::now() != begin)? Shared::frames_fetched++ : 0;
+        Shared::read_us += Host::now() - begin;
+
+        return result;
+    }
+
+    bool __wrap__ZN5PLEN26Motion5Frame8getChunkEhhhRS1_(uint8_t slot, uint8_t index, uint8_t chunk, Motion::Frame& frame)
+    {
+        const uint64_t begin = Host::now();
+        const bool result = __real__ZN5PLEN26Motion5Frame8getChunkEhhhRS1_(slot, index, chunk, frame);
+
+        if (chunk == 0)
+        {
+            Shared::frames_read++;
+            (Host::now() != begin)? Shared::frames_fetched++ : 0;
+        }
+
+        Shared::read_us += Host::now() - begin;
+
+        return result;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    const bool quick = (argc > 1) && (strcmp(argv[1], "--quick") == 0);
+    const uint8_t loop_count = quick? LOOP_COUNT_QUICK : LOOP_COUNT_DEFAULT;
+    const char* directory = (argc > 1 + quick)? argv[1 + quick] : PLEN2_MOTIONS_DIR;
+
+    std::vector<Scenario::MotionFile> motions;
+
+    if (!Scenario::readMotions(directory, motions))
+    {
+        fprintf(stderr, "error: no motion was read from %s.\n", directory);
+
+        return 1;
+    }
+
+    uint32_t frames = 0;
+
+    for (size_t index = 0; index < motions.size(); index++)
+    {
+        if (motions[index].options.loop_count == 255)
+        {
+            motions[index].options.loop_count = loop_count;
+        }
+
+        frames += motions[index].frame_length;
+    }
+
+    const Result plain = run(motions, false);
+    const Result delta = run(motions, true);
+
+    print("plain frames", plain, frames);
+    print("delta-compressed frames", delta, frames);
+
+    // Sanity check: both storages must play the same motions.
+    if (   (plain.ticks != delta.ticks)
+        || (plain.hash  != delta.hash) )
+    {
+        fprintf(stderr, "error: delta-compressed frames were not played the same as plain frames.\n");
+
+        return 1;
+    }
+
+    // Sanity check: delta-compressed frames must take less space, and less time on the bus to fetch a frame.
+    if (   (delta.stored_bytes >= plain.stored_bytes)
+        || (delta.read_us * plain.frames_fetched >= plain.read_us * delta.frames_fetched) )
+    {
+        fprintf(stderr, "error: delta-compressed frames are not smaller or faster than plain frames.\n");
+
+        return 1;
+    }
+
+    return 0;
+}
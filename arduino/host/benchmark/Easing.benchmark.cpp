@@ -0,0 +1,163 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Arduino.h>
+
+#include "Host.h"
+#include "JointController.h"
+#include "Motion.h"
+#include "MotionController.h"
+#include "Scenario.h"
+
+
+/*!
+    @brief Benchmark of easing curves
+
+    The same frames are streamed with each easing curve (see Motion::Frame::EASING),
+    and the benchmark reports the angles given to JointController::setAngleDiff() at each tick:
+
+    - The largest step of a joint per tick, that is proportional to the peak speed.
+    - The largest change of the step between ticks, that is proportional to the peak acceleration,
+      and so the peak current of servos. (Linear transitions have it at frame boundaries.)
+    - Total time of the frames on the virtual clock.
+
+    Usage: Easing.benchmark [--quick]
+    (The frames fill the stream buffer only once, so "--quick" runs the same benchmark.)
+*/
+namespace
+{
+    using namespace PLEN2;
+
+    enum
+    {
+        FRAMES             = MotionController::STREAMBUFFER_LENGTH + 1,
+        TRANSITION_TIME_MS = 320,
+        MARGIN_US          = 100000
+    };
+
+    const char* EASING_NAME[Motion::Frame::EASING_SUM] = {
+        "linear",
+        "smoothstep",
+        "minimum jerk"
+    };
+
+    namespace Shared
+    {
+        int16_t  angle[JointController::JOINTS_SUM];
+        int16_t  speed[JointController::JOINTS_SUM];
+        uint32_t speed_max;
+        uint32_t acceleration_max;
+    }
+
+    void record(uint8_t joint_id, int16_t angle)
+    {
+        const int16_t speed = angle - Shared::angle[joint_id];
+        const uint32_t acceleration = abs(speed - Shared::speed[joint_id]);
+
+        if (static_cast<uint32_t>(abs(speed)) > Shared::speed_max)
+        {
+            Shared::speed_max = abs(speed);
+        }
+
+        if (acceleration > Shared::acceleration_max)
+        {
+            Shared::acceleration_max = acceleration;
+        }
+
+        Shared::angle[joint_id] = angle;
+        Shared::speed[joint_id] = speed;
+    }
+}
+
+
+/*
+    Linker-level probes (see "-Wl,--wrap" in CMakeLists.txt)
+*/
+extern "C"
+{
+    bool __real__ZN5PLEN215JointController12setAngleDiffEhs(JointController* self, uint8_t joint_id, int16_t angle_diff);
+
+    bool __wrap__ZN5PLEN215JointController12setAngleDiffEhs(JointController* self, uint8_t joint_id, int16_t angle_diff)
+    {
+        if (joint_id < JointController::JOINTS_SUM)
+        {
+            record(joint_id, angle_diff);
+        }
+
+        return __real__ZN5PLEN215JointController12setAngleDiffEhs(self, joint_id, angle_diff);
+    }
+}
+
+
+int main()
+{
+    uint32_t acceleration_max[Motion::Frame::EASING_SUM];
+
+    printf("%-16s %16s %20s %14s\n", "easing", "max step / tick", "max step change", "total sim ms");
+
+    for (uint8_t easing = 0; easing < Motion::Frame::EASING_SUM; easing++)
+    {
+        Host::reset();
+        setup();
+
+        // The robot keeps the last frame of the previous curve, and starts from rest.
+        memset(Shared::speed, 0, sizeof(Shared::speed));
+        Shared::speed_max        = 0;
+        Shared::acceleration_max = 0;
+
+        const uint64_t begin = Host::now();
+
+        for (uint8_t frame_id = 0; frame_id < FRAMES; frame_id++)
+        {
+            Scenario::feedStreamFrame(frame_id, TRANSITION_TIME_MS, easing);
+        }
+
+        Scenario::feedCommand("$SM");
+        Scenario::runFor(FRAMES * TRANSITION_TIME_MS * 1000 + MARGIN_US);
+
+        // The robot stops at the last frame.
+        for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+        {
+            record(joint_id, Shared::angle[joint_id]);
+
+            if (Shared::angle[joint_id] != Scenario::angleOf(FRAMES - 1, joint_id))
+            {
+                fprintf(stderr, "error: the last frame was not reached with %s.\n", EASING_NAME[easing]);
+
+                return 1;
+            }
+        }
+
+        acceleration_max[easing] = Shared::acceleration_max;
+
+        printf("%-16s %16lu %20lu %14lu\n",
+            EASING_NAME[easing],
+            static_cast<unsigned long>(Shared::speed_max),
+            static_cast<unsigned long>(Shared::acceleration_max),
+            static_cast<unsigned long>((Host::now() - begin) / 1000)
+        );
+    }
+
+    // Sanity check: easing must cut the peak acceleration of linear transitions.
+    for (uint8_t easing = Motion::Frame::EASING_LINEAR + 1; easing < Motion::Frame::EASING_SUM; easing++)
+    {
+        if (acceleration_max[easing] >= acceleration_max[Motion::Frame::EASING_LINEAR])
+        {
+            fprintf(stderr, "error: %s did not reduce the peak acceleration.\n", EASING_NAME[easing]);
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
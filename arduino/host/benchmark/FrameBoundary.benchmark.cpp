@@ -0,0 +1,281 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <Arduino.h>
+
+#include "Host.h"
+#include "JointController.h"
+#include "Motion.h"
+#include "MotionController.h"
+#include "Scenario.h"
+
+
+/*!
+    @brief Benchmark of frame boundaries of a motion
+
+    A motion that has a loop is played with and without reading ahead frames
+    (MotionController::prefetchFrame()), and the benchmark reports on the virtual clock:
+
+    - Stall of loop() at each frame boundary (time spent in MotionController::loadNextFrame()).
+    - The longest iteration of loop() while playing, which delays reading serial input.
+    - Latency of each tick, from the timer 1 vector that finishes a PWM cycle
+      to the call of MotionController::updateFrame(), for the first tick of frames and the others.
+
+    I2C transfer time on the bus is charged to the virtual clock by the simulated 24FC1025.
+    The frame is read ahead into the buffer of the frame the transition started from, so it needs no extra RAM,
+    and both runs must output the same PWM widths.
+
+    Usage: FrameBoundary.benchmark [--quick]
+*/
+namespace
+{
+    enum
+    {
+        FRAME_LENGTH  = 8,
+        LOOP_BEGIN    = 2,
+        LOOP_END      = 5,
+        LOOP_COUNT    = 2,
+        MOTION_US     = 3000000, //!< Longer than total transition time of the motion installed.
+        MARGIN_US     = 100000,
+        PLAYS_DEFAULT = 20,
+        PLAYS_QUICK   = 2
+    };
+
+    enum PHASE
+    {
+        WITHOUT_PREFETCH,
+        WITH_PREFETCH,
+        PHASES_SUM
+    };
+
+    const char* PHASE_NAME[PHASES_SUM] = {
+        "without prefetch",
+        "with prefetch"
+    };
+
+    struct Samples
+    {
+        std::vector<uint64_t> stall_us;
+        std::vector<uint64_t> loop_us;
+        std::vector<uint64_t> first_tick_us;
+        std::vector<uint64_t> tick_us;
+        std::vector<uint32_t> pwm_sums; //!< Checksum of PWM widths output by each tick. (Except the first play.)
+    };
+
+    namespace Shared
+    {
+        PHASE    phase = WITHOUT_PREFETCH;
+        Samples  samples[PHASES_SUM];
+
+        PLEN2::MotionController* motion_ctrl_ptr = NULL;
+
+        bool     tick_pending    = false;
+        uint64_t tick_begin      = 0;
+        bool     frame_beginning = false;
+        bool     first_play      = true; //!< The first play starts from the initial angles instead of the last frame.
+    }
+
+    /*!
+        @brief Record the time when a PWM cycle finishes (called just after timer 1 vector)
+    */
+    void onTimer1()
+    {
+        if (   (Shared::motion_ctrl_ptr == NULL)
+            || (Shared::tick_pending)
+            || !Shared::motion_ctrl_ptr->playing()
+            || !Shared::motion_ctrl_ptr->frameUpdatable() )
+        {
+            return;
+        }
+
+        Shared::tick_pending = true;
+        Shared::tick_begin   = Host::now();
+    }
+
+    void measuredLoop()
+    {
+        const bool     playing = (Shared::motion_ctrl_ptr != NULL) && Shared::motion_ctrl_ptr->playing();
+        const uint64_t begin   = Host::now();
+
+        loop();
+
+        if (playing)
+        {
+            Shared::samples[Shared::phase].loop_us.push_back(Host::now() - begin);
+        }
+    }
+
+    uint64_t percentile(std::vector<uint64_t> values, uint8_t percent)
+    {
+        if (values.empty())
+        {
+            return 0;
+        }
+
+        std::sort(values.begin(), values.end());
+
+        return values[(values.size() - 1) * percent / 100];
+    }
+
+    void reportRow(const char* name, const std::vector<uint64_t>& values)
+    {
+        const uint64_t min = values.empty()? 0 : *std::min_element(values.begin(), values.end());
+        const uint64_t max = percentile(values, 100);
+
+        printf("  %-24s %8lu %12lu %12lu %12lu %12lu\n",
+            name,
+            static_cast<unsigned long>(values.size()),
+            static_cast<unsigned long>(percentile(values, 50)),
+            static_cast<unsigned long>(percentile(values, 99)),
+            static_cast<unsigned long>(max),
+            static_cast<unsigned long>(max - min)
+        );
+    }
+
+    void report()
+    {
+        for (uint8_t phase = 0; phase < PHASES_SUM; phase++)
+        {
+            const Samples& s = Shared::samples[phase];
+
+            printf("%s:\n", PHASE_NAME[phase]);
+            printf("  %-24s %8s %12s %12s %12s %12s\n",
+                "sim us", "count", "median", "p99", "max", "jitter"
+            );
+
+            reportRow("boundary stall", s.stall_us);
+            reportRow("loop() while playing", s.loop_us);
+            reportRow("first tick latency", s.first_tick_us);
+            reportRow("tick latency", s.tick_us);
+        }
+    }
+}
+
+
+/*
+    Linker-level probes (see "-Wl,--wrap" in CMakeLists.txt)
+*/
+extern "C"
+{
+    void __real__ZN5PLEN216MotionController11updateFrameEv(PLEN2::MotionController* self);
+    void __real__ZN5PLEN216MotionController13loadNextFrameEv(PLEN2::MotionController* self);
+    void __real__ZN5PLEN216MotionController13prefetchFrameEv(PLEN2::MotionController* self);
+
+    void __wrap__ZN5PLEN216MotionController11updateFrameEv(PLEN2::MotionController* self)
+    {
+        Shared::motion_ctrl_ptr = self;
+
+        if (Shared::tick_pending)
+        {
+            Samples& s = Shared::samples[Shared::phase];
+
+            (Shared::frame_beginning? s.first_tick_us : s.tick_us).push_back(Host::now() - Shared::tick_begin);
+        }
+
+        Shared::tick_pending    = false;
+        Shared::frame_beginning = false;
+
+        __real__ZN5PLEN216MotionController11updateFrameEv(self);
+
+        uint32_t sum = 0;
+
+        for (uint8_t joint_id = 0; joint_id < PLEN2::JointController::JOINTS_SUM; joint_id++)
+        {
+            sum = sum * 31 + PLEN2::JointController::m_pwms[joint_id];
+        }
+
+        if (!Shared::first_play)
+        {
+            Shared::samples[Shared::phase].pwm_sums.push_back(sum);
+        }
+    }
+
+    void __wrap__ZN5PLEN216MotionController13loadNextFrameEv(PLEN2::MotionController* self)
+    {
+        const uint64_t begin = Host::now();
+
+        __real__ZN5PLEN216MotionController13loadNextFrameEv(self);
+
+        Shared::samples[Shared::phase].stall_us.push_back(Host::now() - begin);
+        Shared::frame_beginning = true;
+    }
+
+    void __wrap__ZN5PLEN216MotionController13prefetchFrameEv(PLEN2::MotionController* self)
+    {
+        if (Shared::phase == WITH_PREFETCH)
+        {
+            __real__ZN5PLEN216MotionController13prefetchFrameEv(self);
+        }
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    const bool quick = (argc > 1) && (strcmp(argv[1], "--quick") == 0);
+    const uint8_t plays = quick? PLAYS_QUICK : PLAYS_DEFAULT;
+
+    setup();
+    Host::setTimer1Hook(onTimer1);
+
+    const Scenario::MotionOptions options = { 1, LOOP_BEGIN, LOOP_END, LOOP_COUNT };
+
+    Scenario::feedMotion(0, FRAME_LENGTH, options);
+    Scenario::runFor(MARGIN_US, measuredLoop);
+
+    for (uint8_t phase = 0; phase < PHASES_SUM; phase++)
+    {
+        Shared::phase = static_cast<PHASE>(phase);
+
+        for (uint8_t count = 0; count < plays; count++)
+        {
+            Shared::first_play = (count == 0);
+
+            Scenario::feedCommand("$PM00");
+            Scenario::runFor(MOTION_US + MARGIN_US, measuredLoop);
+        }
+    }
+
+    report();
+
+    // Sanity check: reading ahead must remove the stall at frame boundaries.
+    const Samples& before = Shared::samples[WITHOUT_PREFETCH];
+    const Samples& after  = Shared::samples[WITH_PREFETCH];
+
+    if (   before.stall_us.empty()
+        || (before.stall_us.size() != after.stall_us.size()) )
+    {
+        fprintf(stderr, "error: the motion was not played as intended.\n");
+
+        return 1;
+    }
+
+    // Sanity check: the frames read ahead must output the same angles.
+    if (before.pwm_sums != after.pwm_sums)
+    {
+        fprintf(stderr, "error: the motion played with prefetch differs.\n");
+
+        return 1;
+    }
+
+    if (percentile(after.stall_us, 99) >= percentile(before.stall_us, 99))
+    {
+        fprintf(stderr, "error: prefetch did not reduce the boundary stall.\n");
+
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,211 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
+#include <Arduino.h>
+
+#include "Host.h"
+#include "JointController.h"
+#include "Motion.h"
+#include "MotionController.h"
+#include "Scenario.h"
+
+
+/*!
+    @brief Benchmark of the ticks of MotionController::updateFrame()
+
+    Frames like walking, that move only the legs, are streamed with "$SF" commands,
+    so the arms stay still and the joints without servos (9 - 11 and 21 - 23) are always zero.
+    The benchmark reports for each tick:
+
+    - Calls of JointController::setAngleDiff(), compared with JOINTS_SUM that every tick used to call.
+    - The host cost (TSC cycles, or nanoseconds on non-x86 hosts) of updateFrame() and setAngleDiff(),
+      and the cost saved by skipping idle joints that is estimated from them.
+
+    Usage: IdleJoints.benchmark [--quick]
+*/
+namespace
+{
+    using namespace PLEN2;
+
+    enum
+    {
+        FRAMES_DEFAULT     = 200,
+        FRAMES_QUICK       = 20,
+        TRANSITION_TIME_MS = 160,
+        MARGIN_US          = 100000
+    };
+
+    //! Joints that move while walking.
+    const uint8_t LEG_JOINTS[] = {
+        JointController::LEFT_THIGH_ROLL,  JointController::LEFT_THIGH_PITCH,  JointController::LEFT_KNEE_PITCH,
+        JointController::LEFT_FOOT_PITCH,  JointController::LEFT_FOOT_ROLL,
+        JointController::RIGHT_THIGH_ROLL, JointController::RIGHT_THIGH_PITCH, JointController::RIGHT_KNEE_PITCH,
+        JointController::RIGHT_FOOT_PITCH, JointController::RIGHT_FOOT_ROLL
+    };
+
+    enum { LEG_JOINTS_SUM = sizeof(LEG_JOINTS) / sizeof(LEG_JOINTS[0]) };
+
+    #if defined(__x86_64__) || defined(__i386__)
+        const char* HOST_UNIT = "cycles";
+
+        inline uint64_t hostCounter()
+        {
+            return __rdtsc();
+        }
+    #else
+        const char* HOST_UNIT = "nsec";
+
+        inline uint64_t hostCounter()
+        {
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+
+            return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+        }
+    #endif
+
+    namespace Shared
+    {
+        uint64_t ticks      = 0;
+        uint64_t ticks_host = 0;
+        uint64_t calls      = 0;
+        uint64_t calls_host = 0;
+
+        int16_t  angle[JointController::JOINTS_SUM];       //!< Angles of the last frame pushed.
+        int16_t  angle_given[JointController::JOINTS_SUM]; //!< Angles given to the joints at last.
+    }
+
+    /*!
+        @brief Push a frame of walking to the stream
+    */
+    void feedWalkingFrame(uint32_t frame_id)
+    {
+        int16_t angle[JointController::JOINTS_SUM] = { 0 };
+
+        for (uint8_t index = 0; index < LEG_JOINTS_SUM; index++)
+        {
+            angle[LEG_JOINTS[index]] = Scenario::angleOf(static_cast<uint8_t>(frame_id), index);
+        }
+
+        uint8_t  payload[128];
+        uint8_t* it = payload;
+
+        *it++ = TRANSITION_TIME_MS & 0xFF;
+        *it++ = TRANSITION_TIME_MS >> 8;
+
+        for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+        {
+            *it++ = static_cast<uint16_t>(angle[joint_id]) & 0xFF;
+            *it++ = static_cast<uint16_t>(angle[joint_id]) >> 8;
+        }
+
+        Scenario::feedBinary("$SF", payload, it - payload);
+
+        memcpy(Shared::angle, angle, sizeof(angle));
+    }
+}
+
+
+/*
+    Linker-level probes (see "-Wl,--wrap" in CMakeLists.txt)
+*/
+extern "C"
+{
+    void __real__ZN5PLEN216MotionController11updateFrameEv(MotionController* self);
+    bool __real__ZN5PLEN215JointController12setAngleDiffEhs(JointController* self, uint8_t joint_id, int16_t angle_diff);
+
+    void __wrap__ZN5PLEN216MotionController11updateFrameEv(MotionController* self)
+    {
+        const uint64_t begin = hostCounter();
+
+        __real__ZN5PLEN216MotionController11updateFrameEv(self);
+
+        Shared::ticks_host += hostCounter() - begin;
+        Shared::ticks++;
+    }
+
+    bool __wrap__ZN5PLEN215JointController12setAngleDiffEhs(JointController* self, uint8_t joint_id, int16_t angle_diff)
+    {
+        const uint64_t begin  = hostCounter();
+        const bool     result = __real__ZN5PLEN215JointController12setAngleDiffEhs(self, joint_id, angle_diff);
+
+        Shared::calls_host += hostCounter() - begin;
+        Shared::calls++;
+
+        if (joint_id < JointController::JOINTS_SUM)
+        {
+            Shared::angle_given[joint_id] = angle_diff;
+        }
+
+        return result;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    const bool quick = (argc > 1) && (strcmp(argv[1], "--quick") == 0);
+    const uint32_t frames = quick? FRAMES_QUICK : FRAMES_DEFAULT;
+
+    setup();
+
+    // Stream the frames, while keeping the buffer filled. (Flow control is covered by Stream.benchmark.)
+    for (uint32_t frame_id = 0; frame_id < frames; frame_id++)
+    {
+        feedWalkingFrame(frame_id);
+
+        Scenario::runFor(frame_id < MotionController::STREAMBUFFER_LENGTH? 0 : TRANSITION_TIME_MS * 1000);
+    }
+
+    Scenario::feedCommand("$SM");
+    Scenario::runFor(MotionController::STREAMBUFFER_LENGTH * TRANSITION_TIME_MS * 1000 + MARGIN_US);
+
+    // [1/100 calls]
+    const uint64_t calls_per_tick = Shared::ticks? (Shared::calls * 100 / Shared::ticks) : 0;
+    const uint64_t host_per_call  = Shared::calls? (Shared::calls_host / Shared::calls) : 0;
+    const uint64_t host_per_tick  = Shared::ticks? (Shared::ticks_host / Shared::ticks) : 0;
+    const uint64_t saved_per_tick = (JointController::JOINTS_SUM * 100 - calls_per_tick) * host_per_call / 100;
+
+    printf("%-36s %12lu\n", "ticks", static_cast<unsigned long>(Shared::ticks));
+    printf("%-36s %9lu.%02lu\n", "setAngleDiff() calls / tick",
+        static_cast<unsigned long>(calls_per_tick / 100), static_cast<unsigned long>(calls_per_tick % 100));
+    printf("%-36s %12u\n", "joints (calls / tick before)", static_cast<unsigned>(JointController::JOINTS_SUM));
+    printf("%-36s %12lu\n", (std::string(HOST_UNIT) + " / setAngleDiff()").c_str(), static_cast<unsigned long>(host_per_call));
+    printf("%-36s %12lu\n", (std::string(HOST_UNIT) + " / updateFrame()").c_str(), static_cast<unsigned long>(host_per_tick));
+    printf("%-36s %12lu\n", (std::string(HOST_UNIT) + " saved / tick (estimated)").c_str(), static_cast<unsigned long>(saved_per_tick));
+
+    // Sanity check: idle joints must be skipped.
+    if (   (Shared::ticks == 0)
+        || (calls_per_tick >= JointController::JOINTS_SUM * 100) )
+    {
+        fprintf(stderr, "error: idle joints were not skipped.\n");
+
+        return 1;
+    }
+
+    // Sanity check: the robot must reach the last frame even if joints are skipped.
+    if (memcmp(Shared::angle, Shared::angle_given, sizeof(Shared::angle)) != 0)
+    {
+        fprintf(stderr, "error: the last frame was not reached.\n");
+
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "Host.h"
+#include "ExternalEEPROM.h"
+#include "JointController.h"
+#include "Motion.h"
+#include "Scenario.h"
+
+
+/*!
+    @brief Benchmark of installing motions
+
+    Motions that have the maximum frame length are installed with ">MH" and ">MF" commands,
+    and then again with ">MH" and ">MB" (binary frame) commands, sent back-to-back over USB serial.
+    For each encoding the benchmark reports on the virtual clock:
+
+    - Bytes sent per frame.
+    - Total time until all commands are consumed and all slots are written.
+    - Time per page program of the simulated 24FC1025. (A header or a frame is written by one.)
+    - The longest iteration of loop(), which delays reading serial input.
+
+    Usage: Install.benchmark [--quick]
+*/
+namespace
+{
+    enum
+    {
+        MOTIONS_DEFAULT   = PLEN2::Motion::SLOT_END,
+        MOTIONS_QUICK     = 2,
+        FRAME_LENGTH      = 20, //!< Frame length of motions created by the motion editor.
+        BLOCK_TRANSFER_US = 1500 //!< Transfer time of a block at 400kHz, with some margin.
+    };
+
+    uint64_t loop_max_us = 0;
+
+    void measuredLoop()
+    {
+        const uint64_t begin = Host::now();
+
+        loop();
+
+        if ((Host::now() - begin) > loop_max_us)
+        {
+            loop_max_us = Host::now() - begin;
+        }
+    }
+
+    /*!
+        @brief Verify a frame installed by Scenario::feedMotion() or Scenario::feedMotionBinary()
+    */
+    bool verify(uint8_t slot, uint8_t frame_id)
+    {
+        PLEN2::Motion::Frame frame;
+
+        if (!PLEN2::Motion::Frame::get(slot, frame_id, frame))
+        {
+            return false;
+        }
+
+        if (frame.transition_time_ms != Scenario::transitionTimeOf(frame_id))
+        {
+            return false;
+        }
+
+        for (uint8_t device_id = 0; device_id < PLEN2::JointController::JOINTS_SUM; device_id++)
+        {
+            if (frame.joint_angle[device_id] != Scenario::angleOf(frame_id, device_id))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /*!
+        @brief Install motions on freshly reset hardware, and report the result
+
+        @param [in] motions Count of motions to install.
+        @param [in] binary Install frames with ">MB" instead of ">MF".
+
+        @return Exit status
+    */
+    int install(uint8_t motions, bool binary)
+    {
+        Host::reset();
+        setup();
+
+        loop_max_us = 0;
+
+        const uint64_t begin         = Host::now();
+        const uint32_t programs_done = Host::ExternalEEPROM::pagePrograms();
+        size_t frame_bytes = 0;
+
+        for (uint8_t slot = 0; slot < motions; slot++)
+        {
+            if (binary)
+            {
+                frame_bytes = Scenario::feedMotionBinary(slot, FRAME_LENGTH);
+            }
+            else
+            {
+                Scenario::feedMotion(slot, FRAME_LENGTH);
+                frame_bytes = 3 + 2 + 2 + 4 + 4 * PLEN2::JointController::JOINTS_SUM; // ">MF", slot, index, transition and angles in hex
+            }
+
+            while (Serial.pending())
+            {
+                measuredLoop();
+                Host::elapse(Scenario::LOOP_INTERVAL_US);
+            }
+        }
+
+        while (!PLEN2::ExternalEEPROM::idle())
+        {
+            measuredLoop();
+            Host::elapse(Scenario::LOOP_INTERVAL_US);
+        }
+
+        const uint64_t elapsed  = Host::now() - begin;
+        const uint32_t programs = Host::ExternalEEPROM::pagePrograms() - programs_done;
+
+        printf("[%s]\n", binary? ">MB (binary)" : ">MF (ascii)");
+        printf("%-28s %12u\n", "motions", static_cast<unsigned>(motions));
+        printf("%-28s %12lu\n", "bytes / frame", static_cast<unsigned long>(frame_bytes));
+        printf("%-28s %12lu\n", "page programs", static_cast<unsigned long>(programs));
+        printf("%-28s %12lu\n", "I2C transactions", static_cast<unsigned long>(Host::ExternalEEPROM::transactions()));
+        printf("%-28s %12lu\n", "total sim ms", static_cast<unsigned long>(elapsed / 1000));
+        printf("%-28s %12lu\n", "sim us / page program", static_cast<unsigned long>(programs? elapsed / programs : 0));
+        printf("%-28s %12lu\n", "max sim us of loop()", static_cast<unsigned long>(loop_max_us));
+
+        // Sanity check: a header, its entry of the allocation table or a frame must be written by one page program.
+        if (programs != static_cast<uint32_t>(motions) * (2 + FRAME_LENGTH))
+        {
+            fprintf(stderr, "error: a frame was not written by one page program.\n");
+
+            return 1;
+        }
+
+        // Sanity check: installing must be bounded by the actual write cycle and the transfer, not by a fixed wait.
+        if ((elapsed / programs) >= Host::ExternalEEPROM::WRITE_CYCLE_US + BLOCK_TRANSFER_US)
+        {
+            fprintf(stderr, "error: installing is slower than the write cycle of the device.\n");
+
+            return 1;
+        }
+
+        // Sanity check: every motion must be installed correctly.
+        for (uint8_t slot = 0; slot < motions; slot++)
+        {
+            if (   !verify(slot, 0)
+                || !verify(slot, FRAME_LENGTH - 1) )
+            {
+                fprintf(stderr, "error: the motion in slot %u was not installed.\n", static_cast<unsigned>(slot));
+
+                return 1;
+            }
+        }
+
+        return 0;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    const bool quick = (argc > 1) && (strcmp(argv[1], "--quick") == 0);
+    const uint8_t motions = quick? MOTIONS_QUICK : MOTIONS_DEFAULT;
+
+    if (install(motions, false) != 0)
+    {
+        return 1;
+    }
+
+    return install(motions, true);
+}
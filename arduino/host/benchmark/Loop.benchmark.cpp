@@ -0,0 +1,275 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
+#include <Arduino.h>
+
+#include "Host.h"
+#include "JointController.h"
+#include "Motion.h"
+#include "MotionController.h"
+#include "Protocol.h"
+#include "Scenario.h"
+
+
+/*!
+    @brief Benchmark of loop() driven by scripted serial input
+
+    Scenario:
+    1. Install a motion to slot 0 with ">MH" and ">MF" commands over USB serial.
+    2. Play it with "$PM" repeatedly, and apply joints with "$AD" / "$AN" while idle.
+
+    The methods below are measured through linker-level probes, on every call from loop().
+    - MotionController::updateFrame()
+    - MotionController::loadNextFrame()
+    - Protocol::accept()
+    - Protocol::transitState()
+
+    For each method, the benchmark reports the host cost (TSC cycles, or nanoseconds on non-x86 hosts)
+    and the simulated time on the target (I2C transfer, EEPROM write cycles and delay() are charged
+    to the virtual clock). Reads of headers and frames served by the motion cache (see Motion::dumpCache())
+    are reported after them.
+
+    Usage: Loop.benchmark [--quick]
+*/
+namespace
+{
+    enum
+    {
+        FRAME_LENGTH     = 8,
+        MOTION_US        = 1500000, //!< Longer than total transition time of the motion installed.
+        MARGIN_US        = 100000,
+        PLAYS_DEFAULT    = 20,
+        PLAYS_QUICK      = 2
+    };
+
+    enum PROBE_ID
+    {
+        UPDATE_FRAME,
+        LOAD_NEXT_FRAME,
+        ACCEPT,
+        TRANSIT_STATE,
+        LOOP,
+        PROBES_SUM
+    };
+
+    const char* PROBE_NAME[PROBES_SUM] = {
+        "MotionController::updateFrame()",
+        "MotionController::loadNextFrame()",
+        "Protocol::accept()",
+        "Protocol::transitState()",
+        "loop()"
+    };
+
+    #if defined(__x86_64__) || defined(__i386__)
+        const char* HOST_UNIT = "cycles";
+
+        inline uint64_t hostCounter()
+        {
+            return __rdtsc();
+        }
+    #else
+        const char* HOST_UNIT = "nsec";
+
+        inline uint64_t hostCounter()
+        {
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+
+            return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+        }
+    #endif
+
+    struct Samples
+    {
+        std::vector<uint64_t> host;
+        std::vector<uint64_t> target_us;
+    };
+
+    Samples samples[PROBES_SUM];
+
+    /*!
+        @brief Measure a scope
+    */
+    class Probe
+    {
+    private:
+        PROBE_ID m_id;
+        uint64_t m_host_begin;
+        uint64_t m_target_begin;
+
+    public:
+        Probe(PROBE_ID id)
+            : m_id(id)
+            , m_host_begin(hostCounter())
+            , m_target_begin(Host::now())
+        {
+            // noop.
+        }
+
+        ~Probe()
+        {
+            const uint64_t host_end = hostCounter();
+
+            samples[m_id].host.push_back(host_end - m_host_begin);
+            samples[m_id].target_us.push_back(Host::now() - m_target_begin);
+        }
+    };
+
+    void measuredLoop()
+    {
+        Probe p(LOOP);
+
+        loop();
+    }
+
+    uint64_t percentile(std::vector<uint64_t> values, uint8_t percent)
+    {
+        if (values.empty())
+        {
+            return 0;
+        }
+
+        std::sort(values.begin(), values.end());
+
+        return values[(values.size() - 1) * percent / 100];
+    }
+
+    uint64_t mean(const std::vector<uint64_t>& values)
+    {
+        if (values.empty())
+        {
+            return 0;
+        }
+
+        uint64_t sum = 0;
+
+        for (size_t index = 0; index < values.size(); index++)
+        {
+            sum += values[index];
+        }
+
+        return sum / values.size();
+    }
+
+    void report()
+    {
+        printf("%-36s %8s %12s %12s %12s %12s %12s\n",
+            "probe", "calls",
+            (std::string("mean ") + HOST_UNIT).c_str(), (std::string("p99 ") + HOST_UNIT).c_str(),
+            "mean sim us", "p99 sim us", "max sim us"
+        );
+
+        for (uint8_t id = 0; id < PROBES_SUM; id++)
+        {
+            const Samples& s = samples[id];
+
+            printf("%-36s %8lu %12lu %12lu %12lu %12lu %12lu\n",
+                PROBE_NAME[id],
+                static_cast<unsigned long>(s.host.size()),
+                static_cast<unsigned long>(mean(s.host)),
+                static_cast<unsigned long>(percentile(s.host, 99)),
+                static_cast<unsigned long>(mean(s.target_us)),
+                static_cast<unsigned long>(percentile(s.target_us, 99)),
+                static_cast<unsigned long>(percentile(s.target_us, 100))
+            );
+        }
+    }
+}
+
+
+/*
+    Linker-level probes (see "-Wl,--wrap" in CMakeLists.txt)
+*/
+extern "C"
+{
+    void __real__ZN5PLEN216MotionController11updateFrameEv(PLEN2::MotionController* self);
+    void __real__ZN5PLEN216MotionController13loadNextFrameEv(PLEN2::MotionController* self);
+    bool __real__ZN5PLEN28Protocol6acceptEv(PLEN2::Protocol* self);
+    void __real__ZN5PLEN28Protocol12transitStateEv(PLEN2::Protocol* self);
+
+    void __wrap__ZN5PLEN216MotionController11updateFrameEv(PLEN2::MotionController* self)
+    {
+        Probe p(UPDATE_FRAME);
+
+        __real__ZN5PLEN216MotionController11updateFrameEv(self);
+    }
+
+    void __wrap__ZN5PLEN216MotionController13loadNextFrameEv(PLEN2::MotionController* self)
+    {
+        Probe p(LOAD_NEXT_FRAME);
+
+        __real__ZN5PLEN216MotionController13loadNextFrameEv(self);
+    }
+
+    bool __wrap__ZN5PLEN28Protocol6acceptEv(PLEN2::Protocol* self)
+    {
+        Probe p(ACCEPT);
+
+        return __real__ZN5PLEN28Protocol6acceptEv(self);
+    }
+
+    void __wrap__ZN5PLEN28Protocol12transitStateEv(PLEN2::Protocol* self)
+    {
+        Probe p(TRANSIT_STATE);
+
+        __real__ZN5PLEN28Protocol12transitStateEv(self);
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    const bool quick = (argc > 1) && (strcmp(argv[1], "--quick") == 0);
+    const uint8_t plays = quick? PLAYS_QUICK : PLAYS_DEFAULT;
+
+    setup();
+
+    Scenario::feedMotion(0, FRAME_LENGTH);
+    Scenario::runFor(MARGIN_US, measuredLoop);
+
+    for (uint8_t count = 0; count < plays; count++)
+    {
+        Scenario::feedCommand("$PM00");
+        Scenario::runFor(MOTION_US + MARGIN_US, measuredLoop);
+
+        Scenario::feedCommand("$AD00010$AN0C020$HP");
+        Scenario::runFor(MARGIN_US, measuredLoop);
+    }
+
+    report();
+
+    printf("\n%-36s %8lu\n%-36s %8lu\n",
+        "motion cache hits",   static_cast<unsigned long>(PLEN2::Motion::getCacheHits()),
+        "motion cache misses", static_cast<unsigned long>(PLEN2::Motion::getCacheMisses())
+    );
+
+    // Sanity check: every probe must have been hit, or the scenario did not run as intended.
+    for (uint8_t id = 0; id < PROBES_SUM; id++)
+    {
+        if (samples[id].host.empty())
+        {
+            fprintf(stderr, "error: %s was never called.\n", PROBE_NAME[id]);
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
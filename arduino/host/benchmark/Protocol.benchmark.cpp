@@ -0,0 +1,239 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <vector>
+
+#include <Arduino.h>
+
+#include "Host.h"
+#include "Parser.h"
+#include "Protocol.h"
+
+
+/*!
+    @brief Benchmark of ingesting commands by Protocol
+
+    Every command of the protocol is given with valid arguments (hex strings, the name of ">MH",
+    and binary frames of the lengths used by the firmware), and the byte stream is fed into
+    Protocol::readByte() and Protocol::accept() repeatedly, in the same way as loop() does.
+    The event handlers are not run. The benchmark reports on the host clock:
+
+    - Throughput of the full command set [bytes/sec].
+    - Mean cost of a byte of each command, so the cost of a long command (e.g. ">MF" with 104 hex digits)
+      can be compared with a short one. It must not grow with the length of the arguments.
+
+    Then a command with a wrong byte must be rejected at the byte, not after the whole arguments.
+
+    Usage: Protocol.benchmark [--quick]
+*/
+namespace
+{
+    using namespace PLEN2;
+
+    enum
+    {
+        REPEATS_DEFAULT = 20000,
+        REPEATS_QUICK   = 500
+    };
+
+    struct Command
+    {
+        const char* name;
+        int         length; //!< Length of hex arguments, or -(length of a binary payload).
+    };
+
+    const Command COMMANDS[] = {
+        { "$AD",    5 }, { "$AN",    5 }, { "$BD",  -30 }, { "$BN",  -30 }, { "$HP",    0 }, { "$MP",    2 },
+        { "$MS",    0 }, { "$PM",    2 }, { "$SF",  -50 }, { "$SM",    0 }, { "$SP",    4 },
+        { "#PO",    0 }, { "#PU",    4 }, { "#RI",    0 },
+        { ">HO",    5 }, { ">JS",    0 }, { ">MA",    5 }, { ">MB",  -52 }, { ">MD",    0 }, { ">MF",  104 },
+        { ">MH",   35 }, { ">MI",    5 }, { ">PC",    7 }, { ">RM",    2 }, { ">SA", -108 }, { ">SS",    0 },
+        { ">TB",    4 },
+        { "<DI",    0 }, { "<JS",    0 }, { "<MC",    0 }, { "<MO",    2 }, { "<MT",    0 }, { "<MV",    0 },
+        { "<VI",    0 }
+    };
+
+    enum { COMMANDS_SUM = sizeof(COMMANDS) / sizeof(COMMANDS[0]) };
+
+    inline uint64_t hostNsec()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+    }
+
+    /*!
+        @brief Protocol that only counts the commands completed
+    */
+    class CountingProtocol : public Protocol
+    {
+    public:
+        uint32_t completed;
+
+        CountingProtocol(char buffer[])
+            : Protocol(buffer, SESSION_BUFFER_LENGTH)
+            , completed(0)
+        {
+            // noop.
+        }
+
+        virtual void afterHook()
+        {
+            (m_state == READY)? completed++ : 0;
+        }
+
+        /*!
+            @brief Feed bytes
+
+            @return Count of bytes fed until one is rejected
+        */
+        size_t feed(const std::vector<char>& bytes)
+        {
+            for (size_t index = 0; index < bytes.size(); index++)
+            {
+                readByte(bytes[index]);
+
+                if (m_rejected)
+                {
+                    m_abort();
+
+                    return index + 1;
+                }
+
+                if (accept())
+                {
+                    transitState();
+                }
+            }
+
+            return bytes.size();
+        }
+    };
+
+    void append(std::vector<char>& stream, const Command& command, uint8_t seed)
+    {
+        stream.insert(stream.end(), command.name, command.name + 3);
+
+        if (command.length >= 0)
+        {
+            static const char HEX_CHARS[] = "0123456789abcdefABCDEF";
+
+            for (int index = 0; index < command.length; index++)
+            {
+                stream.push_back(HEX_CHARS[(seed + index * 7) % (sizeof(HEX_CHARS) - 1)]);
+            }
+
+            return;
+        }
+
+        uint8_t frame[128];
+        const uint8_t length = -command.length;
+
+        frame[0] = length;
+
+        for (uint8_t index = 1; index <= length; index++)
+        {
+            frame[index] = seed + index * 37;
+        }
+
+        const uint16_t crc = Utility::crc16(frame, 1 + length);
+
+        frame[1 + length]     = crc & 0xFF;
+        frame[1 + length + 1] = crc >> 8;
+
+        stream.insert(stream.end(), frame, frame + 1 + length + 2);
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    const bool quick = (argc > 1) && (strcmp(argv[1], "--quick") == 0);
+    const uint32_t repeats = quick? REPEATS_QUICK : REPEATS_DEFAULT;
+
+    char buffer[Protocol::SESSION_BUFFER_LENGTH];
+    CountingProtocol protocol(buffer);
+
+    std::vector<char> stream;
+
+    for (uint8_t id = 0; id < COMMANDS_SUM; id++)
+    {
+        append(stream, COMMANDS[id], id);
+    }
+
+    uint64_t begin = hostNsec();
+
+    for (uint32_t repeat = 0; repeat < repeats; repeat++)
+    {
+        protocol.feed(stream);
+    }
+
+    const uint64_t total_ns = hostNsec() - begin;
+    const uint32_t expected = repeats * COMMANDS_SUM;
+
+    printf("%-28s %12lu\n", "bytes of command set", static_cast<unsigned long>(stream.size()));
+    printf("%-28s %12lu\n", "commands completed", static_cast<unsigned long>(protocol.completed));
+    printf("%-28s %12lu\n", "bytes / sec", static_cast<unsigned long>(
+        static_cast<double>(stream.size()) * repeats * 1e9 / (total_ns? total_ns : 1)));
+
+    // Sanity check: every command must be accepted.
+    if (protocol.completed != expected)
+    {
+        fprintf(stderr, "error: %lu commands are completed, but %lu commands were given.\n",
+            static_cast<unsigned long>(protocol.completed), static_cast<unsigned long>(expected));
+
+        return 1;
+    }
+
+    printf("%-28s %12s\n", "command", "nsec / byte");
+
+    for (uint8_t id = 0; id < COMMANDS_SUM; id++)
+    {
+        std::vector<char> command;
+        append(command, COMMANDS[id], id);
+
+        begin = hostNsec();
+
+        for (uint32_t repeat = 0; repeat < repeats; repeat++)
+        {
+            protocol.feed(command);
+        }
+
+        const uint64_t ns = hostNsec() - begin;
+
+        printf("%-28s %12.1f\n", COMMANDS[id].name, static_cast<double>(ns) / repeats / command.size());
+    }
+
+    // A wrong byte of the arguments must be rejected when it is read.
+    for (uint8_t id = 0; id < COMMANDS_SUM; id++)
+    {
+        if (COMMANDS[id].length <= 0 || COMMANDS[id].length == 35 /* := The name of ">MH" is not validated. */)
+        {
+            continue;
+        }
+
+        std::vector<char> command;
+        append(command, COMMANDS[id], id);
+        command[3] = 'X';
+
+        if (protocol.feed(command) != 4)
+        {
+            fprintf(stderr, "error: the wrong byte of %s was not rejected at once.\n", COMMANDS[id].name);
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
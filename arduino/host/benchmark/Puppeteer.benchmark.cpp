@@ -0,0 +1,335 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <Arduino.h>
+
+#include "Host.h"
+#include "JointController.h"
+#include "Scenario.h"
+
+
+/*!
+    @brief Benchmark of puppeteering the joints over BLE serial
+
+    A puppeteering rig sends a pose of the 18 joints every POSE_INTERVAL_US (30Hz) over BLE serial
+    (115200bps), with a "$AN" / "$AD" command per joint, and then with a "$BN" / "$BD" command per pose.
+    Each joint is given a different angle in every pose. The benchmark reports for each command:
+
+    - Bytes per pose, and the share of the link taken at 30Hz.
+    - Commits (JointController::commitFrame()) per pose.
+    - Torn poses: poses whose commits are split by a swap of the PWM frames,
+      so the servos output a part of the pose in a cycle, and the rest of it in the next cycle.
+    - The longest time from the first byte of a pose to its last commit.
+
+    (E.g. "$AN" takes 144 bytes (37% of the link) and 18 commits per pose, and a third of the poses are torn,
+    while "$BN" takes 36 bytes (9%) and a commit.)
+
+    Then "$BN" is sent again while a tuning tool sends a ">HO" command with each pose over USB serial (2Mbps),
+    and every pose and every home angle must be applied, since each transport has its own Protocol session.
+
+    Usage: Puppeteer.benchmark [--quick]
+*/
+namespace
+{
+    using namespace PLEN2;
+
+    enum
+    {
+        POSES_DEFAULT    = 300,
+        POSES_QUICK      = 60,
+        POSE_INTERVAL_US = 33333, //!< 30Hz.
+        BLE_BYTE_US      = 87,    //!< Interval of incoming bytes at 115200bps.
+        PUPPET_JOINTS    = 18,
+        SETTLE_US        = 1000000 //!< Time to wait for writes of the joint settings in the background.
+    };
+
+    const uint8_t PUPPET_JOINT[PUPPET_JOINTS] = {
+        JointController::LEFT_SHOULDER_PITCH,  JointController::LEFT_THIGH_YAW,    JointController::LEFT_SHOULDER_ROLL,
+        JointController::LEFT_ELBOW_ROLL,      JointController::LEFT_THIGH_ROLL,   JointController::LEFT_THIGH_PITCH,
+        JointController::LEFT_KNEE_PITCH,      JointController::LEFT_FOOT_PITCH,   JointController::LEFT_FOOT_ROLL,
+        JointController::RIGHT_SHOULDER_PITCH, JointController::RIGHT_THIGH_YAW,   JointController::RIGHT_SHOULDER_ROLL,
+        JointController::RIGHT_ELBOW_ROLL,     JointController::RIGHT_THIGH_ROLL,  JointController::RIGHT_THIGH_PITCH,
+        JointController::RIGHT_KNEE_PITCH,     JointController::RIGHT_FOOT_PITCH,  JointController::RIGHT_FOOT_ROLL
+    };
+
+    namespace Shared
+    {
+        uint8_t  last_front = 0;
+        uint32_t swaps      = 0; //!< Swaps of the PWM frames by the vector.
+
+        bool     recording      = false;
+        uint32_t commits        = 0;
+        uint32_t first_swaps    = 0; //!< Swaps at the first commit of the pose.
+        uint32_t last_swaps     = 0; //!< Swaps at the last commit of the pose.
+        uint64_t last_commit_us = 0;
+    }
+
+    void onTimer1()
+    {
+        if (JointController::m_frame_front != Shared::last_front)
+        {
+            Shared::last_front = JointController::m_frame_front;
+            Shared::swaps++;
+        }
+    }
+
+    /*!
+        @brief Get angle of a joint in a pose [deg * 10]
+
+        Angles vary between -300 and 290 [deg * 10], and differ from the pose before in every joint.
+    */
+    int16_t angleOf(uint16_t pose, uint8_t joint)
+    {
+        return ((pose * 13 + joint * 7) % 60 - 30) * 10;
+    }
+
+    /*!
+        @brief Send a pose with a command per joint
+
+        @return Count of bytes sent
+    */
+    size_t feedEach(uint16_t pose, bool diff)
+    {
+        size_t bytes = 0;
+
+        for (uint8_t joint = 0; joint < PUPPET_JOINTS; joint++)
+        {
+            char command[16];
+
+            strcpy(command, (diff)? "$AD" : "$AN");
+            Scenario::appendHex(command, PUPPET_JOINT[joint], 2);
+            Scenario::appendHex(command, static_cast<uint16_t>(angleOf(pose, joint)) & 0xFFF, 3);
+
+            Serial1.feed(command, static_cast<uint32_t>(BLE_BYTE_US));
+            bytes += strlen(command);
+        }
+
+        return bytes;
+    }
+
+    /*!
+        @brief Send a pose with a bulk command (see applyBulk() in firmware.ino)
+
+        @return Count of bytes sent
+    */
+    size_t feedBulk(uint16_t pose, bool diff)
+    {
+        uint8_t frame[64] = { 0 };
+        uint8_t* payload = frame + Utility::BinaryParser::PREFIX_LENGTH;
+        uint8_t* angles  = payload + 3;
+
+        for (uint8_t joint = 0; joint < PUPPET_JOINTS; joint++)
+        {
+            payload[PUPPET_JOINT[joint] / 8] |= 1 << (PUPPET_JOINT[joint] % 8);
+        }
+
+        for (uint8_t joint = 0; joint < PUPPET_JOINTS; joint += 2)
+        {
+            const uint16_t a = angleOf(pose, joint);
+            const uint16_t b = angleOf(pose, joint + 1);
+
+            *angles++ = a & 0xFF;
+            *angles++ = ((a >> 8) & 0x0F) | ((b & 0x0F) << 4);
+            *angles++ = (b >> 4) & 0xFF;
+        }
+
+        const uint8_t length = angles - payload;
+        frame[0] = length;
+
+        const uint16_t crc = Utility::crc16(frame, 1 + length);
+
+        *angles++ = crc & 0xFF;
+        *angles++ = crc >> 8;
+
+        Serial1.feed((diff)? "$BD" : "$BN", static_cast<uint32_t>(BLE_BYTE_US));
+        Serial1.feed(reinterpret_cast<const char*>(frame), angles - frame, static_cast<uint32_t>(BLE_BYTE_US));
+
+        return 3 + (angles - frame);
+    }
+
+    /*!
+        @brief Puppeteer the joints with a kind of commands, and report the result
+
+        @param [in]  bulk   Send a pose with "$BN" / "$BD" instead of a command per joint.
+        @param [in]  diff   Send angle-diffs instead of angles.
+        @param [in]  tuning Send a ">HO" command with each pose over USB serial too.
+        @param [out] pwms   PWM widths output after the last pose.
+        @param [out] torn   Count of torn poses.
+        @param [out] bytes  Bytes per pose.
+
+        @return Exit status
+    */
+    int puppeteer(uint16_t poses, bool bulk, bool diff, bool tuning, uint16_t pwms[], uint32_t& torn, size_t& bytes)
+    {
+        Host::reset();
+        setup();
+
+        uint32_t commits_max = 0;
+        uint64_t latency_max = 0;
+
+        torn = 0;
+
+        for (uint16_t pose = 0; pose < poses; pose++)
+        {
+            const uint64_t begin = Host::now();
+
+            Shared::commits   = 0;
+            Shared::recording = true;
+
+            bytes = (bulk)? feedBulk(pose, diff) : feedEach(pose, diff);
+
+            if (tuning)
+            {
+                char command[16] = ">HO";
+
+                Scenario::appendHex(command, PUPPET_JOINT[pose % PUPPET_JOINTS], 2);
+                Scenario::appendHex(command, static_cast<uint16_t>(angleOf(pose, 0)) & 0xFFF, 3);
+                Scenario::feedCommand(command);
+            }
+
+            Scenario::runFor(0);
+
+            Shared::recording = false;
+
+            if (Shared::commits == 0)
+            {
+                fprintf(stderr, "error: pose %u was not committed.\n", static_cast<unsigned>(pose));
+
+                return 1;
+            }
+
+            (Shared::first_swaps != Shared::last_swaps)? torn++ : 0;
+            (Shared::commits > commits_max)? (commits_max = Shared::commits) : 0;
+            (Shared::last_commit_us - begin > latency_max)? (latency_max = Shared::last_commit_us - begin) : 0;
+
+            while (Host::now() < begin + POSE_INTERVAL_US)
+            {
+                loop();
+                Host::elapse(Scenario::LOOP_INTERVAL_US);
+            }
+        }
+
+        memcpy(pwms, JointController::m_pwms, sizeof(JointController::m_pwms));
+
+        const char* NAME[2][2] = { { "$AN", "$AD" }, { "$BN", "$BD" } };
+
+        printf("[%s%s]\n", NAME[bulk][diff], (tuning)? " with >HO over USB" : "");
+        printf("%-28s %12lu\n", "bytes / pose", static_cast<unsigned long>(bytes));
+        printf("%-28s %11lu%%\n", "link used at 30Hz",
+            static_cast<unsigned long>(bytes * BLE_BYTE_US * 100 / POSE_INTERVAL_US));
+        printf("%-28s %12lu\n", "commits / pose", static_cast<unsigned long>(commits_max));
+        printf("%-28s %12lu\n", "torn poses", static_cast<unsigned long>(torn));
+        printf("%-28s %12lu\n", "max sim us to commit", static_cast<unsigned long>(latency_max));
+
+        return 0;
+    }
+}
+
+
+/*
+    Linker-level probes (see "-Wl,--wrap" in CMakeLists.txt)
+*/
+extern "C"
+{
+    void __real__ZN5PLEN215JointController11commitFrameEv(PLEN2::JointController* self);
+
+    void __wrap__ZN5PLEN215JointController11commitFrameEv(PLEN2::JointController* self)
+    {
+        __real__ZN5PLEN215JointController11commitFrameEv(self);
+
+        if (Shared::recording)
+        {
+            (Shared::commits == 0)? (Shared::first_swaps = Shared::swaps) : 0;
+
+            Shared::commits++;
+            Shared::last_swaps     = Shared::swaps;
+            Shared::last_commit_us = Host::now();
+        }
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    const bool quick = (argc > 1) && (strcmp(argv[1], "--quick") == 0);
+    const uint16_t poses = quick? POSES_QUICK : POSES_DEFAULT;
+
+    Host::setTimer1Hook(onTimer1);
+
+    for (uint8_t diff = 0; diff < 2; diff++)
+    {
+        uint16_t pwms_each[JointController::JOINTS_SUM], pwms_bulk[JointController::JOINTS_SUM];
+        uint32_t torn_each, torn_bulk;
+        size_t   bytes_each, bytes_bulk;
+
+        if (   (puppeteer(poses, false, diff, false, pwms_each, torn_each, bytes_each) != 0)
+            || (puppeteer(poses, true,  diff, false, pwms_bulk, torn_bulk, bytes_bulk) != 0) )
+        {
+            return 1;
+        }
+
+        // Sanity check: both commands must output the same pose.
+        if (memcmp(pwms_each, pwms_bulk, sizeof(pwms_each)) != 0)
+        {
+            fprintf(stderr, "error: the bulk command outputs another pose.\n");
+
+            return 1;
+        }
+
+        // Sanity check: a pose of the bulk command is never torn, and takes a third of the bytes or fewer.
+        if (   (torn_bulk != 0)
+            || (bytes_bulk * 3 > bytes_each) )
+        {
+            fprintf(stderr, "error: the bulk command is torn or not smaller.\n");
+
+            return 1;
+        }
+    }
+
+    uint16_t pwms[JointController::JOINTS_SUM], pwms_tuned[JointController::JOINTS_SUM];
+    uint32_t torn;
+    size_t   bytes;
+
+    if (   (puppeteer(poses, true, false, false, pwms,       torn, bytes) != 0)
+        || (puppeteer(poses, true, false, true,  pwms_tuned, torn, bytes) != 0) )
+    {
+        return 1;
+    }
+
+    Scenario::runFor(SETTLE_US);
+
+    // Sanity check: the poses over BLE must not be disturbed by the commands over USB.
+    if (   (torn != 0)
+        || (memcmp(pwms, pwms_tuned, sizeof(pwms)) != 0) )
+    {
+        fprintf(stderr, "error: the poses were disturbed by the commands over USB serial.\n");
+
+        return 1;
+    }
+
+    // Sanity check: the commands over USB must not be disturbed by the poses over BLE.
+    JointController rebooted;
+    rebooted.loadSettings();
+
+    for (uint16_t pose = poses - PUPPET_JOINTS; pose < poses; pose++)
+    {
+        if (rebooted.getHomeAngle(PUPPET_JOINT[pose % PUPPET_JOINTS]) != angleOf(pose, 0))
+        {
+            fprintf(stderr, "error: the home angle of joint %u was not set.\n",
+                static_cast<unsigned>(PUPPET_JOINT[pose % PUPPET_JOINTS]));
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,301 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Arduino.h>
+
+#include "Host.h"
+#include "JointController.h"
+#include "Motion.h"
+#include "MotionController.h"
+#include "Pin.h"
+#include "Scenario.h"
+
+
+/*!
+    @brief Simulation of PWM output in each refresh mode
+
+    The refresh mode is changed with ">RM" commands, and every joint is given a different angle with "$AN".
+    After each timer 1 overflow, the selected line of the multiplexers and OCR1x are sampled,
+    and pulses of the servos are rebuilt from them in the same way as the hardware outputs:
+    OCR1x written by the vector becomes active at the next overflow, and the output is HIGH from
+    compare match until TOP. The benchmark reports for each mode:
+
+    - The period of a line, and the period of each servo. (Interval between its pulses.)
+    - The widest pulse, and the error of pulse widths against JointController::m_pwms.
+    - Updates of motions in 900[msec], while a frame streamed with "$SF" is playing.
+
+    Usage: Refresh.benchmark [--quick]
+*/
+namespace
+{
+    using namespace PLEN2;
+
+    enum
+    {
+        TIMER_TICK_US  = 4, //!< 16[MHz] prescaled by 64.
+        PERIODS_WARMUP = 2 * JointController::Multiplexer::SELECTABLE_LINES,
+        STREAM_MS      = 960,
+        WINDOW_US      = 900000, //!< Window to count updates in, while the streamed frame is playing.
+        MARGIN_US      = 100000
+    };
+
+    //! Expected period of a servo of each mode [usec].
+    const uint32_t SERVO_PERIOD_US[] = { 32768, 24000, 20000 };
+
+    namespace Shared
+    {
+        bool     buffered = false;
+        uint8_t  buffered_line;                                          //!< Line that OCR1x buffered is for.
+        uint16_t buffered_ocr[JointController::Multiplexer::SUM];
+
+        uint64_t last_overflow_us = 0;
+        uint32_t periods          = 0;
+        uint32_t line_period_min  = 0xFFFFFFFF;
+        uint32_t line_period_max  = 0;
+
+        uint64_t pulse_begin_us[JointController::JOINTS_SUM];
+        uint32_t servo_period_min = 0xFFFFFFFF;
+        uint32_t servo_period_max = 0;
+        uint32_t pulse_max_us     = 0;
+        uint32_t pulse_error_max  = 0;
+        uint32_t pulses           = 0;
+        bool     lookahead_broken = false;
+
+        uint32_t updates = 0;
+    }
+
+    uint8_t selectedLine()
+    {
+        return (digitalRead(Pin::MULTIPLEXER_SELECT0) << 0)
+             | (digitalRead(Pin::MULTIPLEXER_SELECT1) << 1)
+             | (digitalRead(Pin::MULTIPLEXER_SELECT2) << 2);
+    }
+
+    /*!
+        @brief Rebuild pulses output in the period that begins now
+    */
+    void onTimer1()
+    {
+        const uint64_t now  = Host::now();
+        const uint8_t  line = selectedLine();
+        const uint16_t top  = ICR1;
+
+        Shared::periods++;
+
+        if (Shared::periods > PERIODS_WARMUP)
+        {
+            const uint32_t line_period = now - Shared::last_overflow_us;
+
+            (line_period < Shared::line_period_min)? (Shared::line_period_min = line_period) : 0;
+            (line_period > Shared::line_period_max)? (Shared::line_period_max = line_period) : 0;
+        }
+
+        if (Shared::buffered)
+        {
+            if (Shared::buffered_line != line)
+            {
+                Shared::lookahead_broken = true;
+            }
+
+            for (uint8_t mux = 0; mux < JointController::Multiplexer::SUM; mux++)
+            {
+                const uint8_t  joint_id = line + mux * JointController::Multiplexer::SELECTABLE_LINES;
+                const uint32_t width_us = (top + 1 - Shared::buffered_ocr[mux]) * TIMER_TICK_US;
+                const uint32_t expected = (1024 - JointController::m_pwms[joint_id]) * TIMER_TICK_US;
+                const uint64_t begin_us = now + Shared::buffered_ocr[mux] * TIMER_TICK_US;
+
+                if (Shared::periods > PERIODS_WARMUP)
+                {
+                    const uint32_t error        = labs(static_cast<long>(width_us) - static_cast<long>(expected));
+                    const uint32_t servo_period = begin_us - Shared::pulse_begin_us[joint_id];
+
+                    (error > Shared::pulse_error_max)? (Shared::pulse_error_max = error) : 0;
+                    (width_us > Shared::pulse_max_us)? (Shared::pulse_max_us = width_us) : 0;
+
+                    // A pulse begins at compare match, so the interval depends on the width. Measure by equal widths.
+                    if (width_us == expected)
+                    {
+                        (servo_period < Shared::servo_period_min)? (Shared::servo_period_min = servo_period) : 0;
+                        (servo_period > Shared::servo_period_max)? (Shared::servo_period_max = servo_period) : 0;
+                    }
+
+                    Shared::pulses++;
+                }
+
+                Shared::pulse_begin_us[joint_id] = begin_us;
+            }
+        }
+
+        Shared::buffered      = true;
+        Shared::buffered_line = (line + 1) & (JointController::Multiplexer::SELECTABLE_LINES - 1);
+
+        Shared::buffered_ocr[0] = OCR1C; // Servo 00 to 07
+        Shared::buffered_ocr[1] = OCR1B; // Servo 08 to 15
+        Shared::buffered_ocr[2] = OCR1A; // Servo 16 to 23
+
+        Shared::last_overflow_us = now;
+    }
+
+    void resetSamples()
+    {
+        Shared::buffered         = false;
+        Shared::periods          = 0;
+        Shared::line_period_min  = 0xFFFFFFFF;
+        Shared::line_period_max  = 0;
+        Shared::servo_period_min = 0xFFFFFFFF;
+        Shared::servo_period_max = 0;
+        Shared::pulse_max_us     = 0;
+        Shared::pulse_error_max  = 0;
+        Shared::pulses           = 0;
+        Shared::lookahead_broken = false;
+        Shared::updates          = 0;
+    }
+
+    /*!
+        @brief Give every joint a different angle with "$AN" commands
+    */
+    void applyAngles(uint8_t seed)
+    {
+        for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+        {
+            char command[16] = "$AN";
+
+            const int16_t angle = JointController::ANGLE_MIN
+                + ((joint_id * 7 + seed) % JointController::JOINTS_SUM) * (JointController::ANGLE_MAX - JointController::ANGLE_MIN) / (JointController::JOINTS_SUM - 1);
+
+            Scenario::appendHex(command, joint_id, 2);
+            Scenario::appendHex(command, static_cast<uint16_t>(angle), 3);
+
+            Scenario::feedCommand(command);
+        }
+    }
+
+    /*!
+        @brief Simulate a refresh mode, and report the result
+
+        @return Exit status
+    */
+    int simulate(uint8_t mode, uint32_t servo_periods)
+    {
+        char command[8] = ">RM";
+
+        Scenario::appendHex(command, mode, 2);
+        Scenario::feedCommand(command);
+        applyAngles(mode);
+
+        // Angles committed are output from the cycle after the next one at the latest.
+        Scenario::runFor(2 * SERVO_PERIOD_US[mode]);
+
+        resetSamples();
+        Scenario::runFor(servo_periods * SERVO_PERIOD_US[mode]);
+
+        const uint32_t line_period_min  = Shared::line_period_min;
+        const uint32_t line_period_max  = Shared::line_period_max;
+        const uint32_t servo_period_min = Shared::servo_period_min;
+        const uint32_t servo_period_max = Shared::servo_period_max;
+        const uint32_t pulse_max_us     = Shared::pulse_max_us;
+        const uint32_t pulse_error_max  = Shared::pulse_error_max;
+        const uint32_t pulses           = Shared::pulses;
+        const bool     lookahead_broken = Shared::lookahead_broken;
+
+        // Count updates while a streamed frame is playing.
+        // (The first update follows loading the frame at once, so it is skipped.)
+        Scenario::feedStreamFrame(mode, STREAM_MS);
+        Scenario::runFor(SERVO_PERIOD_US[mode] / 2);
+
+        Shared::updates = 0;
+        Scenario::runFor(WINDOW_US);
+
+        const uint32_t updates = Shared::updates;
+
+        Scenario::feedCommand("$SM");
+        Scenario::runFor(STREAM_MS * 1000 + MARGIN_US);
+
+        printf("[mode %u]\n", static_cast<unsigned>(mode));
+        printf("%-28s %12lu\n", "pulses", static_cast<unsigned long>(pulses));
+        printf("%-28s %12lu\n", "line period us", static_cast<unsigned long>(line_period_max));
+        printf("%-28s %12lu\n", "servo period us (min)", static_cast<unsigned long>(servo_period_min));
+        printf("%-28s %12lu\n", "servo period us (max)", static_cast<unsigned long>(servo_period_max));
+        printf("%-28s %12lu\n", "widest pulse us", static_cast<unsigned long>(pulse_max_us));
+        printf("%-28s %12lu\n", "pulse width error us", static_cast<unsigned long>(pulse_error_max));
+        printf("%-28s %12lu\n", "updates / 900ms", static_cast<unsigned long>(updates));
+
+        // Sanity check: every servo must get its pulse in the period of the mode.
+        if (   (pulses == 0)
+            || lookahead_broken
+            || (line_period_min != line_period_max)
+            || (line_period_max * JointController::Multiplexer::SELECTABLE_LINES != SERVO_PERIOD_US[mode])
+            || (servo_period_min != SERVO_PERIOD_US[mode])
+            || (servo_period_max != SERVO_PERIOD_US[mode]) )
+        {
+            fprintf(stderr, "error: the period of mode %u is wrong.\n", static_cast<unsigned>(mode));
+
+            return 1;
+        }
+
+        // Sanity check: pulse widths must be kept, and fit in the period of a line.
+        if (   (pulse_error_max != 0)
+            || (pulse_max_us > line_period_max) )
+        {
+            fprintf(stderr, "error: the pulse width of mode %u is wrong.\n", static_cast<unsigned>(mode));
+
+            return 1;
+        }
+
+        // Sanity check: motions must be updated once in the period of a servo.
+        if (labs(static_cast<long>(updates) - static_cast<long>(WINDOW_US / SERVO_PERIOD_US[mode])) > 1)
+        {
+            fprintf(stderr, "error: motions of mode %u are not updated at the refresh rate.\n", static_cast<unsigned>(mode));
+
+            return 1;
+        }
+
+        return 0;
+    }
+}
+
+
+/*
+    Linker-level probes (see "-Wl,--wrap" in CMakeLists.txt)
+*/
+extern "C"
+{
+    void __real__ZN5PLEN216MotionController11updateFrameEv(PLEN2::MotionController* self);
+
+    void __wrap__ZN5PLEN216MotionController11updateFrameEv(PLEN2::MotionController* self)
+    {
+        Shared::updates++;
+
+        __real__ZN5PLEN216MotionController11updateFrameEv(self);
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    const bool quick = (argc > 1) && (strcmp(argv[1], "--quick") == 0);
+    const uint32_t servo_periods = quick? 4 : 64;
+
+    setup();
+    Host::setTimer1Hook(onTimer1);
+
+    for (uint8_t mode = 0; mode < JointController::REFRESH_MODE_SUM; mode++)
+    {
+        if (simulate(mode, servo_periods) != 0)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,517 @@
+/*!
+    @file      Scenario.h
+    @brief     Scripted serial input shared by the benchmarks.
+    @author    Kazuyuki TAKASE
+    @copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef HOST_SCENARIO_H
+#define HOST_SCENARIO_H
+
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+
+#include "Host.h"
+#include "JointController.h"
+#include "Motion.h"
+#include "Parser.h"
+
+
+/*!
+    @brief Scripted serial input shared by the benchmarks
+
+    Commands are fed into USB serial with the byte interval of 2Mbps,
+    so they are consumed by loop() in the same way as on the hardware.
+*/
+namespace Scenario
+{
+    enum
+    {
+        LOOP_INTERVAL_US = 20, //!< Virtual time consumed by one iteration of loop().
+        USB_BYTE_US      = 5   //!< Interval of incoming bytes at 2Mbps.
+    };
+
+    /*!
+        @brief Built-in functions of a motion installed by feedMotion()
+    */
+    struct MotionOptions
+    {
+        uint8_t use_loop;
+        uint8_t loop_begin;
+        uint8_t loop_end;
+        uint8_t loop_count;
+    };
+
+    inline void feedCommand(const char* command)
+    {
+        Serial.feed(command, static_cast<uint32_t>(USB_BYTE_US));
+    }
+
+    /*!
+        @brief Append a value as upper case hex string
+
+        Negative values have to be casted to uint16_t in advance (two's complement).
+    */
+    inline void appendHex(char* buffer, uint16_t value, uint8_t digits)
+    {
+        static const char HEX_CHARS[] = "0123456789ABCDEF";
+
+        char* it = buffer + strlen(buffer);
+
+        for (int8_t digit = digits - 1; digit >= 0; digit--)
+        {
+            *it++ = HEX_CHARS[(value >> (digit * 4)) & 0x0F];
+        }
+
+        *it = '\0';
+    }
+
+    /*!
+        @brief Get transition time of a frame installed by the scenario [msec]
+
+        Transition time of each frame is 96, 128, 160 or 192 [msec].
+    */
+    inline uint16_t transitionTimeOf(uint8_t frame_id)
+    {
+        return 96 + 32 * (frame_id % 4);
+    }
+
+    /*!
+        @brief Get joint angle of a frame installed by the scenario [deg * 10]
+
+        Joint angles vary between -120 and 120 [deg * 10].
+    */
+    inline int16_t angleOf(uint8_t frame_id, uint8_t device_id)
+    {
+        return ((frame_id + device_id) % 5 - 2) * 60;
+    }
+
+    /*!
+        @brief Install a motion header with ">MH" command
+
+        @param [in] slot Slot number of the motion.
+        @param [in] frame_length Count of frames.
+        @param [in] options Built-in functions of the motion.
+        @param [in] extra Digit of use_extra. (0x2 stores the frames delta-compressed.)
+    */
+    inline void feedHeader(uint8_t slot, uint8_t frame_length, const MotionOptions& options, uint8_t extra = 0)
+    {
+        char command[128];
+
+        strcpy(command, ">MH");
+        appendHex(command, slot, 2);
+        strcat(command, "Benchmark           "); // 20 characters.
+        appendHex(command, options.use_loop, 1);
+        appendHex(command, options.loop_begin, 2);
+        appendHex(command, options.loop_end, 2);
+        appendHex(command, options.loop_count, 2);
+        strcat(command, "0");                    // use_jump
+        appendHex(command, 0, 2);                // jump_slot
+        appendHex(command, extra, 1);            // use_extra
+        appendHex(command, frame_length, 2);
+        feedCommand(command);
+    }
+
+    /*!
+        @brief Install a motion with ">MH" and ">MF" commands
+
+        @param [in] slot Slot number of the motion.
+        @param [in] frame_length Count of frames.
+        @param [in] options Built-in functions of the motion.
+        @param [in] transition_time_ms Transition time of each frame [msec], or NULL to use transitionTimeOf().
+    */
+    inline void feedMotion(uint8_t slot, uint8_t frame_length, const MotionOptions& options,
+        const uint16_t* transition_time_ms = NULL)
+    {
+        char command[128];
+
+        feedHeader(slot, frame_length, options);
+
+        for (uint8_t frame_id = 0; frame_id < frame_length; frame_id++)
+        {
+            strcpy(command, ">MF");
+            appendHex(command, slot, 2);
+            appendHex(command, frame_id, 2);
+            appendHex(command, (transition_time_ms)? transition_time_ms[frame_id] : transitionTimeOf(frame_id), 4);
+
+            for (uint8_t device_id = 0; device_id < PLEN2::JointController::JOINTS_SUM; device_id++)
+            {
+                appendHex(command, static_cast<uint16_t>(angleOf(frame_id, device_id)), 4);
+            }
+
+            feedCommand(command);
+        }
+    }
+
+    inline void feedMotion(uint8_t slot, uint8_t frame_length)
+    {
+        const MotionOptions options = { 0, 0, 0, 0 };
+
+        feedMotion(slot, frame_length, options);
+    }
+
+    /*!
+        @brief Send a command that takes a binary frame (see Utility::BinaryParser)
+
+        @param [in] command Header and command, e.g. ">MB".
+        @param [in] payload Payload of the frame.
+        @param [in] length Length of the payload.
+
+        @return Count of bytes sent
+    */
+    inline size_t feedBinary(const char* command, const uint8_t* payload, uint8_t length)
+    {
+        uint8_t frame[128];
+        uint8_t* it = frame;
+
+        *it++ = length;
+        memcpy(it, payload, length);
+        it += length;
+
+        const uint16_t crc = Utility::crc16(frame, 1 + length);
+
+        *it++ = crc & 0xFF;
+        *it++ = crc >> 8;
+
+        Serial.feed(command, static_cast<uint32_t>(USB_BYTE_US));
+        Serial.feed(reinterpret_cast<const char*>(frame), it - frame, static_cast<uint32_t>(USB_BYTE_US));
+
+        return strlen(command) + (it - frame);
+    }
+
+    /*!
+        @brief Make a binary payload of a frame (see decodeFrameBinary() in firmware.ino)
+
+        @param [out] payload Buffer of the payload.
+        @param [in] frame_id Index of the frame in the scenario.
+        @param [in] transition_time_ms Transition time of the frame [msec].
+        @param [in] easing Easing curve of the frame, or -1 to omit it.
+
+        @return Length of the payload
+    */
+    inline uint8_t makeFramePayload(uint8_t* payload, uint8_t frame_id, uint16_t transition_time_ms, int easing = -1)
+    {
+        uint8_t* it = payload;
+
+        *it++ = transition_time_ms & 0xFF;
+        *it++ = transition_time_ms >> 8;
+
+        for (uint8_t device_id = 0; device_id < PLEN2::JointController::JOINTS_SUM; device_id++)
+        {
+            const uint16_t angle = static_cast<uint16_t>(angleOf(frame_id, device_id));
+
+            *it++ = angle & 0xFF;
+            *it++ = angle >> 8;
+        }
+
+        if (easing >= 0)
+        {
+            *it++ = static_cast<uint8_t>(easing);
+        }
+
+        return it - payload;
+    }
+
+    /*!
+        @brief Install a motion with ">MH" and ">MB" (binary frame) commands
+
+        The motion is the same as the one installed by feedMotion() without any built-in function.
+
+        @param [in] slot Slot number of the motion.
+        @param [in] frame_length Count of frames.
+
+        @return Count of bytes sent per frame
+    */
+    inline size_t feedMotionBinary(uint8_t slot, uint8_t frame_length)
+    {
+        const MotionOptions options = { 0, 0, 0, 0 };
+
+        feedHeader(slot, frame_length, options);
+
+        size_t bytes = 0;
+
+        for (uint8_t frame_id = 0; frame_id < frame_length; frame_id++)
+        {
+            uint8_t payload[128] = { slot, frame_id };
+            const uint8_t length = 2 + makeFramePayload(payload + 2, frame_id, transitionTimeOf(frame_id));
+
+            bytes = feedBinary(">MB", payload, length);
+        }
+
+        return bytes;
+    }
+
+    /*!
+        @brief Push a frame to the stream with "$SF" (binary frame) command
+
+        @param [in] frame_id Index of the frame in the scenario.
+        @param [in] transition_time_ms Transition time of the frame [msec].
+        @param [in] easing Easing curve of the frame, or -1 to omit it.
+
+        @return Count of bytes sent
+    */
+    inline size_t feedStreamFrame(uint8_t frame_id, uint16_t transition_time_ms, int easing = -1)
+    {
+        uint8_t payload[128];
+        const uint8_t length = makeFramePayload(payload, frame_id, transition_time_ms, easing);
+
+        return feedBinary("$SF", payload, length);
+    }
+
+    /*!
+        @brief Run loop() until all scripted input is consumed and given time elapses
+
+        @param [in] usec Time to keep running after the input is consumed [usec].
+        @param [in] iteration Function that calls loop(), e.g. to measure it.
+    */
+    inline void runFor(uint32_t usec, void (*iteration)() = loop)
+    {
+        while (   Serial.pending()
+               || Serial1.pending() )
+        {
+            iteration();
+            Host::elapse(LOOP_INTERVAL_US);
+        }
+
+        const uint64_t end = Host::now() + usec;
+
+        while (Host::now() < end)
+        {
+            iteration();
+            Host::elapse(LOOP_INTERVAL_US);
+        }
+    }
+
+    /*!
+        @brief Motion read from a file of the format in "motions/"
+    */
+    struct MotionFile
+    {
+        std::string name;
+        uint8_t  slot;
+        uint8_t  frame_length;
+        uint16_t transition_time_ms[PLEN2::Motion::Header::FRAMELENGTH_MAX];
+        int16_t  joint_angle[PLEN2::Motion::Header::FRAMELENGTH_MAX][PLEN2::JointController::JOINTS_SUM];
+        MotionOptions options;
+    };
+
+    /*!
+        @brief Read an integer that follows a key of JSON
+
+        @param [in] cursor Position to search the key from, or NULL.
+        @param [in] key Key to search.
+        @param [out] value Integer read.
+
+        @return Pointer to the character after the integer, or NULL if the key was not found
+    */
+    inline const char* readInteger(const char* cursor, const char* key, long& value)
+    {
+        if (cursor == NULL)
+        {
+            return NULL;
+        }
+
+        cursor = strstr(cursor, key);
+
+        if (cursor == NULL)
+        {
+            return NULL;
+        }
+
+        cursor += strlen(key);
+        cursor += strcspn(cursor, "-0123456789");
+
+        char* end;
+        value = strtol(cursor, &end, 10);
+
+        return (end == cursor)? NULL : end;
+    }
+
+    /*!
+        @brief Read a motion file of the format in "motions/"
+
+        The parser relies on the layout of the files: "codes" precedes "frames", "name" and "slot" follow "frames",
+        the frames are sorted by "@index", and "outputs" lists 9 joints of the left half and then 9 joints
+        of the right half before "transition_time_ms". (Each half has 12 joints in the firmware,
+        and the last 3 of them are not used.)
+    */
+    inline bool readMotion(const char* path, MotionFile& motion)
+    {
+        enum { OUTPUTS_HALF = 9, OUTPUTS = OUTPUTS_HALF * 2 };
+
+        FILE* fp = fopen(path, "rb");
+
+        if (fp == NULL)
+        {
+            return false;
+        }
+
+        std::string text;
+        char buffer[4096];
+        size_t length;
+
+        while ((length = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+        {
+            text.append(buffer, length);
+        }
+
+        fclose(fp);
+
+        const char* json = text.c_str();
+        long value;
+
+        if (   (readInteger(json, "\"@frame_length\"", value) == NULL)
+            || (value < PLEN2::Motion::Header::FRAMELENGTH_MIN)
+            || (value > PLEN2::Motion::Header::FRAMELENGTH_MAX) )
+        {
+            return false;
+        }
+
+        motion.frame_length = static_cast<uint8_t>(value);
+
+        const char* frames = strstr(json, "\"frames\"");
+
+        if (   (frames == NULL)
+            || (readInteger(frames, "\"slot\"", value) == NULL)
+            || (value < 0)
+            || (value >= PLEN2::Motion::SLOT_END) )
+        {
+            return false;
+        }
+
+        motion.slot = static_cast<uint8_t>(value);
+
+        const char* name = strstr(frames, "\"name\"");
+
+        if (name != NULL)
+        {
+            name = strchr(name + strlen("\"name\"") + 1, '"');
+        }
+
+        const char* name_end = (name != NULL)? strchr(name + 1, '"') : NULL;
+
+        if (name_end != NULL)
+        {
+            motion.name.assign(name + 1, name_end - (name + 1));
+        }
+
+        const MotionOptions no_options = { 0, 0, 0, 0 };
+        motion.options = no_options;
+
+        const char* loop = strstr(json, "\"loop\"");
+
+        if (   (loop != NULL)
+            && (loop < frames) )
+        {
+            long begin, end, count;
+
+            const char* cursor = readInteger(json, "\"arguments\"", begin);
+            cursor = readInteger(cursor, ",", end);
+            cursor = readInteger(cursor, ",", count);
+
+            if (cursor == NULL)
+            {
+                return false;
+            }
+
+            motion.options.use_loop   = 1;
+            motion.options.loop_begin = static_cast<uint8_t>(begin);
+            motion.options.loop_end   = static_cast<uint8_t>(end);
+            motion.options.loop_count = static_cast<uint8_t>(count);
+        }
+
+        const char* cursor = frames;
+
+        for (uint8_t frame_id = 0; frame_id < motion.frame_length; frame_id++)
+        {
+            memset(motion.joint_angle[frame_id], 0, sizeof(motion.joint_angle[frame_id]));
+
+            for (uint8_t output = 0; output < OUTPUTS; output++)
+            {
+                cursor = readInteger(cursor, "\"value\"", value);
+
+                if (cursor == NULL)
+                {
+                    return false;
+                }
+
+                const uint8_t joint_id = (output < OUTPUTS_HALF)?
+                    output : (output + PLEN2::JointController::JOINTS_SUM / 2 - OUTPUTS_HALF);
+
+                motion.joint_angle[frame_id][joint_id] = static_cast<int16_t>(value);
+            }
+
+            cursor = readInteger(cursor, "\"transition_time_ms\"", value);
+
+            if (cursor == NULL)
+            {
+                return false;
+            }
+
+            motion.transition_time_ms[frame_id] = static_cast<uint16_t>(value);
+        }
+
+        return true;
+    }
+
+    /*!
+        @brief Read every motion file in a directory, sorted by the file names
+
+        @return Result (false if the directory has no motion file, or a file is not a motion file)
+    */
+    inline bool readMotions(const char* directory, std::vector<MotionFile>& motions)
+    {
+        DIR* dir = opendir(directory);
+
+        if (dir == NULL)
+        {
+            return false;
+        }
+
+        std::vector<std::string> files;
+
+        while (struct dirent* entry = readdir(dir))
+        {
+            const std::string file = entry->d_name;
+
+            if (   (file.size() > 5)
+                && (file.compare(file.size() - 5, 5, ".json") == 0) )
+            {
+                files.push_back(file);
+            }
+        }
+
+        closedir(dir);
+        std::sort(files.begin(), files.end());
+
+        for (size_t index = 0; index < files.size(); index++)
+        {
+            MotionFile motion;
+            const std::string path = std::string(directory) + "/" + files[index];
+
+            if (!readMotion(path.c_str(), motion))
+            {
+                fprintf(stderr, "error: %s is not a motion file.\n", path.c_str());
+
+                return false;
+            }
+
+            motions.push_back(motion);
+        }
+
+        return !motions.empty();
+    }
+}
+
+#endif // HOST_SCENARIO_H
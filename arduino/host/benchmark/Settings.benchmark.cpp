@@ -0,0 +1,354 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+#include "Host.h"
+#include "JointController.h"
+#include "Scenario.h"
+
+
+/*!
+    @brief Benchmark of tuning and calibrating joint settings
+
+    The joint settings are loaded from erased internal EEPROM (the first boot), and then a tuning tool sends
+    ">HO" commands to a few joints over USB serial every COMMAND_INTERVAL_US, and commits them with ">SS".
+    The benchmark reports on the virtual clock:
+
+    - Time of the first JointController::loadSettings().
+    - The longest time until a ">HO" command is consumed, and the longest iteration of loop() meanwhile.
+    - Time of ">SS", that writes the joint settings changed.
+    - Writes of internal EEPROM, and the write count of the most worn cell,
+      against the cells rewritten by each command directly (2 bytes of the joint per command).
+
+    Then the settings are loaded by another instance, as the next boot.
+
+    Next, min, max and home angles of all joints are set with 72 commands of ">MI", ">MA" and ">HO",
+    and then with a ">SA" command (binary), and the bytes sent and the writes of internal EEPROM are reported.
+    (E.g. 576 bytes and 288 writes against 114 bytes and 145 writes.)
+
+    Usage: Settings.benchmark [--quick]
+*/
+namespace
+{
+    using namespace PLEN2;
+
+    enum
+    {
+        COMMANDS_DEFAULT    = 2000,
+        COMMANDS_QUICK      = 400,
+        TUNED_JOINTS        = 3,
+        COMMAND_INTERVAL_US = 20000, //!< Interval of commands sent by the tool.
+        ANGLE_RANGE         = 0x100, //!< Home angles given are 0 to 255.
+        SETTLE_US           = 1000000 //!< Time to wait for writes in the background.
+    };
+
+    const uint8_t TUNED_JOINT[TUNED_JOINTS] = {
+        JointController::LEFT_KNEE_PITCH, JointController::RIGHT_KNEE_PITCH, JointController::LEFT_FOOT_ROLL
+    };
+
+    uint64_t loop_max_us = 0;
+
+    void measuredLoop()
+    {
+        const uint64_t begin = Host::now();
+
+        loop();
+
+        if ((Host::now() - begin) > loop_max_us)
+        {
+            loop_max_us = Host::now() - begin;
+        }
+    }
+
+    void consume()
+    {
+        while (Serial.pending())
+        {
+            measuredLoop();
+            Host::elapse(Scenario::LOOP_INTERVAL_US);
+        }
+    }
+
+    void idle(uint64_t until)
+    {
+        while (Host::now() < until)
+        {
+            measuredLoop();
+            Host::elapse(Scenario::LOOP_INTERVAL_US);
+        }
+    }
+
+    uint32_t writesOfEEPROM()
+    {
+        uint32_t writes = 0;
+
+        for (uint16_t index = 0; index < Host::InternalEEPROM::SIZE; index++)
+        {
+            writes += Host::InternalEEPROM::wearCounts()[index];
+        }
+
+        return writes;
+    }
+
+    uint32_t maxWearOfEEPROM()
+    {
+        uint32_t wear = 0;
+
+        for (uint16_t index = 0; index < Host::InternalEEPROM::SIZE; index++)
+        {
+            if (Host::InternalEEPROM::wearCounts()[index] > wear)
+            {
+                wear = Host::InternalEEPROM::wearCounts()[index];
+            }
+        }
+
+        return wear;
+    }
+
+    int16_t calibratedAngle(uint8_t joint_id, uint8_t field)
+    {
+        switch (field)
+        {
+            case 0:  return -600 + joint_id;
+            case 1:  return  600 - joint_id;
+            default: return joint_id * 10;
+        }
+    }
+
+    bool verify(JointController& joint_ctrl)
+    {
+        for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+        {
+            if (   (joint_ctrl.getMinAngle(joint_id)  != calibratedAngle(joint_id, 0))
+                || (joint_ctrl.getMaxAngle(joint_id)  != calibratedAngle(joint_id, 1))
+                || (joint_ctrl.getHomeAngle(joint_id) != calibratedAngle(joint_id, 2)) )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /*!
+        @brief Set all joint settings on freshly reset hardware, and report the result
+
+        @param [in]  bulk   Set them with ">SA" instead of ">MI", ">MA" and ">HO".
+        @param [out] writes Writes of internal EEPROM.
+        @param [out] bytes  Bytes sent.
+
+        @return Exit status
+    */
+    int calibrate(bool bulk, uint32_t& writes, size_t& bytes)
+    {
+        Host::reset();
+        setup();
+
+        const uint32_t writes_done = writesOfEEPROM();
+        bytes = 0;
+
+        if (bulk)
+        {
+            uint8_t payload[JointController::SETTINGS_SUM / 2 * 3];
+            uint8_t* it = payload;
+
+            for (uint8_t index = 0; index < JointController::SETTINGS_SUM; index += 2)
+            {
+                const uint16_t a = calibratedAngle(index / 3, index % 3);
+                const uint16_t b = calibratedAngle((index + 1) / 3, (index + 1) % 3);
+
+                *it++ = a & 0xFF;
+                *it++ = ((a >> 8) & 0x0F) | ((b & 0x0F) << 4);
+                *it++ = (b >> 4) & 0xFF;
+            }
+
+            bytes = Scenario::feedBinary(">SA", payload, sizeof(payload));
+        }
+        else
+        {
+            const char* COMMAND[] = { ">MI", ">MA", ">HO" };
+
+            for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+            {
+                for (uint8_t field = 0; field < 3; field++)
+                {
+                    char command[16];
+
+                    strcpy(command, COMMAND[field]);
+                    Scenario::appendHex(command, joint_id, 2);
+                    Scenario::appendHex(command, static_cast<uint16_t>(calibratedAngle(joint_id, field)) & 0xFFF, 3);
+                    Scenario::feedCommand(command);
+
+                    bytes += strlen(command);
+                }
+            }
+        }
+
+        consume();
+        idle(Host::now() + SETTLE_US);
+
+        writes = writesOfEEPROM() - writes_done;
+
+        printf("[%s]\n", bulk? ">SA (binary)" : ">MI / >MA / >HO");
+        printf("%-28s %12lu\n", "bytes sent", static_cast<unsigned long>(bytes));
+        printf("%-28s %12lu\n", "EEPROM writes", static_cast<unsigned long>(writes));
+
+        // Sanity check: the settings must be loaded at the next boot.
+        JointController rebooted;
+        rebooted.loadSettings();
+
+        if (!verify(rebooted))
+        {
+            fprintf(stderr, "error: the joint settings were not persisted.\n");
+
+            return 1;
+        }
+
+        return 0;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    const bool quick = (argc > 1) && (strcmp(argv[1], "--quick") == 0);
+    const uint16_t commands = quick? COMMANDS_QUICK : COMMANDS_DEFAULT;
+
+    Host::reset();
+
+    uint64_t begin = Host::now();
+
+    JointController first;
+    first.loadSettings();
+
+    const uint64_t load_us = Host::now() - begin;
+
+    Host::InternalEEPROM::reset();
+    setup();
+
+    int16_t  expected[TUNED_JOINTS];
+    uint32_t commands_of[TUNED_JOINTS] = { 0 };
+
+    loop_max_us = 0;
+
+    const uint32_t writes_done = writesOfEEPROM();
+    uint64_t latency_max_us = 0;
+
+    for (uint16_t count = 0; count < commands; count++)
+    {
+        const uint8_t joint = count % TUNED_JOINTS;
+        char command[16];
+
+        expected[joint] = (count * 7) % ANGLE_RANGE;
+        commands_of[joint]++;
+
+        strcpy(command, ">HO");
+        Scenario::appendHex(command, TUNED_JOINT[joint], 2);
+        Scenario::appendHex(command, expected[joint], 3);
+        begin = Host::now();
+
+        Scenario::feedCommand(command);
+        consume();
+
+        if ((Host::now() - begin) > latency_max_us)
+        {
+            latency_max_us = Host::now() - begin;
+        }
+
+        idle(begin + COMMAND_INTERVAL_US);
+    }
+
+    const uint64_t session_loop_us = loop_max_us;
+
+    begin = Host::now();
+
+    Scenario::feedCommand(">SS");
+    consume();
+
+    const uint64_t commit_us = Host::now() - begin;
+
+    const uint32_t writes = writesOfEEPROM() - writes_done;
+
+    uint32_t direct_wear = 0;
+
+    for (uint8_t joint = 0; joint < TUNED_JOINTS; joint++)
+    {
+        if (commands_of[joint] > direct_wear)
+        {
+            direct_wear = commands_of[joint];
+        }
+    }
+
+    printf("[>HO tuning session]\n");
+    printf("%-28s %12lu\n", "sim ms of first load", static_cast<unsigned long>(load_us / 1000));
+    printf("%-28s %12u\n",  ">HO commands", static_cast<unsigned>(commands));
+    printf("%-28s %12lu\n", "max sim us of a command", static_cast<unsigned long>(latency_max_us));
+    printf("%-28s %12lu\n", "max sim us of loop()", static_cast<unsigned long>(session_loop_us));
+    printf("%-28s %12lu\n", "sim ms of >SS", static_cast<unsigned long>(commit_us / 1000));
+    printf("%-28s %12lu\n", "EEPROM writes", static_cast<unsigned long>(writes));
+    printf("%-28s %12lu\n", "EEPROM writes (direct)", static_cast<unsigned long>(2 * commands));
+    printf("%-28s %12lu\n", "max wear of a cell", static_cast<unsigned long>(maxWearOfEEPROM()));
+    printf("%-28s %12lu\n", "max wear (direct)", static_cast<unsigned long>(direct_wear));
+
+    // Sanity check: loop() must not wait for write cycles of internal EEPROM, but the end of a compaction waits for a few.
+    if (session_loop_us >= 4 * Host::InternalEEPROM::WRITE_CYCLE_US)
+    {
+        fprintf(stderr, "error: a command waits for a write cycle.\n");
+
+        return 1;
+    }
+
+    // Sanity check: the journal must spread writes over the cells.
+    if (maxWearOfEEPROM() * 4 > direct_wear)
+    {
+        fprintf(stderr, "error: the cells are worn as much as writing them directly.\n");
+
+        return 1;
+    }
+
+    // Sanity check: the settings committed must be loaded at the next boot.
+    JointController rebooted;
+    rebooted.loadSettings();
+
+    for (uint8_t joint = 0; joint < TUNED_JOINTS; joint++)
+    {
+        if (rebooted.getHomeAngle(TUNED_JOINT[joint]) != expected[joint])
+        {
+            fprintf(stderr, "error: the home angle of joint %u was not persisted.\n",
+                static_cast<unsigned>(TUNED_JOINT[joint]));
+
+            return 1;
+        }
+    }
+
+    uint32_t writes_each, writes_bulk;
+    size_t   bytes_each,  bytes_bulk;
+
+    if (   (calibrate(false, writes_each, bytes_each) != 0)
+        || (calibrate(true,  writes_bulk, bytes_bulk) != 0) )
+    {
+        return 1;
+    }
+
+    // Sanity check: ">SA" must take fewer bytes and fewer writes than a command per setting.
+    if (   (bytes_bulk * 4 > bytes_each)
+        || (writes_bulk >= writes_each) )
+    {
+        fprintf(stderr, "error: >SA is not cheaper than a command per setting.\n");
+
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,158 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Arduino.h>
+
+#include "Host.h"
+#include "JointController.h"
+#include "Motion.h"
+#include "MotionController.h"
+#include "Scenario.h"
+
+
+/*!
+    @brief Benchmark of timing of a motion played at each playback speed
+
+    A looped motion is played with "$PM" at each speed given by "$SP", and the benchmark reports:
+
+    - Ticks of MotionController::updateFrame() taken by the motion.
+    - Ticks expected from the transition time of the frames divided by the speed,
+      and by the exact period of updates. (32.768[msec] in the mode of 32[msec].)
+    - Error of the ticks, compared with the error of truncating each frame to ticks.
+
+    Usage: Speed.benchmark [--quick]
+*/
+namespace
+{
+    using namespace PLEN2;
+
+    enum
+    {
+        FRAME_LENGTH        = 8,
+        LOOP_COUNT_DEFAULT  = 30,
+        LOOP_COUNT_QUICK    = 3,
+        MARGIN_US           = 100000
+    };
+
+    //! Transition time of each frame [msec], the same as "00_LStep".
+    const uint16_t TRANSITION_TIME_MS[FRAME_LENGTH] = { 100, 140, 140, 140, 140, 140, 180, 200 };
+
+    //! Playback speeds compared. (0.25x, 0.5x, 1x, 1.5x, 3x and 4x)
+    const uint16_t SPEED[] = {
+        MotionController::SPEED_MIN,
+        MotionController::SPEED_ONE / 2,
+        MotionController::SPEED_ONE,
+        MotionController::SPEED_ONE * 3 / 2,
+        MotionController::SPEED_ONE * 3,
+        MotionController::SPEED_MAX
+    };
+
+    enum { SPEEDS = sizeof(SPEED) / sizeof(SPEED[0]) };
+
+    namespace Shared
+    {
+        uint32_t ticks;
+    }
+}
+
+
+/*
+    Linker-level probes (see "-Wl,--wrap" in CMakeLists.txt)
+*/
+extern "C"
+{
+    void __real__ZN5PLEN216MotionController11updateFrameEv(MotionController* self);
+
+    void __wrap__ZN5PLEN216MotionController11updateFrameEv(MotionController* self)
+    {
+        Shared::ticks++;
+
+        __real__ZN5PLEN216MotionController11updateFrameEv(self);
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    const bool quick = (argc > 1) && (strcmp(argv[1], "--quick") == 0);
+    const uint8_t loop_count = quick? LOOP_COUNT_QUICK : LOOP_COUNT_DEFAULT;
+
+    setup();
+
+    JointController joint_ctrl;
+    const uint32_t period_us = joint_ctrl.getUpdatePeriod();
+
+    const Scenario::MotionOptions options = { 1, 0, FRAME_LENGTH - 1, loop_count };
+
+    Scenario::feedMotion(0, FRAME_LENGTH, options, TRANSITION_TIME_MS);
+    Scenario::runFor(MARGIN_US);
+
+    // The loop is played loop_count times after the first play.
+    const uint32_t plays = loop_count + 1;
+
+    printf("%-10s %12s %12s %14s %20s\n", "speed", "ticks", "expected", "error ticks", "truncated error");
+
+    for (uint8_t index = 0; index < SPEEDS; index++)
+    {
+        char command[16] = "$SP";
+
+        Scenario::appendHex(command, SPEED[index], 4);
+        Scenario::feedCommand(command);
+        Scenario::runFor(0);
+
+        // [msec / SPEED_ONE] and [1/1000 ticks]
+        uint32_t time      = 0;
+        uint32_t truncated = 0;
+
+        for (uint8_t frame_id = 0; frame_id < FRAME_LENGTH; frame_id++)
+        {
+            const uint32_t frame_time  = static_cast<uint32_t>(TRANSITION_TIME_MS[frame_id]) << MotionController::SPEED_PRECISION;
+            const uint32_t frame_ticks = frame_time / (SPEED[index] * Motion::Frame::UPDATE_INTERVAL_MS);
+
+            time      += frame_time;
+            truncated += (frame_ticks == 0)? 1 : frame_ticks;
+        }
+
+        time      *= plays;
+        truncated *= plays;
+
+        const uint32_t expected = static_cast<uint64_t>(time) * 1000000 / (static_cast<uint32_t>(SPEED[index]) * period_us);
+
+        Shared::ticks = 0;
+
+        Scenario::feedCommand("$PM00");
+        Scenario::runFor(static_cast<uint64_t>(time) * 1000 / SPEED[index] + MARGIN_US);
+
+        const int32_t error           = static_cast<int32_t>(Shared::ticks * 1000) - static_cast<int32_t>(expected);
+        const int32_t truncated_error = static_cast<int32_t>(truncated * 1000) - static_cast<int32_t>(expected);
+
+        printf("%7u/%-2u %12lu %8lu.%03lu %9c%lu.%03lu %15c%lu.%03lu\n",
+            static_cast<unsigned>(SPEED[index]), static_cast<unsigned>(MotionController::SPEED_ONE),
+            static_cast<unsigned long>(Shared::ticks),
+            static_cast<unsigned long>(expected / 1000), static_cast<unsigned long>(expected % 1000),
+            (error < 0)? '-' : '+', static_cast<unsigned long>(labs(error) / 1000), static_cast<unsigned long>(labs(error) % 1000),
+            (truncated_error < 0)? '-' : '+', static_cast<unsigned long>(labs(truncated_error) / 1000), static_cast<unsigned long>(labs(truncated_error) % 1000)
+        );
+
+        // Sanity check: timing error of the whole loop must be less than a tick.
+        if (labs(error) >= 1000)
+        {
+            fprintf(stderr, "error: timing error at speed %u/%u is a tick or more.\n",
+                static_cast<unsigned>(SPEED[index]), static_cast<unsigned>(MotionController::SPEED_ONE));
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
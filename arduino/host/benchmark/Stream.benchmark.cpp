@@ -0,0 +1,194 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <deque>
+#include <string>
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "Host.h"
+#include "Motion.h"
+#include "MotionController.h"
+#include "Scenario.h"
+
+
+/*!
+    @brief Benchmark of streaming playback from a host
+
+    A control server is simulated: it pushes frames of 32 [msec] with "$SF" commands
+    as long as it has credits, and gets a credit back for each "SC" line after its reaction latency.
+    At the end it sends "$SM", and the benchmark reports on the virtual clock:
+
+    - Total time of the stream, compared with the sum of transition time of the frames.
+    - Count of holds at frame boundaries. (The next frame had not arrived yet.)
+    - Count of rejected frames, and I2C transactions to external EEPROM while streaming.
+
+    Usage: Stream.benchmark [--quick]
+*/
+namespace
+{
+    enum
+    {
+        FRAMES_DEFAULT     = 2000,
+        FRAMES_QUICK       = 100,
+        TRANSITION_TIME_MS = 32,
+        HOST_LATENCY_US    = 4000, //!< Reaction time of the control server to a credit.
+        MARGIN_US          = 100000
+    };
+
+    namespace Shared
+    {
+        std::deque<uint64_t> credits_due; //!< Time when each credit reported becomes usable.
+
+        uint32_t credits  = PLEN2::MotionController::STREAMBUFFER_LENGTH;
+        uint32_t consumed = 0;
+        uint32_t rejected = 0;
+        uint32_t holds    = 0;
+
+        std::string line;
+    }
+
+    /*!
+        @brief Read reports of the firmware, and give back credits
+    */
+    void readReports()
+    {
+        std::string& output = Serial.output();
+
+        for (size_t index = 0; index < output.size(); index++)
+        {
+            const char c = output[index];
+
+            if (c == '\r')
+            {
+                continue;
+            }
+
+            if (c != '\n')
+            {
+                Shared::line += c;
+
+                continue;
+            }
+
+            if (Shared::line.compare(0, 2, "SC") == 0)
+            {
+                Shared::consumed++;
+                Shared::credits_due.push_back(Host::now() + HOST_LATENCY_US);
+            }
+
+            if (Shared::line.compare(0, 2, "SR") == 0)
+            {
+                Shared::rejected++;
+            }
+
+            Shared::line.clear();
+        }
+
+        output.clear();
+
+        while (   !Shared::credits_due.empty()
+               && (Shared::credits_due.front() <= Host::now()) )
+        {
+            Shared::credits_due.pop_front();
+            Shared::credits++;
+        }
+    }
+}
+
+
+/*
+    Linker-level probes (see "-Wl,--wrap" in CMakeLists.txt)
+*/
+extern "C"
+{
+    void __real__ZN5PLEN216MotionController13loadNextFrameEv(PLEN2::MotionController* self);
+
+    void __wrap__ZN5PLEN216MotionController13loadNextFrameEv(PLEN2::MotionController* self)
+    {
+        const uint32_t consumed = Shared::consumed;
+
+        __real__ZN5PLEN216MotionController13loadNextFrameEv(self);
+
+        readReports();
+
+        if (Shared::consumed == consumed)
+        {
+            Shared::holds++;
+        }
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    const bool quick = (argc > 1) && (strcmp(argv[1], "--quick") == 0);
+    const uint32_t frames = quick? FRAMES_QUICK : FRAMES_DEFAULT;
+
+    setup();
+
+    const uint64_t begin        = Host::now();
+    const uint32_t transactions = Host::ExternalEEPROM::transactions();
+    uint32_t pushed = 0;
+
+    while (Shared::consumed < frames)
+    {
+        readReports();
+
+        while (   (pushed < frames)
+               && (Shared::credits > 0) )
+        {
+            Scenario::feedStreamFrame(static_cast<uint8_t>(pushed), TRANSITION_TIME_MS);
+
+            pushed++;
+            Shared::credits--;
+        }
+
+        loop();
+        Host::elapse(Scenario::LOOP_INTERVAL_US);
+    }
+
+    Scenario::feedCommand("$SM");
+    Scenario::runFor(TRANSITION_TIME_MS * 1000 + MARGIN_US);
+    readReports();
+
+    const uint64_t elapsed  = Host::now() - begin - (TRANSITION_TIME_MS * 1000 + MARGIN_US);
+    const uint64_t expected = static_cast<uint64_t>(frames) * TRANSITION_TIME_MS * 1000;
+
+    printf("%-28s %12lu\n", "frames", static_cast<unsigned long>(frames));
+    printf("%-28s %12lu\n", "expected sim ms", static_cast<unsigned long>(expected / 1000));
+    printf("%-28s %12lu\n", "total sim ms", static_cast<unsigned long>(elapsed / 1000));
+    printf("%-28s %12lu\n", "holds (underrun)", static_cast<unsigned long>(Shared::holds));
+    printf("%-28s %12lu\n", "rejected frames", static_cast<unsigned long>(Shared::rejected));
+    printf("%-28s %12lu\n", "I2C transactions", static_cast<unsigned long>(Host::ExternalEEPROM::transactions() - transactions));
+
+    // Sanity check: the flow control must keep the stream without any overrun or underrun.
+    if (   (Shared::rejected != 0)
+        || (Shared::holds != 0)
+        || (Shared::consumed != frames) )
+    {
+        fprintf(stderr, "error: the stream was not played continuously.\n");
+
+        return 1;
+    }
+
+    // Sanity check: streaming must not touch external EEPROM.
+    if (Host::ExternalEEPROM::transactions() != transactions)
+    {
+        fprintf(stderr, "error: external EEPROM was accessed while streaming.\n");
+
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <Arduino.h>
+
+#include "Host.h"
+#include "JointController.h"
+#include "Motion.h"
+#include "MotionController.h"
+#include "Scenario.h"
+
+
+/*!
+    @brief Test of timing of every motion shipped in "motions/" (the ".json" files)
+
+    Each motion file is read, and installed to its slot with its transition time and loop.
+    (Joint angles are given by Scenario::angleOf(), because they don't change the timing.)
+    An infinite loop (loop_count 255) is replaced with a finite one (254 times), so the motion ends.
+    Every motion is played with "$PM", and the benchmark reports for each motion:
+
+    - Ticks of MotionController::updateFrame() taken by the motion.
+    - Ticks expected from the sum of transition time in the file, divided by the exact period of updates.
+    - Error of the ticks, compared with the error of truncating each frame to the update interval.
+
+    The ticks of every motion must be within a tick of the ticks expected.
+
+    Usage: Timing.benchmark [--quick] [motions directory]
+*/
+namespace
+{
+    using namespace PLEN2;
+
+    enum
+    {
+        LOOP_COUNT_DEFAULT = 254, //!< The longest finite loop.
+        LOOP_COUNT_QUICK   = 2,
+        MARGIN_US          = 100000
+    };
+
+    namespace Shared
+    {
+        uint32_t ticks;
+    }
+
+    /*!
+        @brief Get how many times each frame is played
+
+        The frames in the loop are played once, and again loop_count times.
+    */
+    uint32_t playsOf(const Scenario::MotionFile& motion, uint8_t frame_id)
+    {
+        if (   (motion.options.use_loop)
+            && (frame_id >= motion.options.loop_begin)
+            && (frame_id <= motion.options.loop_end) )
+        {
+            return 1 + motion.options.loop_count;
+        }
+
+        return 1;
+    }
+}
+
+
+/*
+    Linker-level probes (see "-Wl,--wrap" in CMakeLists.txt)
+*/
+extern "C"
+{
+    void __real__ZN5PLEN216MotionController11updateFrameEv(MotionController* self);
+
+    void __wrap__ZN5PLEN216MotionController11updateFrameEv(MotionController* self)
+    {
+        Shared::ticks++;
+
+        __real__ZN5PLEN216MotionController11updateFrameEv(self);
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    const bool quick = (argc > 1) && (strcmp(argv[1], "--quick") == 0);
+    const uint8_t loop_count = quick? LOOP_COUNT_QUICK : LOOP_COUNT_DEFAULT;
+    const char* directory = (argc > 1 + quick)? argv[1 + quick] : PLEN2_MOTIONS_DIR;
+
+    std::vector<Scenario::MotionFile> motions;
+
+    if (!Scenario::readMotions(directory, motions))
+    {
+        fprintf(stderr, "error: no motion was read from %s.\n", directory);
+
+        return 1;
+    }
+
+    setup();
+
+    JointController joint_ctrl;
+    const uint32_t period_us   = joint_ctrl.getUpdatePeriod();
+    const uint32_t interval_ms = joint_ctrl.getUpdateInterval();
+
+    for (size_t index = 0; index < motions.size(); index++)
+    {
+        Scenario::MotionFile& motion = motions[index];
+
+        if (motion.options.loop_count == 255)
+        {
+            motion.options.loop_count = loop_count;
+        }
+
+        Scenario::feedMotion(motion.slot, motion.frame_length, motion.options, motion.transition_time_ms);
+        Scenario::runFor(MARGIN_US);
+    }
+
+    printf("%-4s %-20s %6s %10s %10s %14s %12s %18s\n",
+        "slot", "name", "loops", "json ms", "ticks", "expected", "error ticks", "truncated error");
+
+    int32_t error_max = 0;
+
+    for (size_t index = 0; index < motions.size(); index++)
+    {
+        const Scenario::MotionFile& motion = motions[index];
+
+        // [msec] and [ticks]
+        uint32_t time      = 0;
+        uint32_t truncated = 0;
+
+        for (uint8_t frame_id = 0; frame_id < motion.frame_length; frame_id++)
+        {
+            const uint32_t plays       = playsOf(motion, frame_id);
+            const uint32_t frame_ticks = motion.transition_time_ms[frame_id] / interval_ms;
+
+            time      += motion.transition_time_ms[frame_id] * plays;
+            truncated += ((frame_ticks == 0)? 1 : frame_ticks) * plays;
+        }
+
+        // [1/1000 ticks]
+        const uint32_t expected = static_cast<uint64_t>(time) * 1000000 / period_us;
+
+        char command[16] = "$PM";
+
+        Scenario::appendHex(command, motion.slot, 2);
+
+        Shared::ticks = 0;
+
+        Scenario::feedCommand(command);
+        Scenario::runFor(static_cast<uint64_t>(time) * 1000 + period_us + MARGIN_US);
+
+        const int32_t error           = static_cast<int32_t>(Shared::ticks * 1000) - static_cast<int32_t>(expected);
+        const int32_t truncated_error = static_cast<int32_t>(truncated * 1000) - static_cast<int32_t>(expected);
+
+        printf("%02X   %-20s %6u %10lu %10lu %10lu.%03lu %7c%lu.%03lu %13c%lu.%03lu\n",
+            static_cast<unsigned>(motion.slot), motion.name.c_str(),
+            static_cast<unsigned>(motion.options.use_loop? motion.options.loop_count : 0),
+            static_cast<unsigned long>(time),
+            static_cast<unsigned long>(Shared::ticks),
+            static_cast<unsigned long>(expected / 1000), static_cast<unsigned long>(expected % 1000),
+            (error < 0)? '-' : '+', static_cast<unsigned long>(labs(error) / 1000), static_cast<unsigned long>(labs(error) % 1000),
+            (truncated_error < 0)? '-' : '+', static_cast<unsigned long>(labs(truncated_error) / 1000), static_cast<unsigned long>(labs(truncated_error) % 1000)
+        );
+
+        error_max = std::max(error_max, static_cast<int32_t>(labs(error)));
+
+        // Sanity check: cumulative timing of the whole motion must be within a tick of the file.
+        if (labs(error) >= 1000)
+        {
+            fprintf(stderr, "error: timing of slot %02X drifts a tick or more.\n", static_cast<unsigned>(motion.slot));
+
+            return 1;
+        }
+    }
+
+    printf("%-26s %lu.%03lu\n", "max error ticks",
+        static_cast<unsigned long>(error_max / 1000), static_cast<unsigned long>(error_max % 1000));
+
+    return 0;
+}
@@ -0,0 +1,213 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "Host.h"
+#include "ExternalEEPROM.h"
+#include "JointController.h"
+#include "Motion.h"
+
+
+/*!
+    @brief Benchmark of validating the motion bank at boot
+
+    Every slot is installed with a motion (some of them with delta-compressed frames),
+    and then Motion::validate() scans the bank. The benchmark reports on the virtual clock:
+
+    - Time and I2C transactions taken by the scan. (About 0.75[sec] at most, bounded by the count of blocks.)
+    - Time taken by reading every frame, for comparison with a scan that checks the CRC of each frame.
+
+    Then a header is corrupted and a motion is written only partly, and the scan must find both of them.
+    (The scan doesn't read frames, so a frame corrupted is found by its CRC when it is read.)
+
+    Usage: Validate.benchmark [--quick]
+*/
+namespace
+{
+    using namespace PLEN2;
+
+    enum
+    {
+        FRAME_LENGTH_DEFAULT = 20,
+        FRAME_LENGTH_QUICK   = 10,
+        FRAME_LENGTH_DELTA   = 60,
+        DELTA_INTERVAL       = 10,      //!< Every 10th slot uses delta-compressed frames.
+        SLOT_CORRUPTED       = 3,
+        SLOT_FRAME_CORRUPTED = 5,
+        SLOT_PARTIAL         = 7,
+        SCAN_LIMIT_US        = 1000000
+    };
+
+    void flush()
+    {
+        while (!ExternalEEPROM::poll());
+    }
+
+    void makeFrame(uint8_t slot, uint8_t index, Motion::Frame& frame)
+    {
+        memset(&frame, 0, sizeof(Motion::Frame));
+
+        frame.index              = index;
+        frame.transition_time_ms = 100 + index;
+        frame.easing             = Motion::Frame::EASING_LINEAR;
+
+        for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+        {
+            frame.joint_angle[joint_id] = ((joint_id + index) % 4 == 0)? (slot * 10 + index) : 0;
+        }
+    }
+
+    bool install(uint8_t slot, uint8_t frame_length, bool delta, uint8_t frames_written)
+    {
+        Motion::Header header;
+        Motion::Header::init(header);
+
+        header.slot         = slot;
+        header.frame_length = frame_length;
+        header.use_delta    = (delta)? 1 : 0;
+
+        if (!Motion::Header::set(slot, header))
+        {
+            return false;
+        }
+
+        for (uint8_t index = 0; index < frames_written; index++)
+        {
+            Motion::Frame frame;
+            makeFrame(slot, index, frame);
+
+            if (!Motion::Frame::set(slot, index, frame))
+            {
+                return false;
+            }
+        }
+
+        flush();
+
+        return true;
+    }
+
+    inline bool usesDelta(uint8_t slot)
+    {
+        return (slot % DELTA_INTERVAL) == (DELTA_INTERVAL - 1);
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    const bool quick = (argc > 1) && (strcmp(argv[1], "--quick") == 0);
+    const uint8_t frame_length = quick? FRAME_LENGTH_QUICK : FRAME_LENGTH_DEFAULT;
+
+    Host::reset();
+    setup();
+
+    uint32_t frames = 0;
+
+    for (uint8_t slot = Motion::SLOT_BEGIN; slot < Motion::SLOT_END; slot++)
+    {
+        const bool    delta  = usesDelta(slot);
+        const uint8_t length = (delta)? static_cast<uint8_t>(FRAME_LENGTH_DELTA) : frame_length;
+
+        if (!install(slot, length, delta, length))
+        {
+            fprintf(stderr, "error: the motion in slot %u was not installed.\n", static_cast<unsigned>(slot));
+
+            return 1;
+        }
+
+        frames += length;
+    }
+
+    uint64_t begin = Host::now();
+    uint32_t transactions_done = Host::ExternalEEPROM::transactions();
+
+    const uint8_t valid = Motion::validate();
+
+    const uint64_t scan_us           = Host::now() - begin;
+    const uint32_t scan_transactions = Host::ExternalEEPROM::transactions() - transactions_done;
+
+    begin = Host::now();
+
+    for (uint8_t slot = Motion::SLOT_BEGIN; slot < Motion::SLOT_END; slot++)
+    {
+        Motion::Header header;
+        Motion::Header::get(slot, header);
+
+        for (uint8_t index = 0; index < header.frame_length; index++)
+        {
+            Motion::Frame frame;
+            Motion::Frame::get(slot, index, frame);
+        }
+    }
+
+    const uint64_t read_us = Host::now() - begin;
+
+    printf("%-28s %12u\n",  "motions", static_cast<unsigned>(Motion::SLOT_END));
+    printf("%-28s %12lu\n", "frames", static_cast<unsigned long>(frames));
+    printf("%-28s %12u\n",  "valid slots", static_cast<unsigned>(valid));
+    printf("%-28s %12lu\n", "sim ms of scan", static_cast<unsigned long>(scan_us / 1000));
+    printf("%-28s %12lu\n", "I2C transactions of scan", static_cast<unsigned long>(scan_transactions));
+    printf("%-28s %12lu\n", "sim us of scan / motion", static_cast<unsigned long>(scan_us / Motion::SLOT_END));
+    printf("%-28s %12lu\n", "sim ms of reading frames", static_cast<unsigned long>(read_us / 1000));
+
+    // Sanity check: every motion installed completely is valid, and the scan finishes well under a second.
+    if (valid != Motion::SLOT_END)
+    {
+        fprintf(stderr, "error: %u slots are valid, but all slots were installed.\n", static_cast<unsigned>(valid));
+
+        return 1;
+    }
+
+    if (scan_us >= SCAN_LIMIT_US)
+    {
+        fprintf(stderr, "error: the scan takes a second or more.\n");
+
+        return 1;
+    }
+
+    // A byte of a header and a byte of a frame are flipped, and a motion is written only partly.
+    Motion::Extent extent;
+    Motion::getExtent(SLOT_CORRUPTED, extent);
+    Host::ExternalEEPROM::memory()[extent.first * ExternalEEPROM::BLOCK_SIZE + 4] ^= 0x01;
+
+    Motion::getExtent(SLOT_FRAME_CORRUPTED, extent);
+    Host::ExternalEEPROM::memory()[(extent.first + 2) * ExternalEEPROM::BLOCK_SIZE + 4] ^= 0x01;
+
+    if (!install(SLOT_PARTIAL, frame_length, false, frame_length / 2))
+    {
+        fprintf(stderr, "error: the motion in slot %u was not installed.\n", static_cast<unsigned>(SLOT_PARTIAL));
+
+        return 1;
+    }
+
+    const uint8_t partial_valid = Motion::isValid(SLOT_PARTIAL);
+    const uint8_t rescanned     = Motion::validate();
+
+    Motion::Frame frame;
+
+    // Sanity check: the scan finds both motions, and the frame corrupted can't be read.
+    if (   (partial_valid)
+        || (rescanned != Motion::SLOT_END - 2)
+        || (Motion::isValid(SLOT_CORRUPTED))
+        || (Motion::isValid(SLOT_PARTIAL))
+        || (Motion::Frame::get(SLOT_FRAME_CORRUPTED, 1, frame)) )
+    {
+        fprintf(stderr, "error: a corrupted or partial motion was regarded as valid.\n");
+
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,714 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <stdio.h>
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <Wire.h>
+
+#include "Host.h"
+
+
+volatile uint8_t  TCCR1A = 0;
+volatile uint8_t  TCCR1B = 0;
+volatile uint8_t  TIFR1  = 0;
+volatile uint8_t  TIMSK1 = 0;
+volatile uint16_t TCNT1  = 0;
+volatile uint16_t OCR1A  = 0;
+volatile uint16_t OCR1B  = 0;
+volatile uint16_t OCR1C  = 0;
+volatile uint16_t ICR1   = 0;
+volatile uint8_t  TCCR3A = 0;
+volatile uint8_t  TCCR3B = 0;
+HostTCNT3         TCNT3;
+volatile uint8_t  PORTB  = 0;
+volatile uint8_t  PORTC  = 0;
+volatile uint8_t  PORTD  = 0;
+volatile uint8_t  PORTE  = 0;
+volatile uint8_t  PORTF  = 0;
+volatile uint8_t  DDRB   = 0;
+volatile uint8_t  DDRC   = 0;
+volatile uint8_t  DDRD   = 0;
+volatile uint8_t  DDRE   = 0;
+volatile uint8_t  DDRF   = 0;
+volatile uint8_t  SREG   = _BV(SREG_I);
+
+HardwareSerial Serial;
+HardwareSerial Serial1;
+
+
+/*!
+    @brief Default vector for sketches that do not use timer 1
+*/
+extern "C" __attribute__((weak)) void TIMER1_OVF_vect(void)
+{
+    // noop.
+}
+
+
+namespace
+{
+    enum
+    {
+        F_CPU_MHZ = 16
+    };
+
+    namespace Shared
+    {
+        uint64_t now_cycles       = 0;
+        uint64_t next_ovf_cycles  = 0;
+        uint32_t ovf_period       = 0;
+        uint32_t ovf_count        = 0;
+        bool     ovf_pending      = false;
+        bool     in_vector        = false;
+        void     (*timer1_hook)() = NULL;
+
+        uint64_t tcnt3_origin = 0;
+
+        bool     exit_requested = false;
+        int      exit_code      = 0;
+    }
+
+    /*!
+        @brief Port and bit of each digital pin of Arduino Micro (see "variants/leonardo/pins_arduino.h")
+    */
+    const struct
+    {
+        volatile uint8_t* port;
+        volatile uint8_t* ddr;
+        uint8_t           bit;
+    } PIN_MAP[] = {
+        { &PORTD, &DDRD, 2 }, { &PORTD, &DDRD, 3 }, { &PORTD, &DDRD, 1 }, { &PORTD, &DDRD, 0 }, // D0  - D3
+        { &PORTD, &DDRD, 4 }, { &PORTC, &DDRC, 6 }, { &PORTD, &DDRD, 7 }, { &PORTE, &DDRE, 6 }, // D4  - D7
+        { &PORTB, &DDRB, 4 }, { &PORTB, &DDRB, 5 }, { &PORTB, &DDRB, 6 }, { &PORTB, &DDRB, 7 }, // D8  - D11
+        { &PORTD, &DDRD, 6 }, { &PORTC, &DDRC, 7 }, { &PORTB, &DDRB, 3 }, { &PORTB, &DDRB, 1 }, // D12 - D15
+        { &PORTB, &DDRB, 2 }, { &PORTB, &DDRB, 0 }, { &PORTF, &DDRF, 7 }, { &PORTF, &DDRF, 6 }, // D16 - D19
+        { &PORTF, &DDRF, 5 }, { &PORTF, &DDRF, 4 }, { &PORTF, &DDRF, 1 }, { &PORTF, &DDRF, 0 }, // D20 - D23
+        { &PORTD, &DDRD, 4 }, { &PORTD, &DDRD, 7 }, { &PORTB, &DDRB, 4 }, { &PORTB, &DDRB, 5 }, // D24 - D27
+        { &PORTB, &DDRB, 6 }, { &PORTD, &DDRD, 6 }, { &PORTD, &DDRD, 5 }                        // D28 - D30
+    };
+
+    enum { PIN_MAP_LENGTH = sizeof(PIN_MAP) / sizeof(PIN_MAP[0]) };
+
+    uint32_t timer3PrescalerRatio()
+    {
+        switch (TCCR3B & (_BV(CS32) | _BV(CS31) | _BV(CS30)))
+        {
+            case 1:  return 1;
+            case 2:  return 8;
+            case 3:  return 64;
+            case 4:  return 256;
+            case 5:  return 1024;
+            default: return 0;
+        }
+    }
+
+    uint32_t timer1PrescalerRatio()
+    {
+        switch (TCCR1B & (_BV(CS12) | _BV(CS11) | _BV(CS10)))
+        {
+            case 1:  return 1;
+            case 2:  return 8;
+            case 3:  return 64;
+            case 4:  return 256;
+            case 5:  return 1024;
+            default: return 0;
+        }
+    }
+
+    /*!
+        @brief Get count of timer ticks of an overflow period, for each waveform generation mode
+    */
+    uint32_t timer1PeriodTicks()
+    {
+        const uint8_t mode = (TCCR1A & (_BV(WGM11) | _BV(WGM10)))
+                           | ((TCCR1B & (_BV(WGM13) | _BV(WGM12))) >> 1);
+
+        switch (mode)
+        {
+            case 0:  return 0x10000UL;                // Normal.
+            case 1:  return 2UL * 0x00FF;             // Phase correct, 8bit.
+            case 2:  return 2UL * 0x01FF;             // Phase correct, 9bit.
+            case 3:  return 2UL * 0x03FF;             // Phase correct, 10bit.
+            case 4:  return OCR1A + 1UL;              // CTC, TOP = OCR1A.
+            case 5:  return 0x0100UL;                 // Fast PWM, 8bit.
+            case 6:  return 0x0200UL;                 // Fast PWM, 9bit.
+            case 7:  return 0x0400UL;                 // Fast PWM, 10bit.
+            case 8:
+            case 10: return 2UL * ICR1;               // Phase (and frequency) correct, TOP = ICR1.
+            case 9:
+            case 11: return 2UL * OCR1A;              // Phase (and frequency) correct, TOP = OCR1A.
+            case 12: return ICR1 + 1UL;               // CTC, TOP = ICR1.
+            case 14: return ICR1 + 1UL;               // Fast PWM, TOP = ICR1.
+            case 15: return OCR1A + 1UL;              // Fast PWM, TOP = OCR1A.
+            default: return 0;
+        }
+    }
+
+    uint32_t timer1PeriodCycles()
+    {
+        return timer1PeriodTicks() * timer1PrescalerRatio();
+    }
+
+    void invokeTimer1Vector()
+    {
+        Shared::in_vector = true;
+        Shared::ovf_count++;
+
+        TIMER1_OVF_vect();
+
+        if (Shared::timer1_hook != NULL)
+        {
+            Shared::timer1_hook();
+        }
+
+        Shared::in_vector = false;
+    }
+
+    void elapseCycles(uint64_t cycles)
+    {
+        const uint64_t target = Shared::now_cycles + cycles;
+
+        while (true)
+        {
+            const uint32_t period = timer1PeriodCycles();
+
+            if (   (period == 0)
+                || ((TIMSK1 & _BV(TOIE1)) == 0) )
+            {
+                Shared::next_ovf_cycles = 0;
+                Shared::now_cycles      = target;
+
+                break;
+            }
+
+            if (   (Shared::next_ovf_cycles == 0)
+                || (period != Shared::ovf_period) )
+            {
+                Shared::ovf_period      = period;
+                Shared::next_ovf_cycles = Shared::now_cycles + period;
+            }
+
+            if (Shared::next_ovf_cycles > target)
+            {
+                Shared::now_cycles = target;
+
+                break;
+            }
+
+            Shared::now_cycles       = Shared::next_ovf_cycles;
+            Shared::next_ovf_cycles += period;
+
+            if (   (SREG & _BV(SREG_I))
+                && !Shared::in_vector )
+            {
+                invokeTimer1Vector();
+            }
+            else
+            {
+                Shared::ovf_pending = true;
+            }
+        }
+    }
+}
+
+
+/*
+    Timer 3
+*/
+HostTCNT3& HostTCNT3::operator=(uint16_t value)
+{
+    const uint32_t ratio = timer3PrescalerRatio();
+
+    Shared::tcnt3_origin = Shared::now_cycles - (ratio? static_cast<uint64_t>(value) * ratio : value);
+
+    return *this;
+}
+
+HostTCNT3::operator uint16_t() const
+{
+    const uint32_t ratio = timer3PrescalerRatio();
+
+    return ratio? static_cast<uint16_t>((Shared::now_cycles - Shared::tcnt3_origin) / ratio) : 0;
+}
+
+
+/*
+    Host simulator control
+*/
+uint64_t Host::now()
+{
+    return Shared::now_cycles / F_CPU_MHZ;
+}
+
+void Host::elapse(uint32_t usec)
+{
+    elapseCycles(static_cast<uint64_t>(usec) * F_CPU_MHZ);
+}
+
+uint32_t Host::timer1Period()
+{
+    return timer1PeriodCycles() / F_CPU_MHZ;
+}
+
+uint32_t Host::timer1Overflows()
+{
+    return Shared::ovf_count;
+}
+
+void Host::setTimer1Hook(void (*hook)())
+{
+    Shared::timer1_hook = hook;
+}
+
+void Host::exit(int code)
+{
+    Shared::exit_requested = true;
+    Shared::exit_code      = code;
+}
+
+bool Host::exitRequested()
+{
+    return Shared::exit_requested;
+}
+
+int Host::exitCode()
+{
+    return Shared::exit_code;
+}
+
+void Host::reset()
+{
+    Shared::now_cycles      = 0;
+    Shared::next_ovf_cycles = 0;
+    Shared::ovf_period      = 0;
+    Shared::ovf_count       = 0;
+    Shared::ovf_pending     = false;
+
+    TCCR1A = 0;
+    TCCR1B = 0;
+    TIFR1  = 0;
+    TIMSK1 = 0;
+    TCNT1  = 0;
+    OCR1A  = 0;
+    OCR1B  = 0;
+    OCR1C  = 0;
+    ICR1   = 0;
+    TCCR3A = 0;
+    TCCR3B = 0;
+    PORTB  = 0;
+    PORTC  = 0;
+    PORTD  = 0;
+    PORTE  = 0;
+    PORTF  = 0;
+    DDRB   = 0;
+    DDRC   = 0;
+    DDRD   = 0;
+    DDRE   = 0;
+    DDRF   = 0;
+    SREG   = _BV(SREG_I);
+
+    Shared::tcnt3_origin = 0;
+
+    Serial.clear();
+    Serial1.clear();
+
+    InternalEEPROM::reset();
+    ExternalEEPROM::reset();
+}
+
+
+/*
+    Interruption control
+*/
+void cli()
+{
+    SREG &= ~_BV(SREG_I);
+}
+
+void sei()
+{
+    SREG |= _BV(SREG_I);
+
+    if (   Shared::ovf_pending
+        && !Shared::in_vector )
+    {
+        Shared::ovf_pending = false;
+        invokeTimer1Vector();
+    }
+}
+
+
+/*
+    Digital and analog I/O
+*/
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin >= PIN_MAP_LENGTH) return;
+
+    if (mode == OUTPUT)
+    {
+        *PIN_MAP[pin].ddr |= _BV(PIN_MAP[pin].bit);
+    }
+    else
+    {
+        *PIN_MAP[pin].ddr &= ~_BV(PIN_MAP[pin].bit);
+
+        // INPUT_PULLUP sets the output latch, the same as the hardware.
+        (mode == INPUT_PULLUP)?
+            (*PIN_MAP[pin].port |= _BV(PIN_MAP[pin].bit)) : (*PIN_MAP[pin].port &= ~_BV(PIN_MAP[pin].bit));
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    if (pin >= PIN_MAP_LENGTH) return;
+
+    (value != LOW)?
+        (*PIN_MAP[pin].port |= _BV(PIN_MAP[pin].bit)) : (*PIN_MAP[pin].port &= ~_BV(PIN_MAP[pin].bit));
+}
+
+int digitalRead(uint8_t pin)
+{
+    if (pin >= PIN_MAP_LENGTH) return LOW;
+
+    return (*PIN_MAP[pin].port & _BV(PIN_MAP[pin].bit))? HIGH : LOW;
+}
+
+int analogRead(uint8_t pin)
+{
+    return static_cast<int>((Shared::now_cycles + pin) & 0x03FF);
+}
+
+
+/*
+    Time
+*/
+unsigned long millis()
+{
+    return static_cast<uint32_t>(Host::now() / 1000);
+}
+
+unsigned long micros()
+{
+    return static_cast<uint32_t>(Host::now());
+}
+
+void delay(unsigned long ms)
+{
+    elapseCycles(static_cast<uint64_t>(ms) * 1000 * F_CPU_MHZ);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    elapseCycles(static_cast<uint64_t>(us) * F_CPU_MHZ);
+}
+
+
+/*
+    Math
+*/
+void randomSeed(unsigned long seed)
+{
+    if (seed != 0)
+    {
+        srandom(seed);
+    }
+}
+
+long random(long howbig)
+{
+    if (howbig == 0)
+    {
+        return 0;
+    }
+
+    return random() % howbig;
+}
+
+long random(long howsmall, long howbig)
+{
+    if (howsmall >= howbig)
+    {
+        return howsmall;
+    }
+
+    return random(howbig - howsmall) + howsmall;
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max)
+{
+    /*!
+        @note
+        The arithmetic is done in 32bit, the same as "long" of avr-gcc.
+    */
+    const int32_t numerator = static_cast<int32_t>(x - in_min) * static_cast<int32_t>(out_max - out_min);
+
+    return numerator / static_cast<int32_t>(in_max - in_min) + static_cast<int32_t>(out_min);
+}
+
+
+/*
+    Print
+*/
+size_t Print::write(const uint8_t* buffer, size_t size)
+{
+    size_t count = 0;
+
+    while (size--)
+    {
+        count += write(*buffer++);
+    }
+
+    return count;
+}
+
+size_t Print::write(const char* str)
+{
+    return (str == NULL)? 0 : write(reinterpret_cast<const uint8_t*>(str), strlen(str));
+}
+
+size_t Print::m_printNumber(unsigned long n, uint8_t base)
+{
+    char  buffer[8 * sizeof(long) + 1];
+    char* str = &buffer[sizeof(buffer) - 1];
+
+    *str = '\0';
+
+    if (base < 2) base = 10;
+
+    do
+    {
+        char c = n % base;
+        n /= base;
+
+        *--str = (c < 10)? (c + '0') : (c + 'A' - 10);
+    } while (n);
+
+    return write(str);
+}
+
+size_t Print::print(const __FlashStringHelper* fsh)
+{
+    return write(reinterpret_cast<const char*>(fsh));
+}
+
+size_t Print::print(const char str[])
+{
+    return write(str);
+}
+
+size_t Print::print(char value)
+{
+    return write(static_cast<uint8_t>(value));
+}
+
+size_t Print::print(unsigned char value, int base)
+{
+    return print(static_cast<unsigned long>(value), base);
+}
+
+size_t Print::print(int value, int base)
+{
+    return print(static_cast<long>(value), base);
+}
+
+size_t Print::print(unsigned int value, int base)
+{
+    return print(static_cast<unsigned long>(value), base);
+}
+
+size_t Print::print(long value, int base)
+{
+    if (base == 0)
+    {
+        return write(static_cast<uint8_t>(value));
+    }
+
+    if (base == 10)
+    {
+        if (value < 0)
+        {
+            size_t count = print('-');
+
+            return count + m_printNumber(static_cast<unsigned long>(-value), 10);
+        }
+
+        return m_printNumber(value, 10);
+    }
+
+    /*!
+        @note
+        "long" of avr-gcc is 32bit, so a negative value is printed as 32bit two's complement.
+    */
+    return m_printNumber(static_cast<uint32_t>(value), base);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+    if (base == 0)
+    {
+        return write(static_cast<uint8_t>(value));
+    }
+
+    return m_printNumber(value, base);
+}
+
+size_t Print::print(double value, int digits)
+{
+    char buffer[32];
+
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+
+    return write(buffer);
+}
+
+size_t Print::println()
+{
+    return write("\r\n");
+}
+
+size_t Print::println(const __FlashStringHelper* fsh) { size_t n = print(fsh); return n + println(); }
+size_t Print::println(const char str[])               { size_t n = print(str); return n + println(); }
+size_t Print::println(char value)                     { size_t n = print(value); return n + println(); }
+size_t Print::println(unsigned char value, int base)  { size_t n = print(value, base); return n + println(); }
+size_t Print::println(int value, int base)            { size_t n = print(value, base); return n + println(); }
+size_t Print::println(unsigned int value, int base)   { size_t n = print(value, base); return n + println(); }
+size_t Print::println(long value, int base)           { size_t n = print(value, base); return n + println(); }
+size_t Print::println(unsigned long value, int base)  { size_t n = print(value, base); return n + println(); }
+size_t Print::println(double value, int digits)       { size_t n = print(value, digits); return n + println(); }
+
+
+/*
+    Stream
+*/
+size_t Stream::readBytes(char* buffer, size_t length)
+{
+    size_t   count    = 0;
+    uint64_t deadline = Host::now() + static_cast<uint64_t>(m_timeout) * 1000;
+
+    while (count < length)
+    {
+        if (available())
+        {
+            buffer[count++] = read();
+
+            continue;
+        }
+
+        if (Host::now() >= deadline)
+        {
+            break;
+        }
+
+        Host::elapse(100);
+    }
+
+    return count;
+}
+
+
+/*
+    HardwareSerial
+*/
+HardwareSerial::HardwareSerial()
+    : m_baudrate(0)
+    , m_echo(false)
+{
+    // noop.
+}
+
+void HardwareSerial::begin(unsigned long baudrate)
+{
+    m_baudrate = baudrate;
+}
+
+int HardwareSerial::available()
+{
+    int count = 0;
+
+    for (std::deque<Incoming>::const_iterator it = m_input.begin(); it != m_input.end(); ++it)
+    {
+        if (it->arrival > Host::now())
+        {
+            break;
+        }
+
+        count++;
+    }
+
+    return count;
+}
+
+int HardwareSerial::read()
+{
+    if (   m_input.empty()
+        || (m_input.front().arrival > Host::now()) )
+    {
+        return -1;
+    }
+
+    uint8_t value = m_input.front().value;
+    m_input.pop_front();
+
+    return value;
+}
+
+int HardwareSerial::peek()
+{
+    if (   m_input.empty()
+        || (m_input.front().arrival > Host::now()) )
+    {
+        return -1;
+    }
+
+    return m_input.front().value;
+}
+
+size_t HardwareSerial::write(uint8_t value)
+{
+    m_output.push_back(static_cast<char>(value));
+
+    if (m_echo)
+    {
+        putchar(value);
+    }
+
+    return 1;
+}
+
+void HardwareSerial::feed(const char* data, size_t length, uint32_t interval)
+{
+    uint64_t arrival = Host::now();
+
+    if (!m_input.empty() && (m_input.back().arrival > arrival))
+    {
+        arrival = m_input.back().arrival;
+    }
+
+    for (size_t index = 0; index < length; index++)
+    {
+        arrival += interval;
+
+        Incoming incoming = { arrival, static_cast<uint8_t>(data[index]) };
+        m_input.push_back(incoming);
+    }
+}
+
+void HardwareSerial::feed(const char* str, uint32_t interval)
+{
+    feed(str, strlen(str), interval);
+}
+
+void HardwareSerial::clear()
+{
+    m_input.clear();
+    m_output.clear();
+}
@@ -0,0 +1,75 @@
+/*!
+    @file      Arduino.h
+    @brief     Arduino core API for the host simulator.
+    @author    Kazuyuki TAKASE
+    @copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include <avr/pgmspace.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "Host.h"
+#include "HardwareSerial.h"
+
+#define F_CPU 16000000UL //!< Clock of Arduino Micro. (Given by the build on the robot.)
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define lowByte(w)  (static_cast<uint8_t>((w) & 0xff))
+#define highByte(w) (static_cast<uint8_t>((w) >> 8))
+
+#define bitRead(value, bit)            (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit)             ((value) |= (1UL << (bit)))
+#define bitClear(value, bit)           ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) (bitvalue ? bitSet(value, bit) : bitClear(value, bit))
+
+#define interrupts()   sei()
+#define noInterrupts() cli()
+
+typedef bool    boolean;
+typedef uint8_t byte;
+typedef unsigned int word;
+
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int  digitalRead(uint8_t pin);
+int  analogRead(uint8_t pin);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void randomSeed(unsigned long seed);
+long random(long howbig);
+long random(long howsmall, long howbig);
+
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+
+void setup();
+void loop();
+
+#endif // HOST_ARDUINO_H
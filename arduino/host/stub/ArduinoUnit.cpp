@@ -0,0 +1,80 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <string.h>
+
+#include <ArduinoUnit.h>
+
+#include "Host.h"
+
+
+Test* Test::root = NULL;
+
+
+Test::Test(const char* name)
+    : name(name)
+    , state(UNSETUP)
+    , next(NULL)
+{
+    // Insert the test case in dictionary order, the same as ArduinoUnit does.
+    Test** it = &root;
+
+    while ((*it != NULL) && (strcmp((*it)->name, name) < 0))
+    {
+        it = &((*it)->next);
+    }
+
+    next = *it;
+    *it  = this;
+}
+
+
+void Test::run()
+{
+    uint16_t passed  = 0;
+    uint16_t failed  = 0;
+    uint16_t skipped = 0;
+
+    for (Test* it = root; it != NULL; it = it->next)
+    {
+        if (it->state != UNSETUP)
+        {
+            continue;
+        }
+
+        it->once();
+
+        if (it->state == UNSETUP)
+        {
+            it->pass();
+        }
+
+        Serial.print(F("Test "));
+        Serial.print(it->name);
+
+        switch (it->state)
+        {
+            case DONE_PASS: Serial.println(F(" passed."));  passed++;  break;
+            case DONE_FAIL: Serial.println(F(" failed."));  failed++;  break;
+            default:        Serial.println(F(" skipped.")); skipped++; break;
+        }
+    }
+
+    Serial.print(F("Test summary: "));
+    Serial.print(passed);
+    Serial.print(F(" passed, "));
+    Serial.print(failed);
+    Serial.print(F(" failed, and "));
+    Serial.print(skipped);
+    Serial.print(F(" skipped, out of "));
+    Serial.print(passed + failed + skipped);
+    Serial.println(F(" test(s)."));
+
+    Host::exit((failed == 0)? 0 : 1);
+}
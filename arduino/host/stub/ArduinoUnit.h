@@ -0,0 +1,115 @@
+/*!
+    @file      ArduinoUnit.h
+    @brief     Subset of ArduinoUnit v2.1 for the host simulator.
+    @author    Kazuyuki TAKASE
+    @copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef HOST_ARDUINO_UNIT_H
+#define HOST_ARDUINO_UNIT_H
+
+
+#include <Arduino.h>
+
+
+/*!
+    @brief Test case compatible with ArduinoUnit
+
+    The spec sketches under "/arduino/spec/" are built without any changes.
+    Test::run() runs all test cases in dictionary order at once,
+    then outputs the summary and requests termination of the sketch runner.
+*/
+class Test
+{
+public:
+    enum State
+    {
+        UNSETUP,
+        DONE_SKIP,
+        DONE_PASS,
+        DONE_FAIL
+    };
+
+    Test(const char* name);
+    virtual ~Test() {}
+
+    virtual void once() = 0;
+
+    static void run();
+
+    void pass() { state = DONE_PASS; }
+    void fail() { state = DONE_FAIL; }
+    void skip() { state = DONE_SKIP; }
+
+    /*!
+        @brief Report result of an assertion
+
+        @return Result
+    */
+    template<typename L, typename R>
+    bool assertion(
+        const char* file, int line,
+        const char* lhs_expr, const L& lhs, const char* op, const char* rhs_expr, const R& rhs,
+        bool ok
+    )
+    {
+        if (ok)
+        {
+            return true;
+        }
+
+        Serial.print(F("Assertion failed: ("));
+        Serial.print(lhs_expr);
+        Serial.print(F("="));
+        Serial.print(lhs);
+        Serial.print(F(") "));
+        Serial.print(op);
+        Serial.print(F(" ("));
+        Serial.print(rhs_expr);
+        Serial.print(F("="));
+        Serial.print(rhs);
+        Serial.print(F("), file "));
+        Serial.print(file);
+        Serial.print(F(", line "));
+        Serial.print(line);
+        Serial.println(F("."));
+
+        fail();
+
+        return false;
+    }
+
+    const char* name;
+    State       state;
+    Test*       next;
+
+    static Test* root;
+};
+
+
+#define test(name) \
+    struct test_##name : Test \
+    { \
+        test_##name() : Test(#name) {} \
+        void once(); \
+    } test_##name##_instance; \
+    void test_##name::once()
+
+#define assertOp(lhs, op, op_name, rhs) \
+    do \
+    { \
+        if (!assertion(__FILE__, __LINE__, #lhs, (lhs), op_name, #rhs, (rhs), ((lhs) op (rhs)))) return; \
+    } while (false)
+
+#define assertEqual(lhs, rhs)          assertOp(lhs, ==, "==", rhs)
+#define assertNotEqual(lhs, rhs)       assertOp(lhs, !=, "!=", rhs)
+#define assertLess(lhs, rhs)           assertOp(lhs, <,  "<",  rhs)
+#define assertMore(lhs, rhs)           assertOp(lhs, >,  ">",  rhs)
+#define assertLessOrEqual(lhs, rhs)    assertOp(lhs, <=, "<=", rhs)
+#define assertMoreOrEqual(lhs, rhs)    assertOp(lhs, >=, ">=", rhs)
+#define assertTrue(arg)                assertEqual(arg, true)
+#define assertFalse(arg)               assertEqual(arg, false)
+
+#endif // HOST_ARDUINO_UNIT_H
@@ -0,0 +1,124 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <string.h>
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+#include "Host.h"
+
+
+EEPROMClass EEPROM;
+
+
+namespace
+{
+    namespace Shared
+    {
+        uint8_t  memory[Host::InternalEEPROM::SIZE];
+        uint32_t wear_counts[Host::InternalEEPROM::SIZE];
+        uint64_t busy_until = 0;
+
+        /*!
+            @note
+            An erased cell of the EEPROM reads 0xFF.
+        */
+        struct Eraser
+        {
+            Eraser() { memset(memory, 0xFF, sizeof(memory)); }
+        } eraser;
+    }
+
+    uint16_t cellIndex(const void* addr)
+    {
+        return static_cast<uint16_t>(reinterpret_cast<uintptr_t>(addr) & (Host::InternalEEPROM::SIZE - 1));
+    }
+}
+
+
+void eeprom_busy_wait()
+{
+    if (Host::now() < Shared::busy_until)
+    {
+        Host::elapse(static_cast<uint32_t>(Shared::busy_until - Host::now()));
+    }
+}
+
+bool eeprom_is_ready()
+{
+    return Host::now() >= Shared::busy_until;
+}
+
+uint8_t eeprom_read_byte(const uint8_t* addr)
+{
+    eeprom_busy_wait();
+
+    return Shared::memory[cellIndex(addr)];
+}
+
+void eeprom_write_byte(uint8_t* addr, uint8_t value)
+{
+    eeprom_busy_wait();
+
+    const uint16_t index = cellIndex(addr);
+
+    Shared::memory[index] = value;
+    Shared::wear_counts[index]++;
+    Shared::busy_until = Host::now() + Host::InternalEEPROM::WRITE_CYCLE_US;
+}
+
+void eeprom_update_byte(uint8_t* addr, uint8_t value)
+{
+    if (eeprom_read_byte(addr) != value)
+    {
+        eeprom_write_byte(addr, value);
+    }
+}
+
+void eeprom_read_block(void* dst, const void* src, size_t n)
+{
+    uint8_t*       dst_bytes = static_cast<uint8_t*>(dst);
+    const uint8_t* src_bytes = static_cast<const uint8_t*>(src);
+
+    while (n--)
+    {
+        *dst_bytes++ = eeprom_read_byte(src_bytes++);
+    }
+}
+
+void eeprom_update_block(const void* src, void* dst, size_t n)
+{
+    const uint8_t* src_bytes = static_cast<const uint8_t*>(src);
+    uint8_t*       dst_bytes = static_cast<uint8_t*>(dst);
+
+    while (n--)
+    {
+        eeprom_update_byte(dst_bytes++, *src_bytes++);
+    }
+}
+
+
+uint8_t* Host::InternalEEPROM::memory()
+{
+    return Shared::memory;
+}
+
+const uint32_t* Host::InternalEEPROM::wearCounts()
+{
+    return Shared::wear_counts;
+}
+
+void Host::InternalEEPROM::reset()
+{
+    memset(Shared::memory, 0xFF, sizeof(Shared::memory));
+    memset(Shared::wear_counts, 0, sizeof(Shared::wear_counts));
+
+    Shared::busy_until = 0;
+}
@@ -0,0 +1,109 @@
+/*!
+    @file      EEPROM.h
+    @brief     Internal EEPROM library for the host simulator.
+    @author    Kazuyuki TAKASE
+    @copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+
+#include <stdint.h>
+
+#include <avr/eeprom.h>
+
+
+/*!
+    @brief Reference of a cell of the internal EEPROM
+*/
+class EERef
+{
+public:
+    EERef(int index)
+        : index(index)
+    {
+        // noop.
+    }
+
+    uint8_t operator*() const
+    {
+        return eeprom_read_byte(reinterpret_cast<const uint8_t*>(index));
+    }
+
+    operator uint8_t() const { return **this; }
+
+    EERef& operator=(const EERef& ref) { return *this = *ref; }
+
+    EERef& operator=(uint8_t value)
+    {
+        eeprom_write_byte(reinterpret_cast<uint8_t*>(index), value);
+
+        return *this;
+    }
+
+    EERef& update(uint8_t value)
+    {
+        eeprom_update_byte(reinterpret_cast<uint8_t*>(index), value);
+
+        return *this;
+    }
+
+    intptr_t index;
+};
+
+
+/*!
+    @brief Internal EEPROM library compatible with Arduino's EEPROMClass
+*/
+class EEPROMClass
+{
+public:
+    EERef operator[](int index) { return EERef(index); }
+
+    uint8_t read(int index) { return EERef(index); }
+    void write(int index, uint8_t value) { (*this)[index] = value; }
+    void update(int index, uint8_t value) { (*this)[index].update(value); }
+    uint16_t length() { return 1024; }
+};
+
+extern EEPROMClass EEPROM;
+
+
+namespace Host
+{
+    /*!
+        @brief Simulated internal EEPROM of Atmega32u4
+    */
+    namespace InternalEEPROM
+    {
+        enum
+        {
+            SIZE           = 1024, //!< Size of the EEPROM (bytes).
+            WRITE_CYCLE_US = 3400  //!< Erase and write cycle time of a cell.
+        };
+
+        /*!
+            @brief Get raw memory of the EEPROM
+
+            @return Pointer of the memory (SIZE bytes)
+        */
+        uint8_t* memory();
+
+        /*!
+            @brief Count of write cycles done for each cell
+
+            @return Pointer of the counters (SIZE elements)
+        */
+        const uint32_t* wearCounts();
+
+        /*!
+            @brief Erase whole memory to 0xFF and clear all counters
+        */
+        void reset();
+    }
+}
+
+#endif // HOST_EEPROM_H
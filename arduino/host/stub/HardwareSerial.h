@@ -0,0 +1,106 @@
+/*!
+    @file      HardwareSerial.h
+    @brief     Serial ports for the host simulator.
+    @author    Kazuyuki TAKASE
+    @copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef HOST_HARDWARE_SERIAL_H
+#define HOST_HARDWARE_SERIAL_H
+
+
+#include <stdint.h>
+
+#include <deque>
+#include <string>
+
+#include "Stream.h"
+
+
+/*!
+    @brief Serial port backed by host memory
+
+    Incoming bytes are scheduled on the virtual clock by feed(),
+    and become readable only after their arrival time.
+    Outgoing bytes are captured, and echoed to stdout if echo is enabled.
+*/
+class HardwareSerial : public Stream
+{
+private:
+    struct Incoming
+    {
+        uint64_t arrival; //!< Arrival time on the virtual clock [usec].
+        uint8_t  value;   //!< Received byte.
+    };
+
+    std::deque<Incoming> m_input;
+    std::string          m_output;
+    unsigned long        m_baudrate;
+    bool                 m_echo;
+
+public:
+    HardwareSerial();
+
+    void begin(unsigned long baudrate);
+    void end() {}
+
+    virtual int available();
+    virtual int read();
+    virtual int peek();
+    virtual void flush() {}
+
+    using Print::write;
+    virtual size_t write(uint8_t value);
+
+    operator bool() { return true; }
+
+    /*!
+        @brief Schedule incoming bytes
+
+        @param [in] data     Bytes to be received.
+        @param [in] length   Length of the bytes.
+        @param [in] interval Interval between each byte [usec]. (0 means that all bytes arrive at once.)
+    */
+    void feed(const char* data, size_t length, uint32_t interval = 0);
+
+    /*!
+        @brief Schedule an incoming string
+
+        @param [in] str      String to be received.
+        @param [in] interval Interval between each byte [usec].
+    */
+    void feed(const char* str, uint32_t interval = 0);
+
+    /*!
+        @brief Count bytes scheduled but not read yet
+
+        @return Count
+    */
+    size_t pending() const { return m_input.size(); }
+
+    /*!
+        @brief Get outgoing bytes captured
+
+        @return Reference of the captured string
+    */
+    std::string& output() { return m_output; }
+
+    /*!
+        @brief Enable or disable echo to stdout
+
+        @param [in] enabled Echo flag.
+    */
+    void echo(bool enabled) { m_echo = enabled; }
+
+    /*!
+        @brief Discard all scheduled and captured bytes
+    */
+    void clear();
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+#endif // HOST_HARDWARE_SERIAL_H
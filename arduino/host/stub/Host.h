@@ -0,0 +1,102 @@
+/*!
+    @file      Host.h
+    @brief     Control interface of the host simulator.
+    @author    Kazuyuki TAKASE
+    @copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef HOST_HOST_H
+#define HOST_HOST_H
+
+
+#include <stdint.h>
+
+/*!
+    @brief Control interface of the host simulator
+
+    The stub headers (Arduino.h, Wire.h, EEPROM.h and avr/...) are backed by a virtual clock,
+    so the firmware sees the same timing as on the Atmega32u4 as far as possible:
+
+    - delay() and delayMicroseconds() advance the clock instead of sleeping.
+    - Each I2C transaction advances the clock by its transfer time on the bus.
+    - Each internal EEPROM write occupies the EEPROM for its write-cycle time.
+    - Timer 1 overflow vector is invoked whenever the clock crosses its overflow period,
+      which is derived from TCCR1A/TCCR1B/ICR1 the same way the hardware does.
+    - TCNT3 counts the virtual clock prescaled by TCCR3B. (A vector itself takes no time.)
+
+    A test harness advances the clock explicitly by calling elapse() between calls of loop().
+*/
+namespace Host
+{
+    /*!
+        @brief Get current time of the virtual clock
+
+        @return Elapsed time from reset [usec]
+    */
+    uint64_t now();
+
+    /*!
+        @brief Advance the virtual clock
+
+        Interruption vectors which become due are invoked during the method.
+
+        @param [in] usec Elapsed time [usec].
+    */
+    void elapse(uint32_t usec);
+
+    /*!
+        @brief Get the overflow period of timer 1
+
+        @return Period [usec]
+        @retval 0 Timer 1 is stopped.
+    */
+    uint32_t timer1Period();
+
+    /*!
+        @brief Get count of timer 1 overflow vectors that have been invoked
+
+        @return Count
+    */
+    uint32_t timer1Overflows();
+
+    /*!
+        @brief Set a hook invoked just after each timer 1 overflow vector
+
+        A harness can observe state changed by the vector at the exact virtual time.
+
+        @param [in] hook Function to invoke, or NULL to remove it.
+    */
+    void setTimer1Hook(void (*hook)());
+
+    /*!
+        @brief Request termination of the sketch runner
+
+        @param [in] code Exit status of the process.
+    */
+    void exit(int code);
+
+    /*!
+        @brief Decide if termination of the sketch runner was requested
+
+        @return Result
+    */
+    bool exitRequested();
+
+    /*!
+        @brief Get exit status requested
+
+        @return Exit status
+    */
+    int exitCode();
+
+    /*!
+        @brief Reset whole simulated hardware
+
+        Clears the clock, registers, serial buffers, the internal EEPROM and the external EEPROM.
+    */
+    void reset();
+}
+
+#endif // HOST_HOST_H
@@ -0,0 +1,46 @@
+/*!
+    @file      Stream.h
+    @brief     Stream class of Arduino core for the host simulator.
+    @author    Kazuyuki TAKASE
+    @copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef HOST_STREAM_H
+#define HOST_STREAM_H
+
+
+#include "Print.h"
+
+
+/*!
+    @brief Stream class of Arduino core
+*/
+class Stream : public Print
+{
+protected:
+    unsigned long m_timeout;
+
+public:
+    Stream()
+        : m_timeout(1000)
+    {
+        // noop.
+    }
+
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() = 0;
+
+    void setTimeout(unsigned long timeout) { m_timeout = timeout; }
+
+    size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length)
+    {
+        return readBytes(reinterpret_cast<char*>(buffer), length);
+    }
+};
+
+#endif // HOST_STREAM_H
@@ -0,0 +1,463 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <string.h>
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "Host.h"
+
+
+TwoWire Wire;
+
+HostTWCR         TWCR;
+volatile uint8_t TWDR = 0;
+volatile uint8_t TWSR = 0xF8;
+volatile uint8_t TWBR = 0;
+
+
+namespace
+{
+    enum
+    {
+        DEVICE_ADDRESS  = 0x50, //!< Control code of 24FC1025. (Block select bit is 0x04.)
+        BLOCK_SELECT    = 0x04,
+        BLOCK_SIZE      = Host::ExternalEEPROM::SIZE / 2,
+        BITS_PER_BYTE   = 9,    //!< 8 data bits + ACK.
+        BITS_CONDITION  = 2,    //!< START and STOP conditions.
+        F_CPU_HZ        = 16000000UL
+    };
+
+    /*!
+        @brief Status codes of TWSR in master transmitter and receiver mode
+    */
+    enum
+    {
+        TW_START        = 0x08,
+        TW_REP_START    = 0x10,
+        TW_MT_SLA_ACK   = 0x18,
+        TW_MT_SLA_NACK  = 0x20,
+        TW_MT_DATA_ACK  = 0x28,
+        TW_MR_SLA_ACK   = 0x40,
+        TW_MR_SLA_NACK  = 0x48,
+        TW_MR_DATA_ACK  = 0x50,
+        TW_MR_DATA_NACK = 0x58,
+        TW_NO_INFO      = 0xF8
+    };
+
+    enum TWI_PHASE
+    {
+        TWI_IDLE,         //!< STOP condition has been sent.
+        TWI_ADDRESSING,   //!< START condition has been sent, and SLA+W or SLA+R is expected.
+        TWI_TRANSMITTING, //!< The device acknowledged SLA+W.
+        TWI_RECEIVING,    //!< The device acknowledged SLA+R.
+        TWI_IGNORED       //!< Nobody acknowledged the address.
+    };
+
+    namespace Shared
+    {
+        uint8_t  memory[Host::ExternalEEPROM::SIZE];
+        uint32_t pointer       = 0;
+        uint64_t busy_until    = 0;
+        uint32_t page_programs = 0;
+        uint32_t transactions  = 0;
+
+        /*!
+            @note
+            Bytes sent and received through TWI registers directly (e.g. a page write longer than Wire's buffer).
+        */
+        TWI_PHASE twi_phase   = TWI_IDLE;
+        uint8_t   twi_address = 0;
+        uint8_t   twi_buffer[2 + Host::ExternalEEPROM::PAGE_SIZE];
+        uint8_t   twi_length  = 0;
+        uint32_t  twi_debt_ns = 0;
+
+        /*!
+            @note
+            An erased cell of the device reads 0xFF.
+        */
+        struct Eraser
+        {
+            Eraser() { memset(memory, 0xFF, sizeof(memory)); }
+        } eraser;
+    }
+
+    /*!
+        @brief Decide if the device acknowledges the control byte
+    */
+    bool acknowledged(uint8_t address)
+    {
+        if ((address & ~BLOCK_SELECT) != DEVICE_ADDRESS)
+        {
+            return false;
+        }
+
+        return (Host::now() >= Shared::busy_until);
+    }
+
+    void chargeBus(uint32_t clock, uint16_t bytes)
+    {
+        if (clock == 0)
+        {
+            clock = 100000UL;
+        }
+
+        const uint32_t bits = static_cast<uint32_t>(bytes) * BITS_PER_BYTE + BITS_CONDITION;
+
+        Host::elapse((bits * 1000000UL + clock - 1) / clock);
+    }
+
+    /*!
+        @brief Charge bits sent through TWI registers, at the clock derived from TWBR and TWSR
+    */
+    void chargeTWI(uint8_t bits)
+    {
+        static const uint8_t PRESCALER[] = { 1, 4, 16, 64 };
+
+        const uint32_t clock = F_CPU_HZ / (16UL + 2UL * TWBR * PRESCALER[TWSR & 0x03]);
+
+        Shared::twi_debt_ns += static_cast<uint32_t>(bits) * (1000000000UL / clock);
+
+        Host::elapse(Shared::twi_debt_ns / 1000);
+        Shared::twi_debt_ns %= 1000;
+    }
+
+    void setTWIStatus(uint8_t status)
+    {
+        TWSR = (TWSR & 0x03) | status;
+    }
+
+    /*!
+        @brief Latch bytes sent after the control byte of a write command
+
+        @param [in] address Control byte without R/W bit.
+        @param [in] data    Word address (2 bytes) followed by data bytes.
+        @param [in] length  Length of the data including the word address.
+        @param [in] send_stop Whether STOP condition follows, which starts a write cycle.
+    */
+    void program(uint8_t address, const uint8_t data[], uint8_t length, bool send_stop)
+    {
+        if (length < 2)
+        {
+            return;
+        }
+
+        const uint32_t block = (address & BLOCK_SELECT)? BLOCK_SIZE : 0;
+        uint16_t word_address = (static_cast<uint16_t>(data[0]) << 8) | data[1];
+
+        if (length > 2)
+        {
+            /*!
+                @note
+                The device latches data into its page buffer, and the address wraps around inside a page.
+            */
+            const uint16_t page_base = word_address & ~(Host::ExternalEEPROM::PAGE_SIZE - 1);
+
+            for (uint8_t index = 2; index < length; index++)
+            {
+                Shared::memory[block + word_address] = data[index];
+
+                word_address = page_base + ((word_address + 1) & (Host::ExternalEEPROM::PAGE_SIZE - 1));
+            }
+
+            if (send_stop)
+            {
+                Shared::busy_until = Host::now() + Host::ExternalEEPROM::WRITE_CYCLE_US;
+                Shared::page_programs++;
+            }
+        }
+
+        Shared::pointer = block + word_address;
+    }
+}
+
+
+HostTWCR& HostTWCR::operator=(uint8_t value)
+{
+    if (!(value & _BV(TWEN)))
+    {
+        Shared::twi_phase = TWI_IDLE;
+        m_value = value & ~_BV(TWINT);
+
+        return *this;
+    }
+
+    // Writing 0 to TWINT does not clear the flag, and does not start any operation.
+    if (!(value & _BV(TWINT)))
+    {
+        m_value = (value & ~_BV(TWINT)) | (m_value & _BV(TWINT));
+
+        return *this;
+    }
+
+    if (value & _BV(TWSTO))
+    {
+        if (Shared::twi_phase == TWI_TRANSMITTING)
+        {
+            program(Shared::twi_address, Shared::twi_buffer, Shared::twi_length, true);
+        }
+
+        chargeTWI(1);
+        Shared::twi_phase = TWI_IDLE;
+        setTWIStatus(TW_NO_INFO);
+
+        // TWSTO is cleared by the hardware when STOP condition has been sent, and TWINT is not set.
+        m_value = value & ~(_BV(TWSTO) | _BV(TWINT));
+
+        return *this;
+    }
+
+    if (value & _BV(TWSTA))
+    {
+        /*!
+            @note
+            A repeated START aborts the write command in progress, the same as the real chip.
+            (The word address sent alone is kept, and a random read continues from it.)
+        */
+        if (   (Shared::twi_phase == TWI_TRANSMITTING)
+            && (Shared::twi_length == 2) )
+        {
+            program(Shared::twi_address, Shared::twi_buffer, Shared::twi_length, false);
+        }
+
+        setTWIStatus((Shared::twi_phase == TWI_IDLE)? TW_START : TW_REP_START);
+
+        chargeTWI(1);
+        Shared::twi_phase = TWI_ADDRESSING;
+        m_value = value | _BV(TWINT);
+
+        return *this;
+    }
+
+    chargeTWI(BITS_PER_BYTE);
+
+    switch (Shared::twi_phase)
+    {
+        case TWI_ADDRESSING:
+        {
+            const uint8_t address = TWDR >> 1;
+            const bool    reading = (TWDR & 0x01);
+
+            Shared::transactions++;
+
+            if (acknowledged(address))
+            {
+                Shared::twi_phase   = (reading)? TWI_RECEIVING : TWI_TRANSMITTING;
+                Shared::twi_address = address;
+                Shared::twi_length  = 0;
+                setTWIStatus((reading)? TW_MR_SLA_ACK : TW_MT_SLA_ACK);
+            }
+            else
+            {
+                Shared::twi_phase = TWI_IGNORED;
+                setTWIStatus((reading)? TW_MR_SLA_NACK : TW_MT_SLA_NACK);
+            }
+
+            break;
+        }
+
+        case TWI_RECEIVING:
+        {
+            const uint32_t block = (Shared::twi_address & BLOCK_SELECT)? BLOCK_SIZE : 0;
+
+            TWDR = Shared::memory[Shared::pointer];
+
+            // Sequential read wraps around inside a block.
+            Shared::pointer = block + ((Shared::pointer + 1 - block) & (BLOCK_SIZE - 1));
+
+            setTWIStatus((value & _BV(TWEA))? TW_MR_DATA_ACK : TW_MR_DATA_NACK);
+
+            break;
+        }
+
+        case TWI_TRANSMITTING:
+        {
+            // Bytes over the page buffer are not kept. (The firmware never sends them.)
+            if (Shared::twi_length < sizeof(Shared::twi_buffer))
+            {
+                Shared::twi_buffer[Shared::twi_length++] = TWDR;
+            }
+
+            setTWIStatus(TW_MT_DATA_ACK);
+
+            break;
+        }
+
+        default:
+        {
+            setTWIStatus(TW_NO_INFO);
+
+            break;
+        }
+    }
+
+    m_value = value | _BV(TWINT);
+
+    return *this;
+}
+
+
+TwoWire::TwoWire()
+    : m_tx_address(0)
+    , m_tx_length(0)
+    , m_rx_index(0)
+    , m_rx_length(0)
+    , m_clock(100000UL)
+{
+    // noop.
+}
+
+void TwoWire::begin()
+{
+    setClock(100000UL);
+
+    m_tx_length = 0;
+    m_rx_index  = 0;
+    m_rx_length = 0;
+}
+
+void TwoWire::setClock(uint32_t clock)
+{
+    m_clock = clock;
+
+    TWSR &= ~(_BV(TWPS1) | _BV(TWPS0));
+    TWBR  = ((F_CPU_HZ / clock) - 16) / 2;
+}
+
+void TwoWire::beginTransmission(int address)
+{
+    m_tx_address = static_cast<uint8_t>(address);
+    m_tx_length  = 0;
+}
+
+size_t TwoWire::write(uint8_t value)
+{
+    if (m_tx_length >= BUFFER_LENGTH)
+    {
+        return 0;
+    }
+
+    m_tx_buffer[m_tx_length++] = value;
+
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t length)
+{
+    size_t count = 0;
+
+    while (length--)
+    {
+        if (write(*data++) == 0) break;
+
+        count++;
+    }
+
+    return count;
+}
+
+uint8_t TwoWire::endTransmission(bool send_stop)
+{
+    Shared::transactions++;
+
+    if (!acknowledged(m_tx_address))
+    {
+        chargeBus(m_clock, 1);
+        m_tx_length = 0;
+
+        return 2; // Received NACK after sending slave address.
+    }
+
+    chargeBus(m_clock, 1 + m_tx_length);
+
+    program(m_tx_address, m_tx_buffer, m_tx_length, send_stop);
+    m_tx_length = 0;
+
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(int address, int quantity)
+{
+    Shared::transactions++;
+
+    m_rx_index  = 0;
+    m_rx_length = 0;
+
+    if (quantity > BUFFER_LENGTH)
+    {
+        quantity = BUFFER_LENGTH;
+    }
+
+    if (!acknowledged(static_cast<uint8_t>(address)))
+    {
+        chargeBus(m_clock, 1);
+
+        return 0;
+    }
+
+    chargeBus(m_clock, 1 + quantity);
+
+    const uint32_t block = (address & BLOCK_SELECT)? BLOCK_SIZE : 0;
+
+    for (int index = 0; index < quantity; index++)
+    {
+        m_rx_buffer[m_rx_length++] = Shared::memory[Shared::pointer];
+
+        // Sequential read wraps around inside a block.
+        Shared::pointer = block + ((Shared::pointer + 1 - block) & (BLOCK_SIZE - 1));
+    }
+
+    return m_rx_length;
+}
+
+int TwoWire::available()
+{
+    return m_rx_length - m_rx_index;
+}
+
+int TwoWire::read()
+{
+    return (m_rx_index < m_rx_length)? m_rx_buffer[m_rx_index++] : -1;
+}
+
+int TwoWire::peek()
+{
+    return (m_rx_index < m_rx_length)? m_rx_buffer[m_rx_index] : -1;
+}
+
+
+uint8_t* Host::ExternalEEPROM::memory()
+{
+    return Shared::memory;
+}
+
+uint32_t Host::ExternalEEPROM::pagePrograms()
+{
+    return Shared::page_programs;
+}
+
+uint32_t Host::ExternalEEPROM::transactions()
+{
+    return Shared::transactions;
+}
+
+void Host::ExternalEEPROM::reset()
+{
+    memset(Shared::memory, 0xFF, sizeof(Shared::memory));
+
+    Shared::pointer       = 0;
+    Shared::busy_until    = 0;
+    Shared::page_programs = 0;
+    Shared::transactions  = 0;
+
+    Shared::twi_phase   = TWI_IDLE;
+    Shared::twi_length  = 0;
+    Shared::twi_debt_ns = 0;
+}
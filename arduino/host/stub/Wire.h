@@ -0,0 +1,106 @@
+/*!
+    @file      Wire.h
+    @brief     I2C library for the host simulator.
+    @author    Kazuyuki TAKASE
+    @copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Stream.h"
+
+#define BUFFER_LENGTH 32
+
+
+/*!
+    @brief I2C library compatible with Arduino's TwoWire
+
+    The only device on the bus is a 24FC1025 (128KB, two blocks of 64KB) at 0x50 / 0x54.
+    Transfer time is charged to the virtual clock, and the device does not acknowledge
+    its address while an internal write cycle is running, the same as the real chip.
+    Bytes sent and received by driving TWI registers directly (see avr/io.h) reach the same device.
+*/
+class TwoWire : public Stream
+{
+private:
+    uint8_t  m_tx_address;
+    uint8_t  m_tx_buffer[BUFFER_LENGTH];
+    uint8_t  m_tx_length;
+    uint8_t  m_rx_buffer[BUFFER_LENGTH];
+    uint8_t  m_rx_index;
+    uint8_t  m_rx_length;
+    uint32_t m_clock;
+
+public:
+    TwoWire();
+
+    void begin();
+    void setClock(uint32_t clock);
+
+    void    beginTransmission(int address);
+    uint8_t endTransmission(bool send_stop = true);
+    uint8_t requestFrom(int address, int quantity);
+
+    virtual size_t write(uint8_t value);
+    virtual size_t write(const uint8_t* data, size_t length);
+    virtual int available();
+    virtual int read();
+    virtual int peek();
+    virtual void flush() {}
+
+    using Print::write;
+};
+
+extern TwoWire Wire;
+
+
+namespace Host
+{
+    /*!
+        @brief Simulated 24FC1025 connected to the I2C bus
+    */
+    namespace ExternalEEPROM
+    {
+        enum
+        {
+            SIZE            = 0x20000, //!< Size of the device (bytes).
+            PAGE_SIZE       = 128,     //!< Page size of the device (bytes).
+            WRITE_CYCLE_US  = 3000     //!< Typical internal write cycle time.
+        };
+
+        /*!
+            @brief Get raw memory of the device
+
+            @return Pointer of the memory (SIZE bytes)
+        */
+        uint8_t* memory();
+
+        /*!
+            @brief Count of page programs done by the device
+
+            @return Count
+        */
+        uint32_t pagePrograms();
+
+        /*!
+            @brief Count of transactions done on the bus
+
+            @return Count
+        */
+        uint32_t transactions();
+
+        /*!
+            @brief Erase whole memory to 0xFF and clear all counters
+        */
+        void reset();
+    }
+}
+
+#endif // HOST_WIRE_H
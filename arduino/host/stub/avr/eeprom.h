@@ -0,0 +1,33 @@
+/*!
+    @file      eeprom.h
+    @brief     Internal EEPROM access of Atmega32u4 for the host simulator.
+    @author    Kazuyuki TAKASE
+    @copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef HOST_AVR_EEPROM_H
+#define HOST_AVR_EEPROM_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+    @brief Wait until the internal EEPROM finishes the current write cycle
+*/
+void eeprom_busy_wait();
+
+/*!
+    @brief Check whether the internal EEPROM is ready to be written (not in a write cycle)
+*/
+bool eeprom_is_ready();
+
+uint8_t eeprom_read_byte(const uint8_t* addr);
+void    eeprom_write_byte(uint8_t* addr, uint8_t value);
+void    eeprom_update_byte(uint8_t* addr, uint8_t value);
+void    eeprom_read_block(void* dst, const void* src, size_t n);
+void    eeprom_update_block(const void* src, void* dst, size_t n);
+
+#endif // HOST_AVR_EEPROM_H
@@ -0,0 +1,28 @@
+/*!
+    @file      interrupt.h
+    @brief     Interruption vectors of Atmega32u4 for the host simulator.
+    @author    Kazuyuki TAKASE
+    @copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef HOST_AVR_INTERRUPT_H
+#define HOST_AVR_INTERRUPT_H
+
+
+#include "io.h"
+
+/*!
+    @brief Definition of an interruption vector
+
+    The simulator calls the vector as a plain function when the event becomes due.
+*/
+#define ISR(vector, ...) extern "C" void vector(void)
+
+extern "C" void TIMER1_OVF_vect(void);
+
+void cli();
+void sei();
+
+#endif // HOST_AVR_INTERRUPT_H
@@ -0,0 +1,147 @@
+/*!
+    @file      io.h
+    @brief     Register definitions of Atmega32u4 for the host simulator.
+    @author    Kazuyuki TAKASE
+    @copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+
+
+#include <stdint.h>
+
+#define _BV(bit) (1 << (bit))
+
+
+/*
+    Timer 1
+*/
+extern volatile uint8_t  TCCR1A;
+extern volatile uint8_t  TCCR1B;
+extern volatile uint8_t  TIFR1;
+extern volatile uint8_t  TIMSK1;
+extern volatile uint16_t TCNT1;
+extern volatile uint16_t OCR1A;
+extern volatile uint16_t OCR1B;
+extern volatile uint16_t OCR1C;
+extern volatile uint16_t ICR1;
+
+// TCCR1A
+#define WGM10  0
+#define WGM11  1
+#define COM1C0 2
+#define COM1C1 3
+#define COM1B0 4
+#define COM1B1 5
+#define COM1A0 6
+#define COM1A1 7
+
+// TCCR1B
+#define CS10  0
+#define CS11  1
+#define CS12  2
+#define WGM12 3
+#define WGM13 4
+
+// TIFR1
+#define TOV1  0
+#define OCF1A 1
+#define OCF1B 2
+#define OCF1C 3
+
+// TIMSK1
+#define TOIE1 0
+
+
+/*
+    Timer 3
+
+    @note
+    TCNT3 counts with the virtual clock, so it is an object instead of a variable.
+    Only the normal mode is simulated.
+*/
+class HostTCNT3
+{
+public:
+    HostTCNT3& operator=(uint16_t value);
+    operator uint16_t() const;
+};
+
+extern volatile uint8_t TCCR3A;
+extern volatile uint8_t TCCR3B;
+extern HostTCNT3        TCNT3;
+
+// TCCR3B
+#define CS30 0
+#define CS31 1
+#define CS32 2
+
+
+/*
+    I/O ports
+
+    @note
+    digitalWrite(), digitalRead() and pinMode() also work through the registers,
+    with the pin mapping of Arduino Micro.
+*/
+extern volatile uint8_t PORTB;
+extern volatile uint8_t PORTC;
+extern volatile uint8_t PORTD;
+extern volatile uint8_t PORTE;
+extern volatile uint8_t PORTF;
+extern volatile uint8_t DDRB;
+extern volatile uint8_t DDRC;
+extern volatile uint8_t DDRD;
+extern volatile uint8_t DDRE;
+extern volatile uint8_t DDRF;
+
+
+/*
+    Two-wire serial interface
+
+    @note
+    Writing TWCR drives the simulated I2C bus (see Wire.cpp), so it is an object instead of a variable.
+    Only the master transmitter and receiver mode are simulated.
+*/
+class HostTWCR
+{
+private:
+    uint8_t m_value;
+
+public:
+    HostTWCR() : m_value(0) {}
+
+    HostTWCR& operator=(uint8_t value);
+    operator uint8_t() const { return m_value; }
+};
+
+extern HostTWCR         TWCR;
+extern volatile uint8_t TWDR;
+extern volatile uint8_t TWSR;
+extern volatile uint8_t TWBR;
+
+// TWCR
+#define TWIE  0
+#define TWEN  2
+#define TWWC  3
+#define TWSTO 4
+#define TWSTA 5
+#define TWEA  6
+#define TWINT 7
+
+// TWSR
+#define TWPS0 0
+#define TWPS1 1
+
+
+/*
+    Status register
+*/
+extern volatile uint8_t SREG;
+
+#define SREG_I 7
+
+#endif // HOST_AVR_IO_H
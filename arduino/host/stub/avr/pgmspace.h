@@ -0,0 +1,35 @@
+/*!
+    @file      pgmspace.h
+    @brief     Program space utilities for the host simulator.
+    @author    Kazuyuki TAKASE
+    @copyright The MIT License - http://opensource.org/licenses/mit-license.php
+*/
+
+#pragma once
+
+#ifndef HOST_AVR_PGMSPACE_H
+#define HOST_AVR_PGMSPACE_H
+
+
+#include <stdint.h>
+#include <string.h>
+
+/*!
+    @note
+    There is only one address space on the host, so program space is mapped onto ordinary memory.
+*/
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+
+#define pgm_read_byte(addr)  (*reinterpret_cast<const uint8_t*>(addr))
+#define pgm_read_word(addr)  (*reinterpret_cast<const uint16_t*>(addr))
+#define pgm_read_dword(addr) (*reinterpret_cast<const uint32_t*>(addr))
+#define pgm_read_ptr(addr)   (*reinterpret_cast<const void* const*>(addr))
+
+#define memcpy_P      memcpy
+#define strlen_P      strlen
+#define strcasecmp_P  strcasecmp
+#define strncasecmp_P strncasecmp
+
+#endif // HOST_AVR_PGMSPACE_H
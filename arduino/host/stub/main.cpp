@@ -0,0 +1,45 @@
+/*
+    Copyright (c) 2015,
+    - Kazuyuki TAKASE - https://github.com/Guvalif
+    - PLEN Project Company Inc. - https://plen.jp
+
+    This software is released under the MIT License.
+    (See also : http://opensource.org/licenses/mit-license.php)
+*/
+
+#include <Arduino.h>
+
+#include "Host.h"
+
+
+namespace
+{
+    /*!
+        @brief Virtual time consumed by one iteration of loop() [usec]
+    */
+    enum { LOOP_INTERVAL_US = 10 };
+}
+
+
+/*!
+    @brief Sketch runner
+
+    Runs setup() once, then loop() until the sketch requests termination.
+    Output of the serial ports is echoed to stdout.
+*/
+int main()
+{
+    Serial.echo(true);
+    Serial1.echo(true);
+
+    setup();
+
+    while (!Host::exitRequested())
+    {
+        loop();
+
+        Host::elapse(LOOP_INTERVAL_US);
+    }
+
+    return Host::exitCode();
+}
@@ -184,6 +184,150 @@ test(SlotOverflow_Write)
     assertEqual(expected, actual);
 }
 
+/*!
+    @brief キューを経由して読み書きするテスト
+
+    書き込みと読み込みをキューに積んだ後、poll()によってすべて処理されることを検証します。
+*/
+test(RandomSlot_QueuedReadWrite)
+{
+    enum { BUFFER_SIZE = 30 };
+
+    // Setup ===================================================================
+    const uint16_t SLOT = getRandomSlot();
+
+    uint8_t expected[BUFFER_SIZE] = { 0 };
+    uint8_t actual[BUFFER_SIZE]   = { 0 };
+
+    int8_t write_result;
+    int8_t read_result;
+
+    bufferRandomize(expected, BUFFER_SIZE);
+
+    // Run =====================================================================
+    PLEN2::ExternalEEPROM::submitWrite(SLOT, expected, BUFFER_SIZE, &write_result);
+    PLEN2::ExternalEEPROM::submitRead(SLOT, actual, BUFFER_SIZE, &read_result);
+
+    while (!PLEN2::ExternalEEPROM::poll());
+
+    // Assert ==================================================================
+    assertEqual(0, write_result);
+    assertEqual(BUFFER_SIZE, read_result);
+    assertTrue( checkIdentity(expected, actual, BUFFER_SIZE) );
+}
+
+/*!
+    @brief キューの容量を超えて積むテスト
+*/
+test(QueueOverflow)
+{
+    enum { BUFFER_SIZE = 30 };
+
+    // Setup ===================================================================
+    const uint16_t SLOT = getRandomSlot();
+
+    uint8_t data[BUFFER_SIZE] = { 0 };
+
+    for (uint8_t count = 0; count < PLEN2::ExternalEEPROM::QUEUE_LENGTH; count++)
+    {
+        PLEN2::ExternalEEPROM::submitRead(SLOT, data, BUFFER_SIZE);
+    }
+
+    // Run =====================================================================
+    int8_t expected = 1;
+    int8_t actual   = PLEN2::ExternalEEPROM::submitRead(SLOT, data, BUFFER_SIZE);
+
+    while (!PLEN2::ExternalEEPROM::poll());
+
+    // Assert ==================================================================
+    assertEqual(expected, actual);
+}
+
+/*!
+    @brief 書き込みのキューイングのテスト
+
+    書き込みのバッファは共有されるため、書き込みが1つキューにある間は次の書き込みを受け付けないことを検証します。
+*/
+test(WriteQueued)
+{
+    enum { BUFFER_SIZE = 30 };
+
+    // Setup ===================================================================
+    const uint16_t SLOT = getRandomSlot();
+
+    uint8_t data[BUFFER_SIZE] = { 0 };
+
+    PLEN2::ExternalEEPROM::submitWrite(SLOT, data, BUFFER_SIZE);
+
+    // Run =====================================================================
+    int8_t expected = 1;
+    int8_t actual   = PLEN2::ExternalEEPROM::submitWrite(SLOT, data, BUFFER_SIZE);
+
+    while (!PLEN2::ExternalEEPROM::poll());
+
+    int8_t expected_after = 0;
+    int8_t actual_after   = PLEN2::ExternalEEPROM::submitWrite(SLOT, data, BUFFER_SIZE);
+
+    while (!PLEN2::ExternalEEPROM::poll());
+
+    // Assert ==================================================================
+    assertEqual(expected, actual);
+    assertEqual(expected_after, actual_after);
+}
+
+/*!
+    @brief poll()の1回あたりの処理時間のテスト
+
+    poll()が転送の終わりを待たず、1回の呼び出しで高々1バイト分だけバスを進めることを検証します。
+*/
+test(Block_PollStep)
+{
+    enum
+    {
+        BUFFER_SIZE = PLEN2::ExternalEEPROM::BLOCK_SIZE,
+        STEP_MAX_US = 50 //!< 400kHzで1バイト(9ビット)を送る時間に余裕を持たせた値です。
+    };
+
+    // Setup ===================================================================
+    const uint16_t BLOCK = random(PLEN2::ExternalEEPROM::BLOCK_BEGIN, PLEN2::ExternalEEPROM::BLOCK_END);
+
+    uint8_t expected[BUFFER_SIZE] = { 0 };
+    uint8_t actual[BUFFER_SIZE]   = { 0 };
+
+    int8_t write_result;
+
+    bufferRandomize(expected, BUFFER_SIZE);
+
+    while (!PLEN2::ExternalEEPROM::poll());
+
+    // Run =====================================================================
+    PLEN2::ExternalEEPROM::submitWriteBlock(BLOCK, expected, BUFFER_SIZE, 0, &write_result);
+
+    uint16_t calls       = 0;
+    uint32_t step_max_us = 0;
+    bool     finished    = false;
+
+    while (!finished)
+    {
+        const uint32_t begin_us = micros();
+
+        finished = PLEN2::ExternalEEPROM::poll();
+        calls++;
+
+        if ((micros() - begin_us) > step_max_us)
+        {
+            step_max_us = micros() - begin_us;
+        }
+    }
+
+    // Assert ==================================================================
+    assertEqual(0, write_result);
+    assertMore(calls, BUFFER_SIZE);
+    assertLessOrEqual(step_max_us, STEP_MAX_US);
+    assertEqual(BUFFER_SIZE, PLEN2::ExternalEEPROM::readBlock(BLOCK, actual, BUFFER_SIZE));
+    assertTrue( checkIdentity(expected, actual, BUFFER_SIZE) );
+}
+
 
 /*!
     @brief アプリケーション・エントリポイント
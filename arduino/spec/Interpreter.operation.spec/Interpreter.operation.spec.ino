@@ -44,6 +44,12 @@ namespace
         }
 
     public:
+        OperationTest(char buffer[])
+            : PLEN2::Protocol(buffer, SESSION_BUFFER_LENGTH)
+        {
+            // noop.
+        }
+
         virtual void afterHook()
         {
             if (m_state == READY)
@@ -69,7 +75,8 @@ namespace
         }
     };
 
-    OperationTest test_core;
+    char buffer[PLEN2::Protocol::SESSION_BUFFER_LENGTH];
+    OperationTest test_core(buffer);
 }
 
 
@@ -233,6 +233,213 @@ test(AllJoint_SetHomeAngle)
 }
 
 
+/*!
+    @brief ランダムに選択した関節への、角度初期値の繰り返し設定テスト
+
+    ジャーナルの記録数を超えて設定し、コンパクションを経ても最後の値が保持されることを確認します。
+*/
+test(RandomJoint_SetHomeAngleRepeatedly)
+{
+    // Setup ==================================================================
+    uint8_t joint_id = getRandomJoint();
+
+    int16_t expected;
+    int16_t actual;
+
+    // Run ====================================================================
+    for (int count = 0; count < 200; count++)
+    {
+        expected = getRandomAngle_min_max(joint_id);
+        joint_ctrl.setHomeAngle(joint_id, expected);
+
+        // 1回の呼び出しでは、高々1バイトのみが書き込まれます。
+        for (int step = 0; step < 8; step++)
+        {
+            eeprom_busy_wait();
+            joint_ctrl.persistSettings();
+        }
+    }
+
+    joint_ctrl.loadSettings();
+
+    actual = joint_ctrl.getHomeAngle(joint_id);
+
+    // Assert =================================================================
+    assertEqual(expected, actual);
+}
+
+
+/*!
+    @brief ランダムに選択した関節への、関節設定の一括保存テスト
+*/
+test(RandomJoint_CommitSettings)
+{
+    // Setup ==================================================================
+    uint8_t joint_id = getRandomJoint();
+
+    joint_ctrl.setMinAngle(joint_id, JointController::ANGLE_MIN);
+    joint_ctrl.setMaxAngle(joint_id, JointController::ANGLE_MAX);
+
+    int16_t expected_min  = getRandomAngle_MIN_max(joint_id);
+    int16_t expected_max  = random(expected_min + 1, JointController::ANGLE_MAX + 1);
+    int16_t expected_home = random(expected_min, expected_max + 1);
+
+    // Run ====================================================================
+    joint_ctrl.setMinAngle(joint_id, expected_min);
+    joint_ctrl.setMaxAngle(joint_id, expected_max);
+    joint_ctrl.setHomeAngle(joint_id, expected_home);
+
+    joint_ctrl.commitSettings();
+    joint_ctrl.loadSettings();
+
+    // Assert =================================================================
+    assertEqual(expected_min,  joint_ctrl.getMinAngle(joint_id));
+    assertEqual(expected_max,  joint_ctrl.getMaxAngle(joint_id));
+    assertEqual(expected_home, joint_ctrl.getHomeAngle(joint_id));
+
+    joint_ctrl.resetSettings();
+}
+
+
+/*!
+    @brief 全ての関節への、関節設定の一括設定テスト
+*/
+test(AllJoint_SetSettings)
+{
+    // Setup ==================================================================
+    int16_t expected[JointController::SETTINGS_SUM];
+
+    for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+    {
+        expected[joint_id * 3 + 0] = random(JointController::ANGLE_MIN, 0);
+        expected[joint_id * 3 + 1] = random(1, JointController::ANGLE_MAX + 1);
+        expected[joint_id * 3 + 2] = random(expected[joint_id * 3 + 0], expected[joint_id * 3 + 1] + 1);
+    }
+
+    // Run ====================================================================
+    bool result = joint_ctrl.setSettings(expected);
+    joint_ctrl.loadSettings();
+
+    // Assert =================================================================
+    assertTrue(result);
+
+    for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+    {
+        assertEqual(expected[joint_id * 3 + 0], joint_ctrl.getMinAngle(joint_id));
+        assertEqual(expected[joint_id * 3 + 1], joint_ctrl.getMaxAngle(joint_id));
+        assertEqual(expected[joint_id * 3 + 2], joint_ctrl.getHomeAngle(joint_id));
+    }
+
+    joint_ctrl.resetSettings();
+}
+
+
+/*!
+    @brief 異常な関節設定の一括設定時の挙動テスト
+
+    1つの関節でも異常であれば、全ての関節設定が変更されないことを確認します。
+*/
+test(SetSettings_InvalidInputs)
+{
+    // Setup ==================================================================
+    const uint8_t JOINT_ID = getRandomJoint();
+
+    int16_t settings[JointController::SETTINGS_SUM];
+    int16_t expected[JointController::SETTINGS_SUM];
+
+    for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+    {
+        expected[joint_id * 3 + 0] = joint_ctrl.getMinAngle(joint_id);
+        expected[joint_id * 3 + 1] = joint_ctrl.getMaxAngle(joint_id);
+        expected[joint_id * 3 + 2] = joint_ctrl.getHomeAngle(joint_id);
+
+        settings[joint_id * 3 + 0] = JointController::ANGLE_MIN + 1;
+        settings[joint_id * 3 + 1] = JointController::ANGLE_MAX - 1;
+        settings[joint_id * 3 + 2] = JointController::ANGLE_NEUTRAL;
+    }
+
+    // Run ====================================================================
+    bool result[4];
+
+    settings[JOINT_ID * 3 + 0] = JointController::ANGLE_MIN - 1;
+    result[0] = joint_ctrl.setSettings(settings);
+    settings[JOINT_ID * 3 + 0] = JointController::ANGLE_MIN + 1;
+
+    settings[JOINT_ID * 3 + 1] = JointController::ANGLE_MAX + 1;
+    result[1] = joint_ctrl.setSettings(settings);
+    settings[JOINT_ID * 3 + 1] = JointController::ANGLE_MAX - 1;
+
+    settings[JOINT_ID * 3 + 2] = JointController::ANGLE_MAX;
+    result[2] = joint_ctrl.setSettings(settings);
+    settings[JOINT_ID * 3 + 2] = JointController::ANGLE_NEUTRAL;
+
+    settings[JOINT_ID * 3 + 0] = JointController::ANGLE_MAX - 1;
+    result[3] = joint_ctrl.setSettings(settings);
+
+    // Assert =================================================================
+    assertFalse(result[0]);
+    assertFalse(result[1]);
+    assertFalse(result[2]);
+    assertFalse(result[3]);
+
+    for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+    {
+        assertEqual(expected[joint_id * 3 + 0], joint_ctrl.getMinAngle(joint_id));
+        assertEqual(expected[joint_id * 3 + 1], joint_ctrl.getMaxAngle(joint_id));
+        assertEqual(expected[joint_id * 3 + 2], joint_ctrl.getHomeAngle(joint_id));
+    }
+}
+
+
+/*!
+    @brief 書き込み途中で断たれた関節設定の読み込み時の挙動テスト
+
+    整合しない関節設定を持つ関節のみ、初期設定に戻ることを確認します。
+*/
+test(RandomJoint_TornSettings_LoadSettings)
+{
+    // Setup ==================================================================
+    const uint8_t JOINT_ID = getRandomJoint();
+
+    int16_t defaults[JointController::SETTINGS_SUM];
+    int16_t expected[JointController::SETTINGS_SUM];
+
+    joint_ctrl.resetSettings();
+
+    for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+    {
+        defaults[joint_id * 3 + 0] = joint_ctrl.getMinAngle(joint_id);
+        defaults[joint_id * 3 + 1] = joint_ctrl.getMaxAngle(joint_id);
+        defaults[joint_id * 3 + 2] = joint_ctrl.getHomeAngle(joint_id);
+
+        expected[joint_id * 3 + 0] = random(JointController::ANGLE_MIN, 0);
+        expected[joint_id * 3 + 1] = random(1, JointController::ANGLE_MAX + 1);
+        expected[joint_id * 3 + 2] = random(expected[joint_id * 3 + 0], expected[joint_id * 3 + 1] + 1);
+    }
+
+    joint_ctrl.setSettings(expected);
+    joint_ctrl.loadSettings();
+
+    // The upper byte of MIN is torn, so MIN is more than MAX. (The settings are stored from address 1.)
+    EEPROM[1 + JOINT_ID * sizeof(int16_t) * 3 + 1] = 0x7F;
+
+    // Run ====================================================================
+    joint_ctrl.loadSettings();
+
+    // Assert =================================================================
+    for (uint8_t joint_id = 0; joint_id < JointController::JOINTS_SUM; joint_id++)
+    {
+        const int16_t* settings = (joint_id == JOINT_ID)? defaults : expected;
+
+        assertEqual(settings[joint_id * 3 + 0], joint_ctrl.getMinAngle(joint_id));
+        assertEqual(settings[joint_id * 3 + 1], joint_ctrl.getMaxAngle(joint_id));
+        assertEqual(settings[joint_id * 3 + 2], joint_ctrl.getHomeAngle(joint_id));
+    }
+
+    joint_ctrl.resetSettings();
+}
+
+
 /*!
     @brief ランダムに選択した関節への、角度の設定テスト
 */
@@ -335,6 +542,187 @@ test(AllJoint_SetAngleDiff)
 }
 
 
+/*!
+    @brief 全ての関節・全ての角度における、角度設定とmap()のビット一致テスト
+
+    事前計算した変換が、map()と全く同じPWM値を与えることを確認します。
+*/
+test(AllJoint_AllAngle_SetAngle_BitExact)
+{
+    for (uint8_t joint_id = 0;
+                 joint_id < PLEN2::JointController::JOINTS_SUM;
+                 joint_id++
+    )
+    {
+        // Setup ==============================================================
+        joint_ctrl.setMinAngle(joint_id, JointController::ANGLE_MIN);
+        joint_ctrl.setMaxAngle(joint_id, JointController::ANGLE_MAX);
+
+        for (int16_t angle = JointController::ANGLE_MIN;
+                     angle <= JointController::ANGLE_MAX;
+                     angle++
+        )
+        {
+            uint16_t expected = angle2PWM(joint_id, angle);
+            uint16_t actual;
+
+            // Run ============================================================
+            joint_ctrl.setAngle(joint_id, angle);
+
+            actual = PLEN2::JointController::m_pwms[joint_id];
+
+            // Assert =========================================================
+            assertEqual(expected, actual);
+        }
+    }
+
+    joint_ctrl.resetSettings();
+}
+
+
+/*!
+    @brief 全ての関節・全ての角度差分における、角度差分設定とmap()のビット一致テスト
+
+    関節設定の変更後に、変換が再計算されることも確認します。
+*/
+test(AllJoint_AllAngleDiff_SetAngleDiff_BitExact)
+{
+    for (uint8_t joint_id = 0;
+                 joint_id < PLEN2::JointController::JOINTS_SUM;
+                 joint_id++
+    )
+    {
+        // Setup ==============================================================
+        joint_ctrl.setMinAngle(joint_id, JointController::ANGLE_MIN);
+        joint_ctrl.setMaxAngle(joint_id, JointController::ANGLE_MAX);
+        joint_ctrl.setHomeAngle(joint_id, getRandomAngle_min_max(joint_id));
+        joint_ctrl.loadSettings();
+
+        for (int16_t angle_diff = JointController::ANGLE_MIN - joint_ctrl.getHomeAngle(joint_id);
+                     angle_diff <= JointController::ANGLE_MAX - joint_ctrl.getHomeAngle(joint_id);
+                     angle_diff++
+        )
+        {
+            uint16_t expected = angleDiff2PWM(joint_id, angle_diff);
+            uint16_t actual;
+
+            // Run ============================================================
+            joint_ctrl.setAngleDiff(joint_id, angle_diff);
+
+            actual = PLEN2::JointController::m_pwms[joint_id];
+
+            // Assert =========================================================
+            assertEqual(expected, actual);
+        }
+    }
+
+    joint_ctrl.resetSettings();
+}
+
+
+/*!
+    @brief ランダムに選択した関節への、PWM較正の設定テスト
+
+    較正点ではその点のPWM値が厳密に出力され、再読込後も保持されることを確認します。
+*/
+test(RandomJoint_SetCalibration)
+{
+    // Setup ==================================================================
+    uint8_t joint_id = getRandomJoint();
+    uint8_t point    = random(1, JointController::CALIBRATION_POINTS - 1);
+    int16_t angle    = JointController::ANGLE_MIN + point * JointController::CALIBRATION_SPAN;
+
+    joint_ctrl.setMinAngle(joint_id, JointController::ANGLE_MIN);
+    joint_ctrl.setMaxAngle(joint_id, JointController::ANGLE_MAX);
+
+    uint16_t expected = joint_ctrl.getCalibration(joint_id, point) + random(-20, 21);
+    uint16_t actual;
+
+    // Run ====================================================================
+    bool result = joint_ctrl.setCalibration(joint_id, point, expected);
+    joint_ctrl.loadSettings();
+    joint_ctrl.setAngle(joint_id, angle);
+
+    // Assert =================================================================
+    assertTrue(result);
+
+    actual = joint_ctrl.getCalibration(joint_id, point);
+    assertEqual(expected, actual);
+
+    actual = PLEN2::JointController::m_pwms[joint_id];
+    assertEqual(expected, actual);
+
+    joint_ctrl.resetSettings();
+}
+
+
+/*!
+    @brief 較正点の間の角度における、PWM値の単調性テスト
+*/
+test(RandomJoint_CalibrationMonotonic)
+{
+    // Setup ==================================================================
+    uint8_t joint_id = getRandomJoint();
+    uint8_t point    = random(1, JointController::CALIBRATION_POINTS - 1);
+
+    joint_ctrl.setMinAngle(joint_id, JointController::ANGLE_MIN);
+    joint_ctrl.setMaxAngle(joint_id, JointController::ANGLE_MAX);
+    joint_ctrl.setCalibration(joint_id, point, joint_ctrl.getCalibration(joint_id, point) + 30);
+
+    uint16_t before = joint_ctrl.getCalibration(joint_id, 0);
+
+    // Run & Assert ===========================================================
+    for (int16_t angle = JointController::ANGLE_MIN;
+                 angle <= JointController::ANGLE_MAX;
+                 angle++
+    )
+    {
+        joint_ctrl.setAngle(joint_id, angle);
+
+        uint16_t actual = PLEN2::JointController::m_pwms[joint_id];
+
+        assertMoreOrEqual(actual, before);
+
+        before = actual;
+    }
+
+    assertEqual(joint_ctrl.getCalibration(joint_id, JointController::CALIBRATION_POINTS - 1), before);
+
+    joint_ctrl.resetSettings();
+}
+
+
+/*!
+    @brief 不正なPWM較正の設定テスト
+
+    単調でない較正や、未較正への戻しが正しく扱われることを確認します。
+*/
+test(RandomJoint_InvalidCalibration)
+{
+    // Setup ==================================================================
+    uint8_t joint_id = getRandomJoint();
+    uint8_t point    = random(1, JointController::CALIBRATION_POINTS - 1);
+
+    uint16_t expected = joint_ctrl.getCalibration(joint_id, point);
+    uint16_t actual;
+
+    // Run & Assert ===========================================================
+    assertFalse(joint_ctrl.setCalibration(joint_id, point, joint_ctrl.getCalibration(joint_id, 0) - 1));
+    assertFalse(joint_ctrl.setCalibration(joint_id, point, 1024));
+    assertFalse(joint_ctrl.setCalibration(joint_id, JointController::CALIBRATION_POINTS, expected));
+    assertFalse(joint_ctrl.setCalibration(JointController::JOINTS_SUM, point, expected));
+
+    actual = joint_ctrl.getCalibration(joint_id, point);
+    assertEqual(expected, actual);
+
+    assertTrue(joint_ctrl.setCalibration(joint_id, point, expected + 10));
+    assertTrue(joint_ctrl.setCalibration(joint_id, point, JointController::PWM_UNCALIBRATED));
+
+    actual = joint_ctrl.getCalibration(joint_id, point);
+    assertEqual(expected, actual);
+}
+
+
 /*!
     @brief 未定義関節への、各種取得メソッドのテスト
 */
@@ -406,6 +794,77 @@ test(Timer1Attached)
 }
 
 
+/*!
+    @brief タイマ1によるマルチプレクサの出力選択テスト
+
+    1周期の終了直後は、ライン6が選択されていることを確認します。
+    (割り込みベクタは出力ラインを1つ先読みするためです。)
+*/
+test(Timer1SelectsMultiplexer)
+{
+    // Setup ==================================================================
+    joint_ctrl.m_1cycle_finished = false;
+
+    // Run ====================================================================
+    while (!joint_ctrl.m_1cycle_finished)
+    {
+        delayMicroseconds(10);
+    }
+
+    // Assert =================================================================
+    assertEqual(LOW,  digitalRead(PLEN2::Pin::MULTIPLEXER_SELECT0));
+    assertEqual(HIGH, digitalRead(PLEN2::Pin::MULTIPLEXER_SELECT1));
+    assertEqual(HIGH, digitalRead(PLEN2::Pin::MULTIPLEXER_SELECT2));
+}
+
+
+/*!
+    @brief PWMフレームのコミットテスト
+
+    コミットされたフレームは、1周期の終了時にまとめて出力に切り替わることを確認します。
+*/
+test(RandomJoint_CommitFrame)
+{
+    // Setup ==================================================================
+    const int joint_id = random(PLEN2::JointController::JOINTS_SUM);
+    const int angle    = random(
+        joint_ctrl.getMinAngle(joint_id), joint_ctrl.getMaxAngle(joint_id) + 1
+    );
+
+    joint_ctrl.setAngle(joint_id, joint_ctrl.getHomeAngle(joint_id));
+    joint_ctrl.commitFrame();
+    joint_ctrl.m_1cycle_finished = false;
+
+    while (!joint_ctrl.m_1cycle_finished)
+    {
+        delayMicroseconds(10);
+    }
+
+    const uint16_t before = PLEN2::JointController::m_frames[joint_ctrl.m_frame_front][joint_id];
+
+    // Run ====================================================================
+    joint_ctrl.setAngle(joint_id, angle);
+    const uint16_t expected = PLEN2::JointController::m_pwms[joint_id];
+
+    const uint16_t uncommitted = PLEN2::JointController::m_frames[joint_ctrl.m_frame_front][joint_id];
+
+    joint_ctrl.commitFrame();
+    joint_ctrl.m_1cycle_finished = false;
+
+    while (!joint_ctrl.m_1cycle_finished)
+    {
+        delayMicroseconds(10);
+    }
+
+    const uint16_t actual = PLEN2::JointController::m_frames[joint_ctrl.m_frame_front][joint_id];
+
+    // Assert =================================================================
+    assertEqual(before, uncommitted);
+    assertEqual(expected, actual);
+    assertFalse(joint_ctrl.m_frame_committed);
+}
+
+
 /*!
     @brief 関節設定のダンプテスト
 
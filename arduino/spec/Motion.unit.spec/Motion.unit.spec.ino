@@ -18,6 +18,14 @@
 #define TEST_HARD true //!< プロセッサに負荷のかかるテストについても実行します。
 
 
+/*!
+    @brief テストで使用するフレーム数の上限
+
+    全てのスロットにこのフレーム数のモーションを書き込んでも、外部EEPROMに収まる値とします。
+*/
+#define FRAMELENGTH_TEST 20
+
+
 namespace
 {
     const uint8_t getRandomSlot()
@@ -31,14 +39,16 @@ namespace
     {
         using namespace PLEN2::Motion;
 
-        return random(Frame::FRAME_BEGIN, Frame::FRAME_END);
+        return random(Frame::FRAME_BEGIN, FRAMELENGTH_TEST);
     }
 
     void validRandomize(PLEN2::Motion::Header& header)
     {
         using namespace PLEN2::Motion;
 
-        header.frame_length  = random(Header::FRAMELENGTH_MIN, Header::FRAMELENGTH_MAX + 1);
+        header.frame_length  = random(Header::FRAMELENGTH_MIN, FRAMELENGTH_TEST + 1);
+        header.NON_RESERVED  = 0;
+        header.use_delta     = 0;
         header.use_extra     = random();
         header.use_jump      = random();
         header.use_loop      = random();
@@ -55,6 +65,18 @@ namespace
         }
     }
 
+    void validAllocate(uint8_t slot, uint8_t frame_length)
+    {
+        using namespace PLEN2::Motion;
+
+        Header header;
+
+        validRandomize(header);
+        header.frame_length = frame_length;
+
+        Header::set(slot, header);
+    }
+
     void validRandomize(PLEN2::Motion::Frame& frame)
     {
         using namespace PLEN2;
@@ -145,6 +167,7 @@ test(RandomSlotRandomFrame_SetFrame)
 
     Frame expected, actual;
 
+    validAllocate(SLOT, FRAMELENGTH_TEST);
     validRandomize(expected);
 
     // Run ====================================================================
@@ -168,7 +191,9 @@ test(RandomSlotAllFrame_SetFrame)
 
     Frame expected, actual;
 
-    for (uint8_t index = Frame::FRAME_BEGIN; index < Frame::FRAME_END; index++)
+    validAllocate(SLOT, FRAMELENGTH_TEST);
+
+    for (uint8_t index = Frame::FRAME_BEGIN; index < FRAMELENGTH_TEST; index++)
     {
         // Setup ==============================================================
         validRandomize(expected);
@@ -197,7 +222,9 @@ test(AllSlotAllFrame_SetFrame)
 
     for (uint8_t slot = SLOT_BEGIN; slot < SLOT_END; slot++)
     {
-        for (uint8_t index = Frame::FRAME_BEGIN; index < Frame::FRAME_END; index++)
+        validAllocate(slot, FRAMELENGTH_TEST);
+
+        for (uint8_t index = Frame::FRAME_BEGIN; index < FRAMELENGTH_TEST; index++)
         {
             // Setup ==========================================================
             validRandomize(expected);
@@ -250,10 +277,11 @@ test(SetHeader_InvalidInputs)
 
     {
         // Setup ==============================================================
-        header.frame_length = Header::FRAMELENGTH_MAX + 1;
+        header.frame_length = Header::FRAMELENGTH_MAX;
+        header.use_delta    = 0;
 
         // Run ================================================================
-        bool expected = false;
+        bool expected = true;
         bool actual   = Header::set(0, header);
 
         // Assert =============================================================
@@ -310,6 +338,18 @@ test(SetFrame_InvalidInputs)
         // Assert ==============================================================
         assertEqual(expected, actual);
     }
+
+    {
+        // Setup ===============================================================
+        validAllocate(0, FRAMELENGTH_TEST);
+
+        // Run =================================================================
+        bool expected = false;
+        bool actual   = Frame::set(0, FRAMELENGTH_TEST, frame);
+
+        // Assert ==============================================================
+        assertEqual(expected, actual);
+    }
 }
 
 
@@ -343,6 +383,508 @@ test(GetFrame_InvalidInputs)
 }
 
 
+/*!
+    @brief 旧レイアウトで保存されたモーションの移行テスト
+
+    ファームウェア1.4.1以前のレイアウト(ヘッダ1スロット、フレーム2スロット、1モーション41スロット)で
+    スロット0にモーションを書き込み、移行後に読み込めることを検証します。
+*/
+test(Slot0_MigrateLayout)
+{
+    using namespace PLEN2;
+    using namespace PLEN2::Motion;
+
+    enum
+    {
+        LEGACY_SLOT_COUNT_HEADER = 1,
+        LEGACY_SLOT_COUNT_FRAME  = 2,
+        LEGACY_FRAMELENGTH_MAX   = 20,
+        FRAME_LENGTH             = 2
+    };
+
+    // Setup ==================================================================
+    Header expected_header, actual_header;
+    Frame  expected_frames[FRAME_LENGTH], actual_frame;
+
+    validRandomize(expected_header);
+    expected_header.frame_length = FRAME_LENGTH;
+
+    ExternalEEPROM::writeSlot(0, reinterpret_cast<const uint8_t*>(&expected_header), sizeof(Header));
+
+    for (uint8_t index = 0; index < FRAME_LENGTH; index++)
+    {
+        const uint8_t* filler = reinterpret_cast<const uint8_t*>(&expected_frames[index]);
+        const uint16_t slot   = LEGACY_SLOT_COUNT_HEADER + index * LEGACY_SLOT_COUNT_FRAME;
+
+        validRandomize(expected_frames[index]);
+        expected_frames[index].index  = index;
+        expected_frames[index].easing = Frame::EASING_LINEAR; // 旧レイアウトのフレームにはイージングがありません。
+
+        ExternalEEPROM::writeSlot(slot, filler, ExternalEEPROM::SLOT_SIZE);
+        ExternalEEPROM::writeSlot(slot + 1, filler + ExternalEEPROM::SLOT_SIZE, sizeof(Frame) - ExternalEEPROM::SLOT_SIZE);
+    }
+
+    // 他のスロットは空とします。
+    const uint8_t empty_header[sizeof(Header)] = { 0 };
+
+    for (uint16_t slot = 1; slot < SLOT_END; slot++)
+    {
+        ExternalEEPROM::writeBlock(slot * (1 + LEGACY_FRAMELENGTH_MAX), empty_header, sizeof(empty_header));
+    }
+
+    // The layout record (in the last block) tells that motions from slot 1 have been migrated.
+    const uint8_t record[] = { 1, 1 };
+    ExternalEEPROM::writeBlock(ExternalEEPROM::BLOCK_END - 1, record, sizeof(record));
+
+    // Run ====================================================================
+    bool migrated = migrateLayout();
+
+    // Assert =================================================================
+    assertTrue(migrated);
+
+    Header::get(0, actual_header);
+    assertTrue( checkIdentity(expected_header, actual_header, sizeof(Header)) );
+
+    for (uint8_t index = 0; index < FRAME_LENGTH; index++)
+    {
+        Frame::get(0, index, actual_frame);
+        assertTrue( checkIdentity(expected_frames[index], actual_frame, sizeof(Frame)) );
+    }
+}
+
+
+/*!
+    @brief ランダムに選択したスロットの、モーションキャッシュのヒットテスト
+
+    2回目以降の読み込みは外部EEPROMにアクセスせず、キャッシュから同じ値を返すことを検証します。
+*/
+test(RandomSlot_CacheHit)
+{
+    #if MOTION_CACHE_SLOTS > 0
+
+    using namespace PLEN2::Motion;
+
+    // Setup ==================================================================
+    const uint8_t SLOT  = getRandomSlot();
+    const uint8_t INDEX = random(Frame::FRAME_BEGIN, MOTION_CACHE_FRAMES);
+
+    Header expected_header, actual_header;
+    Frame  expected_frame,  actual_frame;
+
+    validRandomize(expected_header);
+    validRandomize(expected_frame);
+    expected_header.frame_length = MOTION_CACHE_FRAMES;
+
+    Header::set(SLOT, expected_header);
+    Frame::set(SLOT, INDEX, expected_frame);
+
+    Header::get(SLOT, actual_header);
+    Frame::get(SLOT, INDEX, actual_frame);
+
+    const uint32_t hits   = getCacheHits();
+    const uint32_t misses = getCacheMisses();
+
+    // Run ====================================================================
+    Header::get(SLOT, actual_header);
+    Frame::get(SLOT, INDEX, actual_frame);
+
+    // Assert =================================================================
+    assertEqual(hits + 2, getCacheHits());
+    assertEqual(misses, getCacheMisses());
+
+    assertTrue( checkIdentity(expected_header, actual_header, sizeof(Header)) );
+    assertTrue( checkIdentity(expected_frame, actual_frame, sizeof(Frame)) );
+
+    #else
+        skip();
+    #endif
+}
+
+
+/*!
+    @brief ランダムに選択したスロットの、書き込みによるモーションキャッシュの無効化テスト
+*/
+test(RandomSlot_CacheInvalidate)
+{
+    using namespace PLEN2::Motion;
+
+    // Setup ==================================================================
+    const uint8_t SLOT  = getRandomSlot();
+    const uint8_t INDEX = getRandomIndex();
+
+    Header expected_header, actual_header;
+    Frame  expected_frame,  actual_frame;
+
+    validRandomize(expected_header);
+    validRandomize(expected_frame);
+    expected_header.frame_length = FRAMELENGTH_TEST;
+
+    Header::set(SLOT, expected_header);
+    Frame::set(SLOT, INDEX, expected_frame);
+
+    Header::get(SLOT, actual_header);
+    Frame::get(SLOT, INDEX, actual_frame);
+
+    validRandomize(expected_header);
+    validRandomize(expected_frame);
+    expected_header.frame_length = FRAMELENGTH_TEST;
+
+    // Run ====================================================================
+    Header::set(SLOT, expected_header);
+    Frame::set(SLOT, INDEX, expected_frame);
+
+    Header::get(SLOT, actual_header);
+    Frame::get(SLOT, INDEX, actual_frame);
+
+    // Assert =================================================================
+    assertTrue( checkIdentity(expected_header, actual_header, sizeof(Header)) );
+    assertTrue( checkIdentity(expected_frame, actual_frame, sizeof(Frame)) );
+}
+
+
+/*!
+    @brief ランダムに選択したスロットへの、差分圧縮されたフレームの設定テスト
+
+    フレーム数の上限を超えるモーションを、順番に書き込んだ後、
+    順番通り・逆順・ループの先頭からの3通りで読み出します。
+*/
+test(RandomSlot_DeltaFrames)
+{
+    using namespace PLEN2;
+    using namespace PLEN2::Motion;
+
+    // Setup ==================================================================
+    const uint8_t SLOT         = getRandomSlot();
+    const uint8_t FRAME_LENGTH = 60;
+    const uint8_t LOOP_BEGIN   = 40;
+
+    Header header;
+
+    validRandomize(header);
+    header.use_delta    = 1;
+    header.use_loop     = 1;
+    header.loop_begin   = LOOP_BEGIN;
+    header.loop_end     = FRAME_LENGTH - 1;
+    header.frame_length = FRAME_LENGTH;
+
+    Header::set(SLOT, header);
+
+    Frame expected, actual, last_frame, loop_frame;
+
+    // 差分圧縮されたフレームはパディングを保存しないため、事前にクリアします。
+    memset(&expected,   0, sizeof(Frame));
+    memset(&actual,     0, sizeof(Frame));
+    memset(&last_frame, 0, sizeof(Frame));
+    memset(&loop_frame, 0, sizeof(Frame));
+
+    validRandomize(expected);
+
+    // 各フレームでは、少数の関節のみを動かします。
+    for (uint8_t index = 0; index < FRAME_LENGTH; index++)
+    {
+        expected.index  = index;
+        expected.easing = index % Frame::EASING_SUM;
+        expected.joint_angle[random(JointController::JOINTS_SUM)] = random(-900, 900);
+        expected.joint_angle[random(JointController::JOINTS_SUM)] = random(-900, 900);
+
+        assertTrue( Frame::set(SLOT, index, expected) );
+    }
+
+    // Run ====================================================================
+    bool in_order = true;
+
+    for (uint8_t index = 0; index < FRAME_LENGTH; index++)
+    {
+        in_order &= Frame::get(SLOT, index, actual);
+    }
+
+    const bool last_read = checkIdentity(expected, actual, sizeof(Frame));
+
+    Frame::get(SLOT, FRAME_LENGTH - 1, last_frame);
+
+    bool reversed = true;
+
+    for (uint8_t index = FRAME_LENGTH; index > 0; index--)
+    {
+        reversed &= Frame::get(SLOT, index - 1, actual);
+    }
+
+    const bool loop_read = Frame::get(SLOT, LOOP_BEGIN, loop_frame);
+
+    // Assert =================================================================
+    assertTrue(in_order);
+    assertTrue(reversed);
+    assertTrue(loop_read);
+    assertTrue(last_read);
+    assertTrue( checkIdentity(expected, last_frame, sizeof(Frame)) );
+    assertEqual(0, actual.index);
+    assertEqual(LOOP_BEGIN, loop_frame.index);
+    assertFalse( Frame::get(SLOT, FRAME_LENGTH, actual) );
+    assertTrue( isValid(SLOT) );
+}
+
+
+/*!
+    @brief 差分圧縮されたフレームの書き込み中に、他のフレームを読み出すテスト
+
+    読み出しと書き込みはカーソルを共有するため、書き込みの途中で他のスロットや同じスロットを読み出しても、
+    書き込みが再開され、シールが正しく計算されることを検証します。
+*/
+test(RandomSlot_DeltaFramesInterleaved)
+{
+    using namespace PLEN2;
+    using namespace PLEN2::Motion;
+
+    // Setup ==================================================================
+    const uint8_t SLOT         = getRandomSlot();
+    const uint8_t OTHER_SLOT   = (SLOT + 1) % SLOT_END;
+    const uint8_t FRAME_LENGTH = 30;
+
+    validAllocate(OTHER_SLOT, 1);
+
+    Header header;
+
+    validRandomize(header);
+    header.use_delta    = 1;
+    header.use_loop     = 0;
+    header.frame_length = FRAME_LENGTH;
+
+    Header::set(SLOT, header);
+
+    Frame expected, actual;
+
+    memset(&expected, 0, sizeof(Frame));
+
+    validRandomize(expected);
+
+    // Run ====================================================================
+    bool written = true;
+
+    for (uint8_t index = 0; index < FRAME_LENGTH; index++)
+    {
+        expected.index  = index;
+        expected.joint_angle[random(JointController::JOINTS_SUM)] = random(-900, 900);
+
+        written &= Frame::set(SLOT, index, expected);
+
+        Frame::get(OTHER_SLOT, 0, actual);
+        Frame::get(SLOT, index / 2, actual);
+    }
+
+    // 差分圧縮されたフレームはパディングを保存しないため、事前にクリアします。
+    memset(&actual, 0, sizeof(Frame));
+
+    const bool last_read = Frame::get(SLOT, FRAME_LENGTH - 1, actual);
+
+    // Assert =================================================================
+    assertTrue(written);
+    assertTrue(last_read);
+    assertTrue( checkIdentity(expected, actual, sizeof(Frame)) );
+    assertTrue( isValid(SLOT) );
+}
+
+
+/*!
+    @brief ランダムに選択したスロットへの、旧レイアウトの上限を超えるモーションの設定テスト
+*/
+test(RandomSlot_LongFrames)
+{
+    using namespace PLEN2::Motion;
+
+    // Setup ==================================================================
+    const uint8_t SLOT         = getRandomSlot();
+    const uint8_t FRAME_LENGTH = 200;
+
+    Frame expected, actual;
+
+    validAllocate(SLOT, FRAME_LENGTH);
+
+    for (uint8_t index = 0; index < FRAME_LENGTH; index++)
+    {
+        validRandomize(expected);
+        expected.transition_time_ms = index;
+
+        Frame::set(SLOT, index, expected);
+    }
+
+    // Run ====================================================================
+    bool read = true, ordered = true;
+
+    for (uint8_t index = 0; index < FRAME_LENGTH; index++)
+    {
+        read    &= Frame::get(SLOT, index, actual);
+        ordered &= (actual.transition_time_ms == index);
+    }
+
+    // Assert =================================================================
+    assertTrue(read);
+    assertTrue(ordered);
+    assertTrue( checkIdentity(expected, actual, sizeof(Frame)) );
+    assertFalse( Frame::get(SLOT, FRAME_LENGTH, actual) );
+}
+
+
+/*!
+    @brief ランダムに選択したスロットを伸ばした後の、デフラグメンテーションのテスト
+
+    伸ばしたモーションは別の領域へ移り、元の領域が空きとなります。
+    デフラグメンテーション後に、全てのモーションが先頭から隙間なく並び、内容が保たれることを検証します。
+*/
+test(RandomSlot_Defragment)
+{
+    using namespace PLEN2::Motion;
+
+    // Setup ==================================================================
+    const uint8_t SLOT         = getRandomSlot();
+    const uint8_t FRAME_LENGTH = 2 * FRAMELENGTH_TEST;
+
+    Header expected_header, actual_header;
+    Frame  expected_frame,  actual_frame;
+
+    validAllocate(SLOT, 1);
+
+    validRandomize(expected_header);
+    validRandomize(expected_frame);
+    expected_header.frame_length = FRAME_LENGTH;
+
+    Header::set(SLOT, expected_header);
+    Frame::set(SLOT, FRAME_LENGTH - 1, expected_frame);
+
+    const uint16_t free_blocks = getFreeBlocks();
+
+    // Run ====================================================================
+    bool packed = defragment();
+
+    // Assert =================================================================
+    assertTrue(packed);
+    assertEqual(free_blocks, getFreeBlocks());
+
+    Header::get(SLOT, actual_header);
+    Frame::get(SLOT, FRAME_LENGTH - 1, actual_frame);
+
+    assertTrue( checkIdentity(expected_header, actual_header, sizeof(Header)) );
+    assertTrue( checkIdentity(expected_frame, actual_frame, sizeof(Frame)) );
+
+    uint16_t used = 0, end = 0;
+
+    for (uint8_t slot = SLOT_BEGIN; slot < SLOT_END; slot++)
+    {
+        Extent extent;
+        getExtent(slot, extent);
+
+        if (extent.first != Extent::FIRST_NONE)
+        {
+            used += extent.blocks;
+
+            if (end < extent.first + extent.blocks)
+            {
+                end = extent.first + extent.blocks;
+            }
+        }
+    }
+
+    assertEqual(used, end);
+}
+
+
+/*!
+    @brief ランダムに選択したスロットへの、書き込み途中のモーションの検証テスト
+
+    ヘッダの設定から最後のフレームの書き込みまでの間、スロットは無効となります。
+*/
+test(RandomSlot_ValidatePartial)
+{
+    using namespace PLEN2::Motion;
+
+    // Setup ==================================================================
+    const uint8_t SLOT = getRandomSlot();
+
+    Frame frame;
+
+    validAllocate(SLOT, FRAMELENGTH_TEST);
+
+    const bool header_valid = isValid(SLOT);
+
+    for (uint8_t index = 0; index < FRAMELENGTH_TEST / 2; index++)
+    {
+        validRandomize(frame);
+        Frame::set(SLOT, index, frame);
+    }
+
+    // Run ====================================================================
+    validate();
+
+    const bool partial_valid = isValid(SLOT);
+
+    for (uint8_t index = FRAMELENGTH_TEST / 2; index < FRAMELENGTH_TEST; index++)
+    {
+        validRandomize(frame);
+        Frame::set(SLOT, index, frame);
+    }
+
+    const bool written_valid = isValid(SLOT);
+
+    validate();
+
+    // Assert =================================================================
+    assertFalse(header_valid);
+    assertFalse(partial_valid);
+    assertTrue(written_valid);
+    assertTrue( isValid(SLOT) );
+}
+
+
+/*!
+    @brief ランダムに選択したスロットへの、破損したモーションの検証テスト
+
+    フレームの破損はCRCにより読み出し時に、ヘッダの破損は起動時の走査により検出されます。
+*/
+test(RandomSlot_ValidateCorrupted)
+{
+    using namespace PLEN2;
+    using namespace PLEN2::Motion;
+
+    // Setup ==================================================================
+    const uint8_t SLOT = getRandomSlot();
+
+    Frame frame;
+
+    validAllocate(SLOT, FRAMELENGTH_TEST);
+
+    for (uint8_t index = 0; index < FRAMELENGTH_TEST; index++)
+    {
+        validRandomize(frame);
+        Frame::set(SLOT, index, frame);
+    }
+
+    Extent extent;
+    getExtent(SLOT, extent);
+
+    // フレーム1の関節角度を、CRCを更新せずに書き換えます。
+    uint8_t data[ExternalEEPROM::BLOCK_SIZE];
+
+    while (!ExternalEEPROM::poll());
+
+    ExternalEEPROM::readBlock(extent.first + 2, data, sizeof(Frame));
+    data[offsetof(Frame, joint_angle)] ^= 0x01;
+    ExternalEEPROM::writeBlock(extent.first + 2, data, sizeof(Frame));
+
+    const bool frame_read = Frame::get(SLOT, 1, frame);
+
+    // ヘッダの名前を、CRCを更新せずに書き換えます。
+    ExternalEEPROM::readBlock(extent.first, data, sizeof(Header));
+    data[offsetof(Header, name)] ^= 0x01;
+    ExternalEEPROM::writeBlock(extent.first, data, sizeof(Header));
+
+    // Run ====================================================================
+    validate();
+
+    // Assert =================================================================
+    assertFalse(frame_read);
+    assertFalse( isValid(SLOT) );
+}
+
+
 /*!
     @brief アプリケーション・エントリポイント
 */
@@ -42,6 +42,12 @@ namespace
         }
 
     public:
+        OperationTest(char buffer[])
+            : PLEN2::Protocol(buffer, SESSION_BUFFER_LENGTH)
+        {
+            // noop.
+        }
+
         virtual void afterHook()
         {
             if (m_state == READY)
@@ -67,7 +73,8 @@ namespace
         }
     };
 
-    OperationTest test_core;
+    char buffer[PLEN2::Protocol::SESSION_BUFFER_LENGTH];
+    OperationTest test_core(buffer);
 }
 
 
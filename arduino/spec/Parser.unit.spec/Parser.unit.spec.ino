@@ -8,7 +8,9 @@
 /*!
     @brief テストケース選択用プリプロセスマクロ
 */
-#define TEST_COMPILE true //!< コンパイルタイムテストについても実行します。
+#ifndef TEST_COMPILE
+    #define TEST_COMPILE true //!< コンパイルタイムテストについても実行します。
+#endif
 
 
 /*!
@@ -149,7 +151,7 @@ test(CharGroupParser_InvalidInputs)
 test(StringGroupParser_ValidInputs)
 {
     // Setup ===================================================================
-    const char* ACCEPT_STRS[] = {
+    static PROGMEM const char ACCEPT_STRS[][3] = {
         "AA",
         "BB"
     };
@@ -199,7 +201,7 @@ test(StringGroupParser_ValidInputs)
 test(StringGroupParser_InvalidInputs)
 {
     // Setup ===================================================================
-    const char* ACCEPT_STRS[] = {
+    static PROGMEM const char ACCEPT_STRS[][3] = {
         "AA",
         "BB"
     };
@@ -331,6 +333,159 @@ test(HexStringParser_InvalidInputs)
 }
 
 
+/*!
+    @brief StringGroupParserの逐次解析に関する動作テスト
+*/
+test(StringGroupParser_ParseByte)
+{
+    // Setup ===================================================================
+    static PROGMEM const char ACCEPT_STRS[][3] = {
+        "AA",
+        "AB",
+        "BB"
+    };
+    enum { ACCEPT_STRS_LENGTH = sizeof(ACCEPT_STRS) / sizeof(ACCEPT_STRS[0]) };
+
+    Utility::StringGroupParser sgp(ACCEPT_STRS, ACCEPT_STRS_LENGTH);
+
+    // Run & Assert ============================================================
+    {
+        bool   expected_result = true;
+        bool   actual_result   = sgp.parseByte("a", 1);
+
+        int8_t expected_index  = -1;
+        int8_t actual_index    = sgp.index();
+
+        assertEqual(expected_result, actual_result);
+        assertEqual(expected_index,  actual_index );
+    }
+
+    {
+        bool   expected_result = true;
+        bool   actual_result   = sgp.parseByte("aB", 2);
+
+        int8_t expected_index  = 1;
+        int8_t actual_index    = sgp.index();
+
+        assertEqual(expected_result, actual_result);
+        assertEqual(expected_index,  actual_index );
+    }
+
+    {
+        bool   expected_result = false;
+        bool   actual_result   = sgp.parseByte("C", 1);
+
+        int8_t expected_index  = -1;
+        int8_t actual_index    = sgp.index();
+
+        assertEqual(expected_result, actual_result);
+        assertEqual(expected_index,  actual_index );
+    }
+
+    {
+        bool   expected_result = false;
+        bool   actual_result   = sgp.parseByte("BA", 2);
+
+        int8_t expected_index  = -1;
+        int8_t actual_index    = sgp.index();
+
+        assertEqual(expected_result, actual_result);
+        assertEqual(expected_index,  actual_index );
+    }
+}
+
+
+/*!
+    @brief HexStringParserの逐次解析に関する動作テスト
+*/
+test(HexStringParser_ParseByte)
+{
+    // Setup ===================================================================
+    Utility::HexStringParser hsp;
+    const char input[] = { '0', 'a', 'F', 'g' }; // NUL終端されていない入力
+
+    // Run & Assert ============================================================
+    {
+        bool expected = true;
+        bool actual   = hsp.parseByte(input, 1) && hsp.parseByte(input, 2) && hsp.parseByte(input, 3);
+
+        assertEqual(expected, actual);
+    }
+
+    {
+        bool   expected_result = false;
+        bool   actual_result   = hsp.parseByte(input, 4);
+
+        int8_t expected_index  = -1;
+        int8_t actual_index    = hsp.index();
+
+        assertEqual(expected_result, actual_result);
+        assertEqual(expected_index,  actual_index );
+    }
+}
+
+
+/*!
+    @brief BinaryParserの逐次解析に関する動作テスト
+*/
+test(BinaryParser_ParseByte)
+{
+    // Setup ===================================================================
+    Utility::BinaryParser bp;
+
+    uint8_t frame[1 + 8 + 2] = { 8 };
+
+    for (uint8_t index = 1; index <= 8; index++)
+    {
+        frame[index] = index * 37;
+    }
+
+    const uint16_t crc = Utility::crc16(frame, 1 + 8);
+
+    frame[1 + 8]     = crc & 0xFF;
+    frame[1 + 8 + 1] = crc >> 8;
+
+    const char* input = reinterpret_cast<const char*>(frame);
+
+    // Run & Assert ============================================================
+    {
+        bool result = true;
+
+        for (uint8_t length = 1; length < sizeof(frame); length++)
+        {
+            result = result && bp.parseByte(input, length) && (bp.index() == -1);
+        }
+
+        bool   expected_result = true;
+        bool   actual_result   = result && bp.parseByte(input, sizeof(frame));
+
+        int8_t expected_index  = 0;
+        int8_t actual_index    = bp.index();
+
+        assertEqual(expected_result, actual_result);
+        assertEqual(expected_index,  actual_index );
+    }
+
+    {
+        frame[5] ^= 0x01;
+
+        for (uint8_t length = 1; length < sizeof(frame); length++)
+        {
+            bp.parseByte(input, length);
+        }
+
+        bool   expected_result = false;
+        bool   actual_result   = bp.parseByte(input, sizeof(frame));
+
+        int8_t expected_index  = -1;
+        int8_t actual_index    = bp.index();
+
+        assertEqual(expected_result, actual_result);
+        assertEqual(expected_index,  actual_index );
+    }
+}
+
+
 /*!
     @brief hexbytes2uint16の動作テスト
 */
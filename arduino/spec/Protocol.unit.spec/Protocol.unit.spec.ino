@@ -4,8 +4,10 @@
 #include <Arduino.h>
 #include <ArduinoUnit.h>
 
+#include "BuildConfig.h"
 #include "System.h"
 #include "Protocol.h"
+#include "Parser.h"
 
 
 namespace
@@ -13,11 +15,22 @@ namespace
     class TestProtocol: public PLEN2::Protocol
     {
     public:
+        TestProtocol(char buffer[], uint8_t length = SESSION_BUFFER_LENGTH)
+            : PLEN2::Protocol(buffer, length)
+        {
+            // noop.
+        }
+
         void abort()
         {
             m_abort();
         }
 
+        bool binaryIncoming()
+        {
+            return (m_state == BINARY_INCOMING);
+        }
+
         void readString(const char* str)
         {
             while (*str != '\0')
@@ -25,9 +38,25 @@ namespace
                 readByte(*str++);
             }
         }
+
+        int8_t headerId()
+        {
+            return m_header_id;
+        }
+
+        int8_t commandId()
+        {
+            return m_command_id;
+        }
+
+        const char* arguments()
+        {
+            return m_buffer.data;
+        }
     };
 
-    TestProtocol protocol;
+    char buffer[PLEN2::Protocol::SESSION_BUFFER_LENGTH];
+    TestProtocol protocol(buffer);
 }
 
 
@@ -162,6 +191,28 @@ test(Controller_ValidInputs)
         assertEqual(expected, actual);
     }
 
+    {
+        setup();
+
+        protocol.readString("BD");
+
+        bool expected = true;
+        bool actual   = protocol.accept();
+
+        assertEqual(expected, actual);
+    }
+
+    {
+        setup();
+
+        protocol.readString("BN");
+
+        bool expected = true;
+        bool actual   = protocol.accept();
+
+        assertEqual(expected, actual);
+    }
+
     {
         setup();
 
@@ -206,6 +257,17 @@ test(Controller_ValidInputs)
         assertEqual(expected, actual);
     }
 
+    {
+        setup();
+
+        protocol.readString("SF");
+
+        bool expected = true;
+        bool actual   = protocol.accept();
+
+        assertEqual(expected, actual);
+    }
+
     {
         setup();
 
@@ -216,6 +278,17 @@ test(Controller_ValidInputs)
 
         assertEqual(expected, actual);
     }
+
+    {
+        setup();
+
+        protocol.readString("SP");
+
+        bool expected = true;
+        bool actual   = protocol.accept();
+
+        assertEqual(expected, actual);
+    }
 }
 
 
@@ -441,6 +514,28 @@ test(Setter_ValidInputs)
         assertEqual(expected, actual);
     }
 
+    {
+        setup();
+
+        protocol.readString("MB");
+
+        bool expected = true;
+        bool actual   = protocol.accept();
+
+        assertEqual(expected, actual);
+    }
+
+    {
+        setup();
+
+        protocol.readString("MD");
+
+        bool expected = true;
+        bool actual   = protocol.accept();
+
+        assertEqual(expected, actual);
+    }
+
     {
         setup();
 
@@ -473,6 +568,61 @@ test(Setter_ValidInputs)
 
         assertEqual(expected, actual);
     }
+
+    {
+        setup();
+
+        protocol.readString("PC");
+
+        bool expected = true;
+        bool actual   = protocol.accept();
+
+        assertEqual(expected, actual);
+    }
+
+    {
+        setup();
+
+        protocol.readString("RM");
+
+        bool expected = true;
+        bool actual   = protocol.accept();
+
+        assertEqual(expected, actual);
+    }
+
+    {
+        setup();
+
+        protocol.readString("SA");
+
+        bool expected = true;
+        bool actual   = protocol.accept();
+
+        assertEqual(expected, actual);
+    }
+
+    {
+        setup();
+
+        protocol.readString("SS");
+
+        bool expected = true;
+        bool actual   = protocol.accept();
+
+        assertEqual(expected, actual);
+    }
+
+    {
+        setup();
+
+        protocol.readString("TB");
+
+        bool expected = true;
+        bool actual   = protocol.accept();
+
+        assertEqual(expected, actual);
+    }
 }
 
 
@@ -553,6 +703,17 @@ test(Getter_ValidInputs)
     Setup setup;
 
     // Run & Assert ============================================================
+    {
+        setup();
+
+        protocol.readString("DI");
+
+        bool expected = true;
+        bool actual   = protocol.accept();
+
+        assertEqual(expected, actual);
+    }
+
     {
         setup();
 
@@ -564,6 +725,17 @@ test(Getter_ValidInputs)
         assertEqual(expected, actual);
     }
 
+    {
+        setup();
+
+        protocol.readString("MC");
+
+        bool expected = true;
+        bool actual   = protocol.accept();
+
+        assertEqual(expected, actual);
+    }
+
     {
         setup();
 
@@ -575,6 +747,28 @@ test(Getter_ValidInputs)
         assertEqual(expected, actual);
     }
 
+    {
+        setup();
+
+        protocol.readString("MT");
+
+        bool expected = true;
+        bool actual   = protocol.accept();
+
+        assertEqual(expected, actual);
+    }
+
+    {
+        setup();
+
+        protocol.readString("MV");
+
+        bool expected = true;
+        bool actual   = protocol.accept();
+
+        assertEqual(expected, actual);
+    }
+
     {
         setup();
 
@@ -725,6 +919,17 @@ test(Args_ValidInputs)
         assertEqual(expected, actual);
     }
 
+    {
+        setup("$SP");
+
+        n_input('E', 4);
+
+        bool expected = true;
+        bool actual   = protocol.accept();
+
+        assertEqual(expected, actual);
+    }
+
     {
         setup("#PU");
 
@@ -791,6 +996,39 @@ test(Args_ValidInputs)
         assertEqual(expected, actual);
     }
 
+    {
+        setup(">PC");
+
+        n_input('B', 7);
+
+        bool expected = true;
+        bool actual   = protocol.accept();
+
+        assertEqual(expected, actual);
+    }
+
+    {
+        setup(">RM");
+
+        n_input('C', 2);
+
+        bool expected = true;
+        bool actual   = protocol.accept();
+
+        assertEqual(expected, actual);
+    }
+
+    {
+        setup(">TB");
+
+        n_input('D', 4);
+
+        bool expected = true;
+        bool actual   = protocol.accept();
+
+        assertEqual(expected, actual);
+    }
+
     {
         setup("<MO");
 
@@ -804,6 +1042,389 @@ test(Args_ValidInputs)
 }
 
 
+/*!
+    @brief バイナリフレーム入力時の挙動テスト
+*/
+test(Binary_Inputs)
+{
+    // Setup ===================================================================
+    struct Setup
+    {
+        void operator()(const char* command, uint8_t* frame, uint8_t length)
+        {
+            protocol.abort();
+
+            protocol.readByte(command[0]);
+            protocol.accept();
+            protocol.transitState();
+
+            protocol.readString(command + 1);
+            protocol.accept();
+            protocol.transitState();
+
+            frame[0] = length;
+
+            for (uint8_t index = 1; index <= length; index++)
+            {
+                frame[index] = index * 37;
+            }
+
+            const uint16_t crc = Utility::crc16(frame, 1 + length);
+
+            frame[1 + length]     = crc & 0xFF;
+            frame[1 + length + 1] = crc >> 8;
+        }
+    };
+
+    struct Feed
+    {
+        bool operator()(const uint8_t* frame, uint8_t size)
+        {
+            for (uint8_t index = 0; index < size; index++)
+            {
+                protocol.readByte(static_cast<char>(frame[index]));
+
+                if (protocol.accept())
+                {
+                    return (index == size - 1);
+                }
+            }
+
+            return false;
+        }
+    };
+
+    Setup   setup;
+    Feed    feed;
+    uint8_t frame[128];
+
+    // Run & Assert ============================================================
+    {
+        setup(">MB", frame, 52);
+
+        bool expected = true;
+        bool actual   = feed(frame, 1 + 52 + 2);
+
+        assertEqual(expected, actual);
+    }
+
+    {
+        setup("$SF", frame, 50);
+
+        bool expected = true;
+        bool actual   = feed(frame, 1 + 50 + 2);
+
+        assertEqual(expected, actual);
+    }
+
+    {
+        setup("$BN", frame, 30);
+
+        bool expected = true;
+        bool actual   = feed(frame, 1 + 30 + 2);
+
+        assertEqual(expected, actual);
+    }
+
+    {
+        setup(">MB", frame, 52);
+        frame[10] ^= 0x01;
+
+        bool expected = false;
+        bool actual   = feed(frame, 1 + 52 + 2);
+
+        assertEqual(expected, actual);
+    }
+
+    {
+        setup(">MB", frame, 52);
+        frame[1 + 52] ^= 0x80;
+
+        bool expected = false;
+        bool actual   = feed(frame, 1 + 52 + 2);
+
+        assertEqual(expected, actual);
+    }
+
+    {
+        setup(">MB", frame, 125);
+
+        bool expected = false;
+        bool actual   = feed(frame, 1 + 125 + 2);
+
+        assertEqual(expected, actual);
+    }
+
+    {
+        setup(">MB", frame, 125);
+        feed(frame, 1 + 125 + 1);
+
+        bool expected = true;
+        bool actual   = protocol.binaryIncoming();
+
+        assertEqual(expected, actual);
+
+        feed(frame + 1 + 125 + 1, 1);
+
+        expected = false;
+        actual   = protocol.binaryIncoming();
+
+        assertEqual(expected, actual);
+    }
+}
+
+
+/*!
+    @brief 破損したバイナリフレームの後に、正常なコマンドを入力した時の挙動テスト
+
+    ペイロードにコマンドとして解釈できるバイト列を含むバルクフレームを、
+    CRCを破損させた場合と長さを破損させた場合のそれぞれで入力し、
+    ペイロードが新たなコマンドとして解析されず、後続のコマンドだけが受理されることを確認します。
+*/
+test(Binary_Resync)
+{
+    // Setup ===================================================================
+    struct Setup
+    {
+        uint8_t operator()(uint8_t* stream, uint8_t length)
+        {
+            protocol.abort();
+
+            const char PAYLOAD[] = "$AN00100>HO00100<JS#PO";
+            const char COMMAND[] = "$AN01100";
+
+            memcpy(stream, "$BN", 3);
+            stream[3] = length;
+
+            for (uint8_t index = 1; index <= length; index++)
+            {
+                stream[3 + index] = PAYLOAD[(index - 1) % (sizeof(PAYLOAD) - 1)];
+            }
+
+            const uint16_t crc = Utility::crc16(stream + 3, 1 + length);
+
+            stream[3 + 1 + length]     = crc & 0xFF;
+            stream[3 + 1 + length + 1] = crc >> 8;
+
+            memcpy(stream + 3 + 1 + length + 2, COMMAND, sizeof(COMMAND) - 1);
+
+            return 3 + 1 + length + 2 + sizeof(COMMAND) - 1;
+        }
+    };
+
+    struct Feed
+    {
+        uint8_t accepted;
+
+        void operator()(const uint8_t* stream, uint8_t size)
+        {
+            accepted = 0;
+
+            for (uint8_t index = 0; index < size; index++)
+            {
+                protocol.readByte(static_cast<char>(stream[index]));
+
+                if (protocol.accept())
+                {
+                    accepted++;
+                    protocol.transitState();
+                }
+            }
+        }
+    };
+
+    Setup   setup;
+    Feed    feed;
+    uint8_t stream[3 + 1 + 150 + 2 + 8];
+
+    // Run & Assert ============================================================
+    {
+        const uint8_t size = setup(stream, 30);
+        stream[3 + 1 + 30] ^= 0x01;
+
+        feed(stream, size);
+
+        assertEqual(2 + 3, feed.accepted); // HEADER and COMMAND of "$BN", and "$AN01100"
+        assertEqual(0, protocol.headerId());
+        assertEqual(1, protocol.commandId());
+        assertEqual(0, memcmp(protocol.arguments(), "01100", 5));
+    }
+
+    {
+        const uint8_t size = setup(stream, 150);
+
+        feed(stream, size);
+
+        assertEqual(2 + 3, feed.accepted);
+        assertEqual(0, protocol.headerId());
+        assertEqual(1, protocol.commandId());
+        assertEqual(0, memcmp(protocol.arguments(), "01100", 5));
+    }
+}
+
+
+/*!
+    @brief 2つのセッションへ1バイトずつ交互に入力した時の挙動テスト
+
+    USBシリアルとBLEシリアルからの入力が、互いに干渉しないことを確認します。
+*/
+test(Sessions_Interleaved)
+{
+    // Setup ===================================================================
+    struct Session
+    {
+        TestProtocol* protocol;
+        const char*   input;
+        uint8_t       length;
+        uint8_t       position;
+        uint8_t       accepted;
+        int8_t        header_id;
+        int8_t        command_id;
+
+        void operator()()
+        {
+            if (position == length)
+            {
+                return;
+            }
+
+            protocol->readByte(input[position++]);
+
+            if (protocol->accept())
+            {
+                accepted++;
+                protocol->transitState();
+
+                header_id  = protocol->headerId();
+                command_id = protocol->commandId();
+            }
+        }
+    };
+
+    char usb_buffer[PLEN2::Protocol::SESSION_BUFFER_LENGTH];
+    char ble_buffer[BLE_BUFFER_LENGTH];
+
+    TestProtocol usb(usb_buffer);
+    TestProtocol ble(ble_buffer, sizeof(ble_buffer));
+
+    struct MakeFrame
+    {
+        void operator()(uint8_t* frame, const char* command, uint8_t length)
+        {
+            memcpy(frame, command, 3);
+            frame[3] = length;
+
+            for (uint8_t index = 1; index <= length; index++)
+            {
+                frame[3 + index] = index * 37 + length;
+            }
+
+            const uint16_t crc = Utility::crc16(frame + 3, 1 + length);
+
+            frame[3 + 1 + length]     = crc & 0xFF;
+            frame[3 + 1 + length + 1] = crc >> 8;
+        }
+    };
+
+    MakeFrame make_frame;
+
+    uint8_t usb_frame[3 + 1 + 52 + 2];
+    uint8_t ble_frame[3 + 1 + 30 + 2];
+
+    make_frame(usb_frame, ">MB", 52);
+    make_frame(ble_frame, "$BN", 30);
+
+    Session usb_session = { &usb, reinterpret_cast<const char*>(usb_frame), sizeof(usb_frame), 0, 0, -1, -1 };
+    Session ble_session = { &ble, reinterpret_cast<const char*>(ble_frame), sizeof(ble_frame), 0, 0, -1, -1 };
+
+    // Run =====================================================================
+    while (   (usb_session.position < usb_session.length)
+           || (ble_session.position < ble_session.length) )
+    {
+        usb_session();
+        ble_session();
+    }
+
+    // Assert ==================================================================
+    assertEqual(3, usb_session.accepted); // HEADER, COMMAND and ARGUMENTS
+    assertEqual(2, usb_session.header_id);
+    assertEqual(3, usb_session.command_id);
+    assertEqual(0, memcmp(usb.arguments(), usb_frame + 3, 1 + 52 + 2));
+
+    assertEqual(3, ble_session.accepted);
+    assertEqual(0, ble_session.header_id);
+    assertEqual(3, ble_session.command_id);
+    assertEqual(0, memcmp(ble.arguments(), ble_frame + 3, 1 + 30 + 2));
+}
+
+
+/*!
+    @brief バッファの短いセッションへ長いコマンドを入力した時の挙動テスト
+
+    バッファに収まらない引数は拒否され、続くコマンドは受理されることを確認します。
+*/
+test(Sessions_ShortBuffer)
+{
+    // Setup ===================================================================
+    char ble_buffer[BLE_BUFFER_LENGTH];
+
+    TestProtocol ble(ble_buffer, sizeof(ble_buffer));
+
+    struct Feed
+    {
+        uint8_t accepted;
+
+        void operator()(TestProtocol& session, const char* str)
+        {
+            accepted = 0;
+
+            while (*str != '\0')
+            {
+                session.readByte(*str++);
+
+                if (session.accept())
+                {
+                    accepted++;
+                    session.transitState();
+                }
+            }
+        }
+    };
+
+    Feed feed;
+
+    char motion_frame[3 + 104 + 1];
+
+    memcpy(motion_frame, ">MF", 3);
+    memset(motion_frame + 3, '0', 104);
+    motion_frame[3 + 104] = '\0';
+
+    // Run & Assert ============================================================
+    {
+        feed(ble, motion_frame);
+
+        assertEqual(2, feed.accepted); // HEADER and COMMAND only
+    }
+
+    {
+        feed(ble, "$PM01");
+
+        assertEqual(3, feed.accepted);
+        assertEqual(0, ble.headerId());
+        assertEqual(7, ble.commandId());
+        assertEqual(0, memcmp(ble.arguments(), "01", 2));
+    }
+
+    {
+        feed(ble, ">MH00MOTION-NAME-LONG-AS-THIS-00000000");
+
+        assertEqual(3, feed.accepted);
+        assertEqual(2, ble.headerId());
+        assertEqual(6, ble.commandId());
+    }
+}
+
+
 /*!
     @brief アプリケーション・エントリポイント
 */
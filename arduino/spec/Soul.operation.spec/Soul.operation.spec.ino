@@ -39,6 +39,12 @@ namespace
         }
 
     public:
+        OperationTest(char buffer[])
+            : PLEN2::Protocol(buffer, SESSION_BUFFER_LENGTH)
+        {
+            // noop.
+        }
+
         virtual void afterHook()
         {
             if (m_state == READY)
@@ -61,7 +67,8 @@ namespace
         }
     };
 
-    OperationTest test_core;
+    char buffer[PLEN2::Protocol::SESSION_BUFFER_LENGTH];
+    OperationTest test_core(buffer);
 }
 
 